@@ -0,0 +1,56 @@
+# Check for the presence of the LZ4 compression library
+#
+# The following variables are set when LZ4 is found:
+#  LZ4_FOUND         = Set to true, if all components of LZ4
+#                          have been found.
+#  LZ4_INCLUDE_DIR   = Include path for the header files of LZ4
+#  LZ4_LIBRARIES     = Link these to use LZ4
+
+## -----------------------------------------------------------------------------
+## Check for the header files
+
+find_path (LZ4_INCLUDE_DIR NAMES lz4.h
+  PATHS ${LZ4_PREFIX} /usr/local/include /usr/include /sw/include
+)
+
+## -----------------------------------------------------------------------------
+## Check for the library
+
+find_library (LZ4_LIBRARIES lz4
+  PATHS ${LZ4_PREFIX} /usr/local/lib /usr/lib /lib /sw/lib
+)
+
+## -----------------------------------------------------------------------------
+## Actions taken when all components have been found
+
+if (LZ4_INCLUDE_DIR AND LZ4_LIBRARIES)
+  set (LZ4_FOUND TRUE)
+else (LZ4_INCLUDE_DIR AND LZ4_LIBRARIES)
+  set (LZ4_FOUND FALSE)
+  if (NOT LZ4_FIND_QUIETLY)
+    if (NOT LZ4_INCLUDE_DIR)
+      message (STATUS "Unable to find LZ4 header files!")
+    endif (NOT LZ4_INCLUDE_DIR)
+    if (NOT LZ4_LIBRARIES)
+      message (STATUS "Unable to find LZ4 library files!")
+    endif (NOT LZ4_LIBRARIES)
+  endif (NOT LZ4_FIND_QUIETLY)
+endif (LZ4_INCLUDE_DIR AND LZ4_LIBRARIES)
+
+if (LZ4_FOUND)
+  if (NOT LZ4_FIND_QUIETLY)
+    message (STATUS "Found components for LZ4")
+    message (STATUS "LZ4_INCLUDE_DIR = ${LZ4_INCLUDE_DIR}")
+    message (STATUS "LZ4_LIBRARIES = ${LZ4_LIBRARIES}")
+  endif (NOT LZ4_FIND_QUIETLY)
+else (LZ4_FOUND)
+  if (LZ4_FIND_REQUIRED)
+    message (FATAL_ERROR "Could not find LZ4!")
+  endif (LZ4_FIND_REQUIRED)
+endif (LZ4_FOUND)
+
+mark_as_advanced (
+  LZ4_FOUND
+  LZ4_LIBRARIES
+  LZ4_INCLUDE_DIR
+)
@@ -0,0 +1,56 @@
+# Check for the presence of the Zstd compression library
+#
+# The following variables are set when Zstd is found:
+#  ZSTD_FOUND         = Set to true, if all components of Zstd
+#                          have been found.
+#  ZSTD_INCLUDE_DIR   = Include path for the header files of Zstd
+#  ZSTD_LIBRARIES     = Link these to use Zstd
+
+## -----------------------------------------------------------------------------
+## Check for the header files
+
+find_path (ZSTD_INCLUDE_DIR NAMES zstd.h
+  PATHS ${ZSTD_PREFIX} /usr/local/include /usr/include /sw/include
+)
+
+## -----------------------------------------------------------------------------
+## Check for the library
+
+find_library (ZSTD_LIBRARIES zstd
+  PATHS ${ZSTD_PREFIX} /usr/local/lib /usr/lib /lib /sw/lib
+)
+
+## -----------------------------------------------------------------------------
+## Actions taken when all components have been found
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+  set (ZSTD_FOUND TRUE)
+else (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+  set (ZSTD_FOUND FALSE)
+  if (NOT Zstd_FIND_QUIETLY)
+    if (NOT ZSTD_INCLUDE_DIR)
+      message (STATUS "Unable to find Zstd header files!")
+    endif (NOT ZSTD_INCLUDE_DIR)
+    if (NOT ZSTD_LIBRARIES)
+      message (STATUS "Unable to find Zstd library files!")
+    endif (NOT ZSTD_LIBRARIES)
+  endif (NOT Zstd_FIND_QUIETLY)
+endif (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+
+if (ZSTD_FOUND)
+  if (NOT Zstd_FIND_QUIETLY)
+    message (STATUS "Found components for Zstd")
+    message (STATUS "ZSTD_INCLUDE_DIR = ${ZSTD_INCLUDE_DIR}")
+    message (STATUS "ZSTD_LIBRARIES = ${ZSTD_LIBRARIES}")
+  endif (NOT Zstd_FIND_QUIETLY)
+else (ZSTD_FOUND)
+  if (Zstd_FIND_REQUIRED)
+    message (FATAL_ERROR "Could not find Zstd!")
+  endif (Zstd_FIND_REQUIRED)
+endif (ZSTD_FOUND)
+
+mark_as_advanced (
+  ZSTD_FOUND
+  ZSTD_LIBRARIES
+  ZSTD_INCLUDE_DIR
+)
@@ -15,7 +15,10 @@
 #include "logger.hh"
 #include "param.hh"
 #include "time.hh"
+
+#include <exception>
 #include <filesystem>
+#include <future>
 
 
 namespace fast_daq
@@ -26,6 +29,8 @@ namespace fast_daq
     butterfly_house::butterfly_house() :
             control_access(),
             f_max_file_size_mb( 500 ),
+            f_preallocate_files( true ),
+            f_io_queue_size( 16 ),
             f_file_infos(),
             f_mw_ptrs(),
             f_writers(),
@@ -54,6 +59,9 @@ namespace fast_daq
         {
             f_file_infos.resize( a_daq_config.get_value( "n-files", 1U ) );
             set_max_file_size_mb( a_daq_config.get_value( "max-file-size-mb", get_max_file_size_mb() ) );
+            set_preallocate_files( a_daq_config.get_value( "preallocate-files", get_preallocate_files() ) );
+            set_io_queue_size( a_daq_config.get_value( "io-queue-size", get_io_queue_size() ) );
+            if( f_io_queue_size == 0 ) throw error() << "io-queue-size must be at least 1";
         }
 
         for( file_infos_it fi_it = f_file_infos.begin(); fi_it != f_file_infos.end(); ++fi_it )
@@ -83,74 +91,111 @@ namespace fast_daq
 	set_duration(t_run_duration_1);
 
         LINFO( plog, "Starting egg3 files" );
-        try
-        {
-            f_mw_ptrs.clear();
-            f_mw_ptrs.resize( f_file_infos.size() );
-            for( unsigned t_file_num = 0; t_file_num < f_file_infos.size(); ++t_file_num )
-            {
-                std::string t_filename( f_file_infos[ t_file_num ].f_filename );
-                LDEBUG( plog, "Creating file <" << t_filename << ">" );
-                f_mw_ptrs[ t_file_num ] = monarch_wrap_ptr( new monarch_wrapper( t_filename ) );
-                f_mw_ptrs[ t_file_num ]->set_max_file_size( f_max_file_size_mb );
-
-                header_wrap_ptr t_hwrap_ptr = f_mw_ptrs[ t_file_num ]->get_header();
-                unique_lock t_header_lock( t_hwrap_ptr->get_lock() );
-                t_hwrap_ptr->header().Description() = f_file_infos[ t_file_num ].f_description;
-
-                time_t t_raw_time = time( nullptr );
-                struct tm* t_processed_time = gmtime( &t_raw_time );
-                char t_timestamp[ 512 ];
-                strftime( t_timestamp, 512, scarab::date_time_format, t_processed_time );
-                //LWARN( plog, "raw: " << t_raw_time << "   proc'd: " << t_processed_time->tm_hour << " " << t_processed_time->tm_min << " " << t_processed_time->tm_year << "   timestamp: " << t_timestamp );
-                t_hwrap_ptr->header().Timestamp() = t_timestamp;
-
-                t_hwrap_ptr->header().SetRunDuration( t_run_duration );
-
-                // writer/stream setup
-                LDEBUG( plog, "Setting up streams" );
-                for( auto it_writer = f_writers.begin(); it_writer != f_writers.end(); ++it_writer )
-                {
-                    if( it_writer->second == t_file_num )
-                    {
-                        it_writer->first->prepare_to_write( f_mw_ptrs[ t_file_num ], t_hwrap_ptr );
-                    }
-                }
-
-                // be sure to unlock here; the header mutex is locked again in monarch_wrapper::start_using()
-                t_header_lock.unlock();
-
-                f_mw_ptrs[ t_file_num ]->start_using();
-            }
-            LINFO( plog, "Done creating egg3 files" );
-        }
-        catch( std::exception& e )
+        f_mw_ptrs.clear();
+        f_mw_ptrs.resize( f_file_infos.size() );
+
+        // each file is created and started on its own thread so that run-start latency doesn't grow with the number of files:
+        // besides the HDF5 calls, starting a file reserves its disk space and waits for its on-deck thread to start up
+        std::vector< std::future< void > > t_starts;
+        for( unsigned t_file_num = 0; t_file_num < f_file_infos.size(); ++t_file_num )
         {
-            throw;
+            t_starts.push_back( std::async( std::launch::async, &butterfly_house::start_file, this, t_file_num ) );
         }
+        wait_for_files( t_starts, "start" );
 
+        LINFO( plog, "Done creating egg3 files" );
         return;
     }
 
     void butterfly_house::finish_files()
     {
         std::unique_lock< std::mutex > t_lock( f_house_mutex );
-        try
+
+        // likewise, each file is finished on its own thread: finishing waits for the file's writers to finish their streams,
+        // joins the file's threads, and releases its reserved disk space
+        std::vector< std::future< void > > t_finishes;
+        for( unsigned t_file_num = 0; t_file_num < f_mw_ptrs.size(); ++t_file_num )
         {
-            for( auto file_it = f_mw_ptrs.begin(); file_it != f_mw_ptrs.end(); ++file_it )
+            t_finishes.push_back( std::async( std::launch::async, &butterfly_house::finish_file, this, t_file_num ) );
+        }
+        wait_for_files( t_finishes, "finish" );
+        f_mw_ptrs.clear();
+
+        return;
+    }
+
+    void butterfly_house::start_file( unsigned a_file_num )
+    {
+        // called from start_files() with the house mutex locked; only f_mw_ptrs[ a_file_num ] is modified here
+        std::string t_filename( f_file_infos[ a_file_num ].f_filename );
+        LDEBUG( plog, "Creating file <" << t_filename << ">" );
+        monarch_wrap_ptr t_mw_ptr( new monarch_wrapper( t_filename ) );
+        t_mw_ptr->set_max_file_size( f_max_file_size_mb );
+        t_mw_ptr->set_preallocate_files( f_preallocate_files );
+        t_mw_ptr->set_io_queue_size( f_io_queue_size );
+        t_mw_ptr->set_metrics_name( "file-" + std::to_string( a_file_num ) );
+        f_mw_ptrs[ a_file_num ] = t_mw_ptr;
+
+        header_wrap_ptr t_hwrap_ptr = t_mw_ptr->get_header();
+        unique_lock t_header_lock( t_hwrap_ptr->get_lock() );
+        t_hwrap_ptr->header().Description() = f_file_infos[ a_file_num ].f_description;
+
+        time_t t_raw_time = time( nullptr );
+        struct tm t_processed_time;
+        gmtime_r( &t_raw_time, &t_processed_time );
+        char t_timestamp[ 512 ];
+        strftime( t_timestamp, 512, scarab::date_time_format, &t_processed_time );
+        t_hwrap_ptr->header().Timestamp() = t_timestamp;
+
+        t_hwrap_ptr->header().SetRunDuration( t_run_duration );
+
+        // writer/stream setup
+        LDEBUG( plog, "Setting up streams for file <" << a_file_num << ">" );
+        for( auto it_writer = f_writers.begin(); it_writer != f_writers.end(); ++it_writer )
+        {
+            if( it_writer->second == a_file_num )
             {
-                (*file_it)->cancel();
-                (*file_it)->stop_using();
-                (*file_it)->finish_file();
-                file_it->reset();
+                it_writer->first->prepare_to_write( t_mw_ptr, t_hwrap_ptr );
             }
-            f_mw_ptrs.clear();
         }
-        catch( std::exception& e )
+
+        // be sure to unlock here; the header mutex is locked again in monarch_wrapper::start_using()
+        t_header_lock.unlock();
+
+        t_mw_ptr->start_using();
+        return;
+    }
+
+    void butterfly_house::finish_file( unsigned a_file_num )
+    {
+        // called from finish_files() with the house mutex locked
+        monarch_wrap_ptr& t_mw_ptr = f_mw_ptrs[ a_file_num ];
+        if( ! t_mw_ptr ) return;
+        LINFO( plog, "File <" << a_file_num << "> was rotated " << t_mw_ptr->get_file_switch_count() << " time(s) during the run" );
+        t_mw_ptr->cancel();
+        t_mw_ptr->stop_using();
+        t_mw_ptr->finish_file();
+        t_mw_ptr.reset();
+        return;
+    }
+
+    void butterfly_house::wait_for_files( std::vector< std::future< void > >& a_futures, const std::string& a_operation )
+    {
+        // wait for every file before reporting a failure, so that no thread is left running with the house mutex released
+        std::exception_ptr t_first_error;
+        for( unsigned t_file_num = 0; t_file_num < a_futures.size(); ++t_file_num )
         {
-            throw;
+            try
+            {
+                a_futures[ t_file_num ].get();
+            }
+            catch( std::exception& e )
+            {
+                LERROR( plog, "Unable to " << a_operation << " file <" << t_file_num << ">: " << e.what() );
+                if( ! t_first_error ) t_first_error = std::current_exception();
+            }
         }
-
+        if( t_first_error ) std::rethrow_exception( t_first_error );
         return;
     }
 
@@ -14,8 +14,9 @@
  *    Thread-safe operations:
  *      - All butterfly_house function calls
  *      - Initializing an egg file
+ *      - Starting and finishing multiple files (done in parallel, one thread per file)
  *      - Accessing the Monarch header (can only be done by one thread at a time)
- *      - Writing data to a file (handled by HDF5's internal thread safety)
+ *      - Writing data to a file (each file's records are written by that file's own I/O thread)
  *      - Finishing an egg file
  *
  *    Non-thread-safe operations:
@@ -33,6 +34,9 @@
 #include "member_variables.hh"
 #include "singleton.hh"
 
+#include <future>
+#include <vector>
+
 namespace scarab
 {
     class param_node;
@@ -53,11 +57,22 @@ namespace fast_daq
      Registers the writer and creates, prepares, starts and finishes egg files via monarch3_wrapper.
      butterfly_house gets the file size from the fast_daq config file and the filename, run duration and description from daq_control.
      It adds this information to the file header.
+
+     Available configuration values (in the "daq" block):
+     - "n-files": uint -- number of egg files written in parallel (default: 1)
+     - "max-file-size-mb": double -- size at which writing switches to a continuation file (default: 500)
+     - "preallocate-files": bool -- reserve max-file-size-mb of disk space when each file is created (default: true)
+     - "io-queue-size": uint -- number of records per file that may wait for the file's I/O thread before its writers are held up (default: 16)
+
+     Files are started and finished in parallel, and each file's records are written by its own I/O thread (see monarch_wrapper),
+     so run start and stop times, and the writers' time spent in HDF5, don't grow with the number of files.
      */
     class butterfly_house : public scarab::singleton< butterfly_house >, public sandfly::control_access
     {
         public:
             mv_accessible( double, max_file_size_mb );
+            mv_accessible( bool, preallocate_files );
+            mv_accessible( unsigned, io_queue_size );
 
         public:
             void register_file( unsigned a_file_num, const std::string& a_filename, const std::string& a_description, unsigned a_duration_ms );
@@ -84,6 +99,13 @@ namespace fast_daq
             const double get_freq_lo();
 
         private:
+            /// Create and start a single file; used by start_files()
+            void start_file( unsigned a_file_num );
+            /// Finish a single file; used by finish_files()
+            void finish_file( unsigned a_file_num );
+            /// Wait for all per-file operations to complete; rethrows the first failure
+            void wait_for_files( std::vector< std::future< void > >& a_futures, const std::string& a_operation );
+
             struct file_info
             {
                 std::string f_filename;
@@ -8,7 +8,9 @@
 #include "daq_control.hh"
 
 #include "butterfly_house.hh"
+#include "data_arena.hh"
 #include "fast_daq_error.hh"
+#include "run_metrics.hh"
 
 #include "message_relayer.hh"
 
@@ -32,6 +34,10 @@ namespace fast_daq
     {
             set_use_monarch( f_daq_config.get_value( "use-monarch", get_use_monarch() ) );
             LDEBUG( plog, "Use-monarch set to: " << f_use_monarch );
+            if( f_daq_config.has( "data-arena" ) )
+            {
+                data_arena::get_instance()->configure( f_daq_config["data-arena"].as_node() );
+            }
     }
 
     daq_control::~daq_control()
@@ -49,6 +55,7 @@ namespace fast_daq
 
     void daq_control::on_pre_run()
     {
+        run_metrics::get_instance()->clear();
         if( f_use_monarch )
         {
             LDEBUG( plog, "Starting egg files" );
@@ -71,6 +78,8 @@ namespace fast_daq
     /// Handle called after run finishes (i.e. control is paused)
     void daq_control::on_post_run()
     {
+        data_arena::get_instance()->log_statistics();
+        run_metrics::get_instance()->log_metrics();
         if( f_use_monarch )
         {
             LDEBUG( plog, "Finishing egg files" );
@@ -249,6 +258,14 @@ namespace fast_daq
         return a_request->reply( dripline::dl_success(), "Use Monarch request completed", std::move(t_payload_ptr) );
     }
 
+    dripline::reply_ptr_t daq_control::handle_get_metrics_request( const dripline::request_ptr_t a_request )
+    {
+        param_ptr_t t_payload_ptr( new param_node() );
+        run_metrics::get_instance()->fill_node( t_payload_ptr->as_node() );
+
+        return a_request->reply( dripline::dl_success(), "Metrics request completed", std::move(t_payload_ptr) );
+    }
+
     void daq_control::derived_register_handlers( std::shared_ptr< sandfly::request_receiver > a_receiver_ptr )
     {
         using namespace std::placeholders;
@@ -260,6 +277,7 @@ namespace fast_daq
         a_receiver_ptr->register_get_handler( "filename", std::bind( &daq_control::handle_get_filename_request, this, _1 ) );
         a_receiver_ptr->register_get_handler( "description", std::bind( &daq_control::handle_get_description_request, this, _1 ) );
         a_receiver_ptr->register_get_handler( "use-monarch", std::bind( &daq_control::handle_get_use_monarch_request, this, _1 ) );
+        a_receiver_ptr->register_get_handler( "metrics", std::bind( &daq_control::handle_get_metrics_request, this, _1 ) );
 
         // add set request handlers
         //a_receiver_ptr->register_set_handler( "filename", std::bind( &daq_control::handle_set_filename_request, this, _1 ) );
@@ -22,6 +22,11 @@ namespace fast_daq
      @brief Adds monarch-based file control to run_control
 
      @details
+     The "data-arena" block of the daq configuration, if present, configures the data_arena from which the data
+     containers are allocated; its statistics are logged after each run.
+
+     The run_metrics (file rotations, buffer overruns and the like) are cleared when a run starts and logged when it
+     ends; a "metrics" get request returns their current values as name/value pairs in the reply payload.
     */
     class daq_control : public sandfly::run_control
     {
@@ -48,6 +53,7 @@ namespace fast_daq
             dripline::reply_ptr_t handle_get_filename_request( const dripline::request_ptr_t a_request );
             dripline::reply_ptr_t handle_get_description_request( const dripline::request_ptr_t a_request );
             dripline::reply_ptr_t handle_get_use_monarch_request( const dripline::request_ptr_t a_request );
+            dripline::reply_ptr_t handle_get_metrics_request( const dripline::request_ptr_t a_request );
 
         protected:
             virtual void derived_register_handlers( std::shared_ptr< sandfly::request_receiver > a_receiver_ptr );
@@ -0,0 +1,20 @@
+/*
+ * load_shedder.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "load_shedder.hh"
+
+namespace fast_daq
+{
+    load_shedder::load_shedder() :
+            f_shedding( false )
+    {
+    }
+
+    load_shedder::~load_shedder()
+    {
+    }
+
+} /* namespace fast_daq */
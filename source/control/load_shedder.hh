@@ -0,0 +1,59 @@
+/*
+ * load_shedder.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_LOAD_SHEDDER_HH_
+#define FAST_DAQ_LOAD_SHEDDER_HH_
+
+#include "singleton.hh"
+
+#include <atomic>
+
+namespace fast_daq
+{
+    /*!
+     @class load_shedder
+     @brief Lets a data source ask the rest of the chain to skip optional work while it is falling behind.
+
+     @details
+     A producer that can see its own backlog (e.g. the digitizer's DMA buffers) turns shedding on when the backlog
+     crosses a high watermark and off again once it has recovered.  Nodes doing work that can be skipped without
+     corrupting the main data path (e.g. relaying spectra for monitoring) check shedding() for each item and skip
+     it while shedding is on, which frees CPU and memory bandwidth for the nodes that cannot skip anything.
+
+     Thread safety: all functions are thread-safe; checking the state is a single relaxed atomic load.
+     */
+    class load_shedder : public scarab::singleton< load_shedder >
+    {
+        public:
+            /// Turn shedding on or off; returns true if the state changed
+            bool set_shedding( bool a_shedding );
+            /// Whether optional work should currently be skipped
+            bool shedding() const;
+
+        private:
+            std::atomic< bool > f_shedding;
+
+        private:
+            friend class scarab::singleton< load_shedder >;
+            friend class scarab::destroyer< load_shedder >;
+
+            load_shedder();
+            virtual ~load_shedder();
+    };
+
+    inline bool load_shedder::set_shedding( bool a_shedding )
+    {
+        return f_shedding.exchange( a_shedding, std::memory_order_relaxed ) != a_shedding;
+    }
+
+    inline bool load_shedder::shedding() const
+    {
+        return f_shedding.load( std::memory_order_relaxed );
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_LOAD_SHEDDER_HH_ */
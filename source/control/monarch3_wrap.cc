@@ -10,6 +10,7 @@
 
 #include "sandfly_return_codes.hh"
 #include "fast_daq_error.hh"
+#include "run_metrics.hh"
 
 #include "M3Exception.hh"
 
@@ -21,6 +22,13 @@
 #include <future>
 #include <signal.h>
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
 
 namespace fast_daq
 {
@@ -41,6 +49,44 @@ namespace fast_daq
     }
 
 
+    // Reserve disk blocks for a file that is expected to grow to a_size_mb, without changing its apparent size.
+    // HDF5 keeps writing at the end of the file as usual, but the filesystem no longer has to allocate blocks as it goes.
+    static void reserve_file_space( const std::string& a_filename, double a_size_mb )
+    {
+        if( a_size_mb <= 0. ) return;
+        int t_fd = ::open( a_filename.c_str(), O_WRONLY );
+        if( t_fd < 0 )
+        {
+            LWARN( plog, "Unable to open file <" << a_filename << "> to reserve disk space" );
+            return;
+        }
+        off_t t_size_bytes = static_cast< off_t >( a_size_mb * 1.e6 );
+        if( ::fallocate( t_fd, FALLOC_FL_KEEP_SIZE, 0, t_size_bytes ) != 0 )
+        {
+            // not all filesystems support fallocate; the file will simply grow as it is written
+            LDEBUG( plog, "Unable to reserve " << a_size_mb << " MB for file <" << a_filename << ">: " << strerror( errno ) );
+        }
+        else
+        {
+            LTRACE( plog, "Reserved " << a_size_mb << " MB for file <" << a_filename << ">" );
+        }
+        ::close( t_fd );
+        return;
+    }
+
+    // Return any reserved-but-unused blocks beyond the end of a finished file to the filesystem
+    static void release_file_space( const std::string& a_filename )
+    {
+        struct stat t_stat;
+        if( ::stat( a_filename.c_str(), &t_stat ) != 0 ) return;
+        if( ::truncate( a_filename.c_str(), t_stat.st_size ) != 0 )
+        {
+            LWARN( plog, "Unable to release reserved disk space for file <" << a_filename << ">: " << strerror( errno ) );
+        }
+        return;
+    }
+
+
     //***************************
     // monarch_on_deck_manager
     //***************************
@@ -179,6 +225,9 @@ namespace fast_daq
             LTRACE( plog, "Writing new header" );
             t_new_monarch->WriteHeader();
 
+            // pre-size the file so that block allocation doesn't happen right after the switch
+            if( f_monarch_wrap->f_preallocate_files ) reserve_file_space( t_new_filename, f_monarch_wrap->f_max_file_size_mb );
+
             // switch out the monarch pointers, f_monarch_on_deck <--> t_new_monarch
             f_monarch_on_deck.swap( t_new_monarch );
         }
@@ -189,6 +238,15 @@ namespace fast_daq
         return;
     }
 
+    void monarch_on_deck_manager::finish_to_finish_nolock()
+    {
+        std::string t_filename( f_monarch_to_finish->GetHeader()->Filename() );
+        f_monarch_to_finish->FinishWriting();
+        f_monarch_to_finish.reset();
+        if( f_monarch_wrap->f_preallocate_files ) release_file_space( t_filename );
+        return;
+    }
+
     void monarch_on_deck_manager::clear_on_deck()
     {
         f_od_mutex.lock();
@@ -242,10 +300,16 @@ namespace fast_daq
             f_filename_ext(),
             f_file_count( 1 ),
             f_max_file_size_mb( 0. ),
-            f_file_size_est_mb( 0. ),
-            f_wait_to_write(),
+            f_preallocate_files( false ),
+            f_file_epoch( 0 ),
+            f_file_bytes_committed{ { 0 }, { 0 } },
+            f_file_bytes_on_disk( 0 ),
+            f_file_switch_count( 0 ),
+            f_file_start_time( std::chrono::steady_clock::now() ),
+            f_last_file_duration_s( 0. ),
+            f_rotated_files_duration_s( 0. ),
+            f_metrics_name( "file" ),
             f_switch_thread( nullptr ),
-            f_ok_to_write( true ),
             f_do_switch_flag( false ),
             f_do_switch_trig(),
             f_monarch(),
@@ -255,7 +319,17 @@ namespace fast_daq
             f_run_start_time( std::chrono::steady_clock::now() ),
             f_stage( monarch_stage::initialized ),
             f_od_thread( nullptr ),
-            f_monarch_od_manager( this )
+            f_monarch_od_manager( this ),
+            f_io_thread( nullptr ),
+            f_io_queue(),
+            f_io_spares(),
+            f_io_mutex(),
+            f_io_work_cv(),
+            f_io_space_cv(),
+            f_io_queue_size( 16 ),
+            f_io_busy( false ),
+            f_io_stopping( false ),
+            f_io_failed( false )
     {
         std::string::size_type t_ext_pos = a_filename.find_last_of( '.' );
         if( t_ext_pos == std::string::npos )
@@ -283,6 +357,8 @@ namespace fast_daq
 
     monarch_wrapper::~monarch_wrapper()
     {
+        stop_io_thread();
+
         f_monarch_mutex.lock();
 
         set_stage( monarch_stage::finished );
@@ -311,8 +387,10 @@ namespace fast_daq
         {
             if( f_monarch )
             {
+                std::string t_filename( f_monarch->GetHeader()->Filename() );
                 f_monarch->FinishWriting();
                 f_monarch.reset();
+                if( f_preallocate_files ) release_file_space( t_filename );
             }
 
         }
@@ -321,8 +399,6 @@ namespace fast_daq
             LERROR( plog, "Unable to write file on monarch_wrapper deletion: " << e.what() );
         }
 
-        f_wait_to_write.notify_all();
-
         f_monarch_mutex.unlock();
 
     }
@@ -360,7 +436,7 @@ namespace fast_daq
         {
             try
             {
-                stream_wrap_ptr t_stream_ptr( new stream_wrapper( *f_monarch.get(), a_stream_no, this ) );
+                stream_wrap_ptr t_stream_ptr( new stream_wrapper( *f_monarch.get(), a_stream_no, this, f_file_epoch.load() ) );
                 f_stream_wraps[ a_stream_no ] = t_stream_ptr;
             }
             catch( error& e )
@@ -399,11 +475,28 @@ namespace fast_daq
         {
             throw error() << e.what();
         }
+        if( f_preallocate_files ) reserve_file_space( f_header_wrap->header().Filename(), f_max_file_size_mb );
         set_stage( monarch_stage::writing );
 
+        f_file_epoch = 0;
+        f_file_bytes_committed[ 0 ] = 0;
+        f_file_bytes_committed[ 1 ] = 0;
+        f_file_bytes_on_disk = 0;
+        f_file_switch_count = 0;
+        f_rotated_files_duration_s = 0.;
+        f_file_start_time = std::chrono::steady_clock::now();
+        run_metrics::get_instance()->set( f_metrics_name + ".rotations", 0. );
+
         t_header_lock.unlock();
 
 
+        // start the I/O thread that writes the records
+
+        f_io_stopping = false;
+        f_io_failed = false;
+        LDEBUG( plog, "Starting the I/O thread for file <" << f_header_wrap->header().Filename() << ">" );
+        f_io_thread = new std::thread( &monarch_wrapper::execute_io_loop, this );
+
         // prepare file-switching components
 
         f_do_switch_flag = false;
@@ -432,18 +525,17 @@ namespace fast_daq
         {
             unique_lock t_lock( f_monarch_mutex );
 
-            // wait on the condition variable
+            // wait on the condition variable; while waiting, keep track of the actual size of the file on disk
             while( ! f_do_switch_flag.load() && ! is_canceled() )
             {
                 f_do_switch_trig.wait_for( t_lock, std::chrono::milliseconds( 500 ) );
+                update_file_size_on_disk();
             }
             if( is_canceled() ) break;
             //if( f_stage == monarch_stage::finished) break;
 
             // f_monarch_mutex is locked at this point
 
-            f_do_switch_flag = false;
-
             LDEBUG( plog, "Switching egg files" );
             try
             {
@@ -455,8 +547,8 @@ namespace fast_daq
                 scarab::signal_handler::cancel_all( RETURN_ERROR );
             }
 
-            f_ok_to_write = true;
-            f_wait_to_write.notify_all();
+            // the flag is only cleared once the switch is complete, so that each file boundary triggers exactly one switch
+            f_do_switch_flag = false;
 
         } // end while( ! f_monarch_od_manager.is_canceled() && f_monarch_wrap->f_stage != monarch_stage::finished )
 
@@ -467,9 +559,8 @@ namespace fast_daq
 
     void monarch_wrapper::trigger_switch()
     {
-        if( f_do_switch_flag.load() ) return;
-        f_do_switch_flag = true;
-        f_ok_to_write = false;
+        bool t_expected = false;
+        if( ! f_do_switch_flag.compare_exchange_strong( t_expected, true ) ) return;
         f_do_switch_trig.notify_one();
         return;
     }
@@ -499,6 +590,9 @@ namespace fast_daq
 
     void monarch_wrapper::finish_stream( unsigned a_stream_no )
     {
+        // the stream's queued records have to be written before the stream goes away
+        flush_records();
+
         unique_lock t_monarch_lock( f_monarch_mutex );
         if( f_stage != monarch_stage::writing )
         {
@@ -565,6 +659,8 @@ namespace fast_daq
                     throw error() << "Streams did not all finish after wait period and global cancellation";
                 }
             }
+            // every stream has been finished, so there's nothing left for the I/O thread to write
+            stop_io_thread();
             // re-lock so that the lock condition is the same once we exit this block
             t_monarch_lock.lock();
         }
@@ -572,7 +668,10 @@ namespace fast_daq
         set_stage( monarch_stage::finished );
         f_monarch->FinishWriting();
         f_monarch.reset();
-        f_file_size_est_mb = 0.;
+        if( f_preallocate_files ) release_file_space( t_filename );
+        f_file_bytes_committed[ 0 ] = 0;
+        f_file_bytes_committed[ 1 ] = 0;
+        f_file_bytes_on_disk = 0;
         return;
     }
 
@@ -596,13 +695,24 @@ namespace fast_daq
 
             LTRACE( plog, "Switching file pointers" );
 
-            // move the old file to the to_finish pointer
-            f_monarch_od_manager.set_as_to_finish( f_monarch );
-
-            // move the on_deck pointer to the current pointer
-            f_monarch_od_manager.get_on_deck( f_monarch );
+            // take the on-deck file; the old file stays alive in t_old_monarch until no writer can be using it
+            std::shared_ptr< monarch3::Monarch3 > t_old_monarch;
+            f_monarch_od_manager.get_on_deck( t_old_monarch );
+            if( ! t_old_monarch ) throw error() << "On-deck file is not available";
+            f_monarch.swap( t_old_monarch );
 
-            f_file_size_est_mb = 0.;
+            // look up all of the new streams before any of them are published to the writers
+            std::map< unsigned, monarch3::M3Stream* > t_new_streams;
+            for( std::map< unsigned, stream_wrap_ptr >::iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
+            {
+                monarch3::M3Stream* t_new_stream = f_monarch->GetStream( t_stream_it->first );
+                if( t_new_stream == nullptr )
+                {
+                    f_monarch.swap( t_old_monarch );
+                    throw error() << "Stream <" << t_stream_it->first << "> was invalid";
+                }
+                t_new_streams[ t_stream_it->first ] = t_new_stream;
+            }
 
             LTRACE( plog, "Switching header pointer" );
 
@@ -612,19 +722,45 @@ namespace fast_daq
 
             LTRACE( plog, "Switching stream pointers" );
 
-            // swap out the stream pointers
+            // start the new file's epoch and byte count, then publish the new stream pointers;
+            // each record is counted toward the epoch whose stream pointer it was written through, so none is lost or charged to the wrong file
+            uint64_t t_old_epoch = f_file_epoch.load();
+            f_file_bytes_committed[ ( t_old_epoch + 1 ) % 2 ] = 0;
+            f_file_bytes_on_disk = 0;
+            f_file_epoch = t_old_epoch + 1;
             for( std::map< unsigned, stream_wrap_ptr >::iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
             {
-                t_stream_it->second->f_stream = f_monarch->GetStream( t_stream_it->first );
-                if( t_stream_it->second->f_stream == nullptr )
-                {
-                    throw error() << "Stream <" << t_stream_it->first << "> was invalid";
-                }
+                t_stream_it->second->advance_epoch( t_new_streams[ t_stream_it->first ] );
             }
 
-            LDEBUG( plog, "Switch to new file is complete: <" << f_header_wrap->ptr()->Filename() << ">" );
+            // grace period: a write that started in the old epoch may still be writing to the old file;
+            // writes that start from now on use the new pointers, so this waits for at most one record per stream
+            for( std::map< unsigned, stream_wrap_ptr >::iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
+            {
+                t_stream_it->second->wait_for_write_to_complete( t_old_epoch );
+            }
+
+            // all records for the old file are in and counted; retire it asynchronously
+            f_monarch_od_manager.set_as_to_finish( t_old_monarch );
+            uint64_t t_old_file_bytes = f_file_bytes_committed[ t_old_epoch % 2 ].load();
+
+            monarch_time_point_t t_now = std::chrono::steady_clock::now();
+            double t_file_duration_s = std::chrono::duration< double >( t_now - f_file_start_time ).count();
+            unsigned t_switch_count = ++f_file_switch_count;
+            double t_file_mb = 1.e-6 * (double)t_old_file_bytes;
+            LINFO( plog, "File rotation " << t_switch_count << ": previous file took " << t_file_duration_s << " s to fill; " <<
+                    t_file_mb << " MB of records committed" );
+            f_last_file_duration_s = t_file_duration_s;
+            f_rotated_files_duration_s += t_file_duration_s;
+
+            run_metrics* t_metrics = run_metrics::get_instance();
+            t_metrics->set( f_metrics_name + ".rotations", (double)t_switch_count );
+            t_metrics->set( f_metrics_name + ".last-file-duration-s", t_file_duration_s );
+            t_metrics->set( f_metrics_name + ".mean-file-duration-s", f_rotated_files_duration_s / (double)t_switch_count );
+            t_metrics->set( f_metrics_name + ".last-file-mb", t_file_mb );
+            f_file_start_time = t_now;
 
-            //f_file_switch_started = false;
+            LDEBUG( plog, "Switch to new file is complete: <" << f_header_wrap->ptr()->Filename() << ">" );
 
             // notify the on-deck thread to process the to-finish and on-deck monarchs
             f_monarch_od_manager.notify();
@@ -644,32 +780,149 @@ namespace fast_daq
         return;
     }
 
-    void monarch_wrapper::record_file_contribution( double a_size )
+    void monarch_wrapper::record_file_contribution( uint64_t a_bytes, uint64_t a_file_epoch )
     {
-        double t_file_size_est_mb = f_file_size_est_mb.load() + a_size;
-        f_file_size_est_mb = t_file_size_est_mb;
-        LTRACE( plog, "File contribution: " << a_size << " MB;  Estimated file size is now " << t_file_size_est_mb << " MB;  limit is " << f_max_file_size_mb << " MB" );
-        if( t_file_size_est_mb >= f_max_file_size_mb )
+        uint64_t t_file_bytes = f_file_bytes_committed[ a_file_epoch % 2 ].fetch_add( a_bytes ) + a_bytes;
+        // a record that finished during the grace period of a switch belongs to the file being retired
+        if( a_file_epoch != f_file_epoch.load() ) return;
+        uint64_t t_max_bytes = max_file_size_bytes();
+        if( t_max_bytes == 0 ) return;
+        // the on-disk size (updated by the switch thread) also accounts for the HDF5 metadata
+        t_file_bytes = std::max( t_file_bytes, f_file_bytes_on_disk.load() );
+        LTRACE( plog, "File contribution: " << a_bytes << " bytes;  file size is now " << t_file_bytes << " bytes;  limit is " << t_max_bytes << " bytes" );
+        if( t_file_bytes >= t_max_bytes && ! f_do_switch_flag.load() )
         {
-            LDEBUG( plog, "Max file size exceeded (" << t_file_size_est_mb << " MB >= " << f_max_file_size_mb << " MB)" );
+            LDEBUG( plog, "Max file size exceeded (" << t_file_bytes << " bytes >= " << t_max_bytes << " bytes)" );
             trigger_switch();
         }
         return;
     }
 
-    inline bool monarch_wrapper::okay_to_write()
+    bool monarch_wrapper::queue_record( stream_wrapper* a_stream, monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq )
+    {
+        unique_lock t_lock( f_io_mutex );
+        if( f_io_thread == nullptr )
+        {
+            // the file isn't in use yet (or anymore), so there's no I/O thread; write directly
+            t_lock.unlock();
+            return a_stream->write_now( a_rec_id, a_rec_time, a_rec_block, a_bytes, a_is_new_acq );
+        }
+        // only hold up the writer if the backlog has reached its limit
+        f_io_space_cv.wait( t_lock, [this](){ return f_io_queue.size() < f_io_queue_size || f_io_stopping || f_io_failed.load(); } );
+        if( f_io_failed.load() ) return false;
+        if( f_io_stopping )
+        {
+            LERROR( plog, "Record <" << a_rec_id << "> arrived after the file was finished" );
+            return false;
+        }
+
+        queued_record_ptr t_record;
+        if( f_io_spares.empty() )
+        {
+            t_record.reset( new queued_record() );
+        }
+        else
+        {
+            t_record = std::move( f_io_spares.back() );
+            f_io_spares.pop_back();
+        }
+        t_lock.unlock();
+
+        // copy outside the lock; the writer's buffer is released as soon as it moves on
+        t_record->f_stream = a_stream;
+        t_record->f_rec_id = a_rec_id;
+        t_record->f_rec_time = a_rec_time;
+        t_record->f_is_new_acq = a_is_new_acq;
+        t_record->f_data.resize( a_bytes );
+        ::memcpy( t_record->f_data.data(), a_rec_block, a_bytes );
+
+        t_lock.lock();
+        f_io_queue.push_back( std::move( t_record ) );
+        t_lock.unlock();
+        f_io_work_cv.notify_one();
+        return true;
+    }
+
+    void monarch_wrapper::flush_records()
+    {
+        unique_lock t_lock( f_io_mutex );
+        f_io_space_cv.wait( t_lock, [this](){ return f_io_queue.empty() && ! f_io_busy; } );
+        return;
+    }
+
+    void monarch_wrapper::execute_io_loop()
     {
-        LTRACE( plog, "Checking ok to write" );
-        if( f_ok_to_write.load() ) return f_monarch.operator bool();
-        std::mutex t_wait_mutex;
-        unique_lock t_wait_lock( t_wait_mutex );
-        while( ! f_ok_to_write.load() )
+        LDEBUG( plog, "I/O thread for file <" << f_orig_filename << "> is starting up" );
+
+        unique_lock t_lock( f_io_mutex );
+        while( true )
         {
-            f_wait_to_write.wait_for( t_wait_lock, std::chrono::milliseconds( 100 ) );
+            f_io_work_cv.wait( t_lock, [this](){ return f_io_stopping || ! f_io_queue.empty(); } );
+            // when stopping, the queue is drained before the thread exits
+            if( f_io_queue.empty() ) break;
+
+            queued_record_ptr t_record = std::move( f_io_queue.front() );
+            f_io_queue.pop_front();
+            f_io_busy = true;
+            t_lock.unlock();
+
+            bool t_written = false;
+            try
+            {
+                t_written = t_record->f_stream->write_now( t_record->f_rec_id, t_record->f_rec_time, t_record->f_data.data(), t_record->f_data.size(), t_record->f_is_new_acq );
+            }
+            catch( std::exception& e )
+            {
+                LERROR( plog, "Exception caught while writing record <" << t_record->f_rec_id << ">: " << e.what() );
+            }
+            if( ! t_written )
+            {
+                LERROR( plog, "Unable to write record <" << t_record->f_rec_id << "> to file <" << f_orig_filename << ">" );
+                f_io_failed = true;
+            }
+
+            t_lock.lock();
+            f_io_busy = false;
+            f_io_spares.push_back( std::move( t_record ) );
+            f_io_space_cv.notify_all();
         }
-        return f_monarch.operator bool();
+
+        LDEBUG( plog, "I/O thread for file <" << f_orig_filename << "> is stopping" );
+        return;
     }
 
+    void monarch_wrapper::stop_io_thread()
+    {
+        unique_lock t_lock( f_io_mutex );
+        if( f_io_thread == nullptr ) return;
+        f_io_stopping = true;
+        t_lock.unlock();
+        f_io_work_cv.notify_all();
+        f_io_space_cv.notify_all();
+
+        f_io_thread->join();
+
+        t_lock.lock();
+        delete f_io_thread;
+        f_io_thread = nullptr;
+        f_io_spares.clear();
+        return;
+    }
+
+    void monarch_wrapper::update_file_size_on_disk()
+    {
+        if( ! f_monarch || f_stage != monarch_stage::writing ) return;
+        struct stat t_stat;
+        if( ::stat( f_monarch->GetHeader()->Filename().c_str(), &t_stat ) != 0 ) return;
+        f_file_bytes_on_disk = static_cast< uint64_t >( t_stat.st_size );
+        uint64_t t_max_bytes = max_file_size_bytes();
+        if( t_max_bytes != 0 && f_file_bytes_on_disk.load() >= t_max_bytes )
+        {
+            LDEBUG( plog, "Max file size exceeded on disk (" << f_file_bytes_on_disk.load() << " bytes >= " << t_max_bytes << " bytes)" );
+            trigger_switch();
+        }
+        return;
+    }
 
     //******************
     // header_wrapper
@@ -715,25 +968,33 @@ namespace fast_daq
     // stream_wrapper
     //******************
 
-    stream_wrapper::stream_wrapper( monarch3::Monarch3& a_monarch, unsigned a_stream_no, monarch_wrapper* a_monarch_wrapper ) :
+    stream_wrapper::stream_wrapper( monarch3::Monarch3& a_monarch, unsigned a_stream_no, monarch_wrapper* a_monarch_wrapper, uint64_t a_epoch ) :
             f_monarch_wrapper( a_monarch_wrapper ),
-            f_stream( a_monarch.GetStream( a_stream_no ) ),
+            f_streams{ { nullptr }, { nullptr } },
+            f_epoch( a_epoch ),
+            f_in_write_epoch( s_no_write ),
             f_is_valid( true ),
-            f_record_size_mb( 1.e-6 * (double)f_stream->GetStreamRecordNBytes() )
+            f_record_n_bytes( 0 )
     {
-        if( f_stream == nullptr )
+        f_streams[ a_epoch % 2 ] = a_monarch.GetStream( a_stream_no );
+        if( current_stream() == nullptr )
         {
             throw error() << "Invalid stream number requested: " << a_stream_no;
         }
+        // every record written to the stream's dataset has this size, regardless of how many bytes the writer filled
+        f_record_n_bytes = current_stream()->GetStreamRecordNBytes();
     }
 
     stream_wrapper::stream_wrapper( stream_wrapper&& a_orig ) :
             f_monarch_wrapper( a_orig.f_monarch_wrapper ),
-            f_stream( a_orig.f_stream ),
+            f_streams{ { a_orig.f_streams[ 0 ].load() }, { a_orig.f_streams[ 1 ].load() } },
+            f_epoch( a_orig.f_epoch.load() ),
+            f_in_write_epoch( s_no_write ),
             f_is_valid( a_orig.f_is_valid ),
-            f_record_size_mb( a_orig.f_record_size_mb )
+            f_record_n_bytes( a_orig.f_record_n_bytes )
     {
-        a_orig.f_stream = nullptr;
+        a_orig.f_streams[ 0 ] = nullptr;
+        a_orig.f_streams[ 1 ] = nullptr;
         a_orig.f_is_valid = false;
     }
 
@@ -743,29 +1004,78 @@ namespace fast_daq
     stream_wrapper& stream_wrapper::operator=( stream_wrapper&& a_orig )
     {
         f_monarch_wrapper = a_orig.f_monarch_wrapper;
-        f_stream = a_orig.f_stream;
-        a_orig.f_stream = nullptr;
+        f_streams[ 0 ] = a_orig.f_streams[ 0 ].load();
+        f_streams[ 1 ] = a_orig.f_streams[ 1 ].load();
+        f_epoch = a_orig.f_epoch.load();
+        a_orig.f_streams[ 0 ] = nullptr;
+        a_orig.f_streams[ 1 ] = nullptr;
         a_orig.f_is_valid = false;
-        f_record_size_mb = a_orig.f_record_size_mb;
+        f_record_n_bytes = a_orig.f_record_n_bytes;
         return *this;
     }
 
-    /// Write the record contents to the file
     bool stream_wrapper::write_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq )
+    {
+        LTRACE( plog, "Queuing record <" << a_rec_id << ">" );
+        return f_monarch_wrapper->queue_record( this, a_rec_id, a_rec_time, a_rec_block, a_bytes, a_is_new_acq );
+    }
+
+    bool stream_wrapper::write_now( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq )
     {
         LTRACE( plog, "Writing record <" << a_rec_id << ">" );
-        if( ! f_monarch_wrapper->okay_to_write() )
+        // announce the epoch before using its stream pointer, then confirm that the epoch is still current:
+        // either the switch sees the announcement and waits for this write, or this write sees the new epoch and uses the new pointer
+        uint64_t t_epoch = f_epoch.load();
+        f_in_write_epoch.store( t_epoch );
+        for( uint64_t t_current = f_epoch.load(); t_current != t_epoch; t_current = f_epoch.load() )
         {
+            t_epoch = t_current;
+            f_in_write_epoch.store( t_epoch );
+        }
+        monarch3::M3Stream* t_stream = f_streams[ t_epoch % 2 ].load();
+        if( t_stream == nullptr )
+        {
+            f_in_write_epoch.store( s_no_write );
             LERROR( plog, "Unable to write to monarch file" );
-            //f_mutex.unlock();
             return false;
         }
-        get_stream_record()->SetRecordId( a_rec_id );
-        get_stream_record()->SetTime( a_rec_time );
-        ::memcpy( get_stream_record()->GetData(), a_rec_block, a_bytes );
-        bool t_return = f_stream->WriteRecord( a_is_new_acq );
-        f_monarch_wrapper->record_file_contribution( f_record_size_mb );
+        bool t_return = false;
+        try
+        {
+            t_stream->GetStreamRecord()->SetRecordId( a_rec_id );
+            t_stream->GetStreamRecord()->SetTime( a_rec_time );
+            ::memcpy( t_stream->GetStreamRecord()->GetData(), a_rec_block, a_bytes );
+            t_return = t_stream->WriteRecord( a_is_new_acq );
+            // count the record before ending the write, so that the switch sees every record of the file it retires
+            if( t_return ) f_monarch_wrapper->record_file_contribution( f_record_n_bytes, t_epoch );
+        }
+        catch( ... )
+        {
+            // don't leave a switch waiting for a write that will never end
+            f_in_write_epoch.store( s_no_write );
+            throw;
+        }
+        f_in_write_epoch.store( s_no_write );
         return t_return;
     }
 
+    void stream_wrapper::advance_epoch( monarch3::M3Stream* a_stream )
+    {
+        // the slot of the next epoch last held the stream of the epoch before the current one, which no write can still be using
+        uint64_t t_next_epoch = f_epoch.load() + 1;
+        f_streams[ t_next_epoch % 2 ] = a_stream;
+        f_epoch = t_next_epoch;
+        return;
+    }
+
+    void stream_wrapper::wait_for_write_to_complete( uint64_t a_epoch )
+    {
+        // called only by the switch thread; the wait is at most one record, so it polls rather than making writers signal it
+        while( f_in_write_epoch.load() == a_epoch )
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( 20 ) );
+        }
+        return;
+    }
+
 } /* namespace fast_daq */
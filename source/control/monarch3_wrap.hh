@@ -14,7 +14,8 @@
  *    Thread-safe operations:
  *      - Initializing an egg file
  *      - Accessing the Monarch header (can only be done by one thread at a time)
- *      - Writing data to a file (handled by HDF5's internal thread safety)
+ *      - Writing data to a file (records are queued for the file's own I/O thread, which makes the HDF5 calls)
+ *      - Switching to a continuation file while writing (writers never wait for the switch to finish)
  *      - Finishing an egg file
  *
  *    Non-thread-safe operations:
@@ -29,10 +30,16 @@
 
 #include "cancelable.hh"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <future>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace fast_daq
 {
@@ -148,6 +155,11 @@ namespace fast_daq
      Provides the thread-safe, synchronized access to the Monarch object.  All thread safety is handled by the interface functions.
 
      Also owns a monarch_on_deck_manager object to handle asynchronous creation of on-deck files and finishing of completed files.
+
+     While the file is in use, its records are written by its own I/O thread: stream_wrapper::write_record() copies a record into
+     a queue and returns, and the I/O thread makes the HDF5 calls in the order the records were queued.  Writers are only held up
+     when io-queue-size records are already waiting.  A record that fails to be written is reported (by returning false) on a
+     writer's next write_record() to the file.  finish_stream() waits for the stream's queued records to be written.
     */
     class monarch_wrapper : public scarab::cancelable
     {
@@ -174,12 +186,11 @@ namespace fast_daq
 
             void trigger_switch();
 
-            /// Ensure that the file is available to write to (via a stream)
-            bool okay_to_write();
-
             /// Switch to a new file that continues the first file.
             /// The filename is automatically determine from the original filename by appending an integer count of the number of continuation files.
             /// If file contributions are being recorded, this is done automatically when the maximum file size is exceeded.
+            /// The new stream pointers are published atomically to the stream wrappers; the old file is handed to the on-deck manager
+            /// to be finished once no writer can still be using it.
             void switch_to_new_file();
 
             /// Make the wrapper unavailable for use; stops the parallel on-deck thread
@@ -199,15 +210,47 @@ namespace fast_daq
             /// Set the maximum file size used to determine when a new file is automatically started.
             void set_max_file_size( double a_size );
 
+            /// Set whether disk space for the maximum file size is reserved when each file is created.
+            /// This moves filesystem block allocation out of the writing path just after a file switch.
+            void set_preallocate_files( bool a_flag );
+
+            /// Set the number of records that may wait for the file's I/O thread before writers are held up
+            void set_io_queue_size( unsigned a_n_records );
+
+            /// Set the prefix of the run metrics published at each file rotation, e.g. "file-0".
+            /// The metrics are "<prefix>.rotations", ".last-file-duration-s", ".mean-file-duration-s" and ".last-file-mb".
+            void set_metrics_name( const std::string& a_name );
+
             /// If keeping track of file sizes for automatically creating new files, use this to inform the monarch_wrapper that a given number of bytes was written to the file.
             /// This should be called every time a record is written to the file.
-            void record_file_contribution( double a_size );
+            /// a_file_epoch is the file epoch (see stream_wrapper) of the stream pointer the record was written through; a record that
+            /// went to the previous file while a switch was in progress is counted toward that file.
+            void record_file_contribution( uint64_t a_bytes, uint64_t a_file_epoch );
+
+            /// Number of times the wrapper has switched to a continuation file
+            unsigned get_file_switch_count() const;
+            /// Time spent writing the most recently completed file [s]
+            double get_last_file_duration_s() const;
 
         private:
             friend class monarch_on_deck_manager;
+            friend class stream_wrapper;
 
             void do_cancellation( int a_code );
 
+            /// Queue a copy of a record for the I/O thread; returns false if a queued record has failed to be written
+            bool queue_record( stream_wrapper* a_stream, monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq );
+            /// Wait until every queued record has been written
+            void flush_records();
+            /// Write the queued records, in order, until stopped
+            void execute_io_loop();
+            /// Write the remaining queued records and stop the I/O thread
+            void stop_io_thread();
+
+            uint64_t max_file_size_bytes() const;
+            /// Update the on-disk size of the current file, which includes HDF5 metadata; call with f_monarch_mutex locked
+            void update_file_size_on_disk();
+
             monarch_wrapper( const monarch_wrapper& ) = delete;
             monarch_wrapper& operator=( const monarch_wrapper& ) = delete;
 
@@ -217,10 +260,16 @@ namespace fast_daq
             mutable unsigned f_file_count;
 
             double f_max_file_size_mb;
-            std::atomic< double > f_file_size_est_mb;
-            std::condition_variable f_wait_to_write;
+            bool f_preallocate_files;
+            std::atomic< uint64_t > f_file_epoch; // number of switches to a continuation file in this run
+            std::atomic< uint64_t > f_file_bytes_committed[ 2 ]; // indexed by file epoch % 2
+            std::atomic< uint64_t > f_file_bytes_on_disk;
+            std::atomic< unsigned > f_file_switch_count;
+            monarch_time_point_t f_file_start_time;
+            std::atomic< double > f_last_file_duration_s;
+            double f_rotated_files_duration_s;
+            std::string f_metrics_name;
             std::thread* f_switch_thread;
-            std::atomic< bool > f_ok_to_write;
             std::atomic< bool > f_do_switch_flag;
             std::condition_variable f_do_switch_trig;
 
@@ -238,6 +287,27 @@ namespace fast_daq
             std::thread* f_od_thread;
             monarch_on_deck_manager f_monarch_od_manager;
 
+            struct queued_record
+            {
+                stream_wrapper* f_stream;
+                monarch3::RecordIdType f_rec_id;
+                monarch3::TimeType f_rec_time;
+                bool f_is_new_acq;
+                std::vector< uint8_t > f_data;
+            };
+            typedef std::unique_ptr< queued_record > queued_record_ptr;
+
+            std::thread* f_io_thread;
+            std::deque< queued_record_ptr > f_io_queue;
+            std::vector< queued_record_ptr > f_io_spares;
+            std::mutex f_io_mutex;
+            std::condition_variable f_io_work_cv;
+            std::condition_variable f_io_space_cv;
+            unsigned f_io_queue_size;
+            bool f_io_busy; // guarded by f_io_mutex
+            bool f_io_stopping; // guarded by f_io_mutex
+            std::atomic< bool > f_io_failed;
+
     };
 
 
@@ -305,16 +375,25 @@ namespace fast_daq
 
      Provides the ability to write records in a thread-safe synchronized way.
 
-     Thread synchronization strategy:
-       - Owns a mutex to control use of the stream.
-       - Provides lock() and unlock() functions to manually lock and unlock the mutex.
-       - Provides access to a reference to the mutex to allow its use in a lock.
-       - Use of lock() and unlock() should be used for more speed-critical applications, with the understanding that the risks for unintentionally leaving the mutex locked is greater.
+     write_record() hands a copy of the record to the file's I/O thread (see monarch_wrapper), which writes it with write_now().
+
+     Thread synchronization strategy between the I/O thread and file switching (read-copy-update style):
+       - Each file the run is spread across is an epoch; the stream keeps the M3Stream pointers of the current and the
+         previous epoch, and an atomic epoch counter selects the current one.
+       - When switching to a continuation file, monarch_wrapper stores the new pointer in the slot of the next epoch and then
+         advances the epoch counter.
+       - write_now() takes no lock: it announces the epoch it is about to write in (the in-write epoch), checks that the
+         epoch is still current, writes through that epoch's pointer, and counts the record's bytes toward that epoch's file
+         before clearing the announcement.
+       - After advancing the epoch, the switch waits only while a write announced in the retired epoch is still in progress
+         (wait_for_write_to_complete()); writes that start later use the new pointer, so the wait is at most one record.
+       - Records are therefore always written to a valid stream, and writing never waits for a file switch.
+       - Only one thread should write to a given stream.
     */
     class stream_wrapper
     {
         public:
-            stream_wrapper( monarch3::Monarch3&, unsigned a_stream_no, monarch_wrapper* a_monarch_wrapper );
+            stream_wrapper( monarch3::Monarch3&, unsigned a_stream_no, monarch_wrapper* a_monarch_wrapper, uint64_t a_epoch = 0 );
             stream_wrapper( stream_wrapper&& a_orig );
             ~stream_wrapper();
 
@@ -327,21 +406,34 @@ namespace fast_daq
             /// Get the pointer to a particular channel record
             monarch3::M3Record* get_channel_record( unsigned a_chan_no );
 
-            /// Write the record contents to the file
+            /// Queue the record contents to be written to the file; returns false if an earlier record could not be written
             bool write_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq );
 
+            /// Wait until no write to the stream of epoch a_epoch is in progress; used when that epoch's file is retired
+            void wait_for_write_to_complete( uint64_t a_epoch );
+
         private:
             stream_wrapper( const stream_wrapper& ) = delete;
             stream_wrapper& operator=( const stream_wrapper& ) = delete;
 
             friend class monarch_wrapper;
 
+            /// Write the record contents to the file now; called by the file's I/O thread
+            bool write_now( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq );
+            /// Publish the stream of the next epoch; called by monarch_wrapper while switching files
+            void advance_epoch( monarch3::M3Stream* a_stream );
+            monarch3::M3Stream* current_stream() const;
+
+            static constexpr uint64_t s_no_write = UINT64_MAX;
+
             monarch_wrapper* f_monarch_wrapper;
 
-            monarch3::M3Stream* f_stream;
+            std::atomic< monarch3::M3Stream* > f_streams[ 2 ]; // indexed by epoch % 2
+            std::atomic< uint64_t > f_epoch;
+            std::atomic< uint64_t > f_in_write_epoch; // s_no_write when no write is in progress
             bool f_is_valid;
 
-            double f_record_size_mb;
+            uint64_t f_record_n_bytes;
     };
 
 
@@ -393,12 +485,6 @@ namespace fast_daq
         return;
     }
 
-    inline void monarch_on_deck_manager::finish_to_finish_nolock()
-    {
-        f_monarch_to_finish->FinishWriting();
-        f_monarch_to_finish.reset();
-    }
-
 
     //*******************
     // monarch_wrapper
@@ -425,6 +511,39 @@ namespace fast_daq
         return;
     }
 
+    inline void monarch_wrapper::set_preallocate_files( bool a_flag )
+    {
+        f_preallocate_files = a_flag;
+        return;
+    }
+
+    inline void monarch_wrapper::set_io_queue_size( unsigned a_n_records )
+    {
+        f_io_queue_size = a_n_records;
+        return;
+    }
+
+    inline void monarch_wrapper::set_metrics_name( const std::string& a_name )
+    {
+        f_metrics_name = a_name;
+        return;
+    }
+
+    inline unsigned monarch_wrapper::get_file_switch_count() const
+    {
+        return f_file_switch_count.load();
+    }
+
+    inline double monarch_wrapper::get_last_file_duration_s() const
+    {
+        return f_last_file_duration_s.load();
+    }
+
+    inline uint64_t monarch_wrapper::max_file_size_bytes() const
+    {
+        return f_max_file_size_mb > 0. ? static_cast< uint64_t >( f_max_file_size_mb * 1.e6 ) : 0;
+    }
+
     inline void monarch_wrapper::do_cancellation( int a_code )
     {
         f_monarch_od_manager.cancel( a_code );
@@ -461,14 +580,19 @@ namespace fast_daq
         return f_is_valid;
     }
 
+    inline monarch3::M3Stream* stream_wrapper::current_stream() const
+    {
+        return f_streams[ f_epoch.load() % 2 ].load();
+    }
+
     inline monarch3::M3Record* stream_wrapper::get_stream_record()
     {
-        return f_stream->GetStreamRecord();
+        return current_stream()->GetStreamRecord();
     }
 
     inline monarch3::M3Record* stream_wrapper::get_channel_record( unsigned a_chan_no )
     {
-        return f_stream->GetChannelRecord( a_chan_no );
+        return current_stream()->GetChannelRecord( a_chan_no );
     }
 
 } /* namespace fast_daq */
@@ -0,0 +1,37 @@
+/*
+ * trigger_broker.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "trigger_broker.hh"
+
+#include "logger.hh"
+
+namespace fast_daq
+{
+    LOGGER( plog, "trigger_broker" );
+
+    trigger_broker::trigger_broker() :
+            f_channels(),
+            f_mutex()
+    {
+    }
+
+    trigger_broker::~trigger_broker()
+    {
+    }
+
+    trigger_broker::trigger_channel_ptr trigger_broker::get_channel( const std::string& a_name )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        trigger_channel_ptr& t_channel = f_channels[ a_name ];
+        if( ! t_channel )
+        {
+            LDEBUG( plog, "Creating trigger channel <" << a_name << ">" );
+            t_channel = std::make_shared< trigger_channel >( 0 );
+        }
+        return t_channel;
+    }
+
+} /* namespace fast_daq */
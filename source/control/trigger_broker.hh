@@ -0,0 +1,75 @@
+/*
+ * trigger_broker.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_TRIGGER_BROKER_HH_
+#define FAST_DAQ_TRIGGER_BROKER_HH_
+
+#include "singleton.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace fast_daq
+{
+    /*!
+     @class trigger_broker
+     @brief Passes trigger decisions from the nodes that make them to the nodes that act on them.
+
+     @details
+     Triggers are grouped into named channels.  A channel is a counter of the triggers fired on it:
+     a trigger source increments it with fire(), and a trigger sink compares it with the last value it saw.
+     Nodes look up their channel once (get_channel()), so firing and polling a trigger are single atomic
+     operations with no locking; a channel is created the first time either side asks for it.
+
+     The broker carries no timing information: a sink acts on a trigger when it next polls the channel, so the
+     latency between the source and the sink has to be covered by the sink's pre-trigger window.
+
+     Thread safety: all functions are thread-safe.
+     */
+    class trigger_broker : public scarab::singleton< trigger_broker >
+    {
+        public:
+            typedef std::atomic< uint64_t > trigger_channel;
+            typedef std::shared_ptr< trigger_channel > trigger_channel_ptr;
+
+            /// Get the channel with the given name, creating it if needed
+            trigger_channel_ptr get_channel( const std::string& a_name );
+
+            /// Fire a trigger on a channel
+            static void fire( trigger_channel& a_channel );
+            /// Number of triggers fired on a channel so far
+            static uint64_t count( const trigger_channel& a_channel );
+
+        private:
+            std::map< std::string, trigger_channel_ptr > f_channels;
+            std::mutex f_mutex;
+
+        private:
+            friend class scarab::singleton< trigger_broker >;
+            friend class scarab::destroyer< trigger_broker >;
+
+            trigger_broker();
+            virtual ~trigger_broker();
+    };
+
+    inline void trigger_broker::fire( trigger_channel& a_channel )
+    {
+        a_channel.fetch_add( 1, std::memory_order_release );
+        return;
+    }
+
+    inline uint64_t trigger_broker::count( const trigger_channel& a_channel )
+    {
+        return a_channel.load( std::memory_order_acquire );
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_TRIGGER_BROKER_HH_ */
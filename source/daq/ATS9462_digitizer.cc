@@ -6,18 +6,31 @@
  */
 
 #include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include "daq_control.hh"
 #include "real_time_data.hh"
 
 #include "ATS9462_digitizer.hh"
 #include "fast_daq_error.hh"
+#include "load_shedder.hh"
+#include "run_metrics.hh"
+#include "sample_kernels.hh"
 
 using midge::stream;
 
 
 namespace fast_daq
 {
+    namespace
+    {
+        // how long the thread sleeps between checks for instructions when it has no buffers to read; it may be
+        // running at real-time priority, so it must not spin
+        const std::chrono::milliseconds s_idle_poll_period( 1 );
+    }
+
     std::string ats9462_digitizer::reference_source_to_string( reference_source_t a_reference_source )
     {
         switch (a_reference_source) {
@@ -35,6 +48,53 @@ namespace fast_daq
         throw fast_daq::error() << "string <" << a_reference_source << "> not recognized as valid reference_source type";
     }
 
+    std::string ats9462_digitizer::overrun_policy_to_string( overrun_policy_t a_policy )
+    {
+        switch (a_policy) {
+            case ats9462_digitizer::overrun_policy_t::drain: return "drain";
+            case ats9462_digitizer::overrun_policy_t::restart: return "restart";
+            default: throw fast_daq::error() << "overrun_policy value <" << static_cast< unsigned >( a_policy ) << "> not recognized";
+        }
+    }
+    ats9462_digitizer::overrun_policy_t ats9462_digitizer::string_to_overrun_policy( const std::string& a_policy )
+    {
+        if( a_policy == overrun_policy_to_string( ats9462_digitizer::overrun_policy_t::drain ) ) return overrun_policy_t::drain;
+        if( a_policy == overrun_policy_to_string( ats9462_digitizer::overrun_policy_t::restart ) ) return overrun_policy_t::restart;
+        throw fast_daq::error() << "string <" << a_policy << "> not recognized as valid overrun_policy type";
+    }
+
+    std::string ats9462_digitizer::sample_layout_to_string( sample_layout_t a_layout )
+    {
+        switch (a_layout) {
+            case ats9462_digitizer::sample_layout_t::interleaved: return "interleaved";
+            case ats9462_digitizer::sample_layout_t::contiguous: return "contiguous";
+            default: throw fast_daq::error() << "sample_layout value <" << static_cast< unsigned >( a_layout ) << "> not recognized";
+        }
+    }
+    ats9462_digitizer::sample_layout_t ats9462_digitizer::string_to_sample_layout( const std::string& a_layout )
+    {
+        if( a_layout == sample_layout_to_string( ats9462_digitizer::sample_layout_t::interleaved ) ) return sample_layout_t::interleaved;
+        if( a_layout == sample_layout_to_string( ats9462_digitizer::sample_layout_t::contiguous ) ) return sample_layout_t::contiguous;
+        throw fast_daq::error() << "string <" << a_layout << "> not recognized as valid sample_layout type";
+    }
+
+    std::string ats9462_digitizer::channel_mask_to_string( U32 a_channel_mask )
+    {
+        switch (a_channel_mask) {
+            case CHANNEL_A: return "A";
+            case CHANNEL_B: return "B";
+            case CHANNEL_A | CHANNEL_B: return "AB";
+            default: throw fast_daq::error() << "channel mask <" << a_channel_mask << "> not recognized";
+        }
+    }
+    U32 ats9462_digitizer::string_to_channel_mask( const std::string& a_channels )
+    {
+        if( a_channels == channel_mask_to_string( CHANNEL_A ) ) return CHANNEL_A;
+        if( a_channels == channel_mask_to_string( CHANNEL_B ) ) return CHANNEL_B;
+        if( a_channels == channel_mask_to_string( CHANNEL_A | CHANNEL_B ) ) return CHANNEL_A | CHANNEL_B;
+        throw fast_daq::error() << "string <" << a_channels << "> not recognized as a valid channel selection";
+    }
+
     REGISTER_NODE_AND_BUILDER( ats9462_digitizer, "ats9462", ats9462_digitizer_binding );
 
     LOGGER( flog, "ats9462_digitizer" );
@@ -60,13 +120,35 @@ namespace fast_daq
         f_trigger_timeout_sec( 0.01 ),
         f_chunk_counter( 0 ),
         f_overrun_collected( 0 ),
+        f_huge_pages( dma_buffer_pool::huge_page_mode_t::automatic ),
+        f_numa_node( -1 ),
+        f_pci_address(),
+        f_lock_dma_buffers( false ),
+        f_overrun_policy( overrun_policy_t::restart ),
+        f_sample_layout( sample_layout_t::interleaved ),
+        f_restart_post_count( 256 ),
+        f_shed_watermark( 0.5 ),
+        f_resume_watermark( 0.25 ),
+        f_drop_watermark( 0.9 ),
+        f_overrun_count( 0 ),
+        f_buffers_dropped( 0 ),
+        f_acquisition_id( 0 ),
+        f_shed_requests( 0 ),
+        f_peak_backlog( 0. ),
         f_sample_rate_to_code(),
         f_channel_count( 1 ),
         f_channel_mask( CHANNEL_A ),
         f_bits_per_sample(),
         f_max_samples_per_channel(),
         f_paused( true ),
+        f_dma_pool(),
         f_board_buffers(),
+        f_posted_buffers(),
+        f_unposted_index( 0 ),
+        f_fill_reference(),
+        f_buffers_read_since_start( 0 ),
+        f_next_sample_index( 0 ),
+        f_samples_lost_pending( 0 ),
         f_buffers_completed( 0 )
     {
         set_internal_maps();
@@ -125,6 +207,15 @@ namespace fast_daq
         float t_dynm_range = 2. * static_cast<float>(f_input_mag_range) / 1000.;
         //out_buffer< 0 >().call( &real_time_data::set_dynamic_range, 2. * static_cast<float>(f_input_mag_range) / 1000. );
         out_buffer< 0 >().call( &real_time_data::set_dynamic_range, t_dynm_range );
+        out_buffer< 0 >().call( &real_time_data::set_bits_per_sample, unsigned(f_bits_per_sample) );
+        // the second stream only carries data when both channels are acquired
+        out_buffer< 1 >().initialize( f_out_length );
+        if( f_channel_count == 2 )
+        {
+            out_buffer< 1 >().call( &real_time_data::allocate_array, f_samples_per_buffer );
+            out_buffer< 1 >().call( &real_time_data::set_dynamic_range, t_dynm_range );
+            out_buffer< 1 >().call( &real_time_data::set_bits_per_sample, unsigned(f_bits_per_sample) );
+        }
         // configure the digitizer board
         configure_board();
         allocate_buffers();
@@ -134,6 +225,7 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             //TODO something interesting here?
             while (! is_canceled() )
             {
@@ -157,12 +249,18 @@ namespace fast_daq
                         std::shared_ptr< daq_control > t_daq_control = std::dynamic_pointer_cast< daq_control >( use_run_control() );
                         t_daq_control->stop_run();
                         check_return_code_macro( AlazarAbortAsyncRead, f_board_handle );
+                        // wait for the pause that stop_run() will send
+                        std::this_thread::sleep_for( s_idle_poll_period );
                     }
                     else
                     {
                         process_a_buffer();
                     }
                 }
+                else
+                {
+                    std::this_thread::sleep_for( s_idle_poll_period );
+                }
             }
         }
         catch( std::exception& )
@@ -176,6 +274,7 @@ namespace fast_daq
         LDEBUG( flog, "in finalize... ");
         clear_buffers();
         out_buffer< 0 >().finalize();
+        out_buffer< 1 >().finalize();
     }
 
     void ats9462_digitizer::check_return_code( RETURN_CODE a_return_code, const std::string& an_action, const std::string& a_file_line )
@@ -212,9 +311,13 @@ namespace fast_daq
         }
 
         ALAZAR_INPUT_RANGES this_input_range = f_input_range_to_code.left.at( f_input_mag_range );
-        check_return_code_macro( AlazarInputControlEx, f_board_handle, f_channel_mask, DC_COUPLING, this_input_range, IMPEDANCE_50_OHM );
-
-        check_return_code_macro( AlazarSetBWLimit, f_board_handle, f_channel_mask, 0 );
+        // input settings are per channel, not per mask
+        for( U32 t_channel : { U32(CHANNEL_A), U32(CHANNEL_B) } )
+        {
+            if( ( f_channel_mask & t_channel ) == 0 ) continue;
+            check_return_code_macro( AlazarInputControlEx, f_board_handle, t_channel, DC_COUPLING, this_input_range, IMPEDANCE_50_OHM );
+            check_return_code_macro( AlazarSetBWLimit, f_board_handle, t_channel, 0 );
+        }
 
 
         check_return_code_macro( AlazarSetTriggerOperation, f_board_handle, TRIG_ENGINE_OP_J, TRIG_ENGINE_J, TRIG_CHAN_A, TRIGGER_SLOPE_POSITIVE, 150, TRIG_ENGINE_K, TRIG_DISABLE, TRIGGER_SLOPE_POSITIVE, 128);
@@ -233,15 +336,20 @@ namespace fast_daq
     void ats9462_digitizer::allocate_buffers()
     {
         LINFO( flog, "allocating DMA buffers" );
+        int t_numa_node = f_numa_node;
+        if( t_numa_node < 0 )
+        {
+            // AlazarTech's PCI vendor ID
+            t_numa_node = f_pci_address.empty() ? dma_buffer_pool::numa_node_of_pci_vendor( 0x1141 ) : dma_buffer_pool::numa_node_of_pci_device( f_pci_address );
+            if( t_numa_node < 0 ) LINFO( flog, "NUMA node of the digitizer not found; DMA buffer placement is left to the kernel" );
+        }
+        //TODO need to make sure that bytes_per_buffer cannot be changed via anything configurable, unless this is redone
+        f_dma_pool.allocate( bytes_per_buffer(), f_dma_buffer_count, f_huge_pages, t_numa_node );
+        if( f_lock_dma_buffers ) f_dma_pool.lock();
+        f_board_buffers.reserve( f_dma_buffer_count );
         for (uint buffer_index = 0; buffer_index<f_dma_buffer_count; buffer_index++)
         {
-            //TODO need to make sure that bytes_per_buffer cannot be changed via anything configurable, unless this is redone
-            f_board_buffers.push_back( (U16*)valloc(bytes_per_buffer()) );
-            if (f_board_buffers.back() == NULL)
-            {
-                clear_buffers();
-                throw fast_daq::error() << "Error: unable to allocate buffer";
-            }
+            f_board_buffers.push_back( static_cast< U16* >( f_dma_pool.buffer( buffer_index ) ) );
         }
     }
 
@@ -250,19 +358,15 @@ namespace fast_daq
         LDEBUG( flog, "clearing up DMA buffers" );
         check_return_code_macro( AlazarAbortAsyncRead, f_board_handle );
         LDEBUG( flog, "async read abort sent to board" );
-        for (std::vector<U16*>::iterator a_buffer=f_board_buffers.begin(); a_buffer != f_board_buffers.end(); )
-        {
-            if (*a_buffer != nullptr)
-            {
-                free(*a_buffer);
-            }
-            f_board_buffers.erase(a_buffer);
-        }
+        f_posted_buffers.clear();
+        f_board_buffers.clear();
+        f_dma_pool.release();
     }
 
-    void ats9462_digitizer::commence_buffer_collection()
+    void ats9462_digitizer::commence_buffer_collection( U32 a_initial_posts )
     {
         U32 adma_flags = ADMA_EXTERNAL_STARTCAPTURE | ADMA_TRIGGERED_STREAMING;
+        if( f_channel_count == 2 && f_sample_layout == sample_layout_t::interleaved ) adma_flags |= ADMA_INTERLEAVE_SAMPLES;
         check_return_code_macro( AlazarBeforeAsyncRead, f_board_handle,
                                                         f_channel_mask,
                                                         0, //per example, "Must be 0"
@@ -272,41 +376,135 @@ namespace fast_daq
                                                         adma_flags
                                );
         LINFO( flog, "board pre-read complete" );
-        //give the board all buffers
+        //give the board the initial buffers; any others are posted as buffers are read
         f_overrun_collected = 0;
-        for (U16* a_buffer : f_board_buffers)
-        {
-            check_return_code_macro( AlazarPostAsyncBuffer, f_board_handle, a_buffer, bytes_per_buffer() );
-        }
+        f_posted_buffers.clear();
+        f_unposted_index = 0;
+        post_pending_buffers( a_initial_posts == 0 ? f_board_buffers.size() : a_initial_posts );
         f_next_read_buffer = 0;
-        LINFO( flog, "buffers posted to board" );
+        LINFO( flog, f_posted_buffers.size() << " buffers posted to board" );
         // arm the trigger to start immediately
         check_return_code_macro( AlazarStartCapture, f_board_handle );
+        f_fill_reference = std::chrono::steady_clock::now();
+        f_buffers_read_since_start = 0;
+        f_next_sample_index = 0;
+        f_samples_lost_pending = 0;
         LDEBUG( flog, "digitizer trigger armed, buffer collection should begin" );
     }
 
+    void ats9462_digitizer::post_buffer( U16* a_buffer )
+    {
+        check_return_code_macro( AlazarPostAsyncBuffer, f_board_handle, a_buffer, bytes_per_buffer() );
+        f_posted_buffers.push_back( a_buffer );
+    }
+
+    void ats9462_digitizer::post_pending_buffers( U32 a_count )
+    {
+        for( U32 i_post = 0; i_post < a_count && f_unposted_index < f_board_buffers.size(); ++i_post )
+        {
+            post_buffer( f_board_buffers[ f_unposted_index ] );
+            ++f_unposted_index;
+        }
+    }
+
+    void ats9462_digitizer::handle_overrun( bool a_can_drain )
+    {
+        ++f_overrun_count;
+        run_metrics::get_instance()->add( get_name() + ".overruns" );
+        if( f_overrun_policy == overrun_policy_t::drain && a_can_drain )
+        {
+            LWARN( flog, "DMA buffer overrun detected; flushing buffers then will increment acquisition" );
+            f_overrun_collected = 1;
+            return;
+        }
+        LWARN( flog, "DMA buffer overrun detected; restarting acquisition with " << f_restart_post_count << " buffers posted" );
+        check_return_code_macro( AlazarAbortAsyncRead, f_board_handle );
+        ++f_acquisition_id;
+        commence_buffer_collection( f_restart_post_count );
+    }
+
+    double ats9462_digitizer::estimate_backlog()
+    {
+        if( f_posted_buffers.empty() ) return 0.;
+        double t_elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - f_fill_reference ).count();
+        double t_unread = t_elapsed * buffers_per_sec() - double(f_buffers_read_since_start);
+        double t_backlog = std::min( std::max( t_unread / double(f_posted_buffers.size()), 0. ), 1. );
+        if( t_backlog > f_peak_backlog ) f_peak_backlog = t_backlog;
+        return t_backlog;
+    }
+
+    void ats9462_digitizer::update_load_shedding( double a_backlog )
+    {
+        if( a_backlog >= f_shed_watermark )
+        {
+            if( load_shedder::get_instance()->set_shedding( true ) )
+            {
+                ++f_shed_requests;
+                run_metrics::get_instance()->add( get_name() + ".shed-requests" );
+                LWARN( flog, "DMA backlog at " << a_backlog << " of posted buffers; asking downstream nodes to shed load" );
+            }
+        }
+        else if( a_backlog <= f_resume_watermark )
+        {
+            if( load_shedder::get_instance()->set_shedding( false ) )
+            {
+                LINFO( flog, "DMA backlog back down to " << a_backlog << " of posted buffers; load shedding withdrawn" );
+            }
+        }
+    }
+
+    void ats9462_digitizer::publish_metrics()
+    {
+        run_metrics* t_metrics = run_metrics::get_instance();
+        t_metrics->set( get_name() + ".buffers-completed", f_buffers_completed );
+        t_metrics->set( get_name() + ".overruns", f_overrun_count );
+        t_metrics->set( get_name() + ".buffers-dropped", f_buffers_dropped );
+        t_metrics->set( get_name() + ".acquisitions", f_acquisition_id + 1 );
+        t_metrics->set( get_name() + ".shed-requests", f_shed_requests );
+        t_metrics->set( get_name() + ".peak-backlog", f_peak_backlog );
+        return;
+    }
+
+    void ats9462_digitizer::report_metrics()
+    {
+        publish_metrics();
+        LINFO( flog, "buffers completed: " << f_buffers_completed << "; overruns: " << f_overrun_count << "; buffers dropped: " << f_buffers_dropped
+                << "; acquisitions: " << f_acquisition_id + 1
+                << "; load-shedding requests: " << f_shed_requests << "; peak DMA backlog: " << f_peak_backlog );
+    }
+
     void ats9462_digitizer::process_instructions()
     {
         if( f_paused && use_instruction() == midge::instruction::resume )
         {
             LINFO( flog, "ATS9462 digitizer resuming");
             if( ! out_stream< 0 >().set( midge::stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+            if( f_channel_count == 2 && ! out_stream< 1 >().set( midge::stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 1 error while starting";
             f_buffers_completed = 0;
             f_chunk_counter = 0;
+            f_acquisition_id = 0;
+            f_overrun_count = 0;
+            f_buffers_dropped = 0;
+            f_shed_requests = 0;
+            f_peak_backlog = 0.;
+            publish_metrics();
             f_paused = false;
             LINFO( flog, "run status members set" );
             //initial run setup for the board
-            commence_buffer_collection();
+            commence_buffer_collection( f_dma_buffer_count );
         }
         else if( ! f_paused && use_instruction() == midge::instruction::pause )
         {
             LINFO( flog, "ATS9462 digitizer pausing");
             if( ! out_stream< 0 >().set( midge::stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+            if( f_channel_count == 2 && ! out_stream< 1 >().set( midge::stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 1 error while stopping";
             f_paused = true;
             //Note: this step may have already have been done when the requested buffer count was reached
             //      it is not a problem for the function to be called again here.
             check_return_code_macro( AlazarAbortAsyncRead, f_board_handle );
             LDEBUG( flog, "abort async read sent to board" );
+            load_shedder::get_instance()->set_shedding( false );
+            report_metrics();
         }
         else
         {
@@ -317,46 +515,120 @@ namespace fast_daq
     void ats9462_digitizer::process_a_buffer()
     {
         LTRACE( flog, "in process_a_buffer" );
+        if( f_posted_buffers.empty() )
+        {
+            // nothing is posted, so the board has nowhere to write: an overrun, whatever the policy, so start a new acquisition
+            LWARN( flog, "no DMA buffers are posted to the board" );
+            handle_overrun( false );
+            return;
+        }
         //grab the next buffer, once it is filled by the digitizer
-        U16* this_buffer = f_board_buffers.at( f_next_read_buffer % f_board_buffers.size() );
-        check_return_code_macro( AlazarWaitAsyncBufferComplete, f_board_handle, this_buffer, 5000 );
+        U16* this_buffer = f_posted_buffers.front();
+        std::chrono::steady_clock::time_point t_wait_start = std::chrono::steady_clock::now();
+        try
+        {
+            check_return_code_macro( AlazarWaitAsyncBufferComplete, f_board_handle, this_buffer, 5000 );
+        }
+        catch( buffer_overflow& )
+        { // the board has stopped; nothing more can be read from this acquisition
+            handle_overrun( false );
+            return;
+        }
+        f_posted_buffers.pop_front();
         ++f_next_read_buffer;
-        //copy the int array into the output stream
-        real_time_data* time_data_out = out_stream< 0 >().data();
-        time_data_out->set_chunk_counter( f_chunk_counter );
-        std::memcpy( time_data_out->get_time_series(), &this_buffer[0], bytes_per_buffer() );
-        if( !out_stream< 0 >().set( stream::s_run ) )
+        ++f_buffers_read_since_start;
+        // if we had to wait for the board, there is no backlog; use that to correct the estimate
+        std::chrono::steady_clock::time_point t_now = std::chrono::steady_clock::now();
+        if( t_now - t_wait_start > std::chrono::microseconds( 100 ) )
         {
-            LERROR( flog, "error pushing time series to output stream" );
+            f_fill_reference = t_now - std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                    std::chrono::duration< double >( double(f_buffers_read_since_start) / buffers_per_sec() ) );
+        }
+        double t_backlog = estimate_backlog();
+        update_load_shedding( t_backlog );
+
+        if( f_drop_watermark < 1. && t_backlog >= f_drop_watermark )
+        {
+            // about to overrun: give the buffer straight back rather than wait for downstream
+            ++f_buffers_dropped;
+            run_metrics::get_instance()->add( get_name() + ".buffers-dropped" );
+            f_samples_lost_pending += f_samples_per_buffer;
+            LDEBUG( flog, "DMA backlog at " << t_backlog << "; dropping chunk " << f_chunk_counter << " (samples " << f_next_sample_index << " to "
+                    << f_next_sample_index + f_samples_per_buffer << " of acquisition " << f_acquisition_id << ")" );
+        }
+        else
+        {
+            send_buffer( this_buffer );
         }
-        // if we're not in a buffer overrun, try to return the buffer to the board
+        // before any restart below, which starts the count again
+        f_next_sample_index += f_samples_per_buffer;
+        // if we're not in a buffer overrun, try to return the buffer to the board, along with a few not yet posted after a restart
         if ( ! f_overrun_collected )
         {
             try
             {
-                check_return_code_macro( AlazarPostAsyncBuffer, f_board_handle, this_buffer, bytes_per_buffer() );
+                post_buffer( this_buffer );
+                post_pending_buffers( 4 );
             }
             catch( buffer_overflow& )
-            { // if posting the buffer fails, we're in an overrun; collect all buffers then restart
-                LWARN( flog, "DMA buffer overrun detected; flushing buffers then will increment acquisition" );
-                f_overrun_collected = 1;
+            { // if posting the buffer fails, we're in an overrun
+                handle_overrun( true );
             }
         }
         else
         {
             ++f_overrun_collected;
-            LDEBUG( flog, "overrun collection now at " << f_overrun_collected << "/" << f_dma_buffer_count );
-        }
-        if ( f_overrun_collected == f_dma_buffer_count )
-        {
-            LINFO( flog, "all buffers cleared, incrementing acquistition number and restarting digitization" );
-            ++f_chunk_counter;
-            commence_buffer_collection();
+            LDEBUG( flog, "overrun collection now at " << f_overrun_collected << ", " << f_posted_buffers.size() << " buffers left" );
+            if ( f_posted_buffers.empty() )
+            {
+                LINFO( flog, "all buffers cleared, incrementing acquistition number and restarting digitization" );
+                ++f_acquisition_id;
+                commence_buffer_collection( f_dma_buffer_count );
+            }
         }
         ++f_buffers_completed;
         ++f_chunk_counter;
     }
 
+    void ats9462_digitizer::send_buffer( const U16* a_buffer )
+    {
+        //copy the int array into the output stream(s)
+        real_time_data* time_data_out = out_stream< 0 >().data();
+        time_data_out->set_chunk_counter( f_chunk_counter );
+        time_data_out->set_acquisition_id( f_acquisition_id );
+        time_data_out->set_first_sample_index( f_next_sample_index );
+        time_data_out->set_sample_span( f_samples_per_buffer );
+        time_data_out->set_samples_lost( f_samples_lost_pending );
+        f_samples_lost_pending = 0;
+        if( f_channel_count == 1 )
+        {
+            std::memcpy( time_data_out->get_time_series(), &a_buffer[0], bytes_per_buffer() );
+        }
+        else
+        {
+            real_time_data* time_data_out_b = out_stream< 1 >().data();
+            time_data_out_b->set_chunk_counter( f_chunk_counter );
+            time_data_out_b->copy_sequence( *time_data_out );
+            if( f_sample_layout == sample_layout_t::interleaved )
+            {
+                deinterleave_two_channels( a_buffer, time_data_out->get_time_series(), time_data_out_b->get_time_series(), f_samples_per_buffer );
+            }
+            else
+            {
+                std::memcpy( time_data_out->get_time_series(), &a_buffer[0], f_samples_per_buffer * sizeof(U16) );
+                std::memcpy( time_data_out_b->get_time_series(), &a_buffer[f_samples_per_buffer], f_samples_per_buffer * sizeof(U16) );
+            }
+        }
+        if( !out_stream< 0 >().set( stream::s_run ) )
+        {
+            LERROR( flog, "error pushing time series to output stream" );
+        }
+        if( f_channel_count == 2 && !out_stream< 1 >().set( stream::s_run ) )
+        {
+            LERROR( flog, "error pushing channel B time series to output stream" );
+        }
+    }
+
     // Derived properties
     INT64 ats9462_digitizer::samples_per_acquisition()
     {
@@ -378,6 +650,11 @@ namespace fast_daq
         return (U32)((samples_per_acquisition() + f_samples_per_buffer -1) / f_samples_per_buffer);
     }
 
+    double ats9462_digitizer::buffers_per_sec()
+    {
+        return double(f_samples_per_sec/f_decimation_factor) / double(f_samples_per_buffer);
+    }
+
     /* ats9462_digitizer_binding class */
     /***********************************/
     // ats9462_digitizer_binding methods
@@ -399,27 +676,53 @@ namespace fast_daq
 	f_decimation_factor = a_decimation_factor;
     }
 
-    void ats9462_digitizer_binding::do_apply_config(ats9462_digitizer* a_node, const scarab::param_node& a_config ) const
+    void ats9462_digitizer_binding::do_apply_node_config(ats9462_digitizer* a_node, const scarab::param_node& a_config ) const
     {
 	      a_node->set_reference_source_and_decimation( a_config.get_value( "reference-source", a_node->get_reference_source_str() ), a_config.get_value( "decimation-factor", a_node->get_decimation_factor() ) );
 
 	      LINFO(flog, "do apply config reference-source: " + a_node->get_reference_source_str())
+        a_node->set_channels( a_config.get_value( "channels", a_node->get_channels_str() ) );
+        a_node->set_sample_layout( a_config.get_value( "sample-layout", a_node->get_sample_layout_str() ) );
         a_node->set_samples_per_buffer( a_config.get_value( "samples-per-buffer", a_node->get_samples_per_buffer() ) );
         a_node->set_out_length( a_config.get_value( "out-length", a_node->get_out_length() ) );
         a_node->set_dma_buffer_count( a_config.get_value( "dma-buffer-count", a_node->get_dma_buffer_count() ) );
         a_node->set_samples_per_sec( a_config.get_value( "samples-per-sec", a_node->get_samples_per_sec() ) );
         a_node->set_acquisition_length_sec( a_config.get_value( "acquisition-length-sec", a_node->get_acquisition_length_sec() ) );
+        a_node->set_huge_pages( a_config.get_value( "huge-pages", a_node->get_huge_pages_str() ) );
+        a_node->set_numa_node( a_config.get_value( "numa-node", a_node->get_numa_node() ) );
+        a_node->set_pci_address( a_config.get_value( "pci-address", a_node->get_pci_address() ) );
+        a_node->set_lock_dma_buffers( a_config.get_value( "lock-dma-buffers", a_node->get_lock_dma_buffers() ) );
+        a_node->set_overrun_policy( a_config.get_value( "overrun-policy", a_node->get_overrun_policy_str() ) );
+        a_node->set_restart_post_count( a_config.get_value( "restart-post-count", a_node->get_restart_post_count() ) );
+        a_node->set_shed_watermark( a_config.get_value( "shed-watermark", a_node->get_shed_watermark() ) );
+        a_node->set_resume_watermark( a_config.get_value( "resume-watermark", a_node->get_resume_watermark() ) );
+        a_node->set_drop_watermark( a_config.get_value( "drop-watermark", a_node->get_drop_watermark() ) );
+        if( a_node->get_resume_watermark() > a_node->get_shed_watermark() )
+        {
+            throw fast_daq::error() << "resume-watermark (" << a_node->get_resume_watermark() << ") must not be above shed-watermark (" << a_node->get_shed_watermark() << ")";
+        }
     }
 
-    void ats9462_digitizer_binding::do_dump_config( const ats9462_digitizer* a_node, scarab::param_node& a_config ) const
+    void ats9462_digitizer_binding::do_dump_node_config( const ats9462_digitizer* a_node, scarab::param_node& a_config ) const
     {
         a_config.add( "reference-source", scarab::param_value( ats9462_digitizer::reference_source_to_string( a_node->get_reference_source() ) ) );
+        a_config.add( "channels", scarab::param_value( a_node->get_channels_str() ) );
+        a_config.add( "sample-layout", scarab::param_value( a_node->get_sample_layout_str() ) );
         a_config.add( "samples-per-buffer", scarab::param_value( a_node->get_samples_per_buffer() ) );
         a_config.add( "out-length", scarab::param_value( a_node->get_out_length() ) );
         a_config.add( "dma-buffer-count", scarab::param_value( a_node->get_dma_buffer_count() ) );
         a_config.add( "samples-per-sec", scarab::param_value( a_node->get_samples_per_sec() ) );
         a_config.add( "decimation-factor", scarab::param_value( a_node->get_decimation_factor() ) );
         a_config.add( "acquisition-length-sec", scarab::param_value( a_node->get_acquisition_length_sec() ) );
+        a_config.add( "huge-pages", scarab::param_value( a_node->get_huge_pages_str() ) );
+        a_config.add( "numa-node", scarab::param_value( a_node->get_numa_node() ) );
+        a_config.add( "pci-address", scarab::param_value( a_node->get_pci_address() ) );
+        a_config.add( "lock-dma-buffers", scarab::param_value( a_node->get_lock_dma_buffers() ) );
+        a_config.add( "overrun-policy", scarab::param_value( a_node->get_overrun_policy_str() ) );
+        a_config.add( "restart-post-count", scarab::param_value( a_node->get_restart_post_count() ) );
+        a_config.add( "shed-watermark", scarab::param_value( a_node->get_shed_watermark() ) );
+        a_config.add( "resume-watermark", scarab::param_value( a_node->get_resume_watermark() ) );
+        a_config.add( "drop-watermark", scarab::param_value( a_node->get_drop_watermark() ) );
     }
 
 } /* namespace fast_daq */
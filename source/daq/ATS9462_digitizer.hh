@@ -18,10 +18,15 @@
 
 // sandfly includes
 #include "node_builder.hh"
+#include "thread_tuning.hh"
 
 #include "producer.hh"
 #include "control_access.hh"
 #include "fast_daq_error.hh"
+#include "dma_buffer_pool.hh"
+
+#include <chrono>
+#include <deque>
 
 
 #define check_return_code_macro( function, ... ) \
@@ -40,24 +45,53 @@ namespace fast_daq
      @details
 
      A node for continuous streaming of time samples from the digitizer. Many intuitive features are *not* currently supported:
-     - there is no support for selecting inputs (only A is supported)
+     - only the input selection "A", "B" or both ("AB") is supported; with both, the channels are acquired together and split
+       into two output streams
      - there is no support for driving the sampling using the external input
      - there is no support for making changes to the board's configuration after the initial startup (you can set values but they will not be applied and behavior is undefined).
 
      Node type: "ats9462"
 
      Available configuration values:
-     - "samples-per-buffer": int -- number of real-valued samples to include in each chunk of data
+     - "channels": string -- inputs to acquire: "A", "B" or "AB" (default: "A")
+     - "sample-layout": string -- with two channels, how the board arranges them in each DMA buffer: "interleaved" (A0 B0 A1 B1 ...,
+       split by a vectorized kernel while copying to the outputs) or "contiguous" (all of A, then all of B) (default: "interleaved")
+     - "samples-per-buffer": int -- number of real-valued samples per channel to include in each chunk of data
      - "out-length": int -- number of output buffer slots
      - "dma-buffer-count": int -- the number of DMA buffers to use between the digitzer board and the application
      - "samples-per-sec": int -- number of samples per second (must be in the set of allowed rates in the digitizer library) (default=25000000)
      - "acquisition-length-sec": double -- the duration of the run in seconds (will be used to compute the integer number of buffers to collect)
+     - "huge-pages": string -- page size backing the DMA buffer pool: "auto", "1GB", "2MB", "transparent" or "none"; "auto" uses the largest available (default: "auto")
+     - "numa-node": int -- NUMA node on which to place the DMA buffer pool; -1 places it on the node of the board's PCIe slot, if that can be found (default: -1)
+     - "overrun-policy": string -- what to do when the board overruns the DMA buffers: "drain" reads out every buffer already posted
+       before starting a new acquisition; "restart" aborts the read at once and restarts with restart-post-count buffers posted,
+       posting the rest as buffers are read (default: "restart")
+     - "restart-post-count": int -- number of buffers posted before a restart begins capturing; 0 posts all of them (default: 256)
+     - "shed-watermark": double -- estimated fraction of the posted buffers holding unread data above which downstream nodes are
+       asked to skip optional work (see load_shedder) (default: 0.5)
+     - "resume-watermark": double -- fraction below which the shedding request is withdrawn (default: 0.25)
+     - "drop-watermark": double -- fraction above which buffers are returned to the board without being sent downstream, to
+       avoid an overrun; dropped buffers still advance the chunk counter and sample index, and are reported as samples lost on the next
+       chunk sent; 1 or more disables dropping (default: 0.9)
+     - "lock-dma-buffers": bool -- lock the DMA buffer pool in RAM with mlock, so none of it can be paged out (default: false)
+     - "pci-address": string -- PCI address of the board (e.g. "0000:3b:00.0"), used to find its NUMA node; if empty, the first AlazarTech device found is used (default: "")
+
+     The fraction of the posted buffers holding unread data is estimated from the time since capture started and the
+     number of buffers read, and recalibrated whenever a read has to wait for the board.  Overruns, dropped buffers and
+     shedding requests are counted per run, published as run metrics as they happen (see run_metrics; "<node-name>.overruns",
+     ".buffers-dropped" and ".shed-requests"), and logged, along with the buffers completed, acquisitions and peak backlog,
+     when the run is paused.
+
+     Each output chunk is sequenced (see sequenced_data): the acquisition ID starts at 0 with each run and goes up by one
+     with each restart after an overrun; the first sample index counts the samples per channel since the start of the
+     acquisition, including those of dropped buffers.  The chunk counter counts the buffers read in the run.
 
      Output Streams
-     - 0: real_time_data
+     - 0: real_time_data -- the first selected channel
+     - 1: real_time_data -- channel B, when both channels are acquired (unused otherwise)
 
     */
-    class ats9462_digitizer : public midge::_producer< midge::type_list< real_time_data > >, public sandfly::control_access
+    class ats9462_digitizer : public midge::_producer< midge::type_list< real_time_data, real_time_data > >, public sandfly::control_access, public thread_tuning
     {
         public:
             enum class reference_source_t
@@ -71,6 +105,25 @@ namespace fast_daq
             static std::string reference_source_to_string( reference_source_t a_reference_source );
             static reference_source_t string_to_reference_source( const std::string& a_reference_source );
 
+            enum class overrun_policy_t
+            {
+                drain,
+                restart
+            };
+            static std::string overrun_policy_to_string( overrun_policy_t a_policy );
+            static overrun_policy_t string_to_overrun_policy( const std::string& a_policy );
+
+            enum class sample_layout_t
+            {
+                interleaved,
+                contiguous
+            };
+            static std::string sample_layout_to_string( sample_layout_t a_layout );
+            static sample_layout_t string_to_sample_layout( const std::string& a_layout );
+
+            static std::string channel_mask_to_string( U32 a_channel_mask );
+            static U32 string_to_channel_mask( const std::string& a_channels );
+
         private:
             typedef boost::bimap< uint32_t, ALAZAR_SAMPLE_RATES > sample_rate_code_map_t;
             typedef sample_rate_code_map_t::value_type rate_mapping_t;
@@ -108,8 +161,35 @@ namespace fast_daq
         mv_accessible( uint64_t, out_length );
         mv_accessible( double, trigger_delay_sec );
         mv_accessible( double, trigger_timeout_sec );
-        mv_accessible( unsigned, chunk_counter );
+        mv_accessible( uint64_t, chunk_counter );
         mv_accessible( unsigned, overrun_collected );
+        mv_accessible( dma_buffer_pool::huge_page_mode_t, huge_pages );
+        mv_accessible( int, numa_node );
+        mv_accessible( std::string, pci_address );
+        mv_accessible( bool, lock_dma_buffers );
+        mv_accessible( overrun_policy_t, overrun_policy );
+        mv_accessible( sample_layout_t, sample_layout );
+        mv_accessible( U32, restart_post_count );
+        mv_accessible( double, shed_watermark );
+        mv_accessible( double, resume_watermark );
+        mv_accessible( double, drop_watermark );
+
+        // per-run metrics
+        mv_accessible_noset( unsigned, overrun_count );
+        mv_accessible_noset( unsigned, buffers_dropped );
+        mv_accessible_noset( uint64_t, acquisition_id );
+        mv_accessible_noset( unsigned, shed_requests );
+        mv_accessible_noset( double, peak_backlog );
+
+        public:
+            void set_huge_pages( const std::string& a_mode );
+            std::string get_huge_pages_str() const;
+            void set_overrun_policy( const std::string& a_policy );
+            std::string get_overrun_policy_str() const;
+            void set_sample_layout( const std::string& a_layout );
+            std::string get_sample_layout_str() const;
+            void set_channels( const std::string& a_channels );
+            std::string get_channels_str() const;
 
         private:
             sample_rate_code_map_t f_sample_rate_to_code;
@@ -120,7 +200,14 @@ namespace fast_daq
             U32 f_max_samples_per_channel;
             HANDLE f_board_handle;
             bool f_paused;
+            dma_buffer_pool f_dma_pool;
             std::vector<U16*> f_board_buffers;
+            std::deque<U16*> f_posted_buffers; // in the order the board fills them
+            U32 f_unposted_index; // index in f_board_buffers of the next buffer not yet posted since the last (re)start
+            std::chrono::steady_clock::time_point f_fill_reference; // when the board would have started filling, given the reads so far
+            U32 f_buffers_read_since_start;
+            uint64_t f_next_sample_index; // per channel, since the start of the acquisition
+            uint64_t f_samples_lost_pending; // dropped since the last chunk sent
             U32 f_buffers_completed;
 
         private:
@@ -129,9 +216,18 @@ namespace fast_daq
             void configure_board();
             void allocate_buffers();
             void clear_buffers();
-            void commence_buffer_collection();
+            void commence_buffer_collection( U32 a_initial_posts );
+            void post_buffer( U16* a_buffer );
+            void post_pending_buffers( U32 a_count );
+            void handle_overrun( bool a_can_drain );
+            double estimate_backlog();
+            void update_load_shedding( double a_backlog );
+            /// Set the run metrics to the counts so far
+            void publish_metrics();
+            void report_metrics();
             void process_instructions();
             void process_a_buffer();
+            void send_buffer( const U16* a_buffer );
 
         public:
             // Derived properties
@@ -139,6 +235,7 @@ namespace fast_daq
             U32 bytes_per_buffer();
             INT64 samples_per_acquisition();
             U32 buffers_per_acquisition();
+            double buffers_per_sec();
 
     };
 
@@ -158,16 +255,49 @@ namespace fast_daq
     {
         return reference_source_to_string( f_reference_source );
     }
+    inline void ats9462_digitizer::set_huge_pages( const std::string& a_mode )
+    {
+        f_huge_pages = dma_buffer_pool::string_to_huge_page_mode( a_mode );
+    }
+    inline std::string ats9462_digitizer::get_huge_pages_str() const
+    {
+        return dma_buffer_pool::huge_page_mode_to_string( f_huge_pages );
+    }
+    inline void ats9462_digitizer::set_overrun_policy( const std::string& a_policy )
+    {
+        f_overrun_policy = string_to_overrun_policy( a_policy );
+    }
+    inline std::string ats9462_digitizer::get_overrun_policy_str() const
+    {
+        return overrun_policy_to_string( f_overrun_policy );
+    }
+    inline void ats9462_digitizer::set_sample_layout( const std::string& a_layout )
+    {
+        f_sample_layout = string_to_sample_layout( a_layout );
+    }
+    inline std::string ats9462_digitizer::get_sample_layout_str() const
+    {
+        return sample_layout_to_string( f_sample_layout );
+    }
+    inline void ats9462_digitizer::set_channels( const std::string& a_channels )
+    {
+        f_channel_mask = string_to_channel_mask( a_channels );
+        f_channel_count = f_channel_mask == ( CHANNEL_A | CHANNEL_B ) ? 2 : 1;
+    }
+    inline std::string ats9462_digitizer::get_channels_str() const
+    {
+        return channel_mask_to_string( f_channel_mask );
+    }
 
-    class ats9462_digitizer_binding : public sandfly::_node_binding< ats9462_digitizer, ats9462_digitizer_binding >
+    class ats9462_digitizer_binding : public _tuned_node_binding< ats9462_digitizer, ats9462_digitizer_binding >
     {
         public:
             ats9462_digitizer_binding();
             virtual ~ats9462_digitizer_binding();
 
         private:
-            virtual void do_apply_config(ats9462_digitizer* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const ats9462_digitizer* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config(ats9462_digitizer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const ats9462_digitizer* a_node, scarab::param_node& a_config ) const;
     };
 
     // ATS-specific exceptions for handling in try/catch blocks
@@ -13,6 +13,8 @@
 
 #include "egg_writer.hh"
 #include "node_builder.hh"
+#include "thread_tuning.hh"
+#include "record_compressor.hh"
 //#include "time_data.hh"
 #include "iq_time_data.hh"
 
@@ -29,6 +31,11 @@ namespace fast_daq
 
      @details
 
+     A new egg acquisition is started at each break in the input sequence (a new digitizer acquisition, lost samples, or
+     skipped samples; see sequence_tracker), and the breaks and samples lost are logged when the run stops.
+     With a "compact-format", the records hold the producer's 16-bit copy of each chunk instead (see compact_data and
+     egg_writer), with 2-byte values.
+
      Parameter setting is not thread-safe.  Executing is thread-safe.
 
      Node type: "ats-streaming-writer"
@@ -44,6 +51,10 @@ namespace fast_daq
        - "v-range": double -- voltage range for ADC calibration
      - "center-freq": double -- the center frequency of the data being digitized in Hz
      - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+     - "compression": node -- optional lossless compression of the records; see record_compressor for the available values
+       When compression is enabled, compressed frames are packed into byte records, and the stream source gives the codec and the original record format.
+       The compression ratio and throughput are published as the run metrics "<node name>.compression-ratio" and ".compress-mb-s".
+     - "compact-format", "compact-scale": write the producer's 16-bit copy; see egg_writer
 
      Input Stream:
      - 0: iq_time_data
@@ -52,7 +63,8 @@ namespace fast_daq
     */
     class ats_streaming_writer :
             public midge::_consumer< midge::type_list< iq_time_data > >,
-            public fast_daq::egg_writer
+            public fast_daq::egg_writer,
+            public fast_daq::thread_tuning
     {
         public:
             ats_streaming_writer();
@@ -71,6 +83,8 @@ namespace fast_daq
             mv_accessible( double, center_freq ); // Hz
             mv_accessible( double, freq_range ); // Hz
 
+            mv_referrable( record_compressor, compressor );
+
         public:
             virtual void prepare_to_write( fast_daq::monarch_wrap_ptr a_mw_ptr, fast_daq::header_wrap_ptr a_hw_ptr );
 
@@ -79,7 +93,7 @@ namespace fast_daq
             virtual void finalize();
 
         private:
-            unsigned f_last_pkt_in_batch;
+            sequence_tracker f_sequence;
 
             fast_daq::monarch_wrap_ptr f_monarch_ptr;
             unsigned f_stream_no;
@@ -87,15 +101,15 @@ namespace fast_daq
     };
 
 
-    class ats_streaming_writer_binding : public sandfly::_node_binding< ats_streaming_writer, ats_streaming_writer_binding >
+    class ats_streaming_writer_binding : public _tuned_node_binding< ats_streaming_writer, ats_streaming_writer_binding >
     {
         public:
             ats_streaming_writer_binding();
             virtual ~ats_streaming_writer_binding();
 
         private:
-            virtual void do_apply_config( ats_streaming_writer* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const ats_streaming_writer* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config( ats_streaming_writer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const ats_streaming_writer* a_node, scarab::param_node& a_config ) const;
     };
 
 } /* namespace fast_daq */
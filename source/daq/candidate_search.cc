@@ -0,0 +1,454 @@
+/*
+ * candidate_search.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "candidate_search.hh"
+
+//scarab includes
+#include "logger.hh"
+#include "param.hh"
+
+//sandfly
+#include "daq_control.hh"
+#include "message_relayer.hh"
+
+//fast_daq includes
+#include "fast_daq_error.hh"
+#include "power_data.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( candidate_search, "candidate-search", candidate_search_binding );
+
+    LOGGER( flog, "candidate_search" );
+
+    // supporting enum helpers
+    std::string candidate_search::baseline_method_to_string( baseline_method_t a_method )
+    {
+        switch( a_method )
+        {
+            case baseline_method_t::median: return "median";
+            case baseline_method_t::savitzky_golay: return "savitzky-golay";
+            default: throw fast_daq::error() << "baseline_method value <" << static_cast< unsigned >( a_method ) << "> not recognized";
+        }
+    }
+    candidate_search::baseline_method_t candidate_search::string_to_baseline_method( const std::string& a_method )
+    {
+        if( a_method == baseline_method_to_string( baseline_method_t::median ) ) return baseline_method_t::median;
+        if( a_method == baseline_method_to_string( baseline_method_t::savitzky_golay ) ) return baseline_method_t::savitzky_golay;
+        throw fast_daq::error() << "string <" << a_method << "> not recognized as valid baseline_method";
+    }
+
+    std::string candidate_search::lineshape_to_string( lineshape_t a_lineshape )
+    {
+        switch( a_lineshape )
+        {
+            case lineshape_t::boxcar: return "boxcar";
+            case lineshape_t::gaussian: return "gaussian";
+            case lineshape_t::lorentzian: return "lorentzian";
+            default: throw fast_daq::error() << "lineshape value <" << static_cast< unsigned >( a_lineshape ) << "> not recognized";
+        }
+    }
+    candidate_search::lineshape_t candidate_search::string_to_lineshape( const std::string& a_lineshape )
+    {
+        if( a_lineshape == lineshape_to_string( lineshape_t::boxcar ) ) return lineshape_t::boxcar;
+        if( a_lineshape == lineshape_to_string( lineshape_t::gaussian ) ) return lineshape_t::gaussian;
+        if( a_lineshape == lineshape_to_string( lineshape_t::lorentzian ) ) return lineshape_t::lorentzian;
+        throw fast_daq::error() << "string <" << a_lineshape << "> not recognized as valid lineshape";
+    }
+
+    /* candidate_search class */
+    /***************************/
+
+    candidate_search::candidate_search() :
+        f_candidate_alert_rk( "candidate-data" ),
+        f_baseline_method( baseline_method_t::median ),
+        f_baseline_width( 101 ),
+        f_savgol_order( 2 ),
+        f_lineshape( lineshape_t::gaussian ),
+        f_lineshape_width( 0. ),
+        f_threshold( 6. ),
+        f_max_candidates( 32 ),
+        f_kurtosis_veto( 0. ),
+        f_baseline(),
+        f_excess(),
+        f_snr(),
+        f_scratch(),
+        f_savgol_coefficients(),
+        f_kernel(),
+        f_kernel_bin_width( 0. ),
+        f_candidates(),
+        f_spectrum_counter( 0 )
+    {
+    }
+
+    candidate_search::~candidate_search()
+    {
+    }
+
+    // node interface methods
+    void candidate_search::initialize()
+    {
+        if ( f_baseline_width % 2 == 0 ) throw fast_daq::error() << "baseline-width must be odd";
+        if ( f_baseline_method == baseline_method_t::savitzky_golay )
+        {
+            if ( f_savgol_order >= f_baseline_width ) throw fast_daq::error() << "savgol-order must be less than baseline-width";
+
+            // least-squares smoothing coefficients for the central point of a window of 2m+1 points:
+            // c_j = sum_k x_k j^k, where (A^T A) x = e_0 and A_jk = j^k
+            const int t_half = f_baseline_width / 2;
+            const unsigned t_n_terms = f_savgol_order + 1;
+            std::vector< double > t_matrix( t_n_terms * ( t_n_terms + 1 ), 0. ); // augmented with e_0
+            for ( unsigned i_row = 0; i_row < t_n_terms; ++i_row )
+            {
+                for ( unsigned i_col = 0; i_col < t_n_terms; ++i_col )
+                {
+                    double t_sum = 0.;
+                    for ( int j = -t_half; j <= t_half; ++j ) t_sum += pow( (double)j, (double)( i_row + i_col ) );
+                    t_matrix[ i_row * ( t_n_terms + 1 ) + i_col ] = t_sum;
+                }
+                t_matrix[ i_row * ( t_n_terms + 1 ) + t_n_terms ] = i_row == 0 ? 1. : 0.;
+            }
+            // Gauss-Jordan elimination with partial pivoting
+            for ( unsigned i_col = 0; i_col < t_n_terms; ++i_col )
+            {
+                unsigned t_pivot = i_col;
+                for ( unsigned i_row = i_col + 1; i_row < t_n_terms; ++i_row )
+                {
+                    if ( fabs( t_matrix[ i_row * ( t_n_terms + 1 ) + i_col ] ) > fabs( t_matrix[ t_pivot * ( t_n_terms + 1 ) + i_col ] ) ) t_pivot = i_row;
+                }
+                for ( unsigned i_elem = 0; i_elem <= t_n_terms; ++i_elem )
+                {
+                    std::swap( t_matrix[ i_col * ( t_n_terms + 1 ) + i_elem ], t_matrix[ t_pivot * ( t_n_terms + 1 ) + i_elem ] );
+                }
+                double t_diag = t_matrix[ i_col * ( t_n_terms + 1 ) + i_col ];
+                for ( unsigned i_row = 0; i_row < t_n_terms; ++i_row )
+                {
+                    if ( i_row == i_col ) continue;
+                    double t_factor = t_matrix[ i_row * ( t_n_terms + 1 ) + i_col ] / t_diag;
+                    for ( unsigned i_elem = i_col; i_elem <= t_n_terms; ++i_elem )
+                    {
+                        t_matrix[ i_row * ( t_n_terms + 1 ) + i_elem ] -= t_factor * t_matrix[ i_col * ( t_n_terms + 1 ) + i_elem ];
+                    }
+                }
+            }
+            f_savgol_coefficients.resize( f_baseline_width );
+            for ( int j = -t_half; j <= t_half; ++j )
+            {
+                double t_coefficient = 0.;
+                for ( unsigned i_term = 0; i_term < t_n_terms; ++i_term )
+                {
+                    double t_x = t_matrix[ i_term * ( t_n_terms + 1 ) + t_n_terms ] / t_matrix[ i_term * ( t_n_terms + 1 ) + i_term ];
+                    t_coefficient += t_x * pow( (double)j, (double)i_term );
+                }
+                f_savgol_coefficients[ j + t_half ] = t_coefficient;
+            }
+        }
+        f_kernel.clear();
+        f_kernel_bin_width = 0.;
+        LINFO( flog, "searching with a " << baseline_method_to_string( f_baseline_method ) << " baseline of " << f_baseline_width << " bins and a "
+                << lineshape_to_string( f_lineshape ) << " lineshape; threshold is " << f_threshold );
+    }
+
+    void candidate_search::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            while (! is_canceled() )
+            {
+                // check the slot status
+                midge::enum_t input_command = in_stream< 0 >().get();
+                unsigned stream_index = in_stream< 0 >().get_current_index();
+                if ( input_command == midge::stream::s_none )
+                {
+                    continue;
+                }
+                else if ( input_command == stream::s_error )
+                {
+                    LWARN( flog, " got an s_error on slot <" << stream_index << ">");
+                    break;
+                }
+                else if ( input_command == stream::s_exit )
+                {
+                    LDEBUG( flog, " got an s_exit on slot <" << stream_index << ">");
+                    break;
+                }
+                else if ( input_command == stream::s_stop )
+                {
+                    LINFO( flog, " got an s_stop on slot <" << stream_index << ">; searched " << f_spectrum_counter << " spectra");
+                    continue;
+                }
+                else if ( input_command == stream::s_start )
+                {
+                    LDEBUG( flog, " got an s_start on slot <" << stream_index << ">");
+                    f_spectrum_counter = 0;
+                    continue;
+                }
+                else if ( input_command == stream::s_run )
+                {
+                    LTRACE( flog, " got an s_run on slot <" << stream_index << ">");
+                    search_spectrum( in_stream< 0 >().data() );
+                    continue;
+                }
+            }
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void candidate_search::finalize()
+    {
+    }
+
+    void candidate_search::search_spectrum( const power_data* a_spectrum )
+    {
+        const unsigned t_size = a_spectrum->get_array_size();
+        const float* t_power = a_spectrum->get_data_array();
+        if ( t_size == 0 ) return;
+
+        if ( a_spectrum->get_bin_width() != f_kernel_bin_width ) build_kernel( a_spectrum->get_bin_width() );
+
+        // baseline and fractional excess over it
+        f_baseline.resize( t_size );
+        if ( f_baseline_method == baseline_method_t::median ) fit_median_baseline( t_power, t_size );
+        else fit_savgol_baseline( t_power, t_size );
+
+        f_excess.resize( t_size );
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            f_excess[i_bin] = f_baseline[i_bin] > 0. ? t_power[i_bin] / f_baseline[i_bin] - 1.f : 0.f;
+        }
+
+        // robust noise estimate: 1.4826 * median absolute deviation
+        f_scratch.assign( f_excess.begin(), f_excess.end() );
+        std::nth_element( f_scratch.begin(), f_scratch.begin() + t_size / 2, f_scratch.end() );
+        const float t_center = f_scratch[ t_size / 2 ];
+        for ( float& t_value : f_scratch ) t_value = fabs( t_value - t_center );
+        std::nth_element( f_scratch.begin(), f_scratch.begin() + t_size / 2, f_scratch.end() );
+        const float t_noise = 1.4826f * f_scratch[ t_size / 2 ];
+        ++f_spectrum_counter;
+        if ( t_noise <= 0. )
+        {
+            LDEBUG( flog, "spectrum has no measurable noise; skipping search" );
+            return;
+        }
+
+        // matched filter; the kernel has unit noise gain, so the output is in units of the noise
+        const int t_half = f_kernel.size() / 2;
+        const float t_inv_noise = 1.f / t_noise;
+        f_snr.resize( t_size );
+        for ( int i_bin = 0; i_bin < (int)t_size; ++i_bin )
+        {
+            const int t_first = std::max( 0, t_half - i_bin );
+            const int t_last = std::min( (int)f_kernel.size(), (int)t_size - i_bin + t_half );
+            float t_sum = 0.;
+            for ( int i_tap = t_first; i_tap < t_last; ++i_tap )
+            {
+                t_sum += f_kernel[i_tap] * ( f_excess[ i_bin + i_tap - t_half ] - t_center );
+            }
+            f_snr[i_bin] = t_sum * t_inv_noise;
+        }
+
+        // each run of bins above threshold is one candidate
+        const float* t_kurtosis = a_spectrum->get_kurtosis_array();
+        const bool t_use_veto = t_kurtosis != nullptr && f_kurtosis_veto > 0. && a_spectrum->get_n_spectra() > 1;
+        const float t_kurtosis_limit = t_use_veto ? 1. + f_kurtosis_veto * 2. / sqrt( (double)a_spectrum->get_n_spectra() ) : 0.;
+        f_candidates.clear();
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            if ( f_snr[i_bin] < f_threshold ) continue;
+            candidate t_candidate{ i_bin, 0, f_snr[i_bin], t_power[i_bin], f_baseline[i_bin], 0.f };
+            for ( ; i_bin < t_size && f_snr[i_bin] >= f_threshold; ++i_bin )
+            {
+                ++t_candidate.f_n_bins_above;
+                if ( f_snr[i_bin] > t_candidate.f_snr )
+                {
+                    t_candidate.f_bin = i_bin;
+                    t_candidate.f_snr = f_snr[i_bin];
+                    t_candidate.f_power = t_power[i_bin];
+                    t_candidate.f_baseline = f_baseline[i_bin];
+                }
+            }
+            if ( t_kurtosis != nullptr ) t_candidate.f_kurtosis = t_kurtosis[t_candidate.f_bin];
+            if ( t_use_veto && t_candidate.f_kurtosis > t_kurtosis_limit )
+            {
+                LDEBUG( flog, "vetoing candidate at bin " << t_candidate.f_bin << " with spectral kurtosis " << t_candidate.f_kurtosis );
+                continue;
+            }
+            f_candidates.push_back( t_candidate );
+        }
+        if ( f_candidates.empty() ) return;
+
+        std::sort( f_candidates.begin(), f_candidates.end(), []( const candidate& a_lhs, const candidate& a_rhs ){ return a_lhs.f_snr > a_rhs.f_snr; } );
+        if ( f_candidates.size() > f_max_candidates ) f_candidates.resize( f_max_candidates );
+
+        LDEBUG( flog, "found " << f_candidates.size() << " candidates; highest SNR is " << f_candidates.front().f_snr );
+        broadcast_candidates( a_spectrum, t_noise );
+    }
+
+    void candidate_search::fit_median_baseline( const float* a_power, unsigned a_size )
+    {
+        // the window slides with the bin, but is held inside the spectrum at the edges;
+        // f_scratch is kept sorted, so each step is one removal and one insertion
+        const unsigned t_width = std::min( f_baseline_width, a_size );
+        const unsigned t_half = t_width / 2;
+        f_scratch.assign( a_power, a_power + t_width );
+        std::sort( f_scratch.begin(), f_scratch.end() );
+        unsigned t_start = 0;
+        for ( unsigned i_bin = 0; i_bin < a_size; ++i_bin )
+        {
+            unsigned t_wanted_start = std::min( i_bin > t_half ? i_bin - t_half : 0, a_size - t_width );
+            while ( t_start < t_wanted_start )
+            {
+                f_scratch.erase( std::lower_bound( f_scratch.begin(), f_scratch.end(), a_power[t_start] ) );
+                f_scratch.insert( std::upper_bound( f_scratch.begin(), f_scratch.end(), a_power[t_start + t_width] ), a_power[t_start + t_width] );
+                ++t_start;
+            }
+            f_baseline[i_bin] = t_width % 2 ? f_scratch[t_half] : 0.5f * ( f_scratch[t_half - 1] + f_scratch[t_half] );
+        }
+        return;
+    }
+
+    void candidate_search::fit_savgol_baseline( const float* a_power, unsigned a_size )
+    {
+        // indices past either edge are reflected back into the spectrum
+        const int t_half = f_savgol_coefficients.size() / 2;
+        const int t_last = (int)a_size - 1;
+        for ( int i_bin = 0; i_bin < (int)a_size; ++i_bin )
+        {
+            double t_sum = 0.;
+            for ( int j = -t_half; j <= t_half; ++j )
+            {
+                int t_index = i_bin + j;
+                if ( t_index < 0 ) t_index = std::min( -t_index, t_last );
+                else if ( t_index > t_last ) t_index = std::max( 2 * t_last - t_index, 0 );
+                t_sum += f_savgol_coefficients[ j + t_half ] * a_power[t_index];
+            }
+            f_baseline[i_bin] = t_sum;
+        }
+        return;
+    }
+
+    void candidate_search::build_kernel( float a_bin_width )
+    {
+        const double t_width_bins = a_bin_width > 0. ? f_lineshape_width / a_bin_width : 0.;
+        int t_half = 0;
+        switch( f_lineshape )
+        {
+            case lineshape_t::boxcar:
+                t_half = std::max( 0L, lrint( t_width_bins ) - 1 ) / 2;
+                break;
+            case lineshape_t::gaussian:
+                t_half = (int)ceil( 3. * t_width_bins / 2.3548 );
+                break;
+            case lineshape_t::lorentzian:
+                t_half = (int)ceil( 5. * t_width_bins / 2. );
+                break;
+        }
+
+        f_kernel.resize( 2 * t_half + 1 );
+        double t_sum_of_squares = 0.;
+        for ( int i_tap = -t_half; i_tap <= t_half; ++i_tap )
+        {
+            double t_value = 1.;
+            if ( t_width_bins > 0. && f_lineshape == lineshape_t::gaussian )
+            {
+                double t_sigma = t_width_bins / 2.3548;
+                t_value = exp( -0.5 * i_tap * i_tap / ( t_sigma * t_sigma ) );
+            }
+            else if ( t_width_bins > 0. && f_lineshape == lineshape_t::lorentzian )
+            {
+                double t_gamma = t_width_bins / 2.;
+                t_value = 1. / ( 1. + i_tap * i_tap / ( t_gamma * t_gamma ) );
+            }
+            f_kernel[ i_tap + t_half ] = t_value;
+            t_sum_of_squares += t_value * t_value;
+        }
+        const float t_norm = 1. / sqrt( t_sum_of_squares );
+        for ( float& t_tap : f_kernel ) t_tap *= t_norm;
+
+        f_kernel_bin_width = a_bin_width;
+        LDEBUG( flog, "matched-filter kernel has " << f_kernel.size() << " taps" );
+        return;
+    }
+
+    void candidate_search::broadcast_candidates( const power_data* a_spectrum, float a_noise )
+    {
+        scarab::param_ptr_t t_payload_ptr( new scarab::param_node() );
+        scarab::param_node& t_payload = t_payload_ptr->as_node();
+        scarab::param_array t_candidate_array;
+        for ( const candidate& t_candidate : f_candidates )
+        {
+            scarab::param_node t_record;
+            t_record.add( "frequency", a_spectrum->get_minimum_frequency() + t_candidate.f_bin * a_spectrum->get_bin_width() );
+            t_record.add( "snr", t_candidate.f_snr );
+            t_record.add( "power", t_candidate.f_power );
+            t_record.add( "baseline", t_candidate.f_baseline );
+            t_record.add( "width", t_candidate.f_n_bins_above * a_spectrum->get_bin_width() );
+            if ( a_spectrum->get_kurtosis_array() != nullptr ) t_record.add( "kurtosis", t_candidate.f_kurtosis );
+            t_candidate_array.push_back( std::move( t_record ) );
+        }
+        t_payload.add( "candidates", std::move( t_candidate_array ) );
+        t_payload.add( "spectrum_counter", f_spectrum_counter - 1 );
+        t_payload.add( "acquisition_id", a_spectrum->get_acquisition_id() );
+        t_payload.add( "first_sample_index", a_spectrum->get_first_sample_index() );
+        t_payload.add( "sample_span", a_spectrum->get_sample_span() );
+        t_payload.add( "samples_lost", a_spectrum->get_samples_lost() );
+        t_payload.add( "frequency_resolution", a_spectrum->get_bin_width() );
+        t_payload.add( "noise_level", a_noise );
+        t_payload.add( "threshold", f_threshold );
+
+        auto t_run_control = use_run_control();
+        t_run_control->relayer().send( dripline::msg_alert::create( std::move( t_payload_ptr ), f_candidate_alert_rk ) );
+        return;
+    }
+
+
+    /* candidate_search_binding class */
+    /***********************************/
+    candidate_search_binding::candidate_search_binding()
+    {
+    }
+
+    candidate_search_binding::~candidate_search_binding()
+    {
+    }
+
+    void candidate_search_binding::do_apply_node_config( candidate_search* a_node, const scarab::param_node& a_config ) const
+    {
+        a_node->set_candidate_alert_rk( a_config.get_value( "candidate-alert-rk", a_node->get_candidate_alert_rk() ) );
+        a_node->set_baseline_method( candidate_search::string_to_baseline_method( a_config.get_value( "baseline-method", candidate_search::baseline_method_to_string( a_node->get_baseline_method() ) ) ) );
+        a_node->set_baseline_width( a_config.get_value( "baseline-width", a_node->get_baseline_width() ) );
+        a_node->set_savgol_order( a_config.get_value( "savgol-order", a_node->get_savgol_order() ) );
+        a_node->set_lineshape( candidate_search::string_to_lineshape( a_config.get_value( "lineshape", candidate_search::lineshape_to_string( a_node->get_lineshape() ) ) ) );
+        a_node->set_lineshape_width( a_config.get_value( "lineshape-width", a_node->get_lineshape_width() ) );
+        a_node->set_threshold( a_config.get_value( "threshold", a_node->get_threshold() ) );
+        a_node->set_max_candidates( a_config.get_value( "max-candidates", a_node->get_max_candidates() ) );
+        a_node->set_kurtosis_veto( a_config.get_value( "kurtosis-veto", a_node->get_kurtosis_veto() ) );
+    }
+
+    void candidate_search_binding::do_dump_node_config( const candidate_search* a_node, scarab::param_node& a_config ) const
+    {
+        a_config.add( "candidate-alert-rk", scarab::param_value( a_node->get_candidate_alert_rk() ) );
+        a_config.add( "baseline-method", scarab::param_value( candidate_search::baseline_method_to_string( a_node->get_baseline_method() ) ) );
+        a_config.add( "baseline-width", scarab::param_value( a_node->get_baseline_width() ) );
+        a_config.add( "savgol-order", scarab::param_value( a_node->get_savgol_order() ) );
+        a_config.add( "lineshape", scarab::param_value( candidate_search::lineshape_to_string( a_node->get_lineshape() ) ) );
+        a_config.add( "lineshape-width", scarab::param_value( a_node->get_lineshape_width() ) );
+        a_config.add( "threshold", scarab::param_value( a_node->get_threshold() ) );
+        a_config.add( "max-candidates", scarab::param_value( a_node->get_max_candidates() ) );
+        a_config.add( "kurtosis-veto", scarab::param_value( a_node->get_kurtosis_veto() ) );
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,149 @@
+/*
+ * candidate_search.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_CANDIDATE_SEARCH_HH_
+#define FAST_DAQ_CANDIDATE_SEARCH_HH_
+
+// sandfly includes
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+#include "control_access.hh"
+#include "consumer.hh"
+#include "shared_cancel.hh"
+
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    // forward declarations
+    class power_data;
+
+    /*!
+     @class candidate_search
+     @brief A node which searches averaged power spectra for narrow excess-power peaks and broadcasts compact candidate records.
+
+     @details
+
+     For each power spectrum received (for example, from a power-averager node):
+     - a baseline is fit with a running median or Savitzky-Golay filter of baseline-width bins;
+     - the spectrum is flattened to a fractional excess over the baseline, P / B - 1, and the noise level is estimated
+       from its median absolute deviation (robust against the peaks being searched for);
+     - the flattened spectrum is convolved with the configured lineshape, normalized to unit noise gain, so the
+       result is a signal-to-noise ratio per bin;
+     - each contiguous run of bins above threshold becomes one candidate, reported at its highest bin.
+
+     If the spectra carry spectral kurtosis, it is reported with each candidate and can be used to veto impulsive interference.
+
+     Spectra with at least one candidate are broadcast via dripline alert; each candidate carries its frequency,
+     SNR, power, baseline and the width of the run above threshold, and the alert places the spectrum in the data
+     (acquisition_id, first_sample_index, sample_span and samples_lost; see sequenced_data).  This replaces shipping
+     whole spectra when only the detections are needed.
+
+     Node type: "candidate-search"
+
+     Available configuration values:
+     - "candidate-alert-rk": string -- A valid AMQP routing key to which candidate records will be broadcast (default: "candidate-data")
+     - "baseline-method": string -- "median" or "savitzky-golay" (default: "median")
+     - "baseline-width": uint -- number of bins in the baseline filter; must be odd (default: 101)
+     - "savgol-order": uint -- polynomial order of the Savitzky-Golay filter; must be less than baseline-width (default: 2)
+     - "lineshape": string -- expected signal shape: "boxcar", "gaussian" or "lorentzian" (default: "gaussian")
+     - "lineshape-width": double -- width of the lineshape in Hz: full width for boxcar, FWHM for gaussian and lorentzian (default: 0, meaning one bin)
+     - "threshold": double -- detection threshold, in units of the matched-filter noise (default: 6)
+     - "max-candidates": uint -- maximum number of candidates reported per spectrum, highest SNR first (default: 32)
+     - "kurtosis-veto": double -- if the input carries spectral kurtosis (power-averager with compute-kurtosis), drop candidates
+       whose kurtosis exceeds 1 by more than this many standard deviations (2/sqrt(M) for M summed spectra), i.e. intermittent
+       interference rather than a steady signal; 0 disables the veto (default: 0)
+
+     Input Streams
+     - 0: power_data
+
+    */
+    class candidate_search : public midge::_consumer< midge::type_list< power_data > >, public sandfly::control_access, public thread_tuning
+    {
+        public:
+            enum class baseline_method_t
+            {
+                median,
+                savitzky_golay
+            };
+            static std::string baseline_method_to_string( baseline_method_t a_method );
+            static baseline_method_t string_to_baseline_method( const std::string& a_method );
+
+            enum class lineshape_t
+            {
+                boxcar,
+                gaussian,
+                lorentzian
+            };
+            static std::string lineshape_to_string( lineshape_t a_lineshape );
+            static lineshape_t string_to_lineshape( const std::string& a_lineshape );
+
+            struct candidate
+            {
+                unsigned f_bin;
+                unsigned f_n_bins_above;
+                float f_snr;
+                float f_power;
+                float f_baseline;
+                float f_kurtosis; // 0 if not available
+            };
+
+        public:
+            candidate_search();
+            virtual ~candidate_search();
+
+        mv_accessible( std::string, candidate_alert_rk );
+        mv_accessible( baseline_method_t, baseline_method );
+        mv_accessible( unsigned, baseline_width );
+        mv_accessible( unsigned, savgol_order );
+        mv_accessible( lineshape_t, lineshape );
+        mv_accessible( double, lineshape_width );
+        mv_accessible( double, threshold );
+        mv_accessible( unsigned, max_candidates );
+        mv_accessible( double, kurtosis_veto );
+
+        public: //node API
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            void search_spectrum( const power_data* a_spectrum );
+            void fit_median_baseline( const float* a_power, unsigned a_size );
+            void fit_savgol_baseline( const float* a_power, unsigned a_size );
+            void build_kernel( float a_bin_width );
+            void broadcast_candidates( const power_data* a_spectrum, float a_noise );
+
+            std::vector< float > f_baseline;
+            std::vector< float > f_excess;
+            std::vector< float > f_snr;
+            std::vector< float > f_scratch;
+            std::vector< float > f_savgol_coefficients;
+            std::vector< float > f_kernel; // centered; length is odd
+            float f_kernel_bin_width;
+            std::vector< candidate > f_candidates;
+            unsigned f_spectrum_counter;
+    };
+
+    class candidate_search_binding : public _tuned_node_binding< candidate_search, candidate_search_binding >
+    {
+        public:
+            candidate_search_binding();
+            virtual ~candidate_search_binding();
+
+        private:
+            virtual void do_apply_node_config( candidate_search* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const candidate_search* a_node, scarab::param_node& a_config ) const;
+    };
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_CANDIDATE_SEARCH_HH_ */
@@ -0,0 +1,417 @@
+/*
+ * chirp_z_transform.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "chirp_z_transform.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( chirp_z_transform, "chirp-z-transform", chirp_z_transform_binding );
+
+    LOGGER( flog, "chirp_z_transform" );
+
+    chirp_z_transform::chirp_z_transform() :
+            f_freq_length( 10 ),
+            f_frame_size( 65536 ),
+            f_n_bins( 1024 ),
+            f_min_frequency( 0. ),
+            f_max_frequency( 0. ),
+            f_samples_per_sec( 0 ),
+            f_window( window_type_t::blackman_harris ),
+            f_kaiser_beta( 8.6 ),
+            f_overlap_fraction( 0. ),
+            f_transform_flag( "ESTIMATE" ),
+            f_use_wisdom( true ),
+            f_wisdom_filename( "wisdom_czt.fftw3" ),
+            f_transform_flag_map(),
+            f_conv_size( 0 ),
+            f_pre_chirp_re(),
+            f_pre_chirp_im(),
+            f_post_chirp_re(),
+            f_post_chirp_im(),
+            f_ring(),
+            f_ring_first_index( 0 ),
+            f_sequence(),
+            f_spectrum_counter( 0 ),
+            f_kernel_spectrum( nullptr ),
+            f_work( nullptr ),
+            f_forward_plan(),
+            f_backward_plan(),
+            f_multithreaded_is_initialized( false )
+    {
+        setup_internal_maps();
+    }
+
+    chirp_z_transform::~chirp_z_transform()
+    {
+    }
+
+    // calculate derived params from members
+    double chirp_z_transform::bin_spacing_hz() const
+    {
+        return ( f_max_frequency - f_min_frequency ) / (double)f_n_bins;
+    }
+
+    unsigned chirp_z_transform::hop_size() const
+    {
+        long to_return = lrint( (double)f_frame_size * ( 1. - f_overlap_fraction ) );
+        return (unsigned)std::max( to_return, 1L );
+    }
+
+    unsigned chirp_z_transform::good_fft_size( unsigned a_min_size )
+    {
+        for ( unsigned t_size = std::max( a_min_size, 1U ); ; ++t_size )
+        {
+            unsigned t_remainder = t_size;
+            for ( unsigned t_factor : { 2U, 3U, 5U, 7U } )
+            {
+                while ( t_remainder % t_factor == 0 ) t_remainder /= t_factor;
+            }
+            if ( t_remainder == 1 ) return t_size;
+        }
+    }
+
+    void chirp_z_transform::build_chirps()
+    {
+        // X[k] = sum_n x[n] exp(-2 pi i (f_min + k df) n / fs)
+        //      = B[k] sum_n ( x[n] A[n] ) C[k - n], with
+        //   A[n] = w[n] exp(-2 pi i f_min n / fs) exp(-pi i df n^2 / fs)
+        //   C[m] = exp(+pi i df m^2 / fs)
+        //   B[k] = exp(-pi i df k^2 / fs)
+        // Phases are reduced modulo one cycle in long double, since n^2 gets large.
+        const long double t_start_cycles = (long double)f_min_frequency / (long double)f_samples_per_sec;
+        const long double t_half_step_cycles = 0.5L * (long double)bin_spacing_hz() / (long double)f_samples_per_sec;
+        auto t_cycles = [t_half_step_cycles]( long long a_index, long double a_linear ) -> double
+        {
+            long double t_value = t_half_step_cycles * (long double)a_index * (long double)a_index + a_linear * (long double)a_index;
+            return (double)( t_value - floorl( t_value ) );
+        };
+
+        std::vector< float > t_window;
+        make_window( f_window, f_frame_size, t_window, f_kaiser_beta );
+
+        f_pre_chirp_re.resize( f_frame_size );
+        f_pre_chirp_im.resize( f_frame_size );
+        for ( unsigned i_sample = 0; i_sample < f_frame_size; ++i_sample )
+        {
+            double t_phase = -2. * M_PI * t_cycles( i_sample, t_start_cycles );
+            f_pre_chirp_re[ i_sample ] = t_window[ i_sample ] * cos( t_phase );
+            f_pre_chirp_im[ i_sample ] = t_window[ i_sample ] * sin( t_phase );
+        }
+
+        // same PSD normalization as frequency_transform
+        const double t_norm = sqrt( 2. / ( (double)f_samples_per_sec * window_sum_of_squares( t_window ) ) );
+        f_post_chirp_re.resize( f_n_bins );
+        f_post_chirp_im.resize( f_n_bins );
+        for ( unsigned i_bin = 0; i_bin < f_n_bins; ++i_bin )
+        {
+            double t_phase = -2. * M_PI * t_cycles( i_bin, 0.L );
+            f_post_chirp_re[ i_bin ] = t_norm * cos( t_phase );
+            f_post_chirp_im[ i_bin ] = t_norm * sin( t_phase );
+        }
+
+        // convolution chirp C[m] for m = -(frame-size - 1) .. n-bins - 1, wrapped into L points; the inverse FFT's 1/L is folded in
+        std::fill( &f_work[0][0], &f_work[0][0] + 2 * (uint64_t)f_conv_size, 0.f );
+        for ( long long i_lag = -(long long)( f_frame_size - 1 ); i_lag < (long long)f_n_bins; ++i_lag )
+        {
+            double t_phase = 2. * M_PI * t_cycles( i_lag, 0.L );
+            unsigned t_index = i_lag < 0 ? (unsigned)( (long long)f_conv_size + i_lag ) : (unsigned)i_lag;
+            f_work[ t_index ][ 0 ] = cos( t_phase ) / (double)f_conv_size;
+            f_work[ t_index ][ 1 ] = sin( t_phase ) / (double)f_conv_size;
+        }
+        // the forward plan is in-place, so it can't be applied to another output array: transform in f_work and copy out
+        fftwf_execute( f_forward_plan );
+        std::copy( &f_work[0][0], &f_work[0][0] + 2 * (uint64_t)f_conv_size, &f_kernel_spectrum[0][0] );
+        return;
+    }
+
+    void chirp_z_transform::initialize()
+    {
+        if ( f_samples_per_sec == 0 ) throw fast_daq::error() << "chirp-z-transform requires samples-per-sec to be set";
+        if ( f_frame_size == 0 || f_n_bins == 0 ) throw fast_daq::error() << "chirp-z-transform requires a non-zero frame-size and n-bins";
+        if ( f_min_frequency < 0. || f_max_frequency <= f_min_frequency || f_max_frequency > 0.5 * (double)f_samples_per_sec )
+        {
+            throw fast_daq::error() << "chirp-z-transform band [" << f_min_frequency << ", " << f_max_frequency << "] Hz must satisfy 0 <= min-frequency < max-frequency <= samples-per-sec / 2";
+        }
+        if ( f_overlap_fraction < 0. || f_overlap_fraction >= 1. ) throw fast_daq::error() << "overlap-fraction must be in [0, 1)";
+
+        f_conv_size = good_fft_size( f_frame_size + f_n_bins - 1 );
+
+        out_buffer< 0 >().initialize( f_freq_length );
+        out_buffer< 0 >().call( &frequency_data::allocate_array, f_n_bins );
+        out_buffer< 0 >().call( &frequency_data::set_fft_size, f_frame_size );
+        out_buffer< 0 >().call( &frequency_data::set_window, f_window );
+
+        LINFO( flog, "evaluating " << f_n_bins << " bins, " << bin_spacing_hz() << " Hz apart, from " << f_min_frequency << " Hz; frames of " <<
+                f_frame_size << " samples (resolution " << (double)f_samples_per_sec / (double)f_frame_size << " Hz) with convolutions of length " << f_conv_size );
+
+        if (f_use_wisdom)
+        {
+            LDEBUG( flog, "Reading wisdom from file <" << f_wisdom_filename << ">");
+            if (fftwf_import_wisdom_from_filename(f_wisdom_filename.c_str()) == 0)
+            {
+                LWARN( flog, "Unable to read FFTW wisdom from file <" << f_wisdom_filename << ">" );
+            }
+        }
+        //initialize multithreaded
+        #ifdef FFTW_NTHREADS
+            if (! f_multithreaded_is_initialized)
+            {
+                fftwf_init_threads();
+                fftwf_plan_with_nthreads(FFTW_NTHREADS);
+                LDEBUG( flog, "Configuring FFTW to use up to " << FFTW_NTHREADS << " threads.");
+                f_multithreaded_is_initialized = true;
+            }
+        #endif
+        transform_flag_map_t::const_iterator iter = f_transform_flag_map.find(f_transform_flag);
+        if ( iter == f_transform_flag_map.end() ) throw fast_daq::error() << "Unknown transform flag <" << f_transform_flag << ">";
+        unsigned transform_flag = iter->second;
+
+        f_work = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_conv_size);
+        f_kernel_spectrum = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_conv_size);
+        f_forward_plan = fftwf_plan_dft_1d(f_conv_size, f_work, f_work, FFTW_FORWARD, transform_flag);
+        f_backward_plan = fftwf_plan_dft_1d(f_conv_size, f_work, f_work, FFTW_BACKWARD, transform_flag);
+        if (f_forward_plan == NULL || f_backward_plan == NULL) throw fast_daq::error() << "Unable to create the FFTW plans";
+        if (f_use_wisdom)
+        {
+            if (fftwf_export_wisdom_to_filename(f_wisdom_filename.c_str()) == 0)
+            {
+                LWARN( flog, "Unable to write FFTW wisdom to file<" << f_wisdom_filename << ">");
+            }
+        }
+
+        build_chirps();
+        LDEBUG( flog, "FFTW plans and chirps created; initialization complete" );
+
+        return;
+    }
+
+    bool chirp_z_transform::process_chunk( const real_time_data* a_time_data )
+    {
+        if ( f_sequence.add_input( *a_time_data ) )
+        {
+            // a frame can't straddle a break in the input
+            f_ring.consume( f_ring.size() );
+            f_ring_first_index = a_time_data->get_first_sample_index();
+        }
+        a_time_data->copy_samples( f_ring.extend( a_time_data->get_array_size() ) );
+
+        // same conversion as real_time_data::as_volts()
+        const float units_factor = a_time_data->get_dynamic_range() / 65536.;
+        const float min_volts = a_time_data->get_dynamic_range() / 2.0;
+        const float* t_pre_re = f_pre_chirp_re.data();
+        const float* t_pre_im = f_pre_chirp_im.data();
+        const float* t_post_re = f_post_chirp_re.data();
+        const float* t_post_im = f_post_chirp_im.data();
+
+        while ( f_ring.size() >= f_frame_size )
+        {
+            // windowed, chirped frame, zero-padded to the convolution length
+            const U16* t_frame = f_ring.data();
+            for ( unsigned i_sample = 0; i_sample < f_frame_size; ++i_sample )
+            {
+                float t_volts = static_cast< float >( t_frame[ i_sample ] ) * units_factor - min_volts;
+                f_work[ i_sample ][ 0 ] = t_volts * t_pre_re[ i_sample ];
+                f_work[ i_sample ][ 1 ] = t_volts * t_pre_im[ i_sample ];
+            }
+            std::fill( &f_work[ f_frame_size ][ 0 ], &f_work[0][0] + 2 * (uint64_t)f_conv_size, 0.f );
+
+            // circular convolution with the chirp kernel
+            fftwf_execute( f_forward_plan );
+            for ( unsigned i_point = 0; i_point < f_conv_size; ++i_point )
+            {
+                float t_re = f_work[ i_point ][ 0 ] * f_kernel_spectrum[ i_point ][ 0 ] - f_work[ i_point ][ 1 ] * f_kernel_spectrum[ i_point ][ 1 ];
+                float t_im = f_work[ i_point ][ 0 ] * f_kernel_spectrum[ i_point ][ 1 ] + f_work[ i_point ][ 1 ] * f_kernel_spectrum[ i_point ][ 0 ];
+                f_work[ i_point ][ 0 ] = t_re;
+                f_work[ i_point ][ 1 ] = t_im;
+            }
+            fftwf_execute( f_backward_plan );
+
+            frequency_data* freq_data_out = out_stream< 0 >().data();
+            frequency_data::complex_t* t_out = freq_data_out->get_data_array();
+            for ( unsigned i_bin = 0; i_bin < f_n_bins; ++i_bin )
+            {
+                t_out[ i_bin ][ 0 ] = f_work[ i_bin ][ 0 ] * t_post_re[ i_bin ] - f_work[ i_bin ][ 1 ] * t_post_im[ i_bin ];
+                t_out[ i_bin ][ 1 ] = f_work[ i_bin ][ 0 ] * t_post_im[ i_bin ] + f_work[ i_bin ][ 1 ] * t_post_re[ i_bin ];
+            }
+            freq_data_out->set_chunk_counter( f_spectrum_counter++ );
+            f_sequence.stamp_output( *freq_data_out, f_ring_first_index, f_frame_size );
+            if ( ! out_stream< 0 >().set( stream::s_run ) )
+            {
+                LERROR( flog, "chirp_z_transform error setting frequency output stream to s_run" );
+                return false;
+            }
+
+            f_ring.consume( hop_size() );
+            f_ring_first_index += hop_size();
+        }
+        return true;
+    }
+
+    void chirp_z_transform::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the chirp-z transform" );
+
+            while (! is_canceled() )
+            {
+                midge::enum_t in_cmd = in_stream< 0 >().get();
+                unsigned in_stream_index = in_stream< 0 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    // samples from a previous acquisition must not leak into this one
+                    f_ring.clear();
+                    f_sequence.reset();
+                    f_spectrum_counter = 0;
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    out_buffer< 0 >().call( &frequency_data::set_bin_width, (float)bin_spacing_hz() );
+                    out_buffer< 0 >().call( &frequency_data::set_minimum_frequency, (float)f_min_frequency );
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_chunk( in_stream< 0 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "CHIRP-Z TRANSFORM is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void chirp_z_transform::finalize()
+    {
+        LINFO( flog, "in finalize(), freeing fftw data objects" );
+        out_buffer< 0 >().finalize();
+        if (f_forward_plan != NULL)
+        {
+            fftwf_destroy_plan(f_forward_plan);
+            f_forward_plan = NULL;
+        }
+        if (f_backward_plan != NULL)
+        {
+            fftwf_destroy_plan(f_backward_plan);
+            f_backward_plan = NULL;
+        }
+        if (f_work != NULL )
+        {
+            fftwf_free(f_work);
+            f_work = NULL;
+        }
+        if (f_kernel_spectrum != NULL)
+        {
+            fftwf_free(f_kernel_spectrum);
+            f_kernel_spectrum = NULL;
+        }
+        return;
+    }
+
+    void chirp_z_transform::setup_internal_maps()
+    {
+        f_transform_flag_map.clear();
+        f_transform_flag_map["ESTIMATE"] = FFTW_ESTIMATE;
+        f_transform_flag_map["MEASURE"] = FFTW_MEASURE;
+        f_transform_flag_map["PATIENT"] = FFTW_PATIENT;
+        f_transform_flag_map["EXHAUSTIVE"] = FFTW_EXHAUSTIVE;
+    }
+
+
+    // chirp_z_transform_binding methods
+    chirp_z_transform_binding::chirp_z_transform_binding() :
+            _tuned_node_binding< chirp_z_transform, chirp_z_transform_binding >()
+    {
+    }
+
+    chirp_z_transform_binding::~chirp_z_transform_binding()
+    {
+    }
+
+    void chirp_z_transform_binding::do_apply_node_config( chirp_z_transform* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring chirp_z_transform with:\n" << a_config );
+        a_node->set_freq_length( a_config.get_value( "freq-length", a_node->get_freq_length() ) );
+        a_node->set_frame_size( a_config.get_value( "frame-size", a_node->get_frame_size() ) );
+        a_node->set_n_bins( a_config.get_value( "n-bins", a_node->get_n_bins() ) );
+        a_node->set_min_frequency( a_config.get_value( "min-frequency", a_node->get_min_frequency() ) );
+        a_node->set_max_frequency( a_config.get_value( "max-frequency", a_node->get_max_frequency() ) );
+        a_node->set_samples_per_sec( a_config.get_value( "samples-per-sec", a_node->get_samples_per_sec() ) );
+        a_node->set_window( string_to_window_type( a_config.get_value( "window", window_type_to_string( a_node->get_window() ) ) ) );
+        a_node->set_kaiser_beta( a_config.get_value( "kaiser-beta", a_node->get_kaiser_beta() ) );
+        a_node->set_overlap_fraction( a_config.get_value( "overlap-fraction", a_node->get_overlap_fraction() ) );
+        a_node->set_transform_flag( a_config.get_value( "transform-flag", a_node->get_transform_flag() ) );
+        a_node->set_use_wisdom( a_config.get_value( "use-wisdom", a_node->get_use_wisdom() ) );
+        a_node->set_wisdom_filename( a_config.get_value( "wisdom-filename", a_node->get_wisdom_filename() ) );
+        return;
+    }
+
+    void chirp_z_transform_binding::do_dump_node_config( const chirp_z_transform* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping chirp_z_transform configuration" );
+        a_config.add( "freq-length", scarab::param_value( a_node->get_freq_length() ) );
+        a_config.add( "frame-size", scarab::param_value( a_node->get_frame_size() ) );
+        a_config.add( "n-bins", scarab::param_value( a_node->get_n_bins() ) );
+        a_config.add( "min-frequency", scarab::param_value( a_node->get_min_frequency() ) );
+        a_config.add( "max-frequency", scarab::param_value( a_node->get_max_frequency() ) );
+        a_config.add( "samples-per-sec", scarab::param_value( a_node->get_samples_per_sec() ) );
+        a_config.add( "window", scarab::param_value( window_type_to_string( a_node->get_window() ) ) );
+        a_config.add( "kaiser-beta", scarab::param_value( a_node->get_kaiser_beta() ) );
+        a_config.add( "overlap-fraction", scarab::param_value( a_node->get_overlap_fraction() ) );
+        a_config.add( "transform-flag", scarab::param_value( a_node->get_transform_flag() ) );
+        a_config.add( "use-wisdom", scarab::param_value( a_node->get_use_wisdom() ) );
+        a_config.add( "wisdom-filename", scarab::param_value( a_node->get_wisdom_filename() ) );
+        return;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,157 @@
+/*
+ * chirp_z_transform.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_CHIRP_Z_TRANSFORM_HH_
+#define FAST_DAQ_CHIRP_Z_TRANSFORM_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "frequency_data.hh"
+#include "real_time_data.hh"
+#include "sample_ring.hh"
+#include "window_functions.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+//external
+#include <fftw3.h>
+
+#include <map>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class chirp_z_transform
+     @brief A transformer that computes a zoomed spectrum over an arbitrary sub-band with the chirp-z transform.
+
+     @details
+     Each frame of frame-size real samples is evaluated at n-bins frequencies, evenly spaced from min-frequency up to
+     (but not including) max-frequency, with Bluestein's algorithm: the frame is multiplied by a precomputed chirp,
+     convolved with a second chirp using FFTW transforms of length L >= frame-size + n-bins - 1 (chosen to have only
+     small prime factors), and multiplied by a third chirp.  The chirps, the window and the frequency-domain convolution
+     kernel are all computed once in initialize(), so each frame costs two length-L complex FFTs and three complex
+     multiplies per point, independent of the full digitized bandwidth.
+
+     The frequency resolution is set by the frame size and window (samples-per-sec / frame-size times the window's ENBW);
+     n-bins sets the spacing at which the spectrum is evaluated within the band.  Frames are assembled from the input
+     through a sample ring, so frame-size is independent of the digitizer buffer size; overlap-fraction works as in
+     frequency-transform, including how spectra are sequenced.  The output is normalized like frequency-transform's (one-sided PSD, sqrt(2 / (fs * sum(w^2)))),
+     so it can feed the same downstream nodes.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "chirp-z-transform"
+
+     Available configuration values:
+     - "freq-length": uint -- The size of the output frequency-data buffer (default: 10)
+     - "frame-size": uint -- number of input samples in each transform (default: 65536)
+     - "n-bins": uint -- number of output frequencies (default: 1024)
+     - "min-frequency": double -- frequency of the first output bin in Hz
+     - "max-frequency": double -- upper edge of the output band in Hz; must be above min-frequency and at most samples-per-sec / 2
+     - "samples-per-sec": int -- the sampling rate for the upstream node
+     - "window": string -- window applied to each frame (default: "blackman-harris"); see frequency-transform for the options
+     - "kaiser-beta": double -- shape parameter of the Kaiser window (default: 8.6)
+     - "overlap-fraction": double -- fraction of each frame shared with the next one, in [0, 1) (default: 0)
+     - "transform-flag": string -- FFTW flag to indicate how much optimization of the fftwf_plan is desired
+     - "use-wisdom": bool -- whether to use a plan from a wisdom file and save the plan to that file
+     - "wisdom-filename": string -- if "use-wisdom" is true, resolvable path to the wisdom file
+
+     Input Stream:
+     - 0: real_time_data
+
+     Output Streams:
+     - 0: frequency_data
+    */
+    class chirp_z_transform : public midge::_transformer< midge::type_list< real_time_data >, midge::type_list< frequency_data > >, public thread_tuning
+    {
+        private:
+            typedef std::map< std::string, unsigned > transform_flag_map_t;
+
+        public:
+            chirp_z_transform();
+            virtual ~chirp_z_transform();
+
+        mv_accessible( uint64_t, freq_length );
+        mv_accessible( unsigned, frame_size );
+        mv_accessible( unsigned, n_bins );
+        mv_accessible( double, min_frequency );
+        mv_accessible( double, max_frequency );
+        mv_accessible( uint32_t, samples_per_sec );
+        mv_accessible( window_type_t, window );
+        mv_accessible( double, kaiser_beta );
+        mv_accessible( double, overlap_fraction );
+        mv_accessible( std::string, transform_flag );
+        mv_accessible( bool, use_wisdom );
+        mv_accessible( std::string, wisdom_filename );
+
+        // derived scalars
+        private:
+            double bin_spacing_hz() const;
+            unsigned hop_size() const;
+            /// Smallest length >= a_min_size with no prime factors above 7
+            static unsigned good_fft_size( unsigned a_min_size );
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            void build_chirps();
+            bool process_chunk( const real_time_data* a_time_data );
+
+            transform_flag_map_t f_transform_flag_map;
+            unsigned f_conv_size; // L
+
+            // window and input chirp, output chirp (with normalization); real and imaginary parts kept separately
+            std::vector< float > f_pre_chirp_re;
+            std::vector< float > f_pre_chirp_im;
+            std::vector< float > f_post_chirp_re;
+            std::vector< float > f_post_chirp_im;
+
+            sample_ring< U16 > f_ring;
+            uint64_t f_ring_first_index; // sample index of the oldest sample in the ring
+            sequence_tracker f_sequence;
+            uint64_t f_spectrum_counter;
+
+            fftwf_complex* f_kernel_spectrum; // FFT of the convolution chirp, scaled by 1/L
+            fftwf_complex* f_work;
+            fftwf_plan f_forward_plan;
+            fftwf_plan f_backward_plan;
+
+            bool f_multithreaded_is_initialized;
+
+        private:
+            void setup_internal_maps();
+
+    };
+
+    class chirp_z_transform_binding : public _tuned_node_binding< chirp_z_transform, chirp_z_transform_binding >
+    {
+        public:
+            chirp_z_transform_binding();
+            virtual ~chirp_z_transform_binding();
+
+        private:
+            virtual void do_apply_node_config( chirp_z_transform* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const chirp_z_transform* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_CHIRP_Z_TRANSFORM_HH_ */
@@ -7,6 +7,8 @@
 
 #include "data_producer.hh"
 
+#include "fast_daq_error.hh"
+
 #include "logger.hh"
 
 #include <thread>
@@ -27,6 +29,7 @@ namespace fast_daq
             f_data_value( 5 ),
             f_dynamic_range( 1. ),
             f_delay_time_ms( 500 ),
+            f_bits_per_sample( 16 ),
             f_primary_packet()
     {
         write_primary_packet();
@@ -49,7 +52,20 @@ namespace fast_daq
 
     void data_producer::initialize()
     {
+        if( f_bits_per_sample != 16 && f_bits_per_sample != 14 && f_bits_per_sample != 12 )
+        {
+            throw fast_daq::error() << "data_producer: bits-per-sample must be 12, 14 or 16, not " << f_bits_per_sample;
+        }
+        // the configuration may have changed the size or value since construction
+        write_primary_packet();
         out_buffer< 0 >().initialize( f_length );
+
+        // the blocks are filled once, here, rather than when first used
+        const U16* t_samples = f_primary_packet.get_time_series();
+        out_buffer< 0 >().call( &real_time_data::allocate_array, f_data_size );
+        out_buffer< 0 >().call( &real_time_data::set_dynamic_range, static_cast< float >( f_dynamic_range ) );
+        out_buffer< 0 >().call( &real_time_data::set_bits_per_sample, f_bits_per_sample );
+        out_buffer< 0 >().call( &real_time_data::set_samples, t_samples );
     }
 
     void data_producer::execute( midge::diptera* a_midge )
@@ -58,6 +74,7 @@ namespace fast_daq
 
         try
         {
+            tune_current_thread( get_name() );
             real_time_data* t_block = nullptr;
 
             //LDEBUG( plog, "Server is listening" );
@@ -65,16 +82,20 @@ namespace fast_daq
             if( ! out_stream< 0 >().set( stream::s_start ) ) return;
 
             ssize_t t_size_received = 0;
+            uint64_t t_chunk_counter = 0;
 
             LINFO( plog, "Starting main loop; sending packets" );
             //unsigned count = 0;
             while( ! is_canceled() )
             {
                 t_block = out_stream< 0 >().data();
-                if( t_block->get_array_size() != f_data_size )
-                {
-                    initialize_block( t_block );
-                }
+                // one uninterrupted acquisition
+                t_block->set_chunk_counter( t_chunk_counter );
+                t_block->set_acquisition_id( 0 );
+                t_block->set_first_sample_index( t_chunk_counter * f_data_size );
+                t_block->set_sample_span( f_data_size );
+                t_block->set_samples_lost( 0 );
+                ++t_chunk_counter;
 
                 t_size_received = 0;
 
@@ -117,17 +138,8 @@ namespace fast_daq
         return;
     }
 
-    void data_producer::initialize_block( real_time_data* a_block )
-    {
-        a_block->allocate_array( f_data_size );
-
-        ::memcpy( a_block->get_time_series(), f_primary_packet.get_time_series(), f_data_size*sizeof(U16) );
-
-        return;
-    }
-
     data_producer_binding::data_producer_binding() :
-            sandfly::_node_binding< data_producer, data_producer_binding >()
+            _tuned_node_binding< data_producer, data_producer_binding >()
     {
     }
 
@@ -135,7 +147,7 @@ namespace fast_daq
     {
     }
 
-    void data_producer_binding::do_apply_config( data_producer* a_node, const scarab::param_node& a_config ) const
+    void data_producer_binding::do_apply_node_config( data_producer* a_node, const scarab::param_node& a_config ) const
     {
         LDEBUG( plog, "Configuring data_producer with:\n" << a_config );
         a_node->set_length( a_config.get_value( "length", a_node->get_length() ) );
@@ -143,10 +155,11 @@ namespace fast_daq
         a_node->set_data_value( a_config.get_value( "data-value", a_node->get_data_value() ) );
         a_node->set_dynamic_range( a_config.get_value( "dynamic-range", a_node->get_dynamic_range() ) );
         a_node->set_delay_time_ms( a_config.get_value( "delay-time-ms", a_node->get_delay_time_ms() ) );
+        a_node->set_bits_per_sample( a_config.get_value( "bits-per-sample", a_node->get_bits_per_sample() ) );
         return;
     }
 
-    void data_producer_binding::do_dump_config( const data_producer* a_node, scarab::param_node& a_config ) const
+    void data_producer_binding::do_dump_node_config( const data_producer* a_node, scarab::param_node& a_config ) const
     {
         LDEBUG( plog, "Dumping data_producer configuration" );
         a_config.add( "length", scarab::param_value( a_node->get_length() ) );
@@ -154,6 +167,7 @@ namespace fast_daq
         a_config.add( "data-value", scarab::param_value( a_node->get_data_value() ) );
         a_config.add( "dynamic-range", scarab::param_value( a_node->get_dynamic_range() ) );
         a_config.add( "delay-time-ms", scarab::param_value( a_node->get_delay_time_ms() ) );
+        a_config.add( "bits-per-sample", scarab::param_value( a_node->get_bits_per_sample() ) );
         return;
 
     }
@@ -11,6 +11,7 @@
 #include "real_time_data.hh"
 
 #include "node_builder.hh"
+#include "thread_tuning.hh"
 
 #include "producer.hh"
 
@@ -25,7 +26,7 @@ namespace fast_daq
 
      @details
 
-     The data are all output as `real_time_data` objects.
+     The data are all output as `real_time_data` objects, sequenced as one acquisition without losses.
 
      Parameter setting is not thread-safe.  Executing is thread-safe.
 
@@ -37,12 +38,14 @@ namespace fast_daq
      - "data-value": uint16 -- The value of the digitized data (all bins will be the same)
      - "dynamic-range": double -- The dynamic range of the data when converted to floating-point
      - "record-delay-ms": uint -- Delay time between outputting data objects in ms
+     - "bits-per-sample": uint -- 16 for plain 16-bit samples, or 12 or 14 to send the samples packed to that many bits, as from a
+       lower-resolution digitizer (the low bits of data-value are dropped) (default: 16)
 
      Output Stream:
      - 0: real_time_data
 
     */
-    class data_producer : public midge::_producer< midge::type_list< real_time_data > >
+    class data_producer : public midge::_producer< midge::type_list< real_time_data > >, public thread_tuning
     {
         public:
             data_producer();
@@ -53,6 +56,7 @@ namespace fast_daq
             mv_accessible( uint16_t, data_value );
             mv_accessible( double, dynamic_range );
             mv_accessible( uint32_t, delay_time_ms );
+            mv_accessible( unsigned, bits_per_sample );
 
             mv_referrable( real_time_data, primary_packet );
 
@@ -63,20 +67,17 @@ namespace fast_daq
             virtual void execute( midge::diptera* a_midge = nullptr );
             virtual void finalize();
 
-        private:
-            void initialize_block( real_time_data* a_block );
-
     };
 
-    class data_producer_binding : public sandfly::_node_binding< data_producer, data_producer_binding >
+    class data_producer_binding : public _tuned_node_binding< data_producer, data_producer_binding >
     {
         public:
             data_producer_binding();
             virtual ~data_producer_binding();
 
         private:
-            virtual void do_apply_config( data_producer* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const data_producer* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config( data_producer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const data_producer* a_node, scarab::param_node& a_config ) const;
     };
 
 } /* namespace fast_daq */
@@ -49,6 +49,7 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             unsigned t_received = 0;
             while (! is_canceled() )
             {
@@ -137,12 +138,12 @@ namespace fast_daq
     {
     }
 
-    void dead_end_binding::do_apply_config(dead_end* a_node, const scarab::param_node& a_config ) const
+    void dead_end_binding::do_apply_node_config(dead_end* a_node, const scarab::param_node& a_config ) const
     {
         a_node->set_input_index( a_config.get_value( "input-index", a_node->get_input_index() ) );
     }
 
-    void dead_end_binding::do_dump_config( const dead_end* a_node, scarab::param_node& a_config ) const
+    void dead_end_binding::do_dump_node_config( const dead_end* a_node, scarab::param_node& a_config ) const
     {
         a_config.add( "input-index", scarab::param_value( a_node->get_input_index() ) );
     }
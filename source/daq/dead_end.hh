@@ -11,6 +11,7 @@
 // sandfly includes
 //#include "memory_block.hh"
 #include "node_builder.hh"
+#include "thread_tuning.hh"
 
 //#include "control_access.hh"
 #include "consumer.hh"
@@ -49,7 +50,7 @@ namespace fast_daq
      - 3: iq_time_data
 
     */
-    class dead_end : public midge::_consumer< midge::type_list< real_time_data, frequency_data, power_data, iq_time_data > >
+    class dead_end : public midge::_consumer< midge::type_list< real_time_data, frequency_data, power_data, iq_time_data > >, public thread_tuning
     {
         public:
             dead_end();
@@ -64,15 +65,15 @@ namespace fast_daq
 
     };
 
-    class dead_end_binding : public sandfly::_node_binding< dead_end, dead_end_binding >
+    class dead_end_binding : public _tuned_node_binding< dead_end, dead_end_binding >
     {
         public:
             dead_end_binding();
             virtual ~dead_end_binding();
 
         private:
-            virtual void do_apply_config(dead_end* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const dead_end* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config(dead_end* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const dead_end* a_node, scarab::param_node& a_config ) const;
     };
 } /* namespace fast_daq */
 #endif /* DEAD_END_HH_ */
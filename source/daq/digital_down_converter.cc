@@ -0,0 +1,458 @@
+/*
+ * digital_down_converter.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "digital_down_converter.hh"
+
+#include "window_functions.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( digital_down_converter, "digital-down-converter", digital_down_converter_binding );
+
+    LOGGER( flog, "digital_down_converter" );
+
+    // mixed samples are held as integers with this many fractional bits before the CIC
+    static const double s_mix_scale = 32768.;
+    // ADC codes are centered on mid-scale before mixing
+    static const float s_adc_mid_scale = 32768.;
+
+    digital_down_converter::digital_down_converter() :
+            f_time_length( 10 ),
+            f_output_size( 4096 ),
+            f_samples_per_sec( 0 ),
+            f_nco_frequency( 0. ),
+            f_cic_decimation( 16 ),
+            f_cic_order( 4 ),
+            f_fir_decimation( 4 ),
+            f_fir_taps( 64 ),
+            f_fir_passband_fraction( 0.8 ),
+            f_compact_format( compact_data::compact_format_t::none ),
+            f_compact_scale( 0. ),
+            f_compact_only( false ),
+            f_unpacked(),
+            f_nco_cycles_per_sample( 0. ),
+            f_nco_phase( 0. ),
+            f_nco_table_re(),
+            f_nco_table_im(),
+            f_mixed_i( s_nco_block ),
+            f_mixed_q( s_nco_block ),
+            f_integrators_i(),
+            f_integrators_q(),
+            f_combs_i(),
+            f_combs_q(),
+            f_cic_phase( 0 ),
+            f_cic_to_volts( 1. ),
+            f_fir_coeffs(),
+            f_fir_history_i(),
+            f_fir_history_q(),
+            f_fir_fill( 0 ),
+            f_fir_first_index( 0 ),
+            f_current_output( nullptr ),
+            f_staging(),
+            f_output_fill( 0 ),
+            f_output_first_index( 0 ),
+            f_output_counter( 0 ),
+            f_sequence(),
+            f_volts_per_code( 0. )
+    {
+    }
+
+    digital_down_converter::~digital_down_converter()
+    {
+    }
+
+    double digital_down_converter::output_rate() const
+    {
+        return (double)f_samples_per_sec / (double)( f_cic_decimation * f_fir_decimation );
+    }
+
+    void digital_down_converter::initialize()
+    {
+        if ( f_samples_per_sec == 0 ) throw fast_daq::error() << "digital-down-converter requires samples-per-sec to be set";
+        if ( f_output_size == 0 ) throw fast_daq::error() << "digital-down-converter requires a non-zero output-size";
+        if ( f_cic_decimation == 0 || f_fir_decimation == 0 ) throw fast_daq::error() << "digital-down-converter decimation factors must be at least 1";
+        if ( f_cic_order == 0 ) throw fast_daq::error() << "digital-down-converter requires a CIC order of at least 1";
+        if ( f_fir_taps == 0 ) throw fast_daq::error() << "digital-down-converter requires at least 1 FIR tap";
+        if ( f_fir_passband_fraction <= 0. || f_fir_passband_fraction > 1. ) throw fast_daq::error() << "fir-passband-fraction must be in (0, 1]";
+        if ( f_compact_only && f_compact_format == compact_data::compact_format_t::none ) throw fast_daq::error() << "compact-only requires a compact-format";
+
+        // CIC bit growth: order * ceil(log2(decimation)) on top of the 32-bit signed mixer output must fit in 64 bits
+        unsigned t_log2_decimation = 0;
+        while ( ( 1ULL << t_log2_decimation ) < f_cic_decimation ) ++t_log2_decimation;
+        if ( 32 + f_cic_order * t_log2_decimation > 64 )
+        {
+            throw fast_daq::error() << "CIC with order " << f_cic_order << " and decimation " << f_cic_decimation << " grows by " <<
+                    f_cic_order * t_log2_decimation << " bits, which overflows the 64-bit accumulators; reduce the order or the CIC decimation";
+        }
+
+        out_buffer< 0 >().initialize( f_time_length );
+        out_buffer< 0 >().call( &iq_time_data::allocate_container, f_output_size );
+        if ( f_compact_only ) f_staging.allocate_container( f_output_size );
+
+        build_nco_table();
+        build_fir();
+
+        // CIC gain is decimation^order
+        f_cic_to_volts = 1. / s_mix_scale;
+        for ( unsigned i_stage = 0; i_stage < f_cic_order; ++i_stage ) f_cic_to_volts /= (double)f_cic_decimation;
+
+        LINFO( flog, "Mixing " << f_nco_frequency << " Hz to baseband and decimating by " << f_cic_decimation << " (CIC, order " << f_cic_order <<
+                ") x " << f_fir_decimation << " (FIR, " << f_fir_taps << " taps); output rate is " << output_rate() << " samples/s" );
+        return;
+    }
+
+    void digital_down_converter::build_nco_table()
+    {
+        f_nco_cycles_per_sample = f_nco_frequency / (double)f_samples_per_sec;
+        f_nco_cycles_per_sample -= floor( f_nco_cycles_per_sample );
+        f_nco_table_re.resize( s_nco_block );
+        f_nco_table_im.resize( s_nco_block );
+        for ( unsigned i_sample = 0; i_sample < s_nco_block; ++i_sample )
+        {
+            double t_phase = -2. * M_PI * f_nco_cycles_per_sample * (double)i_sample;
+            f_nco_table_re[ i_sample ] = cos( t_phase );
+            f_nco_table_im[ i_sample ] = sin( t_phase );
+        }
+        return;
+    }
+
+    void digital_down_converter::build_fir()
+    {
+        // windowed sinc at the CIC output rate; unit gain at DC
+        const double t_cutoff = 0.5 * f_fir_passband_fraction / (double)f_fir_decimation; // cycles per CIC-output sample
+        if ( f_fir_taps > 1 )
+        {
+            // symmetric window: the periodic window of one point fewer, closed with its first point
+            make_window( window_type_t::blackman_harris, f_fir_taps - 1, f_fir_coeffs );
+            f_fir_coeffs.push_back( f_fir_coeffs[ 0 ] );
+        }
+        else
+        {
+            f_fir_coeffs.assign( 1, 1. );
+        }
+        const double t_center = 0.5 * (double)( f_fir_taps - 1 );
+        double t_sum = 0.;
+        for ( unsigned i_tap = 0; i_tap < f_fir_taps; ++i_tap )
+        {
+            double t_x = 2. * t_cutoff * ( (double)i_tap - t_center );
+            double t_sinc = t_x == 0. ? 1. : sin( M_PI * t_x ) / ( M_PI * t_x );
+            f_fir_coeffs[ i_tap ] *= t_sinc;
+            t_sum += f_fir_coeffs[ i_tap ];
+        }
+        for ( float& t_coeff : f_fir_coeffs ) t_coeff /= t_sum;
+        return;
+    }
+
+    void digital_down_converter::reset_state()
+    {
+        f_nco_phase = 0.;
+        f_integrators_i.assign( f_cic_order, 0 );
+        f_integrators_q.assign( f_cic_order, 0 );
+        f_combs_i.assign( f_cic_order, 0 );
+        f_combs_q.assign( f_cic_order, 0 );
+        f_cic_phase = 0;
+        f_fir_fill = 0;
+        f_fir_first_index = 0;
+        f_current_output = nullptr;
+        f_output_fill = 0;
+        f_output_counter = 0;
+        return;
+    }
+
+    void digital_down_converter::mix_block( const U16* a_samples, unsigned a_n_samples )
+    {
+        // the block's starting phase is exact (double precision, reduced modulo one cycle); within the block the table rotates it
+        const double t_base_phase = -2. * M_PI * f_nco_phase;
+        const float t_base_re = cos( t_base_phase );
+        const float t_base_im = sin( t_base_phase );
+        const float t_scale = s_mix_scale;
+        for ( unsigned i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            float t_rot_re = t_base_re * f_nco_table_re[ i_sample ] - t_base_im * f_nco_table_im[ i_sample ];
+            float t_rot_im = t_base_re * f_nco_table_im[ i_sample ] + t_base_im * f_nco_table_re[ i_sample ];
+            float t_value = ( static_cast< float >( a_samples[ i_sample ] ) - s_adc_mid_scale ) * t_scale;
+            f_mixed_i[ i_sample ] = static_cast< int64_t >( t_value * t_rot_re );
+            f_mixed_q[ i_sample ] = static_cast< int64_t >( t_value * t_rot_im );
+        }
+        f_nco_phase += f_nco_cycles_per_sample * (double)a_n_samples;
+        f_nco_phase -= floor( f_nco_phase );
+        return;
+    }
+
+    void digital_down_converter::run_cic( unsigned a_n_samples )
+    {
+        if ( f_fir_history_i.size() < f_fir_fill + a_n_samples )
+        {
+            f_fir_history_i.resize( f_fir_fill + a_n_samples );
+            f_fir_history_q.resize( f_fir_fill + a_n_samples );
+        }
+
+        const float t_to_volts = f_cic_to_volts * f_volts_per_code * M_SQRT2;
+        if ( f_cic_decimation == 1 )
+        {
+            for ( unsigned i_sample = 0; i_sample < a_n_samples; ++i_sample )
+            {
+                f_fir_history_i[ f_fir_fill + i_sample ] = (float)f_mixed_i[ i_sample ] * t_to_volts;
+                f_fir_history_q[ f_fir_fill + i_sample ] = (float)f_mixed_q[ i_sample ] * t_to_volts;
+            }
+            f_fir_fill += a_n_samples;
+            return;
+        }
+
+        // unsigned arithmetic wraps modulo 2^64, so integrator overflow cancels in the combs
+        for ( unsigned i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            uint64_t t_value_i = static_cast< uint64_t >( f_mixed_i[ i_sample ] );
+            uint64_t t_value_q = static_cast< uint64_t >( f_mixed_q[ i_sample ] );
+            for ( unsigned i_stage = 0; i_stage < f_cic_order; ++i_stage )
+            {
+                t_value_i = f_integrators_i[ i_stage ] += t_value_i;
+                t_value_q = f_integrators_q[ i_stage ] += t_value_q;
+            }
+            if ( ++f_cic_phase < f_cic_decimation ) continue;
+            f_cic_phase = 0;
+
+            for ( unsigned i_stage = 0; i_stage < f_cic_order; ++i_stage )
+            {
+                uint64_t t_delayed_i = f_combs_i[ i_stage ];
+                uint64_t t_delayed_q = f_combs_q[ i_stage ];
+                f_combs_i[ i_stage ] = t_value_i;
+                f_combs_q[ i_stage ] = t_value_q;
+                t_value_i -= t_delayed_i;
+                t_value_q -= t_delayed_q;
+            }
+            f_fir_history_i[ f_fir_fill ] = (float)static_cast< int64_t >( t_value_i ) * t_to_volts;
+            f_fir_history_q[ f_fir_fill ] = (float)static_cast< int64_t >( t_value_q ) * t_to_volts;
+            ++f_fir_fill;
+        }
+        return;
+    }
+
+    bool digital_down_converter::run_fir()
+    {
+        const uint64_t t_n_taps = f_fir_coeffs.size();
+        uint64_t t_position = 0;
+        while ( t_position + t_n_taps <= f_fir_fill )
+        {
+            const float* t_in_i = f_fir_history_i.data() + t_position;
+            const float* t_in_q = f_fir_history_q.data() + t_position;
+            float t_out_i = 0.;
+            float t_out_q = 0.;
+            for ( uint64_t i_tap = 0; i_tap < t_n_taps; ++i_tap )
+            {
+                t_out_i += f_fir_coeffs[ i_tap ] * t_in_i[ i_tap ];
+                t_out_q += f_fir_coeffs[ i_tap ] * t_in_q[ i_tap ];
+            }
+
+            if ( f_current_output == nullptr )
+            {
+                f_current_output = out_stream< 0 >().data();
+                f_output_fill = 0;
+                f_output_first_index = f_fir_first_index + t_position * f_cic_decimation;
+            }
+            iq_time_data::complex_t* t_samples = ( f_compact_only ? &f_staging : f_current_output )->get_data_array();
+            t_samples[ f_output_fill ][ 0 ] = t_out_i;
+            t_samples[ f_output_fill ][ 1 ] = t_out_q;
+            if ( ++f_output_fill == f_output_size )
+            {
+                f_current_output->set_chunk_counter( f_output_counter++ );
+                uint64_t t_end_index = f_fir_first_index + ( t_position + t_n_taps ) * f_cic_decimation;
+                f_sequence.stamp_output( *f_current_output, f_output_first_index, t_end_index - f_output_first_index );
+                if ( f_compact_only )
+                {
+                    f_staging.make_compact( f_compact_format, f_compact_scale );
+                    f_current_output->take_compact( f_staging );
+                }
+                else
+                {
+                    f_current_output->make_compact( f_compact_format, f_compact_scale );
+                }
+                f_current_output = nullptr;
+                if ( ! out_stream< 0 >().set( stream::s_run ) )
+                {
+                    LERROR( flog, "digital_down_converter error setting IQ output stream to s_run" );
+                    return false;
+                }
+            }
+
+            t_position += f_fir_decimation;
+        }
+
+        // keep the samples that later outputs still need
+        t_position = std::min( t_position, f_fir_fill );
+        f_fir_fill -= t_position;
+        f_fir_first_index += t_position * f_cic_decimation;
+        if ( t_position > 0 && f_fir_fill > 0 )
+        {
+            ::memmove( f_fir_history_i.data(), f_fir_history_i.data() + t_position, sizeof(float) * f_fir_fill );
+            ::memmove( f_fir_history_q.data(), f_fir_history_q.data() + t_position, sizeof(float) * f_fir_fill );
+        }
+        return true;
+    }
+
+    bool digital_down_converter::process_chunk( const real_time_data* a_time_data )
+    {
+        if ( f_sequence.add_input( *a_time_data ) )
+        {
+            // the filters can't run across a break in the input: start them afresh, dropping any incomplete output chunk
+            uint64_t t_output_counter = f_output_counter;
+            reset_state();
+            f_output_counter = t_output_counter;
+            f_fir_first_index = a_time_data->get_first_sample_index();
+        }
+        f_volts_per_code = a_time_data->get_dynamic_range() / 65536.;
+        const unsigned t_n_samples = a_time_data->get_array_size();
+        const U16* t_samples = a_time_data->get_time_series();
+        if ( a_time_data->get_packed() )
+        {
+            f_unpacked.resize( t_n_samples );
+            a_time_data->copy_samples( f_unpacked.data() );
+            t_samples = f_unpacked.data();
+        }
+        for ( unsigned i_block = 0; i_block < t_n_samples; i_block += s_nco_block )
+        {
+            unsigned t_block_size = std::min( s_nco_block, t_n_samples - i_block );
+            mix_block( t_samples + i_block, t_block_size );
+            run_cic( t_block_size );
+        }
+        return run_fir();
+    }
+
+    void digital_down_converter::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the digital down-converter" );
+
+            LINFO( flog, "Starting main loop (digital down-converter)" );
+            while (! is_canceled() )
+            {
+                midge::enum_t in_cmd = in_stream< 0 >().get();
+                unsigned in_stream_index = in_stream< 0 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">; dropping " << f_output_fill << " samples of an incomplete output chunk" );
+                    f_current_output = nullptr;
+                    f_output_fill = 0;
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    reset_state();
+                    f_sequence.reset();
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_chunk( in_stream< 0 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "DIGITAL DOWN-CONVERTER is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void digital_down_converter::finalize()
+    {
+        out_buffer< 0 >().finalize();
+        return;
+    }
+
+
+    // digital_down_converter_binding methods
+    digital_down_converter_binding::digital_down_converter_binding() :
+            _tuned_node_binding< digital_down_converter, digital_down_converter_binding >()
+    {
+    }
+
+    digital_down_converter_binding::~digital_down_converter_binding()
+    {
+    }
+
+    void digital_down_converter_binding::do_apply_node_config( digital_down_converter* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring digital_down_converter with:\n" << a_config );
+        a_node->set_time_length( a_config.get_value( "time-length", a_node->get_time_length() ) );
+        a_node->set_output_size( a_config.get_value( "output-size", a_node->get_output_size() ) );
+        a_node->set_samples_per_sec( a_config.get_value( "samples-per-sec", a_node->get_samples_per_sec() ) );
+        a_node->set_nco_frequency( a_config.get_value( "nco-frequency", a_node->get_nco_frequency() ) );
+        a_node->set_cic_decimation( a_config.get_value( "cic-decimation", a_node->get_cic_decimation() ) );
+        a_node->set_cic_order( a_config.get_value( "cic-order", a_node->get_cic_order() ) );
+        a_node->set_fir_decimation( a_config.get_value( "fir-decimation", a_node->get_fir_decimation() ) );
+        a_node->set_fir_taps( a_config.get_value( "fir-taps", a_node->get_fir_taps() ) );
+        a_node->set_fir_passband_fraction( a_config.get_value( "fir-passband-fraction", a_node->get_fir_passband_fraction() ) );
+        a_node->set_compact_format( compact_data::string_to_compact_format( a_config.get_value( "compact-format", compact_data::compact_format_to_string( a_node->get_compact_format() ) ) ) );
+        a_node->set_compact_scale( a_config.get_value( "compact-scale", a_node->get_compact_scale() ) );
+        a_node->set_compact_only( a_config.get_value( "compact-only", a_node->get_compact_only() ) );
+        return;
+    }
+
+    void digital_down_converter_binding::do_dump_node_config( const digital_down_converter* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping digital_down_converter configuration" );
+        a_config.add( "time-length", scarab::param_value( a_node->get_time_length() ) );
+        a_config.add( "output-size", scarab::param_value( a_node->get_output_size() ) );
+        a_config.add( "samples-per-sec", scarab::param_value( a_node->get_samples_per_sec() ) );
+        a_config.add( "nco-frequency", scarab::param_value( a_node->get_nco_frequency() ) );
+        a_config.add( "cic-decimation", scarab::param_value( a_node->get_cic_decimation() ) );
+        a_config.add( "cic-order", scarab::param_value( a_node->get_cic_order() ) );
+        a_config.add( "fir-decimation", scarab::param_value( a_node->get_fir_decimation() ) );
+        a_config.add( "fir-taps", scarab::param_value( a_node->get_fir_taps() ) );
+        a_config.add( "fir-passband-fraction", scarab::param_value( a_node->get_fir_passband_fraction() ) );
+        a_config.add( "compact-format", scarab::param_value( compact_data::compact_format_to_string( a_node->get_compact_format() ) ) );
+        a_config.add( "compact-scale", scarab::param_value( a_node->get_compact_scale() ) );
+        a_config.add( "compact-only", scarab::param_value( a_node->get_compact_only() ) );
+        return;
+    }
+
+} /* namespace fast_daq */
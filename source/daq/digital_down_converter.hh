@@ -0,0 +1,167 @@
+/*
+ * digital_down_converter.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_DIGITAL_DOWN_CONVERTER_HH_
+#define FAST_DAQ_DIGITAL_DOWN_CONVERTER_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "iq_time_data.hh"
+#include "real_time_data.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+
+#include <cstdint>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class digital_down_converter
+     @brief A transformer that mixes real time data down to baseband and decimates it to IQ time data.
+
+     @details
+     Processing chain:
+     1. NCO mixing: each ADC sample (centered on mid-scale) is multiplied by exp(-2 pi i f_nco t).
+        The NCO runs in blocks: the phase at the start of each block is kept in double precision and reduced modulo one cycle,
+        and the samples within a block are rotated by a fixed table, so the phase does not drift over long runs.
+     2. CIC decimation by cic-decimation, with cic-order integrator/comb stages.  The CIC uses integer arithmetic with
+        64-bit wraparound, which is exact as long as the bit growth fits; this is checked when the node is initialized.
+     3. FIR decimation by fir-decimation with a windowed-sinc (Blackman-Harris) low-pass filter of fir-taps coefficients.
+
+     All filter and NCO state is carried across input chunks, so the output is independent of the input chunking.
+     At a break in the input sequence (see sequence_tracker) the filters and NCO start afresh and any incomplete output
+     chunk is dropped, its samples being counted as lost.  Each output chunk is sequenced by the input samples its
+     filter windows covered, so its first sample index is in input samples, not output samples.
+     The output is emitted in chunks of output-size samples with the output rate samples-per-sec / (cic-decimation * fir-decimation).
+     Output samples are in volts, scaled by sqrt(2) so that the power of the complex baseband signal equals the power of
+     the real input signal in the selected band.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "digital-down-converter"
+
+     Available configuration values:
+     - "time-length": uint -- The size of the output time-data buffer
+     - "output-size": uint -- number of IQ samples in each output chunk (default: 4096)
+     - "samples-per-sec": int -- the sampling rate for the upstream node
+     - "nco-frequency": double -- frequency (in Hz) that is mixed down to zero
+     - "cic-decimation": uint -- decimation factor of the CIC stage; 1 disables the CIC (default: 16)
+     - "cic-order": uint -- number of integrator/comb pairs in the CIC (default: 4)
+     - "fir-decimation": uint -- decimation factor of the FIR stage (default: 4)
+     - "fir-taps": uint -- number of FIR coefficients (default: 64)
+     - "fir-passband-fraction": double -- FIR cutoff as a fraction of the output Nyquist frequency (default: 0.8)
+     - "compact-format": string -- also encode each output chunk in 16 bits, for relays and writers: "none", "float16", "bfloat16" or "int16"; see compact_data (default: "none")
+     - "compact-scale": double -- for int16, the value of one code; 0 to scale each chunk to its largest value (default: 0)
+     - "compact-only": bool -- fill only the 16-bit copy of each output chunk, not its full-precision samples, for output
+       that only goes to writers; needs a compact-format (default: false)
+
+     Input Stream:
+     - 0: real_time_data
+
+     Output Streams:
+     - 0: iq_time_data
+    */
+    class digital_down_converter : public midge::_transformer< midge::type_list< real_time_data >, midge::type_list< iq_time_data > >, public thread_tuning
+    {
+        public:
+            digital_down_converter();
+            virtual ~digital_down_converter();
+
+        mv_accessible( uint64_t, time_length );
+        mv_accessible( unsigned, output_size );
+        mv_accessible( uint32_t, samples_per_sec );
+        mv_accessible( double, nco_frequency );
+        mv_accessible( unsigned, cic_decimation );
+        mv_accessible( unsigned, cic_order );
+        mv_accessible( unsigned, fir_decimation );
+        mv_accessible( unsigned, fir_taps );
+        mv_accessible( double, fir_passband_fraction );
+        mv_accessible( compact_data::compact_format_t, compact_format );
+        mv_accessible( float, compact_scale );
+        mv_accessible( bool, compact_only );
+
+        public:
+            double output_rate() const;
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            void reset_state();
+            void build_nco_table();
+            void build_fir();
+            bool process_chunk( const real_time_data* a_time_data );
+            void mix_block( const U16* a_samples, unsigned a_n_samples );
+            void run_cic( unsigned a_n_samples );
+            bool run_fir();
+
+            std::vector< U16 > f_unpacked; // input samples, if they arrive packed
+
+            // NCO
+            static constexpr unsigned s_nco_block = 64;
+            double f_nco_cycles_per_sample;
+            double f_nco_phase; // phase at the start of the next block, in cycles, in [0, 1)
+            std::vector< float > f_nco_table_re;
+            std::vector< float > f_nco_table_im;
+            std::vector< int64_t > f_mixed_i;
+            std::vector< int64_t > f_mixed_q;
+
+            // CIC (integer, 64-bit wraparound)
+            std::vector< uint64_t > f_integrators_i;
+            std::vector< uint64_t > f_integrators_q;
+            std::vector< uint64_t > f_combs_i;
+            std::vector< uint64_t > f_combs_q;
+            unsigned f_cic_phase;
+            double f_cic_to_volts;
+
+            // FIR decimator; input samples not yet consumed are kept between chunks
+            std::vector< float > f_fir_coeffs;
+            std::vector< float > f_fir_history_i;
+            std::vector< float > f_fir_history_q;
+            uint64_t f_fir_fill;
+            uint64_t f_fir_first_index; // input sample index at which the oldest FIR history sample starts
+
+            // output accumulation; in compact-only mode the samples go to the staging chunk, and only their compact copy to the output
+            iq_time_data* f_current_output;
+            iq_time_data f_staging;
+            unsigned f_output_fill;
+            uint64_t f_output_first_index;
+            uint64_t f_output_counter;
+            sequence_tracker f_sequence;
+            float f_volts_per_code;
+
+    };
+
+
+    class digital_down_converter_binding : public _tuned_node_binding< digital_down_converter, digital_down_converter_binding >
+    {
+        public:
+            digital_down_converter_binding();
+            virtual ~digital_down_converter_binding();
+
+        private:
+            virtual void do_apply_node_config( digital_down_converter* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const digital_down_converter* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_DIGITAL_DOWN_CONVERTER_HH_ */
@@ -7,15 +7,21 @@
 
 #include "egg_writer.hh"
 
-//#include "logger.hh"
+#include "digital.hh"
+#include "logger.hh"
+#include "param.hh"
 
-//#include "fast_daq_error.hh"
+#include "fast_daq_error.hh"
+
+#include <sstream>
 
 namespace fast_daq
 {
     LOGGER( plog, "egg_writer" );
 
-    egg_writer::egg_writer()
+    egg_writer::egg_writer() :
+            f_compact_format( compact_data::compact_format_t::none ),
+            f_compact_scale( 0. )
     {
     }
 
@@ -23,4 +29,98 @@ namespace fast_daq
     {
     }
 
+    void egg_writer::apply_compact_config( const scarab::param_node& a_config )
+    {
+        set_compact_format( compact_data::string_to_compact_format( a_config.get_value( "compact-format", compact_data::compact_format_to_string( f_compact_format ) ) ) );
+        set_compact_scale( a_config.get_value( "compact-scale", f_compact_scale ) );
+        // the scale goes in the header, so it can't be set from the data
+        if( f_compact_format == compact_data::compact_format_t::int16 && f_compact_scale <= 0. )
+        {
+            throw fast_daq::error() << "int16 records need a compact-scale greater than 0, matching the producer's";
+        }
+        return;
+    }
+
+    void egg_writer::dump_compact_config( scarab::param_node& a_config ) const
+    {
+        a_config.add( "compact-format", scarab::param_value( compact_data::compact_format_to_string( f_compact_format ) ) );
+        a_config.add( "compact-scale", scarab::param_value( f_compact_scale ) );
+        return;
+    }
+
+    bool egg_writer::writes_compact() const
+    {
+        return f_compact_format != compact_data::compact_format_t::none;
+    }
+
+    unsigned egg_writer::record_data_type_size( unsigned a_data_type_size ) const
+    {
+        return writes_compact() ? sizeof(uint16_t) : a_data_type_size;
+    }
+
+    uint32_t egg_writer::record_data_format( uint32_t a_data_format ) const
+    {
+        if( f_compact_format == compact_data::compact_format_t::int16 ) return monarch3::sDigitizedS;
+        if( writes_compact() ) return monarch3::sAnalog;
+        return a_data_format;
+    }
+
+    std::string egg_writer::compact_description() const
+    {
+        std::stringstream t_description;
+        switch( f_compact_format )
+        {
+            case compact_data::compact_format_t::float16:
+                t_description << "IEEE half-precision (float16) values";
+                break;
+            case compact_data::compact_format_t::bfloat16:
+                t_description << "bfloat16 values (the upper 16 bits of a float)";
+                break;
+            case compact_data::compact_format_t::int16:
+                t_description << "int16 codes; value = code * " << f_compact_scale;
+                break;
+            default:
+                break;
+        }
+        return t_description.str();
+    }
+
+    void egg_writer::set_compact_calib_params( scarab::dig_calib_params& a_params ) const
+    {
+        if( f_compact_format != compact_data::compact_format_t::int16 ) return;
+        a_params.v_offset = 0.;
+        a_params.dac_gain = f_compact_scale;
+        a_params.v_range = f_compact_scale * 65536.;
+        return;
+    }
+
+    const void* egg_writer::compact_record( const compact_data& a_data, uint64_t a_bytes_per_record ) const
+    {
+        if( ! writes_compact() )
+        {
+            if( a_data.get_compact_only() )
+            {
+                throw fast_daq::error() << "the input carries only its " << compact_data::compact_format_to_string( a_data.get_compact_format() )
+                        << " copy; set the writer's compact-format to write it";
+            }
+            return nullptr;
+        }
+
+        if( a_data.get_compact_format() != f_compact_format )
+        {
+            throw fast_daq::error() << "the writer's records are " << compact_data::compact_format_to_string( f_compact_format ) << ", but the input's compact copy is "
+                    << compact_data::compact_format_to_string( a_data.get_compact_format() ) << "; set the producer's compact-format to match";
+        }
+        if( a_data.compact_bytes() != a_bytes_per_record )
+        {
+            throw fast_daq::error() << "the input's compact copy is " << a_data.compact_bytes() << " bytes, but the records are " << a_bytes_per_record << " bytes";
+        }
+        if( f_compact_format == compact_data::compact_format_t::int16 && a_data.get_compact_scale() != f_compact_scale )
+        {
+            throw fast_daq::error() << "the input's int16 scale is " << a_data.get_compact_scale() << ", but the records are declared with " << f_compact_scale
+                    << "; set the producer's compact-scale to the writer's";
+        }
+        return a_data.get_compact_array();
+    }
+
 } /* namespace fast_daq */
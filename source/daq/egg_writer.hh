@@ -10,6 +10,13 @@
 #define FAST_DAQ_EGG_WRITER_HH_
 
 #include "monarch3_wrap.hh"
+#include "compact_data.hh"
+
+namespace scarab
+{
+    class param_node;
+    struct dig_calib_params;
+}
 
 namespace fast_daq
 {
@@ -20,6 +27,16 @@ namespace fast_daq
      @brief Base class for all writers.
 
      @details
+     Writers can store the 16-bit copy that producers attach to their data (see compact_data) instead of the full-precision
+     values.  The writer's "compact-format" fixes the format of the records before the file is started, so that the stream
+     header can describe it: the records are declared with 2-byte values (signed integers for int16, analog for the float
+     formats), the stream source names the format, and for int16 the channel calibration is set from "compact-scale"
+     (DAC gain = compact-scale, v-offset = 0), so that value = code * gain.  Every object written must then carry a
+     compact copy in that format, exactly one record long and, for int16, with that scale; anything else is an error.
+
+     Configuration values, for the writers:
+     - "compact-format": string -- format of the records: "none" for the full-precision values, or "float16", "bfloat16" or "int16" for the producer's compact copy (default: "none")
+     - "compact-scale": double -- for int16, the value of one code; must match the producer's fixed compact-scale (default: 0)
      */
     class egg_writer
     {
@@ -28,6 +45,27 @@ namespace fast_daq
             virtual ~egg_writer();
 
             virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr ) = 0;
+
+        mv_accessible( compact_data::compact_format_t, compact_format );
+        mv_accessible( float, compact_scale );
+
+        public:
+            /// Apply the "compact-format" and "compact-scale" values; throws fast_daq::error if int16 has no scale
+            void apply_compact_config( const scarab::param_node& a_config );
+            void dump_compact_config( scarab::param_node& a_config ) const;
+
+        protected:
+            bool writes_compact() const;
+            /// Bytes per value component in the records: 2 for compact records, otherwise a_data_type_size
+            unsigned record_data_type_size( unsigned a_data_type_size ) const;
+            /// Monarch data format of the records: a_data_format, unless they are compact
+            uint32_t record_data_format( uint32_t a_data_format ) const;
+            /// Description of the compact format for the stream source; empty for full-precision records
+            std::string compact_description() const;
+            /// For int16 records, calibrate value = code * compact_scale; otherwise a_params is left as it is
+            void set_compact_calib_params( scarab::dig_calib_params& a_params ) const;
+            /// Compact array of a_data to write as a record of a_bytes_per_record bytes, or nullptr to write the full-precision values
+            const void* compact_record( const compact_data& a_data, uint64_t a_bytes_per_record ) const;
     };
 
 } /* namespace fast_daq */
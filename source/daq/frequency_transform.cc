@@ -55,10 +55,31 @@ namespace fast_daq
             f_wisdom_filename( "wisdom_complexfft.fftw3" ),
             f_centerish_freq( 0. ),
             f_min_output_bandwidth( 0. ),
+            f_overlap_fraction( 0. ),
+            f_window( window_type_t::rectangular ),
+            f_kaiser_beta( 8.6 ),
+            f_layout( frequency_data::layout_t::interleaved ),
+            f_compact_format( compact_data::compact_format_t::none ),
+            f_compact_scale( 0. ),
+            f_compact_only( false ),
+            f_staging(),
+            f_real_ring(),
+            f_complex_ring(),
+            f_ring_first_index( 0 ),
+            f_sequence(),
+            f_spectrum_counter( 0 ),
+            f_window_values(),
+            f_real_input_gain(),
+            f_real_input_offset(),
+            f_real_input_dynamic_range( 0. ),
+            f_fft_norm( 1. ),
             f_transform_flag_map(),
             f_fftwf_input_real(),
             f_fftwf_input_complex(),
             f_fftwf_output(),
+            f_fftwf_input_imag(),
+            f_fftwf_output_real(),
+            f_fftwf_output_imag(),
             f_fftwf_plan(),
             f_multithreaded_is_initialized( false )
     {
@@ -94,6 +115,11 @@ namespace fast_daq
 
     float frequency_transform::min_output_frequency()
     {
+        if ( f_input_type == input_type_t::complex )
+        {
+            // complex spectra are unfolded to start at the most negative frequency
+            return ( (float)first_output_index() - (float)(f_fft_size / 2) ) * bin_width_hz();
+        }
         return first_output_index() * bin_width_hz();
     }
 
@@ -107,13 +133,35 @@ namespace fast_daq
         return std::min(to_return, f_fft_size);
     }
 
+    unsigned frequency_transform::hop_size() const
+    {
+        long to_return = lrint( (double)f_fft_size * ( 1. - f_overlap_fraction ) );
+        return (unsigned)std::max( to_return, 1L );
+    }
+
     void frequency_transform::initialize()
     {
+        if ( f_overlap_fraction < 0. || f_overlap_fraction >= 1. ) throw fast_daq::error() << "overlap-fraction must be in [0, 1)";
+        if ( f_compact_only && f_compact_format == compact_data::compact_format_t::none ) throw fast_daq::error() << "compact-only requires a compact-format";
+
         out_buffer< 0 >().initialize( f_freq_length );
+        out_buffer< 0 >().call( &frequency_data::set_layout, f_layout );
         out_buffer< 0 >().call( &frequency_data::allocate_array, num_output_bins() );
         out_buffer< 0 >().call( &frequency_data::set_fft_size, f_fft_size );
+        out_buffer< 0 >().call( &frequency_data::set_window, f_window );
+        if ( f_compact_only )
+        {
+            f_staging.set_layout( f_layout );
+            f_staging.allocate_array( num_output_bins() );
+        }
+
+        LINFO( flog, "configuring to use: " << num_output_bins() << " bins, each " << bin_width_hz() << " Hz wide; a new frame every " << hop_size() << " samples; " << get_layout_str() << " output" );
 
-        LINFO( flog, "configuring to use: " << num_output_bins() << " bins, each " << bin_width_hz() << " Hz wide" );
+        make_window( f_window, f_fft_size, f_window_values, f_kaiser_beta );
+        // one-sided PSD normalization, including the window's equivalent noise bandwidth
+        f_fft_norm = sqrt( 2. / ( (double)f_samples_per_sec * window_sum_of_squares( f_window_values ) ) );
+        f_real_input_dynamic_range = 0.; // gain arrays are filled when the first real input arrives
+        LINFO( flog, "using a " << get_window_str() << " window; ENBW is " << window_enbw_bins( f_window_values ) << " bins" );
 
         if (f_use_wisdom)
         {
@@ -137,18 +185,43 @@ namespace fast_daq
         TransformFlagMap::const_iterator iter = f_transform_flag_map.find(f_transform_flag);
         unsigned transform_flag = iter->second;
         // initialize FFTW IO arrays and plan
-        f_fftwf_output = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_fft_size);
-        switch (f_input_type)
+        if ( f_layout == frequency_data::layout_t::split )
         {
-            case input_type_t::real:
-                f_fftwf_input_real = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
-                f_fftwf_plan = fftwf_plan_dft_r2c_1d(f_fft_size, f_fftwf_input_real, f_fftwf_output, transform_flag | FFTW_PRESERVE_INPUT);
-                break;
-            case input_type_t::complex:
-                f_fftwf_input_complex = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_fft_size);
-                f_fftwf_plan = fftwf_plan_dft_1d(f_fft_size, f_fftwf_input_complex, f_fftwf_output, FFTW_FORWARD, transform_flag | FFTW_PRESERVE_INPUT);
-                break;
-            default: throw fast_daq::error() << "input_type not fully implemented";
+            fftwf_iodim t_dim;
+            t_dim.n = f_fft_size;
+            t_dim.is = 1;
+            t_dim.os = 1;
+            f_fftwf_input_real = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
+            f_fftwf_output_real = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
+            f_fftwf_output_imag = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
+            switch (f_input_type)
+            {
+                case input_type_t::real:
+                    f_fftwf_plan = fftwf_plan_guru_split_dft_r2c(1, &t_dim, 0, NULL, f_fftwf_input_real, f_fftwf_output_real, f_fftwf_output_imag, transform_flag | FFTW_PRESERVE_INPUT);
+                    break;
+                case input_type_t::complex:
+                    // split-array transforms are always forward
+                    f_fftwf_input_imag = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
+                    f_fftwf_plan = fftwf_plan_guru_split_dft(1, &t_dim, 0, NULL, f_fftwf_input_real, f_fftwf_input_imag, f_fftwf_output_real, f_fftwf_output_imag, transform_flag | FFTW_PRESERVE_INPUT);
+                    break;
+                default: throw fast_daq::error() << "input_type not fully implemented";
+            }
+        }
+        else
+        {
+            f_fftwf_output = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_fft_size);
+            switch (f_input_type)
+            {
+                case input_type_t::real:
+                    f_fftwf_input_real = (float*) fftwf_malloc(sizeof(float) * f_fft_size);
+                    f_fftwf_plan = fftwf_plan_dft_r2c_1d(f_fft_size, f_fftwf_input_real, f_fftwf_output, transform_flag | FFTW_PRESERVE_INPUT);
+                    break;
+                case input_type_t::complex:
+                    f_fftwf_input_complex = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * f_fft_size);
+                    f_fftwf_plan = fftwf_plan_dft_1d(f_fft_size, f_fftwf_input_complex, f_fftwf_output, FFTW_FORWARD, transform_flag | FFTW_PRESERVE_INPUT);
+                    break;
+                default: throw fast_daq::error() << "input_type not fully implemented";
+            }
         }
         //save plan
         if (f_fftwf_plan != NULL)
@@ -170,12 +243,9 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             LDEBUG( flog, "Executing the frequency transformer" );
 
-            time_data* complex_time_data_in = nullptr;
-            real_time_data* real_time_data_in = nullptr;
-            frequency_data* freq_data_out = nullptr;
-
             try
             {
                 LINFO( flog, "Starting main loop (frequency transform)" );
@@ -225,6 +295,12 @@ namespace fast_daq
                     {
                         LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
                         if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                        // samples from a previous acquisition must not leak into this one
+                        f_real_ring.clear();
+                        f_complex_ring.clear();
+                        f_ring_first_index = 0;
+                        f_sequence.reset();
+                        f_spectrum_counter = 0;
                         // ensure scalars are set
                         out_buffer< 0 >().call( &frequency_data::set_bin_width, bin_width_hz() );
                         out_buffer< 0 >().call( &frequency_data::set_minimum_frequency, min_output_frequency() );
@@ -233,72 +309,12 @@ namespace fast_daq
                     if ( in_cmd == stream::s_run )
                     {
                         LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
-                        unsigned t_center_bin;
-                        switch ( f_input_type )
-                        {
-                            case input_type_t::real:
-                                real_time_data_in = in_stream< 1 >().data();
-                                t_center_bin = real_time_data_in->get_array_size() / 2;
-                                break;
-                            case input_type_t::complex:
-                                complex_time_data_in = in_stream< 0 >().data();
-                                t_center_bin = complex_time_data_in->get_array_size();
-                                break;
-                        }
-
-                        //frequency output
-                        freq_data_out = out_stream< 0 >().data();
-
-                        std::vector<float> volts_data;
-
-                        // copy input data into fft input array
-                        switch (f_input_type)
-                        {
-                            case input_type_t::real:
-                                LTRACE( flog, "copy real input data" );
-                                //std::copy(&real_time_data_in->get_time_series()[0], &real_time_data_in->get_time_series()[0] + f_fft_size, &f_fftwf_input_real[0]);
-                                volts_data = real_time_data_in->as_volts();
-                                std::copy(volts_data.begin(), volts_data.end(), &f_fftwf_input_real[0] );
-                                break;
-                            case input_type_t::complex:
-                                LTRACE( flog, "grab complex data" );
-                                LWARN( flog, "complex input transforms are currently not tested" );
-                                std::copy(&complex_time_data_in->get_array()[0][0], &complex_time_data_in->get_array()[0][0] + f_fft_size*2, &f_fftwf_input_complex[0][0]);
-                                break;
-                            default: throw fast_daq::error() << "input_type not fully implemented";
-                        }
-                        // execute fft
-                        fftwf_execute( f_fftwf_plan );
-
-                        //take care of FFT normalization
-                        //is this the normalization we want? ... it is not symmetric, but seems to give the correct result
-                        float fft_norm = sqrt(2. / (double)f_fft_size / (double) f_samples_per_sec);
-			//DZ comment: I confirmed with a SA that sqrt(2) is needed for the normalization May 2025
-                        //float fft_norm = sqrt(2.) / (double)f_fft_size;
-                        for (size_t i_bin=0; i_bin<f_fft_size; ++i_bin)
-                        {
-                            f_fftwf_output[i_bin][0] *= fft_norm;
-                            f_fftwf_output[i_bin][1] *= fft_norm;
-                        }
-
-                        switch (f_input_type)
-                        {
-                            case input_type_t::real:
-                                std::copy(&f_fftwf_output[first_output_index()][0], &f_fftwf_output[first_output_index()+num_output_bins()][1], &freq_data_out->get_data_array()[0][0] );
-                                freq_data_out->set_chunk_counter( real_time_data_in->get_chunk_counter() );
-                                break;
-                            case input_type_t::complex:
-                                // FFT unfolding based on katydid:Source/Data/Transform/KTFrequencyTransformFFTW
-                                std::copy(&f_fftwf_output[0][0], &f_fftwf_output[0][0] + (t_center_bin - 1), &freq_data_out->get_data_array()[0][0] + t_center_bin);
-                                std::copy(&f_fftwf_output[0][0] + t_center_bin, &f_fftwf_output[0][0] + f_fft_size*2, &freq_data_out->get_data_array()[0][0]);
-                                break;
-                            default: throw fast_daq::error() << "input_type not fully implemented";
-                        }
-                        if ( !out_stream< 0 >().set( stream::s_run ) )
+                        if ( f_input_type == input_type_t::real )
                         {
-                            LERROR( flog, "frequency_transform error setting frequency output stream to s_run" );
-                            break;
+                            if ( ! transform_real_input( in_stream< 1 >().data() ) ) break;
+                            continue;
                         }
+                        if ( ! transform_complex_input( in_stream< 0 >().data() ) ) break;
                     }
                 }
             }
@@ -328,6 +344,178 @@ namespace fast_daq
         return;
     }
 
+    void frequency_transform::normalize_fft_output()
+    {
+        //take care of FFT normalization
+        //is this the normalization we want? ... it is not symmetric, but seems to give the correct result
+        //f_fft_norm is sqrt(2 / (fs * sum(w^2))), which is sqrt(2 / (N * fs)) for the rectangular window
+        //DZ comment: I confirmed with a SA that sqrt(2) is needed for the normalization May 2025
+        //float fft_norm = sqrt(2.) / (double)f_fft_size;
+        for (size_t i_bin=0; i_bin<f_fft_size; ++i_bin)
+        {
+            f_fftwf_output[i_bin][0] *= f_fft_norm;
+            f_fftwf_output[i_bin][1] *= f_fft_norm;
+        }
+        return;
+    }
+
+    void frequency_transform::update_real_input_gain( float a_dynamic_range )
+    {
+        // same conversion as real_time_data::as_volts(), with the window folded in:
+        // w * (code * units_factor - min_volts) = code * gain - offset
+        const float units_factor = a_dynamic_range / 65536.;
+        const float min_volts = a_dynamic_range / 2.0;
+        f_real_input_gain.resize( f_fft_size );
+        f_real_input_offset.resize( f_fft_size );
+        for ( unsigned i_sample = 0; i_sample < f_fft_size; ++i_sample )
+        {
+            f_real_input_gain[i_sample] = f_window_values[i_sample] * units_factor;
+            f_real_input_offset[i_sample] = f_window_values[i_sample] * min_volts;
+        }
+        f_real_input_dynamic_range = a_dynamic_range;
+        return;
+    }
+
+    bool frequency_transform::transform_real_input( const real_time_data* a_time_data )
+    {
+        if ( f_sequence.add_input( *a_time_data ) )
+        {
+            // a frame can't straddle a break in the input
+            f_real_ring.consume( f_real_ring.size() );
+            f_ring_first_index = a_time_data->get_first_sample_index();
+        }
+        a_time_data->copy_samples( f_real_ring.extend( a_time_data->get_array_size() ) );
+
+        if ( a_time_data->get_dynamic_range() != f_real_input_dynamic_range ) update_real_input_gain( a_time_data->get_dynamic_range() );
+        const float* t_gain = f_real_input_gain.data();
+        const float* t_offset = f_real_input_offset.data();
+
+        while ( f_real_ring.size() >= f_fft_size )
+        {
+            const U16* t_frame = f_real_ring.data();
+            for ( unsigned i_sample = 0; i_sample < f_fft_size; ++i_sample )
+            {
+                f_fftwf_input_real[i_sample] = static_cast<float>(t_frame[i_sample]) * t_gain[i_sample] - t_offset[i_sample];
+            }
+            fftwf_execute( f_fftwf_plan );
+
+            frequency_data* freq_data_out = out_stream< 0 >().data();
+            if ( f_layout == frequency_data::layout_t::split )
+            {
+                copy_split_output( values_for( freq_data_out ), first_output_index(), 0 );
+            }
+            else
+            {
+                normalize_fft_output();
+                std::copy(&f_fftwf_output[first_output_index()][0], &f_fftwf_output[first_output_index()+num_output_bins()][1], &values_for( freq_data_out )->get_data_array()[0][0] );
+            }
+            if ( ! send_spectrum( freq_data_out ) ) return false;
+            f_real_ring.consume( hop_size() );
+            f_ring_first_index += hop_size();
+        }
+        return true;
+    }
+
+    bool frequency_transform::transform_complex_input( const time_data* a_time_data )
+    {
+        // the ring holds interleaved I and Q values
+        f_complex_ring.append( &a_time_data->get_array()[0][0], 2 * a_time_data->get_array_size() );
+
+        const unsigned t_first_bin = first_output_index();
+        const unsigned t_n_output_bins = num_output_bins();
+        const unsigned t_shift = f_fft_size - f_fft_size / 2;
+        while ( f_complex_ring.size() >= 2 * (uint64_t)f_fft_size )
+        {
+            const int8_t* t_frame = f_complex_ring.data();
+            frequency_data* freq_data_out = out_stream< 0 >().data();
+            if ( f_layout == frequency_data::layout_t::split )
+            {
+                for ( unsigned i_sample = 0; i_sample < f_fft_size; ++i_sample )
+                {
+                    f_fftwf_input_real[i_sample] = static_cast<float>(t_frame[2*i_sample]) * f_window_values[i_sample];
+                    f_fftwf_input_imag[i_sample] = static_cast<float>(t_frame[2*i_sample+1]) * f_window_values[i_sample];
+                }
+                fftwf_execute( f_fftwf_plan );
+                copy_split_output( values_for( freq_data_out ), t_first_bin, t_shift );
+            }
+            else
+            {
+                for ( unsigned i_sample = 0; i_sample < f_fft_size; ++i_sample )
+                {
+                    f_fftwf_input_complex[i_sample][0] = static_cast<float>(t_frame[2*i_sample]) * f_window_values[i_sample];
+                    f_fftwf_input_complex[i_sample][1] = static_cast<float>(t_frame[2*i_sample+1]) * f_window_values[i_sample];
+                }
+                fftwf_execute( f_fftwf_plan );
+                normalize_fft_output();
+
+                // FFT unfolding based on katydid:Source/Data/Transform/KTFrequencyTransformFFTW:
+                // output bin j is FFT bin (j + ceil(N/2)) mod N, so the output runs from the most negative frequency to the most positive
+                frequency_data::complex_t* t_bins = values_for( freq_data_out )->get_data_array();
+                for ( unsigned i_bin = 0; i_bin < t_n_output_bins; ++i_bin )
+                {
+                    unsigned t_fft_bin = ( t_first_bin + i_bin + t_shift ) % f_fft_size;
+                    t_bins[i_bin][0] = f_fftwf_output[t_fft_bin][0];
+                    t_bins[i_bin][1] = f_fftwf_output[t_fft_bin][1];
+                }
+            }
+            if ( ! send_spectrum( freq_data_out ) ) return false;
+            f_complex_ring.consume( 2 * (uint64_t)hop_size() );
+            f_ring_first_index += hop_size();
+        }
+        return true;
+    }
+
+    void frequency_transform::copy_split_output( frequency_data* a_freq_data, unsigned a_first_bin, unsigned a_shift )
+    {
+        // normalization is folded into the copy of the selected band; output bin j is FFT bin (a_first_bin + j + a_shift) mod N
+        const unsigned t_n_output_bins = num_output_bins();
+        const float t_norm = f_fft_norm;
+        float* t_real = a_freq_data->get_real_array();
+        float* t_imag = a_freq_data->get_imag_array();
+        unsigned i_bin = 0;
+        while ( i_bin < t_n_output_bins )
+        {
+            // contiguous runs of FFT bins, so each run is a plain vectorizable loop
+            const unsigned t_fft_bin = ( a_first_bin + i_bin + a_shift ) % f_fft_size;
+            const unsigned t_run = std::min( t_n_output_bins - i_bin, f_fft_size - t_fft_bin );
+            const float* t_fft_real = f_fftwf_output_real + t_fft_bin;
+            const float* t_fft_imag = f_fftwf_output_imag + t_fft_bin;
+            for ( unsigned i_run = 0; i_run < t_run; ++i_run )
+            {
+                t_real[i_bin + i_run] = t_fft_real[i_run] * t_norm;
+                t_imag[i_bin + i_run] = t_fft_imag[i_run] * t_norm;
+            }
+            i_bin += t_run;
+        }
+        return;
+    }
+
+    frequency_data* frequency_transform::values_for( frequency_data* a_freq_data )
+    {
+        return f_compact_only ? &f_staging : a_freq_data;
+    }
+
+    bool frequency_transform::send_spectrum( frequency_data* a_freq_data )
+    {
+        a_freq_data->set_chunk_counter( f_spectrum_counter++ );
+        f_sequence.stamp_output( *a_freq_data, f_ring_first_index, f_fft_size );
+        if ( f_compact_only )
+        {
+            f_staging.make_compact( f_compact_format, f_compact_scale );
+            a_freq_data->take_compact( f_staging );
+        }
+        else
+        {
+            a_freq_data->make_compact( f_compact_format, f_compact_scale );
+        }
+        if ( !out_stream< 0 >().set( stream::s_run ) )
+        {
+            LERROR( flog, "frequency_transform error setting frequency output stream to s_run" );
+            return false;
+        }
+        return true;
+    }
+
     void frequency_transform::finalize()
     {
         LINFO( flog, "in finalize(), freeing fftw data objects" );
@@ -347,6 +535,21 @@ namespace fast_daq
             fftwf_free(f_fftwf_output);
             f_fftwf_output = NULL;
         }
+        if (f_fftwf_input_imag != NULL)
+        {
+            fftwf_free(f_fftwf_input_imag);
+            f_fftwf_input_imag = NULL;
+        }
+        if (f_fftwf_output_real != NULL)
+        {
+            fftwf_free(f_fftwf_output_real);
+            f_fftwf_output_real = NULL;
+        }
+        if (f_fftwf_output_imag != NULL)
+        {
+            fftwf_free(f_fftwf_output_imag);
+            f_fftwf_output_imag = NULL;
+        }
         return;
     }
 
@@ -362,7 +565,7 @@ namespace fast_daq
 
     // frequency_transform_binding methods
     frequency_transform_binding::frequency_transform_binding() :
-            _node_binding< frequency_transform, frequency_transform_binding >()
+            _tuned_node_binding< frequency_transform, frequency_transform_binding >()
     {
     }
 
@@ -370,7 +573,7 @@ namespace fast_daq
     {
     }
 
-    void frequency_transform_binding::do_apply_config( frequency_transform* a_node, const scarab::param_node& a_config ) const
+    void frequency_transform_binding::do_apply_node_config( frequency_transform* a_node, const scarab::param_node& a_config ) const
     {
         LDEBUG( flog, "Configuring frequency_transform with:\n" << a_config );
         a_node->set_time_length( a_config.get_value( "time-length", a_node->get_time_length() ) );
@@ -384,10 +587,17 @@ namespace fast_daq
         //TODO make these names consistent
         a_node->set_centerish_freq( a_config.get_value( "freq-in-center-bin", a_node->get_centerish_freq() ) );
         a_node->set_min_output_bandwidth( a_config.get_value( "min-output-bandwidth", a_node->get_min_output_bandwidth() ) );
+        a_node->set_overlap_fraction( a_config.get_value( "overlap-fraction", a_node->get_overlap_fraction() ) );
+        a_node->set_window( a_config.get_value( "window", a_node->get_window_str() ) );
+        a_node->set_kaiser_beta( a_config.get_value( "kaiser-beta", a_node->get_kaiser_beta() ) );
+        a_node->set_layout( a_config.get_value( "layout", a_node->get_layout_str() ) );
+        a_node->set_compact_format( a_config.get_value( "compact-format", a_node->get_compact_format_str() ) );
+        a_node->set_compact_scale( a_config.get_value( "compact-scale", a_node->get_compact_scale() ) );
+        a_node->set_compact_only( a_config.get_value( "compact-only", a_node->get_compact_only() ) );
         return;
     }
 
-    void frequency_transform_binding::do_dump_config( const frequency_transform* a_node, scarab::param_node& a_config ) const
+    void frequency_transform_binding::do_dump_node_config( const frequency_transform* a_node, scarab::param_node& a_config ) const
     {
         LDEBUG( flog, "Dumping frequency_transform configuration" );
         a_config.add( "time-length", scarab::param_value( a_node->get_time_length() ) );
@@ -401,6 +611,13 @@ namespace fast_daq
         //TODO make these names consistent
         a_config.add( "freq-in-center-bin", scarab::param_value( a_node->get_centerish_freq() ) );
         a_config.add( "min-output-bandwidth", scarab::param_value( a_node->get_min_output_bandwidth() ) );
+        a_config.add( "overlap-fraction", scarab::param_value( a_node->get_overlap_fraction() ) );
+        a_config.add( "window", scarab::param_value( a_node->get_window_str() ) );
+        a_config.add( "kaiser-beta", scarab::param_value( a_node->get_kaiser_beta() ) );
+        a_config.add( "layout", scarab::param_value( a_node->get_layout_str() ) );
+        a_config.add( "compact-format", scarab::param_value( a_node->get_compact_format_str() ) );
+        a_config.add( "compact-scale", scarab::param_value( a_node->get_compact_scale() ) );
+        a_config.add( "compact-only", scarab::param_value( a_node->get_compact_only() ) );
         return;
     }
 
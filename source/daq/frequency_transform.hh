@@ -10,11 +10,14 @@
 
 //sandfly
 #include "node_builder.hh"
+#include "thread_tuning.hh"
 #include "time_data.hh"
 
 //fast_daq
 #include "frequency_data.hh"
 #include "real_time_data.hh"
+#include "sample_ring.hh"
+#include "window_functions.hh"
 
 //midge
 #include "transformer.hh"
@@ -54,6 +57,32 @@ namespace fast_daq
      - "wisdom-filename": string -- if "use-wisdom" is true, resolvable path to the wisdom file
      - "freq-in-center-bin": double -- determine the center output bin to be the bin containing this frequency in Hz (default = 0; special case meaning center of the full band)
      - "min-output-bandwidth": double -- the output band will be an integer number of bins covering at least this width, centered on the bin identified by the freq-in-center-bin parameter (default = 0; special case meaning the full band)
+     - "overlap-fraction": double -- fraction of each FFT frame shared with the next one, in [0, 1) (default = 0)
+     - "window": string -- window applied to each FFT frame: "rectangular", "hann", "hamming", "blackman-harris", "flat-top" or "kaiser" (default = "rectangular")
+     - "kaiser-beta": double -- shape parameter of the Kaiser window (default = 8.6)
+     - "layout": string -- memory layout of the output spectra: "interleaved" or "split" (see frequency_data) (default = "interleaved")
+     - "compact-format": string -- also encode each spectrum in 16 bits, for writers: "none", "float16", "bfloat16" or "int16" (see compact_data) (default = "none")
+     - "compact-scale": double -- for int16, the value of one code; 0 to scale each spectrum to its largest magnitude (default = 0)
+     - "compact-only": bool -- fill only the 16-bit copy of each spectrum, not its full-precision bins, which saves the memory
+       traffic of the float arrays when the output only goes to writers; needs a compact-format (default = false)
+
+     Input is streamed through an internal sample ring: a spectrum is produced every fft-size * (1 - overlap-fraction)
+     samples, regardless of the size of the incoming buffers, and samples that don't complete a frame are kept for the next buffer.
+     The FFT size is therefore independent of the digitizer buffer size.  The output chunk counter counts spectra since the start of the run.
+     Each spectrum is sequenced by its FFT frame (see sequenced_data); at a break in the input sequence the partial frame is
+     discarded and its samples are counted as lost.  Complex (time_data) input carries no sequence and is treated as one acquisition.
+     Complex spectra are unfolded so that the output runs from the most negative to the most positive frequency.
+
+     The window is precomputed in initialize().  For real input it is folded into the ADC-to-volts conversion
+     (one multiply-subtract per sample), so windowing adds no separate pass over the frame.
+     Spectra are normalized as a one-sided power spectral density, sqrt(2 / (samples-per-sec * sum(w^2))), which
+     includes the equivalent noise bandwidth of the window; with the rectangular window this is the original sqrt(2 / (N * samples-per-sec)).
+
+     With the split layout the FFT itself produces separate real and imaginary arrays (FFTW split-array guru plans), and
+     the normalization is applied while the selected band is copied out, so there is no interleaving pass.
+
+     Welch PSD estimation: choose a window (e.g. "hann") and an overlap-fraction (e.g. 0.5), and feed the output to a
+     power-averager with "averaging-mode" set to "mean".
 
      Input Stream:
      - 0: time_data (IQ)
@@ -62,7 +91,7 @@ namespace fast_daq
      Output Streams:
      - 0: frequency_data
     */
-    class frequency_transform : public midge::_transformer< midge::type_list< time_data, real_time_data >, midge::type_list< frequency_data > >
+    class frequency_transform : public midge::_transformer< midge::type_list< time_data, real_time_data >, midge::type_list< frequency_data > >, public thread_tuning
     {
         public:
             // internal enums
@@ -99,6 +128,22 @@ namespace fast_daq
         // center frequency and band require custom sets
         mv_accessible( double, centerish_freq );
         mv_accessible( double, min_output_bandwidth );
+        mv_accessible( double, overlap_fraction );
+        mv_accessible( window_type_t, window );
+        public:
+            void set_window( const std::string& a_window );
+            std::string get_window_str() const;
+        mv_accessible( double, kaiser_beta );
+        mv_accessible( frequency_data::layout_t, layout );
+        public:
+            void set_layout( const std::string& a_layout );
+            std::string get_layout_str() const;
+        mv_accessible( compact_data::compact_format_t, compact_format );
+        mv_accessible( float, compact_scale );
+        mv_accessible( bool, compact_only );
+        public:
+            void set_compact_format( const std::string& a_format );
+            std::string get_compact_format_str() const;
 
         // derrive scalers
         private:
@@ -106,6 +151,7 @@ namespace fast_daq
             unsigned first_output_index();
             float min_output_frequency();
             unsigned num_output_bins();
+            unsigned hop_size() const;
 
         private:
             bool f_enable_time_output;
@@ -115,11 +161,40 @@ namespace fast_daq
             virtual void execute( midge::diptera* a_midge = nullptr );
             virtual void finalize();
 
+        private:
+            void normalize_fft_output();
+            void copy_split_output( frequency_data* a_freq_data, unsigned a_first_bin, unsigned a_shift );
+            bool transform_real_input( const real_time_data* a_time_data );
+            bool transform_complex_input( const time_data* a_time_data );
+            bool send_spectrum( frequency_data* a_freq_data );
+            /// Spectrum to fill with the bins of a_freq_data: a_freq_data itself, or in compact-only mode the staging spectrum
+            frequency_data* values_for( frequency_data* a_freq_data );
+            frequency_data f_staging; // compact-only mode: the bins, kept here so the output's float arrays are never touched
+
+            // samples that have not yet been consumed by a full FFT frame
+            sample_ring< U16 > f_real_ring;
+            sample_ring< int8_t > f_complex_ring; // interleaved I and Q
+            uint64_t f_ring_first_index; // sample index of the oldest sample in the ring
+            sequence_tracker f_sequence;
+            uint64_t f_spectrum_counter;
+
+            // window coefficients, and the same folded into the ADC-to-volts conversion for real input
+            void update_real_input_gain( float a_dynamic_range );
+            std::vector< float > f_window_values;
+            std::vector< float > f_real_input_gain;
+            std::vector< float > f_real_input_offset;
+            float f_real_input_dynamic_range;
+            float f_fft_norm;
+
         private:
             TransformFlagMap f_transform_flag_map;
             float* f_fftwf_input_real;
             fftwf_complex* f_fftwf_input_complex;
             fftwf_complex* f_fftwf_output;
+            // split layout: the complex input is f_fftwf_input_real and f_fftwf_input_imag
+            float* f_fftwf_input_imag;
+            float* f_fftwf_output_real;
+            float* f_fftwf_output_imag;
             fftwf_plan f_fftwf_plan;
 
             bool f_multithreaded_is_initialized;
@@ -145,17 +220,41 @@ namespace fast_daq
     {
         return input_type_to_string( f_input_type );
     }
+    inline void frequency_transform::set_window( const std::string& a_window )
+    {
+        set_window( string_to_window_type( a_window ) );
+    }
+    inline std::string frequency_transform::get_window_str() const
+    {
+        return window_type_to_string( f_window );
+    }
+    inline void frequency_transform::set_layout( const std::string& a_layout )
+    {
+        set_layout( frequency_data::string_to_layout( a_layout ) );
+    }
+    inline std::string frequency_transform::get_layout_str() const
+    {
+        return frequency_data::layout_to_string( f_layout );
+    }
+    inline void frequency_transform::set_compact_format( const std::string& a_format )
+    {
+        set_compact_format( compact_data::string_to_compact_format( a_format ) );
+    }
+    inline std::string frequency_transform::get_compact_format_str() const
+    {
+        return compact_data::compact_format_to_string( f_compact_format );
+    }
 
 
-    class frequency_transform_binding : public sandfly::_node_binding< frequency_transform, frequency_transform_binding >
+    class frequency_transform_binding : public _tuned_node_binding< frequency_transform, frequency_transform_binding >
     {
         public:
             frequency_transform_binding();
             virtual ~frequency_transform_binding();
 
         private:
-            virtual void do_apply_config( frequency_transform* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const frequency_transform* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config( frequency_transform* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const frequency_transform* a_node, scarab::param_node& a_config ) const;
             virtual bool do_run_command( frequency_transform* a_node, const std::string& a_cmd, const scarab::param_node& ) const;
     };
 
@@ -27,6 +27,22 @@ namespace fast_daq
 
     LOGGER( flog, "inverse_frequency_transform" );
 
+    // supporting enum helpers
+    std::string inverse_frequency_transform::mode_to_string( mode_t a_mode )
+    {
+        switch (a_mode) {
+            case mode_t::slice: return "slice";
+            case mode_t::overlap_save: return "overlap-save";
+            default: throw fast_daq::error() << "mode value <" << static_cast< unsigned >( a_mode ) << "> not recognized";
+        }
+    }
+    inverse_frequency_transform::mode_t inverse_frequency_transform::string_to_mode( const std::string& a_mode )
+    {
+        if( a_mode == mode_to_string( mode_t::slice ) ) return mode_t::slice;
+        if( a_mode == mode_to_string( mode_t::overlap_save ) ) return mode_t::overlap_save;
+        throw fast_daq::error() << "string <" << a_mode << "> not recognized as valid inverse-transform mode";
+    }
+
     // inverse_frequency_transform class implementation
     inverse_frequency_transform::inverse_frequency_transform() :
             f_time_length( 10 ),
@@ -37,6 +53,24 @@ namespace fast_daq
             f_wisdom_filename( "wisdom_complex_inversefft.fftw3" ),
             f_start_fraction( 0 ),
             f_sampling_rate(50000000),
+            f_mode( mode_t::slice ),
+            f_overlap_fraction( 0. ),
+            f_output_size( 4096 ),
+            f_passband_fraction( 0.8 ),
+            f_compact_format( compact_data::compact_format_t::none ),
+            f_compact_scale( 0. ),
+            f_compact_only( false ),
+            f_staging(),
+            f_frame_discard( 0 ),
+            f_band_response(),
+            f_frame_hop( 0 ),
+            f_last_first_index( 0 ),
+            f_frame_counter( 0 ),
+            f_current_output( nullptr ),
+            f_output_fill( 0 ),
+            f_output_counter( 0 ),
+            f_output_first_index( 0 ),
+            f_sequence(),
             f_transform_flag_map(),
             f_fftwf_input(),
             f_fftwf_input_part(),
@@ -53,8 +87,43 @@ namespace fast_daq
 
     void inverse_frequency_transform::initialize()
     {
+        if ( f_compact_only && f_compact_format == compact_data::compact_format_t::none )
+        {
+            throw fast_daq::error() << "compact-only requires a compact-format";
+        }
         out_buffer< 0 >().initialize( f_time_length );
-        out_buffer< 0 >().call( &iq_time_data::allocate_container, f_fft_size );
+        if ( f_mode == mode_t::overlap_save )
+        {
+            if ( f_overlap_fraction < 0. || f_overlap_fraction >= 1. ) throw fast_daq::error() << "overlap-fraction must be in [0, 1)";
+            if ( f_output_size == 0 ) throw fast_daq::error() << "output-size must be non-zero";
+            if ( f_passband_fraction <= 0. || f_passband_fraction >= 1. ) throw fast_daq::error() << "passband-fraction must be in (0, 1)";
+            if ( f_fft_size_fraction == 0 || f_fft_size % f_fft_size_fraction != 0 )
+            {
+                throw fast_daq::error() << "overlap-save requires fft-size (" << f_fft_size << ") to be a multiple of fft-size-fraction (" << f_fft_size_fraction << ")";
+            }
+            double t_discard = 0.5 * f_overlap_fraction * (double)f_fft_size_fraction;
+            f_frame_discard = lrint( t_discard );
+            if ( std::fabs( t_discard - (double)f_frame_discard ) > 1.e-6 )
+            {
+                throw fast_daq::error() << "overlap-save requires fft-size-fraction * overlap-fraction (" << 2. * t_discard << ") to be an even number, so that frames join seamlessly";
+            }
+            if ( 2 * f_frame_discard >= f_fft_size_fraction ) throw fast_daq::error() << "overlap-fraction leaves no samples to keep from each frame";
+            f_frame_hop = (uint64_t)( f_fft_size_fraction - 2 * f_frame_discard ) * ( f_fft_size / f_fft_size_fraction );
+            if ( f_frame_discard == 0 )
+            {
+                LWARN( flog, "overlap-save with no overlap discards nothing: samples near the frame edges carry the full wrap-around error" );
+            }
+            build_band_filter();
+            out_buffer< 0 >().call( &iq_time_data::allocate_container, f_output_size );
+            if ( f_compact_only ) f_staging.allocate_container( f_output_size );
+            LINFO( flog, "overlap-save: keeping " << f_fft_size_fraction - 2 * f_frame_discard << " of " << f_fft_size_fraction << " samples per frame; output rate is " <<
+                    (double)f_sampling_rate * (double)f_fft_size_fraction / (double)f_fft_size << " samples/s" );
+        }
+        else
+        {
+            out_buffer< 0 >().call( &iq_time_data::allocate_container, f_fft_size );
+            if ( f_compact_only ) f_staging.allocate_container( f_fft_size );
+        }
 
         if (f_use_wisdom)
         {
@@ -102,9 +171,10 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             LDEBUG( flog, "Executing the frequency transformer" );
 
-            frequency_data* input_freq_data = nullptr;
+            const frequency_data* input_freq_data = nullptr;
             iq_time_data* output_time_data = nullptr;
 
             try
@@ -136,26 +206,40 @@ namespace fast_daq
                     if ( in_cmd == stream::s_stop )
                     {
                         LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                        // an incomplete overlap-save output chunk is dropped
+                        f_current_output = nullptr;
                         if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
                         continue;
                     }
                     if ( in_cmd == stream::s_start )
                     {
                         LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                        f_frame_counter = 0;
+                        f_current_output = nullptr;
+                        f_output_fill = 0;
+                        f_output_counter = 0;
+                        f_sequence.reset();
                         if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
                         continue;
                     }
                     if ( in_cmd == stream::s_run )
                     {
                         LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                        if ( f_mode == mode_t::overlap_save )
+                        {
+                            if ( ! overlap_save( in_stream< 0 >().data() ) ) break;
+                            continue;
+                        }
                         // Grab data buffers for input and output streams
                         input_freq_data = in_stream< 0 >().data();
+                        input_freq_data->require_full_precision( get_name() );
                         output_time_data = out_stream< 0 >().data();
                         output_time_data->set_chunk_counter( input_freq_data->get_chunk_counter() );
+                        output_time_data->copy_sequence( *input_freq_data );
                         // copy input data into fft input array
                         //std::copy(&input_freq_data->get_data_array()[0][0], &input_freq_data->get_data_array()[0][0] + 2*f_fft_size, &f_fftwf_input[0][0] );
                         int bin_start = f_fft_size * f_start_fraction;
-                        std::copy(&input_freq_data->get_data_array()[0][0] + 2 * bin_start, &input_freq_data->get_data_array()[0][0] + 2 * (bin_start + f_fft_size_fraction), & f_fftwf_output[0][0]);
+                        input_freq_data->copy_bins( bin_start, f_fft_size_fraction, f_fftwf_output );
 
                         //// execute fft
                         //fftwf_execute( f_fftwf_plan );
@@ -171,7 +255,8 @@ namespace fast_daq
                         //    f_fftwf_output[i_bin][1] *= fft_norm;
                         //}
                         //// Is there anything weird in the output ordering of the inverse transform?
-                        std::copy(&f_fftwf_output[0][0], &f_fftwf_output[f_fft_size_fraction][1], &output_time_data->get_data_array()[0][0]);
+                        std::copy(&f_fftwf_output[0][0], &f_fftwf_output[f_fft_size_fraction][1], &values_for( output_time_data )->get_data_array()[0][0]);
+                        encode_output( output_time_data );
                         if ( !out_stream< 0 >().set( stream::s_run ) )
                         {
                             LERROR( flog, "inverse_frequency_transform error setting frequency output stream to s_run" );
@@ -206,6 +291,143 @@ namespace fast_daq
         return;
     }
 
+    bool inverse_frequency_transform::overlap_save( const frequency_data* a_freq_data )
+    {
+        a_freq_data->require_full_precision( get_name() );
+        const unsigned t_n_bins = f_fft_size_fraction;
+        const unsigned t_half = t_n_bins / 2;
+        const unsigned t_bin_start = f_fft_size * f_start_fraction;
+        const unsigned t_n_keep = t_n_bins - 2 * f_frame_discard;
+
+        if ( a_freq_data->get_fft_size() != f_fft_size )
+        {
+            throw fast_daq::error() << "overlap-save is configured for fft-size " << f_fft_size << ", but the input spectra come from " << a_freq_data->get_fft_size() << "-sample frames";
+        }
+        if ( a_freq_data->get_window() != window_type_t::rectangular )
+        {
+            throw fast_daq::error() << "overlap-save needs rectangular-window spectra, but the input frames were tapered with the " << window_type_to_string( a_freq_data->get_window() )
+                    << " window; set the upstream window to rectangular";
+        }
+        // the upstream spacing of the spectra must match the overlap-fraction, or the kept samples would not abut
+        bool t_is_break = f_sequence.add_input( *a_freq_data );
+        if ( ! t_is_break && a_freq_data->get_first_sample_index() - f_last_first_index != f_frame_hop )
+        {
+            throw fast_daq::error() << "input spectra are " << a_freq_data->get_first_sample_index() - f_last_first_index << " samples apart, but overlap-fraction "
+                    << f_overlap_fraction << " needs " << f_frame_hop << "; set it to the upstream frequency-transform's overlap-fraction";
+        }
+        f_last_first_index = a_freq_data->get_first_sample_index();
+        if ( t_is_break && f_current_output != nullptr )
+        {
+            // output chunks can't straddle a break in the input; the incomplete one is dropped
+            LDEBUG( flog, "break in the input sequence; dropping " << f_output_fill << " samples of an incomplete output chunk" );
+            f_current_output = nullptr;
+            f_output_fill = 0;
+        }
+
+        // put the center of the selected band at 0 Hz: upper half of the band to the positive frequencies, lower half to the negative,
+        // i.e. bin i goes to FFT index (i + n - half) mod n: two contiguous runs, copied from either layout
+        a_freq_data->copy_bins( t_bin_start + t_half, t_n_bins - t_half, f_fftwf_input_part );
+        a_freq_data->copy_bins( t_bin_start, t_half, f_fftwf_input_part + ( t_n_bins - t_half ) );
+        for ( unsigned i_bin = 0; i_bin < t_n_bins; ++i_bin )
+        {
+            f_fftwf_input_part[ i_bin ][ 0 ] *= f_band_response[ i_bin ];
+            f_fftwf_input_part[ i_bin ][ 1 ] *= f_band_response[ i_bin ];
+        }
+        fftwf_execute( f_fftwf_plan );
+
+        // Each spectrum's phase reference is the start of its own frame, which is n_keep * (fft-size / fft-size-fraction) input samples after the previous one.
+        // Mixing the band center (absolute bin b) down to 0 Hz continuously therefore needs a rotation of exp(-2 pi i b k n_keep / fft-size-fraction) on frame k.
+        // The phase is computed in integer arithmetic modulo fft-size-fraction so that it stays exact for arbitrarily long runs.
+        const uint64_t t_center_bin = (uint64_t)lrint( a_freq_data->get_minimum_frequency() / a_freq_data->get_bin_width() ) + t_bin_start + t_half;
+        const uint64_t t_phase_step = ( t_center_bin % t_n_bins ) * ( t_n_keep % t_n_bins ) % t_n_bins;
+        const uint64_t t_phase_index = t_phase_step * ( f_frame_counter % t_n_bins ) % t_n_bins;
+        const double t_phase = -2. * M_PI * (double)t_phase_index / (double)t_n_bins;
+        const double t_norm = sqrt( (double)f_sampling_rate / (double)f_fft_size );
+        const float t_rot_re = cos( t_phase ) * t_norm;
+        const float t_rot_im = sin( t_phase ) * t_norm;
+        ++f_frame_counter;
+
+        for ( unsigned i_sample = f_frame_discard; i_sample < f_frame_discard + t_n_keep; ++i_sample )
+        {
+            if ( f_current_output == nullptr )
+            {
+                f_current_output = out_stream< 0 >().data();
+                f_output_fill = 0;
+                f_output_first_index = a_freq_data->get_first_sample_index() + (uint64_t)i_sample * f_fft_size / t_n_bins;
+            }
+            const float t_re = f_fftwf_output[ i_sample ][ 0 ];
+            const float t_im = f_fftwf_output[ i_sample ][ 1 ];
+            iq_time_data::complex_t* t_values = values_for( f_current_output )->get_data_array();
+            t_values[ f_output_fill ][ 0 ] = t_re * t_rot_re - t_im * t_rot_im;
+            t_values[ f_output_fill ][ 1 ] = t_re * t_rot_im + t_im * t_rot_re;
+            if ( ++f_output_fill == f_output_size )
+            {
+                f_current_output->set_chunk_counter( f_output_counter++ );
+                uint64_t t_end_index = a_freq_data->get_first_sample_index() + (uint64_t)( i_sample + 1 ) * f_fft_size / t_n_bins;
+                f_sequence.stamp_output( *f_current_output, f_output_first_index, t_end_index - f_output_first_index );
+                encode_output( f_current_output );
+                f_current_output = nullptr;
+                if ( ! out_stream< 0 >().set( stream::s_run ) )
+                {
+                    LERROR( flog, "inverse_frequency_transform error setting IQ output stream to s_run" );
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void inverse_frequency_transform::build_band_filter()
+    {
+        // Kaiser-windowed sinc with taps at -L..L input samples, L = D * fft-size / fft-size-fraction: its circular wrap-around in the
+        // inverse FFT then covers exactly the D discarded output samples at each end of the frame
+        const unsigned t_n_bins = f_fft_size_fraction;
+        const unsigned t_half = t_n_bins / 2;
+        const unsigned t_half_length = f_frame_discard * ( f_fft_size / f_fft_size_fraction );
+        f_band_response.assign( t_n_bins, 1.f );
+        if ( t_half_length == 0 ) return;
+
+        // frequencies in bins from the band center; the stopband starts at the band edges
+        const double t_edge = 0.5 * (double)t_n_bins;
+        const double t_pass = f_passband_fraction * t_edge;
+        const double t_cutoff = 0.5 * ( t_pass + t_edge );
+        // Kaiser's design formulas: attenuation for this length and transition width, and the beta that reaches it
+        const double t_transition = 2. * M_PI * ( t_edge - t_pass ) / (double)f_fft_size;
+        const double t_attenuation = 2.285 * t_transition * 2. * (double)t_half_length + 7.95;
+        double t_beta = 0.;
+        if ( t_attenuation > 50. ) t_beta = 0.1102 * ( t_attenuation - 8.7 );
+        else if ( t_attenuation >= 21. ) t_beta = 0.5842 * pow( t_attenuation - 21., 0.4 ) + 0.07886 * ( t_attenuation - 21. );
+
+        std::vector< double > t_taps( t_half_length + 1 );
+        const double t_kaiser_norm = 1. / std::cyl_bessel_i( 0., t_beta );
+        double t_sum = 0.;
+        for ( unsigned i_tap = 0; i_tap <= t_half_length; ++i_tap )
+        {
+            const double t_x = (double)i_tap / (double)t_half_length;
+            const double t_arg = 2. * M_PI * t_cutoff * (double)i_tap / (double)f_fft_size;
+            t_taps[ i_tap ] = std::cyl_bessel_i( 0., t_beta * sqrt( 1. - t_x * t_x ) ) * t_kaiser_norm * ( i_tap == 0 ? 1. : sin( t_arg ) / t_arg );
+            t_sum += ( i_tap == 0 ? 1. : 2. ) * t_taps[ i_tap ];
+        }
+
+        // the filter is symmetric, so its response is real; normalized to unity at the band center
+        for ( unsigned i_bin = 0; i_bin < t_n_bins; ++i_bin )
+        {
+            const double t_offset = (double)i_bin - (double)t_half;
+            double t_response = t_taps[ 0 ];
+            for ( unsigned i_tap = 1; i_tap <= t_half_length; ++i_tap )
+            {
+                t_response += 2. * t_taps[ i_tap ] * cos( 2. * M_PI * t_offset * (double)i_tap / (double)f_fft_size );
+            }
+            f_band_response[ ( i_bin + t_n_bins - t_half ) % t_n_bins ] = t_response / t_sum;
+        }
+        LINFO( flog, "overlap-save band filter: " << 2 * t_half_length + 1 << " taps, flat over " << f_passband_fraction << " of the band, about " << t_attenuation << " dB stopband attenuation" );
+        if ( t_attenuation < 40. )
+        {
+            LWARN( flog, "overlap-save band filter reaches only about " << t_attenuation << " dB; a larger overlap-fraction or a smaller passband-fraction gives a sharper filter" );
+        }
+        return;
+    }
+
     void inverse_frequency_transform::finalize()
     {
         LINFO( flog, "in finalize(), freeing fftw data objects" );
@@ -237,10 +459,27 @@ namespace fast_daq
         f_transform_flag_map["EXHAUSTIVE"] = FFTW_EXHAUSTIVE;
     }
 
+    iq_time_data* inverse_frequency_transform::values_for( iq_time_data* a_output )
+    {
+        return f_compact_only ? &f_staging : a_output;
+    }
+
+    void inverse_frequency_transform::encode_output( iq_time_data* a_output )
+    {
+        if ( ! f_compact_only )
+        {
+            a_output->make_compact( f_compact_format, f_compact_scale );
+            return;
+        }
+        f_staging.make_compact( f_compact_format, f_compact_scale );
+        a_output->take_compact( f_staging );
+        return;
+    }
+
 
     // inverse_frequency_transform_binding methods
     inverse_frequency_transform_binding::inverse_frequency_transform_binding() :
-            _node_binding< inverse_frequency_transform, inverse_frequency_transform_binding >()
+            _tuned_node_binding< inverse_frequency_transform, inverse_frequency_transform_binding >()
     {
     }
 
@@ -248,7 +487,7 @@ namespace fast_daq
     {
     }
 
-    void inverse_frequency_transform_binding::do_apply_config( inverse_frequency_transform* a_node, const scarab::param_node& a_config ) const
+    void inverse_frequency_transform_binding::do_apply_node_config( inverse_frequency_transform* a_node, const scarab::param_node& a_config ) const
     {
         LDEBUG( flog, "Configuring inverse_frequency_transform with:\n" << a_config );
         a_node->set_time_length( a_config.get_value( "time-length", a_node->get_time_length() ) );
@@ -259,9 +498,16 @@ namespace fast_daq
         a_node->set_use_wisdom( a_config.get_value( "use-wisdom", a_node->get_use_wisdom() ) );
         a_node->set_wisdom_filename( a_config.get_value( "wisdom-filename", a_node->get_wisdom_filename() ) );
         a_node->set_start_fraction( a_config.get_value( "start-fraction", a_node->get_start_fraction() ) );
+        a_node->set_mode( inverse_frequency_transform::string_to_mode( a_config.get_value( "mode", inverse_frequency_transform::mode_to_string( a_node->get_mode() ) ) ) );
+        a_node->set_overlap_fraction( a_config.get_value( "overlap-fraction", a_node->get_overlap_fraction() ) );
+        a_node->set_output_size( a_config.get_value( "output-size", a_node->get_output_size() ) );
+        a_node->set_passband_fraction( a_config.get_value( "passband-fraction", a_node->get_passband_fraction() ) );
+        a_node->set_compact_format( compact_data::string_to_compact_format( a_config.get_value( "compact-format", compact_data::compact_format_to_string( a_node->get_compact_format() ) ) ) );
+        a_node->set_compact_scale( a_config.get_value( "compact-scale", a_node->get_compact_scale() ) );
+        a_node->set_compact_only( a_config.get_value( "compact-only", a_node->get_compact_only() ) );
     }
 
-    void inverse_frequency_transform_binding::do_dump_config( const inverse_frequency_transform* a_node, scarab::param_node& a_config ) const
+    void inverse_frequency_transform_binding::do_dump_node_config( const inverse_frequency_transform* a_node, scarab::param_node& a_config ) const
     {
         LDEBUG( flog, "Dumping inverse_frequency_transform configuration" );
         a_config.add( "time-length", scarab::param_value( a_node->get_time_length() ) );
@@ -272,6 +518,13 @@ namespace fast_daq
         a_config.add( "use-wisdom", scarab::param_value( a_node->get_use_wisdom() ) );
         a_config.add( "wisdom-filename", scarab::param_value( a_node->get_wisdom_filename() ) );
         a_config.add( "start-fraction", scarab::param_value( a_node->get_start_fraction() ) );
+        a_config.add( "mode", scarab::param_value( inverse_frequency_transform::mode_to_string( a_node->get_mode() ) ) );
+        a_config.add( "overlap-fraction", scarab::param_value( a_node->get_overlap_fraction() ) );
+        a_config.add( "output-size", scarab::param_value( a_node->get_output_size() ) );
+        a_config.add( "passband-fraction", scarab::param_value( a_node->get_passband_fraction() ) );
+        a_config.add( "compact-format", scarab::param_value( compact_data::compact_format_to_string( a_node->get_compact_format() ) ) );
+        a_config.add( "compact-scale", scarab::param_value( a_node->get_compact_scale() ) );
+        a_config.add( "compact-only", scarab::param_value( a_node->get_compact_only() ) );
     }
 
     bool inverse_frequency_transform_binding::do_run_command( inverse_frequency_transform* /* a_node */, const std::string& a_cmd, const scarab::param_node& ) const
@@ -0,0 +1,384 @@
+/*
+ * pfb_channelizer.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pfb_channelizer.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( pfb_channelizer, "pfb-channelizer", pfb_channelizer_binding );
+
+    LOGGER( flog, "pfb_channelizer" );
+
+    pfb_channelizer::pfb_channelizer() :
+            f_freq_length( 10 ),
+            f_n_channels( 4096 ),
+            f_n_taps( 4 ),
+            f_window( window_type_t::hamming ),
+            f_samples_per_sec( 0 ),
+            f_transform_flag( "ESTIMATE" ),
+            f_use_wisdom( true ),
+            f_wisdom_filename( "wisdom_pfb.fftw3" ),
+            f_centerish_freq( 0. ),
+            f_min_output_bandwidth( 0. ),
+            f_transform_flag_map(),
+            f_prototype(),
+            f_norm( 1. ),
+            f_volts(),
+            f_history(),
+            f_history_first_index( 0 ),
+            f_sequence(),
+            f_spectrum_counter( 0 ),
+            f_fftwf_input( nullptr ),
+            f_fftwf_output( nullptr ),
+            f_fftwf_plan(),
+            f_multithreaded_is_initialized( false )
+    {
+        setup_internal_maps();
+    }
+
+    pfb_channelizer::~pfb_channelizer()
+    {
+    }
+
+    // calculate derived params from members
+    float pfb_channelizer::bin_width_hz() const
+    {
+        return (float) f_samples_per_sec / (float) f_n_channels;
+    }
+
+    unsigned pfb_channelizer::num_spectrum_bins() const
+    {
+        // real-to-complex transform
+        return f_n_channels / 2 + 1;
+    }
+
+    unsigned pfb_channelizer::num_output_bins() const
+    {
+        unsigned to_return = num_spectrum_bins();
+        if ( f_min_output_bandwidth > 0. )
+        {
+            to_return = static_cast<int>( f_min_output_bandwidth / bin_width_hz() - 1. ) + 1;
+        }
+        return std::min( to_return, num_spectrum_bins() );
+    }
+
+    unsigned pfb_channelizer::first_output_index() const
+    {
+        if ( num_output_bins() == num_spectrum_bins() ) return 0;
+        // the same band selection as frequency_transform::first_output_index(), so that the bins line up when one node replaces the other
+        float t_bin_width_hz = bin_width_hz();
+        unsigned center_bin = ((f_n_channels - 1) / 2) + 1;
+        if ( f_centerish_freq > 0. )
+        {
+            center_bin = static_cast<unsigned>( f_centerish_freq / t_bin_width_hz );
+        }
+        unsigned to_return = center_bin - (num_output_bins() / 2);
+        // even number of bins && target is in upper half
+        if ( ! (num_output_bins() % 2) && ( ( f_centerish_freq - (num_output_bins() / 2)*t_bin_width_hz ) > (t_bin_width_hz/2.) ) )
+        {
+            to_return += 1;
+        }
+        return to_return;
+    }
+
+    float pfb_channelizer::min_output_frequency() const
+    {
+        return first_output_index() * bin_width_hz();
+    }
+
+    void pfb_channelizer::build_prototype_filter()
+    {
+        // windowed sinc with its first nulls one channel spacing from the center
+        const unsigned t_length = f_n_channels * f_n_taps;
+        make_window( f_window, t_length, f_prototype );
+        const double t_center = 0.5 * (double)( t_length - 1 );
+        for ( unsigned i_coeff = 0; i_coeff < t_length; ++i_coeff )
+        {
+            double t_x = ( (double)i_coeff - t_center ) / (double)f_n_channels;
+            double t_sinc = t_x == 0. ? 1. : sin( M_PI * t_x ) / ( M_PI * t_x );
+            f_prototype[ i_coeff ] *= t_sinc;
+        }
+        // same PSD normalization as frequency_transform, with the filter's sum of squares in place of the FFT size
+        f_norm = sqrt( 2. / window_sum_of_squares( f_prototype ) / (double)f_samples_per_sec );
+        return;
+    }
+
+    void pfb_channelizer::initialize()
+    {
+        if ( f_n_channels < 2 ) throw fast_daq::error() << "pfb-channelizer requires at least 2 channels";
+        if ( f_n_taps == 0 ) throw fast_daq::error() << "pfb-channelizer requires at least 1 tap";
+        if ( f_samples_per_sec == 0 ) throw fast_daq::error() << "pfb-channelizer requires samples-per-sec to be set";
+        // a band that runs below 0 Hz wraps first_output_index() around to a very large value, so this also catches that case
+        if ( (uint64_t)first_output_index() + num_output_bins() > num_spectrum_bins() )
+        {
+            throw fast_daq::error() << "pfb-channelizer: the " << num_output_bins() << " output bins around freq-in-center-bin do not fit in the " << num_spectrum_bins() << " channels from 0 to the Nyquist frequency";
+        }
+
+        out_buffer< 0 >().initialize( f_freq_length );
+        out_buffer< 0 >().call( &frequency_data::allocate_array, num_output_bins() );
+        out_buffer< 0 >().call( &frequency_data::set_fft_size, f_n_channels );
+        // the frames are always tapered, by the prototype filter; its window is the closest description
+        out_buffer< 0 >().call( &frequency_data::set_window, f_window );
+
+        LINFO( flog, "configuring to use: " << num_output_bins() << " of " << num_spectrum_bins() << " channels, each " << bin_width_hz() << " Hz wide; " <<
+                f_n_taps << " taps with a " << window_type_to_string( f_window ) << " window" );
+
+        build_prototype_filter();
+
+        if (f_use_wisdom)
+        {
+            LDEBUG( flog, "Reading wisdom from file <" << f_wisdom_filename << ">");
+            if (fftwf_import_wisdom_from_filename(f_wisdom_filename.c_str()) == 0)
+            {
+                LWARN( flog, "Unable to read FFTW wisdom from file <" << f_wisdom_filename << ">" );
+            }
+        }
+        //initialize multithreaded
+        #ifdef FFTW_NTHREADS
+            if (! f_multithreaded_is_initialized)
+            {
+                fftwf_init_threads();
+                fftwf_plan_with_nthreads(FFTW_NTHREADS);
+                LDEBUG( flog, "Configuring FFTW to use up to " << FFTW_NTHREADS << " threads.");
+                f_multithreaded_is_initialized = true;
+            }
+        #endif
+        transform_flag_map_t::const_iterator iter = f_transform_flag_map.find(f_transform_flag);
+        if ( iter == f_transform_flag_map.end() ) throw fast_daq::error() << "Unknown transform flag <" << f_transform_flag << ">";
+        unsigned transform_flag = iter->second;
+
+        f_fftwf_input = (float*) fftwf_malloc(sizeof(float) * f_n_channels);
+        f_fftwf_output = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * num_spectrum_bins());
+        f_fftwf_plan = fftwf_plan_dft_r2c_1d(f_n_channels, f_fftwf_input, f_fftwf_output, transform_flag);
+        if (f_fftwf_plan == NULL) throw fast_daq::error() << "Unable to create the FFTW plan";
+        if (f_use_wisdom)
+        {
+            if (fftwf_export_wisdom_to_filename(f_wisdom_filename.c_str()) == 0)
+            {
+                LWARN( flog, "Unable to write FFTW wisdom to file<" << f_wisdom_filename << ">");
+            }
+        }
+        LDEBUG( flog, "FFTW plan created; initialization complete" );
+
+        return;
+    }
+
+    bool pfb_channelizer::process_chunk( const real_time_data* a_time_data )
+    {
+        const uint64_t t_window_length = f_prototype.size();
+        const unsigned t_first_bin = first_output_index();
+        const unsigned t_n_output_bins = num_output_bins();
+
+        if ( f_sequence.add_input( *a_time_data ) )
+        {
+            // the filter can't run across a break in the input; start filling it again
+            f_history.consume( f_history.size() );
+            f_history_first_index = a_time_data->get_first_sample_index();
+        }
+
+        // append the new samples to whatever is left over from the previous chunk
+        f_volts.resize( a_time_data->get_array_size() );
+        a_time_data->fill_volts( f_volts.data() );
+        f_history.append( f_volts.data(), f_volts.size() );
+
+        while ( f_history.size() >= t_window_length )
+        {
+            // weight and fold the n-taps segments into one n-channels block
+            const float* t_samples = f_history.data();
+            for ( unsigned i_chan = 0; i_chan < f_n_channels; ++i_chan )
+            {
+                f_fftwf_input[ i_chan ] = f_prototype[ i_chan ] * t_samples[ i_chan ];
+            }
+            for ( unsigned i_tap = 1; i_tap < f_n_taps; ++i_tap )
+            {
+                const float* t_coeffs = f_prototype.data() + i_tap * f_n_channels;
+                const float* t_tap_samples = t_samples + i_tap * f_n_channels;
+                for ( unsigned i_chan = 0; i_chan < f_n_channels; ++i_chan )
+                {
+                    f_fftwf_input[ i_chan ] += t_coeffs[ i_chan ] * t_tap_samples[ i_chan ];
+                }
+            }
+
+            fftwf_execute( f_fftwf_plan );
+
+            frequency_data* freq_data_out = out_stream< 0 >().data();
+            for ( unsigned i_bin = 0; i_bin < t_n_output_bins; ++i_bin )
+            {
+                freq_data_out->get_data_array()[ i_bin ][ 0 ] = f_fftwf_output[ t_first_bin + i_bin ][ 0 ] * f_norm;
+                freq_data_out->get_data_array()[ i_bin ][ 1 ] = f_fftwf_output[ t_first_bin + i_bin ][ 1 ] * f_norm;
+            }
+            freq_data_out->set_chunk_counter( f_spectrum_counter++ );
+            f_sequence.stamp_output( *freq_data_out, f_history_first_index, t_window_length );
+            if ( ! out_stream< 0 >().set( stream::s_run ) )
+            {
+                LERROR( flog, "pfb_channelizer error setting frequency output stream to s_run" );
+                return false;
+            }
+
+            f_history.consume( f_n_channels );
+            f_history_first_index += f_n_channels;
+        }
+        return true;
+    }
+
+    void pfb_channelizer::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the PFB channelizer" );
+
+            LINFO( flog, "Starting main loop (pfb channelizer)" );
+            while (! is_canceled() )
+            {
+                // real input arrives on slot 1, as for frequency-transform; slot 0 (IQ time data) is not used
+                midge::enum_t in_cmd = in_stream< 1 >().get();
+                unsigned in_stream_index = in_stream< 1 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    // samples from a previous acquisition must not leak into this one
+                    f_history.clear();
+                    f_sequence.reset();
+                    f_spectrum_counter = 0;
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    out_buffer< 0 >().call( &frequency_data::set_bin_width, bin_width_hz() );
+                    out_buffer< 0 >().call( &frequency_data::set_minimum_frequency, min_output_frequency() );
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_chunk( in_stream< 1 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "PFB CHANNELIZER is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void pfb_channelizer::finalize()
+    {
+        LINFO( flog, "in finalize(), freeing fftw data objects" );
+        out_buffer< 0 >().finalize();
+        if (f_fftwf_plan != NULL)
+        {
+            fftwf_destroy_plan(f_fftwf_plan);
+            f_fftwf_plan = NULL;
+        }
+        if (f_fftwf_input != NULL )
+        {
+            fftwf_free(f_fftwf_input);
+            f_fftwf_input = NULL;
+        }
+        if (f_fftwf_output != NULL)
+        {
+            fftwf_free(f_fftwf_output);
+            f_fftwf_output = NULL;
+        }
+        return;
+    }
+
+    void pfb_channelizer::setup_internal_maps()
+    {
+        f_transform_flag_map.clear();
+        f_transform_flag_map["ESTIMATE"] = FFTW_ESTIMATE;
+        f_transform_flag_map["MEASURE"] = FFTW_MEASURE;
+        f_transform_flag_map["PATIENT"] = FFTW_PATIENT;
+        f_transform_flag_map["EXHAUSTIVE"] = FFTW_EXHAUSTIVE;
+    }
+
+
+    // pfb_channelizer_binding methods
+    pfb_channelizer_binding::pfb_channelizer_binding() :
+            _tuned_node_binding< pfb_channelizer, pfb_channelizer_binding >()
+    {
+    }
+
+    pfb_channelizer_binding::~pfb_channelizer_binding()
+    {
+    }
+
+    void pfb_channelizer_binding::do_apply_node_config( pfb_channelizer* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring pfb_channelizer with:\n" << a_config );
+        a_node->set_freq_length( a_config.get_value( "freq-length", a_node->get_freq_length() ) );
+        a_node->set_n_channels( a_config.get_value( "n-channels", a_node->get_n_channels() ) );
+        a_node->set_n_taps( a_config.get_value( "n-taps", a_node->get_n_taps() ) );
+        a_node->set_window( string_to_window_type( a_config.get_value( "window", window_type_to_string( a_node->get_window() ) ) ) );
+        a_node->set_samples_per_sec( a_config.get_value( "samples-per-sec", a_node->get_samples_per_sec() ) );
+        a_node->set_transform_flag( a_config.get_value( "transform-flag", a_node->get_transform_flag() ) );
+        a_node->set_use_wisdom( a_config.get_value( "use-wisdom", a_node->get_use_wisdom() ) );
+        a_node->set_wisdom_filename( a_config.get_value( "wisdom-filename", a_node->get_wisdom_filename() ) );
+        a_node->set_centerish_freq( a_config.get_value( "freq-in-center-bin", a_node->get_centerish_freq() ) );
+        a_node->set_min_output_bandwidth( a_config.get_value( "min-output-bandwidth", a_node->get_min_output_bandwidth() ) );
+        return;
+    }
+
+    void pfb_channelizer_binding::do_dump_node_config( const pfb_channelizer* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping pfb_channelizer configuration" );
+        a_config.add( "freq-length", scarab::param_value( a_node->get_freq_length() ) );
+        a_config.add( "n-channels", scarab::param_value( a_node->get_n_channels() ) );
+        a_config.add( "n-taps", scarab::param_value( a_node->get_n_taps() ) );
+        a_config.add( "window", scarab::param_value( window_type_to_string( a_node->get_window() ) ) );
+        a_config.add( "samples-per-sec", scarab::param_value( a_node->get_samples_per_sec() ) );
+        a_config.add( "transform-flag", scarab::param_value( a_node->get_transform_flag() ) );
+        a_config.add( "use-wisdom", scarab::param_value( a_node->get_use_wisdom() ) );
+        a_config.add( "wisdom-filename", scarab::param_value( a_node->get_wisdom_filename() ) );
+        a_config.add( "freq-in-center-bin", scarab::param_value( a_node->get_centerish_freq() ) );
+        a_config.add( "min-output-bandwidth", scarab::param_value( a_node->get_min_output_bandwidth() ) );
+        return;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,155 @@
+/*
+ * pfb_channelizer.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_PFB_CHANNELIZER_HH_
+#define FAST_DAQ_PFB_CHANNELIZER_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "frequency_data.hh"
+#include "real_time_data.hh"
+#include "time_data.hh"
+#include "sample_ring.hh"
+#include "window_functions.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+//external
+#include <fftw3.h>
+
+#include <map>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class pfb_channelizer
+     @brief A transformer that splits real time data into frequency channels with a polyphase filter bank.
+
+     @details
+     A critically-sampled polyphase filter bank: each output spectrum is computed from n-channels * n-taps input samples,
+     weighted by a windowed-sinc prototype filter, folded into n-channels points, and transformed with a real-to-complex FFT.
+     Consecutive spectra are n-channels samples apart, so each input chunk produces (chunk size) / n-channels spectra.
+     Input samples that don't yet complete a spectrum are carried over to the next chunk, so the output does not depend
+     on how the input is chunked.  Each spectrum is sequenced by the n-channels * n-taps samples it was computed from; at a
+     break in the input sequence the filter history is discarded and starts filling again.
+
+     Compared to frequency-transform's rectangular window, the channel response is much flatter across each bin and
+     leakage from distant frequencies is suppressed by the window's sidelobe level, for n-taps multiply-adds per sample
+     on top of the same FFT.
+
+     The output is normalized like frequency-transform (sqrt(2/(fs * sum(h^2))), where h is the prototype filter), so it
+     can replace frequency-transform for real input in existing configurations: the input slots are the same (real input
+     on slot 1), and the output band is selected with the same rule, so with n-channels equal to the fft-size the output
+     bins line up with frequency-transform's.  A band that doesn't fit between 0 Hz and the Nyquist frequency is refused.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "pfb-channelizer"
+
+     Available configuration values:
+     - "freq-length": uint -- The size of the output frequency-data buffer
+     - "n-channels": uint -- number of points in each FFT; the channel spacing is samples-per-sec / n-channels (default: 4096)
+     - "n-taps": uint -- number of taps per polyphase branch (default: 4)
+     - "window": string -- window applied to the sinc prototype filter: rectangular, hann, hamming, or blackman-harris (default: hamming)
+     - "samples-per-sec": int -- the sampling rate for the upstream node
+     - "transform-flag": string -- FFTW flag to indicate how much optimization of the fftwf_plan is desired
+     - "use-wisdom": bool -- whether to use a plan from a wisdom file and save the plan to that file
+     - "wisdom-filename": string -- if "use-wisdom" is true, resolvable path to the wisdom file
+     - "freq-in-center-bin": double -- determine the center output bin to be the bin containing this frequency in Hz (default = 0; special case meaning center of the full band)
+     - "min-output-bandwidth": double -- the output band will be an integer number of bins covering at least this width, centered on the bin identified by the freq-in-center-bin parameter (default = 0; special case meaning the full band)
+
+     Input Stream:
+     - 0: time_data (IQ) -- not supported; the slot is there so that connections match frequency-transform
+     - 1: real_time_data
+
+     Output Streams:
+     - 0: frequency_data
+    */
+    class pfb_channelizer : public midge::_transformer< midge::type_list< time_data, real_time_data >, midge::type_list< frequency_data > >, public thread_tuning
+    {
+        private:
+            typedef std::map< std::string, unsigned > transform_flag_map_t;
+
+        public:
+            pfb_channelizer();
+            virtual ~pfb_channelizer();
+
+        mv_accessible( uint64_t, freq_length );
+        mv_accessible( unsigned, n_channels );
+        mv_accessible( unsigned, n_taps );
+        mv_accessible( window_type_t, window );
+        mv_accessible( uint32_t, samples_per_sec );
+        mv_accessible( std::string, transform_flag );
+        mv_accessible( bool, use_wisdom );
+        mv_accessible( std::string, wisdom_filename );
+        mv_accessible( double, centerish_freq );
+        mv_accessible( double, min_output_bandwidth );
+
+        // derived scalars
+        private:
+            float bin_width_hz() const;
+            unsigned num_spectrum_bins() const;
+            unsigned first_output_index() const;
+            float min_output_frequency() const;
+            unsigned num_output_bins() const;
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            void build_prototype_filter();
+            bool process_chunk( const real_time_data* a_time_data );
+
+            transform_flag_map_t f_transform_flag_map;
+            std::vector< float > f_prototype; // n-channels * n-taps coefficients
+            float f_norm;
+
+            std::vector< float > f_volts;
+            sample_ring< float > f_history; // input samples (in volts) not yet fully consumed
+            uint64_t f_history_first_index; // sample index of the oldest sample in the history
+            sequence_tracker f_sequence;
+            uint64_t f_spectrum_counter;
+
+            float* f_fftwf_input;
+            fftwf_complex* f_fftwf_output;
+            fftwf_plan f_fftwf_plan;
+
+            bool f_multithreaded_is_initialized;
+
+        private:
+            void setup_internal_maps();
+
+    };
+
+
+    class pfb_channelizer_binding : public _tuned_node_binding< pfb_channelizer, pfb_channelizer_binding >
+    {
+        public:
+            pfb_channelizer_binding();
+            virtual ~pfb_channelizer_binding();
+
+        private:
+            virtual void do_apply_node_config( pfb_channelizer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const pfb_channelizer* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_PFB_CHANNELIZER_HH_ */
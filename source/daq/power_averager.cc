@@ -6,6 +6,7 @@
  */
 
 #include <stdio.h>
+#include <algorithm>
 #include <cmath>
 
 //scarab includes
@@ -17,6 +18,8 @@
 #include "power_data.hh"
 #include "real_time_data.hh"
 
+#include "fast_daq_error.hh"
+
 
 using midge::stream;
 
@@ -29,15 +32,42 @@ namespace fast_daq
     /* power_averager class */
     /***************************/
 
+    std::string power_averager::averaging_mode_to_string( averaging_mode_t a_mode )
+    {
+        switch( a_mode )
+        {
+            case averaging_mode_t::sum: return "sum";
+            case averaging_mode_t::mean: return "mean";
+            default: throw fast_daq::error() << "averaging_mode value <" << static_cast< unsigned >( a_mode ) << "> not recognized";
+        }
+    }
+    power_averager::averaging_mode_t power_averager::string_to_averaging_mode( const std::string& a_mode )
+    {
+        if( a_mode == averaging_mode_to_string( averaging_mode_t::sum ) ) return averaging_mode_t::sum;
+        if( a_mode == averaging_mode_to_string( averaging_mode_t::mean ) ) return averaging_mode_t::mean;
+        throw fast_daq::error() << "string <" << a_mode << "> not recognized as valid averaging_mode";
+    }
+
     // power_averager methods
     power_averager::power_averager() :
         f_num_output_buffers( 1 ),
         f_spectrum_size(),
         f_num_to_average( 0 ),
+        f_averaging_mode( averaging_mode_t::sum ),
+        f_compute_kurtosis( false ),
+        f_compact_format( compact_data::compact_format_t::none ),
+        f_compact_scale( 0. ),
         f_bin_width(),
         f_minimum_frequency(),
         f_average_spectrum(),
-        f_input_counter( 0 )
+        f_sum_power_sq(),
+        f_power(),
+        f_input_counter( 0 ),
+        f_flag_counts(),
+        f_n_flagged( 0 ),
+        f_sequence(),
+        f_first_sample_index( 0 ),
+        f_end_sample_index( 0 )
     {
     }
 
@@ -50,8 +80,15 @@ namespace fast_daq
     {
         out_buffer< 0 >().initialize( f_num_output_buffers );
         out_buffer< 0 >().call( &power_data::allocate_array, f_spectrum_size );
+        if ( f_compute_kurtosis )
+        {
+            out_buffer< 0 >().call( &power_data::allocate_kurtosis_array, f_spectrum_size );
+            f_sum_power_sq.resize( f_spectrum_size, 0. );
+            f_power.resize( f_spectrum_size );
+        }
 
         f_average_spectrum.resize( f_spectrum_size, 0. );
+        f_flag_counts.resize( f_spectrum_size, 0 );
 
         //f_rescale = f_num_to_average == 0 ? 1. : 1. / (float)f_num_to_average;
 	
@@ -66,6 +103,7 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             while (! is_canceled() )
             {
                 // Check for midge instructions
@@ -129,32 +167,69 @@ namespace fast_daq
     void power_averager::handle_start()
     {
         std::fill( f_average_spectrum.begin(), f_average_spectrum.end(), 0. );
+        std::fill( f_sum_power_sq.begin(), f_sum_power_sq.end(), 0. );
+        std::fill( f_flag_counts.begin(), f_flag_counts.end(), 0 );
         f_input_counter = 0;
+        f_n_flagged = 0;
+        f_sequence.reset();
     }
 
     void power_averager::handle_run()
     {
-        frequency_data* data_in = in_stream< 0 >().data();
-        frequency_data::complex_t* data_array_in = data_in->get_data_array();
+        const frequency_data* data_in = in_stream< 0 >().data();
+        data_in->require_full_precision( get_name() );
         //TODO I shouldn't be doing this on each pass, just the first...
         //     ... even better, do it with a call upon getting s_start, or in init, or something
         f_bin_width = data_in->get_bin_width();
         f_minimum_frequency = data_in->get_minimum_frequency();
 
+        // an average never straddles a break in the input: send what has been collected before it
+        if ( f_input_counter > 0 && f_sequence.breaks_sequence( *data_in ) )
+        {
+            send_output();
+        }
+        f_sequence.add_input( *data_in );
+        if ( f_input_counter == 0 ) f_first_sample_index = data_in->get_first_sample_index();
+        f_end_sample_index = data_in->end_sample_index();
+
         if (data_in->get_array_size() != f_average_spectrum.size())
         {
             LERROR( flog, "input array size [" << data_in->get_array_size() <<"] != output array size ["<<f_average_spectrum.size()<<"]");
             //TODO throw something smart please
 	    f_average_spectrum.resize(data_in->get_array_size(), 0.);
+            f_flag_counts.resize(data_in->get_array_size(), 0);
+            if ( f_compute_kurtosis ) f_sum_power_sq.resize(data_in->get_array_size(), 0.);
+            if ( f_compute_kurtosis ) f_power.resize(data_in->get_array_size());
             f_avg_spectrum_bytes = f_average_spectrum.size() * sizeof(float);
             LPROG( flog, "Resized average spectrum to match input: " << data_in->get_array_size() );
             //throw 1;
         }
 
-        for (unsigned i_bin=0; i_bin < data_in->get_array_size(); ++i_bin)
+        if ( f_compute_kurtosis )
         {
-            // compute the power in mW (note, not W)
-            f_average_spectrum[i_bin] += ( data_array_in[i_bin][0]*data_array_in[i_bin][0] + data_array_in[i_bin][1]*data_array_in[i_bin][1] ) * f_rescale;
+            // S1 and S2 in the same pass
+            data_in->fill_power( f_power.data() );
+            for (unsigned i_bin=0; i_bin < data_in->get_array_size(); ++i_bin)
+            {
+                float power = f_power[i_bin] * f_rescale;
+                f_average_spectrum[i_bin] += power;
+                f_sum_power_sq[i_bin] += (double)power * (double)power;
+            }
+        }
+        else
+        {
+            // compute the power in mW (note, not W), from either layout
+            data_in->add_power( f_average_spectrum.data(), f_rescale );
+        }
+
+        if ( data_in->get_n_flagged() > 0 )
+        {
+            const uint8_t* flags_in = data_in->get_flag_array();
+            for (unsigned i_bin=0; i_bin < data_in->get_array_size(); ++i_bin)
+            {
+                f_flag_counts[i_bin] += flags_in[i_bin] != 0;
+            }
+            f_n_flagged += data_in->get_n_flagged();
         }
 
         ++f_input_counter;
@@ -177,8 +252,33 @@ namespace fast_daq
 
     void power_averager::send_output()
     {
+        // Spectral kurtosis uses the raw sums, so it comes before any rescaling
+        power_data* out_data_ptr = out_stream< 0 >().data();
+        if ( f_compute_kurtosis )
+        {
+            float* out_kurtosis_array = out_data_ptr->get_kurtosis_array();
+            const unsigned n_bins = std::min< size_t >( f_average_spectrum.size(), out_data_ptr->get_array_size() );
+            const float n_summed = f_input_counter;
+            const float prefactor = f_input_counter > 1 ? ( n_summed + 1.f ) / ( n_summed - 1.f ) : 0.f;
+            for (unsigned i_bin=0; i_bin < n_bins; ++i_bin)
+            {
+                const double s1 = f_average_spectrum[i_bin];
+                out_kurtosis_array[i_bin] = s1 > 0. ? prefactor * ( n_summed * f_sum_power_sq[i_bin] / ( s1 * s1 ) - 1. ) : 0.f;
+            }
+            std::fill( f_sum_power_sq.begin(), f_sum_power_sq.end(), 0. );
+        }
+
+        if ( f_averaging_mode == averaging_mode_t::mean )
+        {
+            // Welch estimate: mean of the collected (already PSD-normalized) spectra
+            float t_rescale_factor = 1. / static_cast<float>(f_input_counter);
+            for (std::vector< float >::iterator bin_i = f_average_spectrum.begin(); bin_i != f_average_spectrum.end(); ++bin_i)
+            {
+                *bin_i = t_rescale_factor * *bin_i;
+            }
+        }
         // Rescale averaging N if needed
-        if ( f_input_counter != f_num_to_average )
+        else if ( f_input_counter != f_num_to_average )
         {
             if ( f_num_to_average != 0 )
             {
@@ -193,7 +293,6 @@ namespace fast_daq
         }
 
         // Copy data into output stream and re-zero the averager container
-        power_data* out_data_ptr = out_stream< 0 >().data();
         float* out_data_array = out_data_ptr->get_data_array();
 
         out_data_ptr->set_bin_width( f_bin_width );
@@ -201,8 +300,16 @@ namespace fast_daq
 
         std::memcpy( out_data_array, f_average_spectrum.data(), f_avg_spectrum_bytes );
         std::fill( f_average_spectrum.begin(), f_average_spectrum.end(), 0. );
+        out_data_ptr->make_compact( f_compact_format, f_compact_scale );
+
+        std::copy( f_flag_counts.begin(), f_flag_counts.begin() + std::min< size_t >( f_flag_counts.size(), out_data_ptr->get_array_size() ), out_data_ptr->get_flag_count_array() );
+        std::fill( f_flag_counts.begin(), f_flag_counts.end(), 0 );
+        out_data_ptr->set_n_flagged( f_n_flagged );
+        out_data_ptr->set_n_spectra( f_input_counter );
+        f_sequence.stamp_output( *out_data_ptr, f_first_sample_index, f_end_sample_index - f_first_sample_index );
 
         f_input_counter = 0;
+        f_n_flagged = 0;
 
         LINFO( flog, "sending out a spectrum" );
         if (! out_stream< 0 >().set( stream::s_run))
@@ -225,18 +332,26 @@ namespace fast_daq
     {
     }
 
-    void power_averager_binding::do_apply_config(power_averager* a_node, const scarab::param_node& a_config ) const
+    void power_averager_binding::do_apply_node_config(power_averager* a_node, const scarab::param_node& a_config ) const
     {
         a_node->set_num_output_buffers( a_config.get_value( "num-output-buffers", a_node->get_num_output_buffers() ) );
         a_node->set_spectrum_size( a_config.get_value( "spectrum-size", a_node->get_spectrum_size() ) );
         a_node->set_num_to_average( a_config.get_value( "num-to-average", a_node->get_num_to_average() ) );
+        a_node->set_averaging_mode( power_averager::string_to_averaging_mode( a_config.get_value( "averaging-mode", power_averager::averaging_mode_to_string( a_node->get_averaging_mode() ) ) ) );
+        a_node->set_compute_kurtosis( a_config.get_value( "compute-kurtosis", a_node->get_compute_kurtosis() ) );
+        a_node->set_compact_format( compact_data::string_to_compact_format( a_config.get_value( "compact-format", compact_data::compact_format_to_string( a_node->get_compact_format() ) ) ) );
+        a_node->set_compact_scale( a_config.get_value( "compact-scale", a_node->get_compact_scale() ) );
     }
 
-    void power_averager_binding::do_dump_config( const power_averager* a_node, scarab::param_node& a_config ) const
+    void power_averager_binding::do_dump_node_config( const power_averager* a_node, scarab::param_node& a_config ) const
     {
         a_config.add( "num-output-buffers", scarab::param_value( a_node->get_num_output_buffers() ) );
         a_config.add( "spectrum-size", scarab::param_value( a_node->get_spectrum_size() ) );
         a_config.add( "num-to-average", scarab::param_value( a_node->get_num_to_average() ) );
+        a_config.add( "averaging-mode", scarab::param_value( power_averager::averaging_mode_to_string( a_node->get_averaging_mode() ) ) );
+        a_config.add( "compute-kurtosis", scarab::param_value( a_node->get_compute_kurtosis() ) );
+        a_config.add( "compact-format", scarab::param_value( compact_data::compact_format_to_string( a_node->get_compact_format() ) ) );
+        a_config.add( "compact-scale", scarab::param_value( a_node->get_compact_scale() ) );
     }
 
 } /* namespace fast_daq */
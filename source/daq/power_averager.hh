@@ -10,6 +10,10 @@
 
 // sandfly includes
 #include "node_builder.hh"
+#include "thread_tuning.hh"
+
+#include "compact_data.hh"
+#include "sequenced_data.hh"
 
 #include "transformer.hh"
 #include "shared_cancel.hh"
@@ -33,7 +37,17 @@ namespace fast_daq
      an incoherent average of power. If an acquisition ends before the configured number of elements
      is received, the average as-collected average is sent (re-weighted for the number of terms collected...
      because the average is computed by scaling each term before adding to the sum, because that's
-     generally more reliable when using finite precision).
+     generally more reliable when using finite precision).  The same happens at a break in the input sequence (a new
+     acquisition or lost samples; see sequenced_data), so that no average mixes data from either side of a gap.
+     Each output is sequenced from the start of its first spectrum's frame to the end of its last.
+
+     Optionally (compute-kurtosis), the sum of squared powers S2 is accumulated in the same pass as the power sum S1,
+     and a spectral kurtosis array, SK = (M+1)/(M-1) * (M S2 / S1^2 - 1) for M summed spectra, is sent with the output.
+     SK is about 1 for Gaussian noise (standard deviation 2/sqrt(M)), below 1 for steady narrow-band signals and above 1
+     for intermittent interference.
+
+     If the input spectra carry RFI flags (e.g. from an rfi-excision node), the number of times each bin was
+     flagged is counted and sent with the output, along with the number of spectra summed.
 
      Node type: "power-averager"
 
@@ -41,6 +55,11 @@ namespace fast_daq
      - num-output-buffers: (int) -- number of output buffer slots (default==5)
      - spectrum-size: (int) -- number of bins in the output spectrum
      - num-to-average: (int) -- number of buffers to average together
+     - averaging-mode: (string) -- "sum" to output the sum of the collected power spectra, or "mean" to divide it by the number collected,
+       which gives a Welch PSD estimate when fed with windowed, overlapping spectra (default=="sum")
+     - compute-kurtosis: (bool) -- also accumulate S2 and send a spectral kurtosis array (default==false)
+     - compact-format: (string) -- also encode each output spectrum in 16 bits, for relays and writers: "none", "float16", "bfloat16" or "int16" (see compact_data) (default=="none")
+     - compact-scale: (double) -- for int16, the value of one code; 0 to scale each spectrum to its largest value (default==0)
 
      Input Streams
      - 1: frequency_data
@@ -49,8 +68,17 @@ namespace fast_daq
     - 0: power_data
 
     */
-    class power_averager : public midge::_transformer< midge::type_list<  frequency_data >, midge::type_list< power_data > >
+    class power_averager : public midge::_transformer< midge::type_list<  frequency_data >, midge::type_list< power_data > >, public thread_tuning
     {
+        public:
+            enum class averaging_mode_t
+            {
+                sum,
+                mean
+            };
+            static std::string averaging_mode_to_string( averaging_mode_t a_mode );
+            static averaging_mode_t string_to_averaging_mode( const std::string& a_mode );
+
         public:
             power_averager();
             virtual ~power_averager();
@@ -69,6 +97,10 @@ namespace fast_daq
         mv_accessible( unsigned, num_output_buffers );
         mv_accessible( unsigned, spectrum_size );
         mv_accessible( unsigned, num_to_average );
+        mv_accessible( averaging_mode_t, averaging_mode );
+        mv_accessible( bool, compute_kurtosis );
+        mv_accessible( compact_data::compact_format_t, compact_format );
+        mv_accessible( float, compact_scale );
         mv_accessible( float, bin_width );
         mv_accessible( float, minimum_frequency );
 
@@ -77,19 +109,28 @@ namespace fast_daq
 
         private:
             std::vector< float > f_average_spectrum;
+            std::vector< double > f_sum_power_sq; // S2, if computing the spectral kurtosis; double because squared PSDs can approach the float minimum
+            std::vector< float > f_power; // power of the current input, if computing the spectral kurtosis
             unsigned f_input_counter;
+            // RFI flags of the summed spectra, passed on with the output
+            std::vector< unsigned > f_flag_counts;
+            unsigned f_n_flagged;
+            // span of the summed spectra
+            sequence_tracker f_sequence;
+            uint64_t f_first_sample_index;
+            uint64_t f_end_sample_index;
 
     };
 
-    class power_averager_binding : public sandfly::_node_binding< power_averager, power_averager_binding >
+    class power_averager_binding : public _tuned_node_binding< power_averager, power_averager_binding >
     {
         public:
             power_averager_binding();
             virtual ~power_averager_binding();
 
         private:
-            virtual void do_apply_config(power_averager* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const power_averager* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config(power_averager* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const power_averager* a_node, scarab::param_node& a_config ) const;
     };
 } /* namespace fast_daq */
 #endif /* POWER_AVERAGER_HH_ */
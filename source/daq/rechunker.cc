@@ -0,0 +1,183 @@
+/*
+ * rechunker.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "rechunker.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( rechunker, "rechunker", rechunker_binding );
+
+    LOGGER( flog, "rechunker" );
+
+    rechunker::rechunker() :
+            f_out_length( 10 ),
+            f_output_size( 4096 ),
+            f_overlap( 0 ),
+            f_ring(),
+            f_ring_first_index( 0 ),
+            f_sequence(),
+            f_output_counter( 0 )
+    {
+    }
+
+    rechunker::~rechunker()
+    {
+    }
+
+    void rechunker::initialize()
+    {
+        if ( f_output_size == 0 ) throw fast_daq::error() << "rechunker requires a non-zero output-size";
+        if ( f_overlap >= f_output_size ) throw fast_daq::error() << "rechunker overlap <" << f_overlap << "> must be less than the output-size <" << f_output_size << ">";
+
+        out_buffer< 0 >().initialize( f_out_length );
+        out_buffer< 0 >().call( &real_time_data::allocate_array, f_output_size );
+
+        LINFO( flog, "emitting chunks of " << f_output_size << " samples every " << f_output_size - f_overlap << " samples" );
+        return;
+    }
+
+    bool rechunker::process_chunk( const real_time_data* a_time_data )
+    {
+        if ( f_sequence.add_input( *a_time_data ) )
+        {
+            // samples from before a break can't be joined to the ones after it
+            f_ring.consume( f_ring.size() );
+            f_ring_first_index = a_time_data->get_first_sample_index();
+        }
+        a_time_data->copy_samples( f_ring.extend( a_time_data->get_array_size() ) );
+
+        while ( f_ring.size() >= f_output_size )
+        {
+            real_time_data* t_out = out_stream< 0 >().data();
+            std::copy( f_ring.data(), f_ring.data() + f_output_size, t_out->get_time_series() );
+            t_out->set_dynamic_range( a_time_data->get_dynamic_range() );
+            t_out->set_bits_per_sample( a_time_data->get_bits_per_sample() );
+            t_out->set_chunk_counter( f_output_counter++ );
+            f_sequence.stamp_output( *t_out, f_ring_first_index, f_output_size );
+            if ( ! out_stream< 0 >().set( stream::s_run ) )
+            {
+                LERROR( flog, "rechunker error setting output stream to s_run" );
+                return false;
+            }
+            f_ring.consume( f_output_size - f_overlap );
+            f_ring_first_index += f_output_size - f_overlap;
+        }
+        return true;
+    }
+
+    void rechunker::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the rechunker" );
+
+            while (! is_canceled() )
+            {
+                midge::enum_t in_cmd = in_stream< 0 >().get();
+                unsigned in_stream_index = in_stream< 0 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    f_ring.clear();
+                    f_sequence.reset();
+                    f_output_counter = 0;
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_chunk( in_stream< 0 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "RECHUNKER is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void rechunker::finalize()
+    {
+        out_buffer< 0 >().finalize();
+        return;
+    }
+
+
+    // rechunker_binding methods
+    rechunker_binding::rechunker_binding() :
+            _tuned_node_binding< rechunker, rechunker_binding >()
+    {
+    }
+
+    rechunker_binding::~rechunker_binding()
+    {
+    }
+
+    void rechunker_binding::do_apply_node_config( rechunker* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring rechunker with:\n" << a_config );
+        a_node->set_out_length( a_config.get_value( "out-length", a_node->get_out_length() ) );
+        a_node->set_output_size( a_config.get_value( "output-size", a_node->get_output_size() ) );
+        a_node->set_overlap( a_config.get_value( "overlap", a_node->get_overlap() ) );
+        return;
+    }
+
+    void rechunker_binding::do_dump_node_config( const rechunker* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping rechunker configuration" );
+        a_config.add( "out-length", scarab::param_value( a_node->get_out_length() ) );
+        a_config.add( "output-size", scarab::param_value( a_node->get_output_size() ) );
+        a_config.add( "overlap", scarab::param_value( a_node->get_overlap() ) );
+        return;
+    }
+
+} /* namespace fast_daq */
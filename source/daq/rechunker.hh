@@ -0,0 +1,98 @@
+/*
+ * rechunker.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_RECHUNKER_HH_
+#define FAST_DAQ_RECHUNKER_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "real_time_data.hh"
+#include "sample_ring.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class rechunker
+     @brief A transformer that regroups real time data into chunks of a different, optionally overlapping, size.
+
+     @details
+     Incoming buffers are accumulated in a sample ring, and a chunk of output-size samples is emitted every
+     output-size - overlap samples.  This decouples the digitizer's DMA buffer size (chosen for transfer efficiency)
+     from the frame size of downstream nodes (chosen for resolution).  Samples that don't complete a chunk are kept
+     for the next input buffer; the ring is cleared at the start of each run.
+
+     The output chunk counter counts output chunks since the start of the run; the dynamic range is copied from the input.
+     Chunks never straddle a break in the input sequence (see sequence_tracker): samples held when the break arrives are
+     discarded and counted as lost on the next output chunk.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "rechunker"
+
+     Available configuration values:
+     - "out-length": uint -- number of output buffers (default: 10)
+     - "output-size": uint -- number of samples in each output chunk (default: 4096)
+     - "overlap": uint -- number of samples shared by consecutive output chunks; must be less than output-size (default: 0)
+
+     Input Stream:
+     - 0: real_time_data
+
+     Output Streams:
+     - 0: real_time_data
+    */
+    class rechunker : public midge::_transformer< midge::type_list< real_time_data >, midge::type_list< real_time_data > >, public thread_tuning
+    {
+        public:
+            rechunker();
+            virtual ~rechunker();
+
+        mv_accessible( uint64_t, out_length );
+        mv_accessible( unsigned, output_size );
+        mv_accessible( unsigned, overlap );
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            bool process_chunk( const real_time_data* a_time_data );
+
+            sample_ring< U16 > f_ring;
+            uint64_t f_ring_first_index; // sample index of the oldest sample in the ring
+            sequence_tracker f_sequence;
+            uint64_t f_output_counter;
+    };
+
+
+    class rechunker_binding : public _tuned_node_binding< rechunker, rechunker_binding >
+    {
+        public:
+            rechunker_binding();
+            virtual ~rechunker_binding();
+
+        private:
+            virtual void do_apply_node_config( rechunker* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const rechunker* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_RECHUNKER_HH_ */
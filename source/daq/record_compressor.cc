@@ -0,0 +1,433 @@
+/*
+ * record_compressor.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "record_compressor.hh"
+
+#include "fast_daq_error.hh"
+#include "run_metrics.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#ifdef LZ4_FOUND
+#include <lz4.h>
+#endif
+
+#ifdef ZSTD_FOUND
+#include <zstd.h>
+#endif
+
+namespace fast_daq
+{
+    LOGGER( plog, "record_compressor" );
+
+    static_assert( sizeof( record_compressor::frame_header ) == 32, "Compressed frame header must be 32 bytes" );
+
+    record_compressor::codec_t record_compressor::codec_from_string( const std::string& a_codec )
+    {
+        if( a_codec == "none" ) return codec_t::none;
+        if( a_codec == "lz4" ) return codec_t::lz4;
+        if( a_codec == "zstd" ) return codec_t::zstd;
+        throw error() << "Unknown compression codec: <" << a_codec << ">; options are none, lz4 and zstd";
+    }
+
+    std::string record_compressor::codec_to_string( codec_t a_codec )
+    {
+        switch( a_codec )
+        {
+            case codec_t::lz4: return "lz4";
+            case codec_t::zstd: return "zstd";
+            default: return "none";
+        }
+    }
+
+    bool record_compressor::codec_is_available( codec_t a_codec )
+    {
+        switch( a_codec )
+        {
+            case codec_t::none: return true;
+#ifdef LZ4_FOUND
+            case codec_t::lz4: return true;
+#endif
+#ifdef ZSTD_FOUND
+            case codec_t::zstd: return true;
+#endif
+            default: return false;
+        }
+    }
+
+    record_compressor::record_compressor() :
+            f_codec( codec_t::none ),
+            f_level( 1 ),
+            f_shuffle( true ),
+            f_element_size( 1 ),
+            f_n_workers( 2 ),
+            f_max_pending( 64 ),
+            f_metrics_name( "compressor" ),
+            f_workers(),
+            f_work_queue(),
+            f_pending(),
+            f_spare_jobs(),
+            f_mutex(),
+            f_work_cv(),
+            f_done_cv(),
+            f_stopping( false ),
+            f_pack_buffer(),
+            f_pack_fill( 0 ),
+            f_pack_record_id( 0 ),
+            f_pack_record_time( 0 ),
+            f_pack_is_new_acq( true ),
+            f_raw_bytes( 0 ),
+            f_compressed_bytes( 0 ),
+            f_worker_ns( 0 )
+    {
+    }
+
+    record_compressor::~record_compressor()
+    {
+        stop();
+    }
+
+    void record_compressor::configure( const scarab::param_node& a_config )
+    {
+        codec_t t_codec = codec_from_string( a_config.get_value( "codec", codec_to_string( f_codec ) ) );
+        if( ! codec_is_available( t_codec ) )
+        {
+            throw error() << "Compression codec <" << codec_to_string( t_codec ) << "> was requested, but fast_daq was built without it";
+        }
+        f_codec = t_codec;
+        f_level = a_config.get_value( "level", f_level );
+        f_shuffle = a_config.get_value( "shuffle", f_shuffle );
+        f_n_workers = a_config.get_value( "n-workers", f_n_workers );
+        f_max_pending = a_config.get_value( "max-pending", f_max_pending );
+        if( f_n_workers == 0 ) throw error() << "Compression requires at least one worker thread";
+        if( f_max_pending == 0 ) throw error() << "Compression max-pending must be at least 1";
+        return;
+    }
+
+    void record_compressor::dump_config( scarab::param_node& a_config ) const
+    {
+        a_config.add( "codec", codec_to_string( f_codec ) );
+        a_config.add( "level", f_level );
+        a_config.add( "shuffle", f_shuffle );
+        a_config.add( "n-workers", f_n_workers );
+        a_config.add( "max-pending", f_max_pending );
+        return;
+    }
+
+    std::string record_compressor::describe() const
+    {
+        std::stringstream t_desc;
+        t_desc << "compressed: " << codec_to_string( f_codec ) << " level " << f_level;
+        if( f_shuffle ) t_desc << ", shuffle " << f_element_size;
+        return t_desc.str();
+    }
+
+    void record_compressor::start( uint64_t a_raw_record_n_bytes )
+    {
+        stop();
+
+        f_pack_buffer.assign( packed_record_n_bytes( a_raw_record_n_bytes ), 0 );
+        f_pack_fill = 0;
+        f_pack_record_id = 0;
+        f_pack_record_time = 0;
+        f_pack_is_new_acq = true;
+        f_raw_bytes = 0;
+        f_compressed_bytes = 0;
+        f_worker_ns = 0;
+
+        f_stopping = false;
+        for( unsigned i_worker = 0; i_worker < f_n_workers; ++i_worker )
+        {
+            f_workers.emplace_back( &record_compressor::execute_worker, this );
+        }
+        LDEBUG( plog, "Started " << f_n_workers << " compression worker(s); " << describe() );
+        return;
+    }
+
+    void record_compressor::submit( uint64_t a_rec_id, uint64_t a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq )
+    {
+        if( sizeof( frame_header ) + a_bytes > f_pack_buffer.size() )
+        {
+            throw error() << "Record of " << a_bytes << " bytes is larger than the compressor was started for (" << f_pack_buffer.size() - sizeof( frame_header ) << " bytes)";
+        }
+
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        job_ptr t_job;
+        if( f_spare_jobs.empty() )
+        {
+            t_job = std::make_shared< job >();
+        }
+        else
+        {
+            t_job = f_spare_jobs.back();
+            f_spare_jobs.pop_back();
+        }
+        t_lock.unlock();
+
+        // copy outside the lock; the input buffer is released back to the stream as soon as the writer moves on
+        t_job->f_rec_id = a_rec_id;
+        t_job->f_rec_time = a_rec_time;
+        t_job->f_is_new_acq = a_is_new_acq;
+        t_job->f_raw.resize( a_bytes );
+        ::memcpy( t_job->f_raw.data(), a_rec_block, a_bytes );
+        t_job->f_done = false;
+
+        t_lock.lock();
+        f_pending.push_back( t_job );
+        f_work_queue.push_back( t_job );
+        t_lock.unlock();
+        f_work_cv.notify_one();
+        return;
+    }
+
+    bool record_compressor::write_ready( stream_wrap_ptr a_swrap_ptr )
+    {
+        return drain( a_swrap_ptr, false );
+    }
+
+    bool record_compressor::finish( stream_wrap_ptr a_swrap_ptr )
+    {
+        bool t_return = drain( a_swrap_ptr, true );
+        if( t_return && f_pack_fill > 0 ) t_return = write_pack_buffer( a_swrap_ptr );
+        LINFO( plog, "Compressed " << 1.e-6 * (double)get_raw_bytes() << " MB to " << 1.e-6 * (double)get_compressed_bytes() << " MB (ratio " <<
+                get_compression_ratio() << ") at " << get_throughput_mb_s() << " MB/s per worker" );
+        publish_metrics();
+        stop();
+        return t_return;
+    }
+
+    void record_compressor::stop()
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_stopping = true;
+        t_lock.unlock();
+        f_work_cv.notify_all();
+        for( std::thread& t_worker : f_workers )
+        {
+            if( t_worker.joinable() ) t_worker.join();
+        }
+        f_workers.clear();
+
+        t_lock.lock();
+        f_work_queue.clear();
+        for( job_ptr& t_job : f_pending )
+        {
+            f_spare_jobs.push_back( t_job );
+        }
+        f_pending.clear();
+        f_pack_fill = 0;
+        return;
+    }
+
+    double record_compressor::get_compression_ratio() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_compressed_bytes == 0 ? 0. : (double)f_raw_bytes / (double)f_compressed_bytes;
+    }
+
+    double record_compressor::get_throughput_mb_s() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_worker_ns == 0 ? 0. : 1.e3 * (double)f_raw_bytes / (double)f_worker_ns;
+    }
+
+    void record_compressor::publish_metrics() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        double t_ratio = f_compressed_bytes == 0 ? 0. : (double)f_raw_bytes / (double)f_compressed_bytes;
+        double t_throughput = f_worker_ns == 0 ? 0. : 1.e3 * (double)f_raw_bytes / (double)f_worker_ns;
+        t_lock.unlock();
+
+        run_metrics* t_metrics = run_metrics::get_instance();
+        t_metrics->set( f_metrics_name + ".compression-ratio", t_ratio );
+        t_metrics->set( f_metrics_name + ".compress-mb-s", t_throughput );
+        return;
+    }
+
+    uint64_t record_compressor::get_raw_bytes() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_raw_bytes;
+    }
+
+    uint64_t record_compressor::get_compressed_bytes() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_compressed_bytes;
+    }
+
+    void record_compressor::execute_worker()
+    {
+        void* t_codec_context = nullptr;
+#ifdef ZSTD_FOUND
+        if( f_codec == codec_t::zstd ) t_codec_context = ZSTD_createCCtx();
+#endif
+        std::vector< uint8_t > t_scratch;
+
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        while( true )
+        {
+            f_work_cv.wait( t_lock, [this](){ return f_stopping || ! f_work_queue.empty(); } );
+            if( f_stopping ) break;
+
+            job_ptr t_job = f_work_queue.front();
+            f_work_queue.pop_front();
+            t_lock.unlock();
+
+            std::chrono::steady_clock::time_point t_start = std::chrono::steady_clock::now();
+            compress( *t_job, t_scratch, t_codec_context );
+            uint64_t t_ns = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - t_start ).count();
+
+            t_lock.lock();
+            t_job->f_done = true;
+            f_raw_bytes += t_job->f_raw.size();
+            f_compressed_bytes += t_job->f_frame.size();
+            f_worker_ns += t_ns;
+            f_done_cv.notify_all();
+        }
+        t_lock.unlock();
+
+#ifdef ZSTD_FOUND
+        if( t_codec_context != nullptr ) ZSTD_freeCCtx( static_cast< ZSTD_CCtx* >( t_codec_context ) );
+#endif
+        return;
+    }
+
+    void record_compressor::compress( job& a_job, std::vector< uint8_t >& a_scratch, void* a_codec_context ) const
+    {
+        const uint64_t t_raw_n_bytes = a_job.f_raw.size();
+        const uint8_t* t_input = a_job.f_raw.data();
+
+        frame_header t_header;
+        t_header.f_magic = s_frame_magic;
+        t_header.f_codec = static_cast< uint8_t >( f_codec );
+        t_header.f_shuffle_element_size = 0;
+        t_header.f_reserved = 0;
+        t_header.f_record_id = a_job.f_rec_id;
+        t_header.f_record_time = a_job.f_rec_time;
+        t_header.f_raw_n_bytes = t_raw_n_bytes;
+
+        if( f_shuffle && f_element_size > 1 )
+        {
+            // byte-shuffle: byte j of element i goes to position j * n_elements + i; any trailing partial element is copied as-is
+            const uint64_t t_n_elements = t_raw_n_bytes / f_element_size;
+            a_scratch.resize( t_raw_n_bytes );
+            for( unsigned i_byte = 0; i_byte < f_element_size; ++i_byte )
+            {
+                uint8_t* t_out = a_scratch.data() + i_byte * t_n_elements;
+                const uint8_t* t_in = t_input + i_byte;
+                for( uint64_t i_elem = 0; i_elem < t_n_elements; ++i_elem )
+                {
+                    t_out[ i_elem ] = t_in[ i_elem * f_element_size ];
+                }
+            }
+            ::memcpy( a_scratch.data() + t_n_elements * f_element_size, t_input + t_n_elements * f_element_size, t_raw_n_bytes - t_n_elements * f_element_size );
+            t_input = a_scratch.data();
+            t_header.f_shuffle_element_size = f_element_size;
+        }
+
+        uint64_t t_bound = t_raw_n_bytes;
+#ifdef LZ4_FOUND
+        if( f_codec == codec_t::lz4 ) t_bound = LZ4_compressBound( t_raw_n_bytes );
+#endif
+#ifdef ZSTD_FOUND
+        if( f_codec == codec_t::zstd ) t_bound = ZSTD_compressBound( t_raw_n_bytes );
+#endif
+        a_job.f_frame.resize( sizeof( frame_header ) + t_bound );
+        uint8_t* t_payload = a_job.f_frame.data() + sizeof( frame_header );
+
+        uint64_t t_payload_n_bytes = 0;
+#ifdef LZ4_FOUND
+        if( f_codec == codec_t::lz4 )
+        {
+            int t_result = LZ4_compress_fast( reinterpret_cast< const char* >( t_input ), reinterpret_cast< char* >( t_payload ), t_raw_n_bytes, t_bound, f_level < 1 ? 1 : f_level );
+            if( t_result > 0 ) t_payload_n_bytes = t_result;
+        }
+#endif
+#ifdef ZSTD_FOUND
+        if( f_codec == codec_t::zstd )
+        {
+            size_t t_result = ZSTD_compressCCtx( static_cast< ZSTD_CCtx* >( a_codec_context ), t_payload, t_bound, t_input, t_raw_n_bytes, f_level );
+            if( ! ZSTD_isError( t_result ) ) t_payload_n_bytes = t_result;
+        }
+#endif
+
+        if( t_payload_n_bytes == 0 || t_payload_n_bytes >= t_raw_n_bytes )
+        {
+            // incompressible (or the codec failed): store the original record
+            t_header.f_codec = static_cast< uint8_t >( codec_t::none );
+            t_header.f_shuffle_element_size = 0;
+            ::memcpy( t_payload, a_job.f_raw.data(), t_raw_n_bytes );
+            t_payload_n_bytes = t_raw_n_bytes;
+        }
+
+        t_header.f_payload_n_bytes = t_payload_n_bytes;
+        ::memcpy( a_job.f_frame.data(), &t_header, sizeof( frame_header ) );
+        a_job.f_frame.resize( sizeof( frame_header ) + t_payload_n_bytes );
+        return;
+    }
+
+    bool record_compressor::drain( stream_wrap_ptr a_swrap_ptr, bool a_wait_all )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        while( ! f_pending.empty() )
+        {
+            job_ptr t_job = f_pending.front();
+            if( ! t_job->f_done )
+            {
+                // only hold up the writer if the backlog has reached its limit
+                if( ! a_wait_all && f_pending.size() < f_max_pending ) break;
+                f_done_cv.wait( t_lock, [&t_job](){ return t_job->f_done; } );
+            }
+            f_pending.pop_front();
+            t_lock.unlock();
+
+            if( ! pack_frame( *t_job, a_swrap_ptr ) ) return false;
+
+            t_lock.lock();
+            f_spare_jobs.push_back( t_job );
+        }
+        return true;
+    }
+
+    bool record_compressor::pack_frame( const job& a_job, stream_wrap_ptr a_swrap_ptr )
+    {
+        // a frame never spans two egg records; a new acquisition also starts a new egg record
+        if( f_pack_fill > 0 && ( a_job.f_is_new_acq || f_pack_fill + a_job.f_frame.size() > f_pack_buffer.size() ) )
+        {
+            if( ! write_pack_buffer( a_swrap_ptr ) ) return false;
+        }
+        if( f_pack_fill == 0 )
+        {
+            // each egg record carries the record ID and time of its first frame
+            f_pack_record_id = a_job.f_rec_id;
+            f_pack_record_time = a_job.f_rec_time;
+            f_pack_is_new_acq = f_pack_is_new_acq || a_job.f_is_new_acq;
+        }
+        ::memcpy( f_pack_buffer.data() + f_pack_fill, a_job.f_frame.data(), a_job.f_frame.size() );
+        f_pack_fill += a_job.f_frame.size();
+        return true;
+    }
+
+    bool record_compressor::write_pack_buffer( stream_wrap_ptr a_swrap_ptr )
+    {
+        // zero-fill the tail; a zero magic number tells the reader that there are no more frames in this record
+        ::memset( f_pack_buffer.data() + f_pack_fill, 0, f_pack_buffer.size() - f_pack_fill );
+        bool t_return = a_swrap_ptr->write_record( f_pack_record_id, f_pack_record_time, f_pack_buffer.data(), f_pack_buffer.size(), f_pack_is_new_acq );
+        if( ! t_return ) LERROR( plog, "Unable to write compressed record <" << f_pack_record_id << ">" );
+        f_pack_fill = 0;
+        f_pack_is_new_acq = false;
+        publish_metrics();
+        return t_return;
+    }
+
+} /* namespace fast_daq */
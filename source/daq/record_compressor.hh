@@ -0,0 +1,197 @@
+/*
+ * record_compressor.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_RECORD_COMPRESSOR_HH_
+#define FAST_DAQ_RECORD_COMPRESSOR_HH_
+
+#include "monarch3_wrap.hh"
+
+#include "member_variables.hh"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+
+    /*!
+     @class record_compressor
+
+     @brief Optional lossless compression of egg records for the streaming writers.
+
+     @details
+     Records submitted by a writer are copied and compressed on a small pool of worker threads, so that the
+     codec doesn't run on the writer's thread.  Compressed frames are collected in submission order and packed
+     back-to-back into fixed-size egg records of packed_record_n_bytes(), which is large enough for one frame
+     of an incompressible record.  A frame never spans two egg records, so every egg record can be decoded on
+     its own, and a switch to a continuation file (which can happen between any two egg records) never splits
+     a frame.  Each egg record carries the record ID and time of its first frame.  A record submitted as the
+     start of a new acquisition closes the current egg record and starts a new egg acquisition.
+
+     Each frame starts with a frame_header (32 bytes, little-endian) giving the original record ID and time,
+     the codec, the byte-shuffle element size, and the raw and compressed payload sizes.
+     A frame whose payload doesn't shrink is stored uncompressed (codec "none" in its header).
+     The unused tail of each egg record is zero-filled; a zero magic number marks the end of its frames.
+
+     Since the egg records no longer hold samples, writers declare a compressed stream as unsigned bytes
+     (data-type size 1, 8 bits) with a record size of packed_record_n_bytes(), and give the codec and the
+     original record format (describe()) in the stream's source; the channel calibration applies to the
+     decompressed samples.
+
+     Byte shuffling groups the n-th byte of every sample together before compression, which exposes the
+     slowly-varying high bytes of digitized samples to the codec.
+
+     Each time an egg record is written, and when the compressor finishes, the compression ratio and the throughput
+     are published to run_metrics as "<metrics-name>.compression-ratio" and "<metrics-name>.compress-mb-s"; the writer
+     sets the metrics name to its node name.
+
+     Thread synchronization strategy:
+       - submit(), write_ready() and finish() must be called from the owning writer's thread.
+       - The worker threads only touch the jobs they take from the work queue and the metrics, both guarded by an internal mutex.
+       - write_ready() only blocks when more than max-pending records are waiting for compression.
+
+     Available configuration values (in the writer's "compression" block):
+     - "codec": string -- "none", "lz4" or "zstd"; codecs are only available if fast_daq was built with them (default: "none")
+     - "level": int -- compression level for zstd, or acceleration factor for lz4 (default: 1)
+     - "shuffle": bool -- byte-shuffle each record before compression (default: true)
+     - "n-workers": uint -- number of compression threads (default: 2)
+     - "max-pending": uint -- maximum number of records waiting for compression before the writer is held up (default: 64)
+    */
+    class record_compressor
+    {
+        public:
+            enum class codec_t : uint8_t
+            {
+                none = 0,
+                lz4 = 1,
+                zstd = 2
+            };
+            static codec_t codec_from_string( const std::string& a_codec );
+            static std::string codec_to_string( codec_t a_codec );
+            static bool codec_is_available( codec_t a_codec );
+
+            struct frame_header
+            {
+                uint32_t f_magic;
+                uint8_t f_codec;
+                uint8_t f_shuffle_element_size; // 0 if not shuffled
+                uint16_t f_reserved;
+                uint64_t f_record_id;
+                uint64_t f_record_time;
+                uint32_t f_raw_n_bytes;
+                uint32_t f_payload_n_bytes;
+            };
+            static const uint32_t s_frame_magic = 0x43514446; // "FDQC"
+
+        public:
+            record_compressor();
+            ~record_compressor();
+
+            record_compressor( const record_compressor& ) = delete;
+            record_compressor& operator=( const record_compressor& ) = delete;
+
+        public:
+            mv_accessible( codec_t, codec );
+            mv_accessible( int, level );
+            mv_accessible( bool, shuffle );
+            mv_accessible( unsigned, element_size ); // bytes per shuffled element; set by the writer
+            mv_accessible( unsigned, n_workers );
+            mv_accessible( unsigned, max_pending );
+            mv_accessible( std::string, metrics_name ); // prefix of the published metrics; set by the writer
+
+        public:
+            void configure( const scarab::param_node& a_config );
+            void dump_config( scarab::param_node& a_config ) const;
+
+            bool is_enabled() const;
+
+            /// Description of the compression settings, for the egg stream source
+            std::string describe() const;
+
+            /// Size of the egg records into which frames of a_raw_record_n_bytes records are packed
+            static uint64_t packed_record_n_bytes( uint64_t a_raw_record_n_bytes );
+
+            /// Start the worker pool; records of a_raw_record_n_bytes will be packed into egg records of packed_record_n_bytes()
+            void start( uint64_t a_raw_record_n_bytes );
+            /// Queue a copy of a record for compression; a_is_new_acq closes the current egg record and starts a new egg acquisition
+            void submit( uint64_t a_rec_id, uint64_t a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq );
+            /// Write all egg records that can be filled with the frames compressed so far, in order
+            bool write_ready( stream_wrap_ptr a_swrap_ptr );
+            /// Wait for all queued records, write them and the final partial egg record, and stop the worker pool
+            bool finish( stream_wrap_ptr a_swrap_ptr );
+            /// Stop the worker pool and discard anything not yet written
+            void stop();
+
+            /// Raw bytes divided by compressed bytes (including frame headers) since the last start()
+            double get_compression_ratio() const;
+            /// Raw MB compressed per second of worker time since the last start()
+            double get_throughput_mb_s() const;
+            uint64_t get_raw_bytes() const;
+            uint64_t get_compressed_bytes() const;
+
+        private:
+            struct job
+            {
+                uint64_t f_rec_id;
+                uint64_t f_rec_time;
+                bool f_is_new_acq;
+                std::vector< uint8_t > f_raw;
+                std::vector< uint8_t > f_frame;
+                bool f_done;
+            };
+            typedef std::shared_ptr< job > job_ptr;
+
+            void execute_worker();
+            void compress( job& a_job, std::vector< uint8_t >& a_scratch, void* a_codec_context ) const;
+            bool pack_frame( const job& a_job, stream_wrap_ptr a_swrap_ptr );
+            bool write_pack_buffer( stream_wrap_ptr a_swrap_ptr );
+            bool drain( stream_wrap_ptr a_swrap_ptr, bool a_wait_all );
+            void publish_metrics() const;
+
+            std::vector< std::thread > f_workers;
+            std::deque< job_ptr > f_work_queue;
+            std::deque< job_ptr > f_pending; // in submission order
+            std::vector< job_ptr > f_spare_jobs;
+            mutable std::mutex f_mutex;
+            std::condition_variable f_work_cv;
+            std::condition_variable f_done_cv;
+            bool f_stopping;
+
+            std::vector< uint8_t > f_pack_buffer;
+            uint64_t f_pack_fill;
+            uint64_t f_pack_record_id;
+            uint64_t f_pack_record_time;
+            bool f_pack_is_new_acq;
+
+            uint64_t f_raw_bytes;
+            uint64_t f_compressed_bytes;
+            uint64_t f_worker_ns;
+    };
+
+    inline bool record_compressor::is_enabled() const
+    {
+        return f_codec != codec_t::none;
+    }
+
+    inline uint64_t record_compressor::packed_record_n_bytes( uint64_t a_raw_record_n_bytes )
+    {
+        return a_raw_record_n_bytes + sizeof( frame_header );
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_RECORD_COMPRESSOR_HH_ */
@@ -0,0 +1,349 @@
+/*
+ * rfi_excision.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "rfi_excision.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( rfi_excision, "rfi-excision", rfi_excision_binding );
+
+    LOGGER( flog, "rfi_excision" );
+
+    namespace
+    {
+        const float s_inv_ln2 = 1. / M_LN2;
+    }
+
+    // supporting enum helpers
+    std::string rfi_excision::replacement_to_string( replacement_t a_replacement )
+    {
+        switch( a_replacement )
+        {
+            case replacement_t::median: return "median";
+            case replacement_t::zero: return "zero";
+            default: throw fast_daq::error() << "replacement value <" << static_cast< unsigned >( a_replacement ) << "> not recognized";
+        }
+    }
+    rfi_excision::replacement_t rfi_excision::string_to_replacement( const std::string& a_replacement )
+    {
+        if( a_replacement == replacement_to_string( replacement_t::median ) ) return replacement_t::median;
+        if( a_replacement == replacement_to_string( replacement_t::zero ) ) return replacement_t::zero;
+        throw fast_daq::error() << "string <" << a_replacement << "> not recognized as valid replacement";
+    }
+
+    rfi_excision::rfi_excision() :
+            f_freq_length( 10 ),
+            f_spectrum_size( 4096 ),
+            f_time_constant( 100. ),
+            f_warm_up( 1000 ),
+            f_false_flag_rate( 1.e-6 ),
+            f_sk_length( 64 ),
+            f_sk_threshold( 5. ),
+            f_sk_upper_threshold( 13. ),
+            f_replacement( replacement_t::median ),
+            f_n_flagged_total( 0 ),
+            f_power(),
+            f_median(),
+            f_mad(),
+            f_sum_power(),
+            f_sum_power_sq(),
+            f_sk_mask(),
+            f_scale(),
+            f_n_spectra( 0 ),
+            f_sk_fill( 0 )
+    {
+    }
+
+    rfi_excision::~rfi_excision()
+    {
+    }
+
+    void rfi_excision::initialize()
+    {
+        if ( f_spectrum_size == 0 ) throw fast_daq::error() << "rfi-excision requires a non-zero spectrum-size";
+        if ( f_time_constant < 1. ) throw fast_daq::error() << "rfi-excision time-constant must be at least 1";
+        if ( f_false_flag_rate <= 0. || f_false_flag_rate >= 1. ) throw fast_daq::error() << "rfi-excision false-flag-rate must be in (0, 1)";
+        if ( f_sk_length == 1 ) throw fast_daq::error() << "rfi-excision sk-length must be 0 (disabled) or at least 2";
+        if ( (double)f_warm_up < 10. * f_time_constant )
+        {
+            LWARN( flog, "rfi-excision warm-up (" << f_warm_up << " spectra) is less than ten time-constants (" << 10. * f_time_constant << "); noise will be flagged while the running median settles" );
+        }
+
+        out_buffer< 0 >().initialize( f_freq_length );
+        out_buffer< 0 >().call( &frequency_data::allocate_array, f_spectrum_size );
+
+        f_power.resize( f_spectrum_size );
+        f_median.resize( f_spectrum_size );
+        f_mad.resize( f_spectrum_size );
+        f_sum_power.resize( f_spectrum_size );
+        f_sum_power_sq.resize( f_spectrum_size );
+        f_sk_mask.resize( f_spectrum_size );
+        f_scale.resize( f_spectrum_size );
+
+        LINFO( flog, "flagging bins above " << -log( f_false_flag_rate ) << " times their mean noise power (false-flag rate " << f_false_flag_rate << ")" <<
+                ( f_sk_length > 0 ? " or with non-Gaussian spectral kurtosis" : "" ) <<
+                "; flagged bins are replaced by " << replacement_to_string( f_replacement ) );
+        return;
+    }
+
+    void rfi_excision::reset_state()
+    {
+        std::fill( f_sum_power.begin(), f_sum_power.end(), 0. );
+        std::fill( f_sum_power_sq.begin(), f_sum_power_sq.end(), 0. );
+        std::fill( f_sk_mask.begin(), f_sk_mask.end(), 0 );
+        f_n_spectra = 0;
+        f_sk_fill = 0;
+        f_n_flagged_total = 0;
+        return;
+    }
+
+    void rfi_excision::update_sk_mask()
+    {
+        const float t_m = f_sk_length;
+        const float t_prefactor = ( t_m + 1.f ) / ( t_m - 1.f );
+        const float t_sigma = 2. / sqrt( (double)f_sk_length );
+        const float t_lower = 1. - f_sk_threshold * t_sigma;
+        const float t_upper = 1. + f_sk_upper_threshold * t_sigma;
+        const unsigned t_size = f_spectrum_size;
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            const float t_s1 = f_sum_power[i_bin];
+            const float t_sk = t_s1 > 0.f ? t_prefactor * ( t_m * f_sum_power_sq[i_bin] / ( t_s1 * t_s1 ) - 1.f ) : 1.f;
+            f_sk_mask[i_bin] = ( t_sk < t_lower ) | ( t_sk > t_upper );
+            f_sum_power[i_bin] = 0.f;
+            f_sum_power_sq[i_bin] = 0.f;
+        }
+        f_sk_fill = 0;
+        return;
+    }
+
+    bool rfi_excision::process_spectrum( const frequency_data* a_freq_data )
+    {
+        a_freq_data->require_full_precision( get_name() );
+        if ( a_freq_data->get_array_size() != f_spectrum_size )
+        {
+            throw fast_daq::error() << "rfi-excision received a spectrum of " << a_freq_data->get_array_size() << " bins; spectrum-size is " << f_spectrum_size;
+        }
+
+        const unsigned t_size = f_spectrum_size;
+        float* t_power = f_power.data();
+        a_freq_data->fill_power( t_power );
+
+        if ( f_n_spectra == 0 )
+        {
+            // seed the running statistics with the first spectrum
+            std::copy( f_power.begin(), f_power.end(), f_median.begin() );
+            std::copy( f_power.begin(), f_power.end(), f_mad.begin() );
+        }
+
+        frequency_data* t_out = out_stream< 0 >().data();
+        uint8_t* t_flags = t_out->get_flag_array();
+
+        const uint8_t t_armed = f_n_spectra >= f_warm_up;
+        const uint8_t t_use_sk = f_sk_length > 0;
+        const bool t_replace_with_median = f_replacement == replacement_t::median;
+        const float t_step = 1. / f_time_constant;
+        // exponentially-distributed noise power exceeds k times its mean (median / ln 2) with probability exp(-k)
+        const float t_limit = -log( f_false_flag_rate ) * s_inv_ln2;
+        float* t_median = f_median.data();
+        float* t_mad = f_mad.data();
+        float* t_s1 = f_sum_power.data();
+        float* t_s2 = f_sum_power_sq.data();
+        const uint8_t* t_sk_mask = f_sk_mask.data();
+        float* t_bin_scale = f_scale.data();
+        unsigned t_n_flagged = 0;
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            const float t_p = t_power[i_bin];
+            const float t_m = t_median[i_bin];
+            const float t_d = t_mad[i_bin];
+            const float t_dev = t_p - t_m;
+
+            const uint8_t t_flag = t_armed & ( ( t_p > t_limit * t_m ) | ( t_use_sk & t_sk_mask[i_bin] ) );
+            t_flags[i_bin] = t_flag;
+            t_n_flagged += t_flag;
+
+            // streaming median and MAD: step towards the sample by a fraction of the current spread
+            const float t_spread = t_d > 0.f ? t_d : t_m;
+            t_median[i_bin] = t_m + t_step * t_spread * (float)( ( t_dev > 0.f ) - ( t_dev < 0.f ) );
+            t_mad[i_bin] = t_d + t_step * t_spread * ( fabs( t_dev ) > t_d ? 1.f : -1.f );
+
+            t_s1[i_bin] += t_p;
+            t_s2[i_bin] += t_p * t_p;
+
+            // the mean of exponentially-distributed noise power is its median / ln 2; never scale a bin up
+            const float t_keep_scale = t_replace_with_median && t_p > 0.f ? sqrt( std::min( t_m * s_inv_ln2 / t_p, 1.f ) ) : 0.f;
+            t_bin_scale[i_bin] = t_flag ? t_keep_scale : 1.f;
+        }
+
+        t_out->set_layout( a_freq_data->get_layout() );
+        if ( a_freq_data->get_layout() == frequency_data::layout_t::split )
+        {
+            const float* t_in_real = a_freq_data->get_real_array();
+            const float* t_in_imag = a_freq_data->get_imag_array();
+            float* t_out_real = t_out->get_real_array();
+            float* t_out_imag = t_out->get_imag_array();
+            for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+            {
+                t_out_real[i_bin] = t_in_real[i_bin] * t_bin_scale[i_bin];
+                t_out_imag[i_bin] = t_in_imag[i_bin] * t_bin_scale[i_bin];
+            }
+        }
+        else
+        {
+            const frequency_data::complex_t* t_in = a_freq_data->get_data_array();
+            frequency_data::complex_t* t_out_array = t_out->get_data_array();
+            for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+            {
+                t_out_array[i_bin][0] = t_in[i_bin][0] * t_bin_scale[i_bin];
+                t_out_array[i_bin][1] = t_in[i_bin][1] * t_bin_scale[i_bin];
+            }
+        }
+        ++f_n_spectra;
+        if ( t_use_sk && ++f_sk_fill == f_sk_length ) update_sk_mask();
+
+        f_n_flagged_total += t_n_flagged;
+        t_out->set_n_flagged( t_n_flagged );
+        t_out->set_fft_size( a_freq_data->get_fft_size() );
+        t_out->set_bin_width( a_freq_data->get_bin_width() );
+        t_out->set_minimum_frequency( a_freq_data->get_minimum_frequency() );
+        t_out->set_chunk_counter( a_freq_data->get_chunk_counter() );
+        t_out->copy_sequence( *a_freq_data );
+        // excision only scales bins down, so the input's int16 scale still covers the output
+        t_out->make_compact( a_freq_data->get_compact_format(), a_freq_data->get_compact_scale() );
+        if ( ! out_stream< 0 >().set( stream::s_run ) )
+        {
+            LERROR( flog, "rfi_excision error setting output stream to s_run" );
+            return false;
+        }
+        return true;
+    }
+
+    void rfi_excision::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the RFI excision" );
+
+            while (! is_canceled() )
+            {
+                midge::enum_t in_cmd = in_stream< 0 >().get();
+                unsigned in_stream_index = in_stream< 0 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                    LINFO( flog, "flagged " << f_n_flagged_total << " bins in " << f_n_spectra << " spectra" );
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    reset_state();
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_spectrum( in_stream< 0 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "RFI EXCISION is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void rfi_excision::finalize()
+    {
+        out_buffer< 0 >().finalize();
+        return;
+    }
+
+
+    // rfi_excision_binding methods
+    rfi_excision_binding::rfi_excision_binding() :
+            _tuned_node_binding< rfi_excision, rfi_excision_binding >()
+    {
+    }
+
+    rfi_excision_binding::~rfi_excision_binding()
+    {
+    }
+
+    void rfi_excision_binding::do_apply_node_config( rfi_excision* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring rfi_excision with:\n" << a_config );
+        a_node->set_freq_length( a_config.get_value( "freq-length", a_node->get_freq_length() ) );
+        a_node->set_spectrum_size( a_config.get_value( "spectrum-size", a_node->get_spectrum_size() ) );
+        a_node->set_time_constant( a_config.get_value( "time-constant", a_node->get_time_constant() ) );
+        a_node->set_warm_up( a_config.get_value( "warm-up", a_node->get_warm_up() ) );
+        a_node->set_false_flag_rate( a_config.get_value( "false-flag-rate", a_node->get_false_flag_rate() ) );
+        a_node->set_sk_length( a_config.get_value( "sk-length", a_node->get_sk_length() ) );
+        a_node->set_sk_threshold( a_config.get_value( "sk-threshold", a_node->get_sk_threshold() ) );
+        a_node->set_sk_upper_threshold( a_config.get_value( "sk-upper-threshold", a_node->get_sk_upper_threshold() ) );
+        a_node->set_replacement( rfi_excision::string_to_replacement( a_config.get_value( "replacement", rfi_excision::replacement_to_string( a_node->get_replacement() ) ) ) );
+        return;
+    }
+
+    void rfi_excision_binding::do_dump_node_config( const rfi_excision* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping rfi_excision configuration" );
+        a_config.add( "freq-length", scarab::param_value( a_node->get_freq_length() ) );
+        a_config.add( "spectrum-size", scarab::param_value( a_node->get_spectrum_size() ) );
+        a_config.add( "time-constant", scarab::param_value( a_node->get_time_constant() ) );
+        a_config.add( "warm-up", scarab::param_value( a_node->get_warm_up() ) );
+        a_config.add( "false-flag-rate", scarab::param_value( a_node->get_false_flag_rate() ) );
+        a_config.add( "sk-length", scarab::param_value( a_node->get_sk_length() ) );
+        a_config.add( "sk-threshold", scarab::param_value( a_node->get_sk_threshold() ) );
+        a_config.add( "sk-upper-threshold", scarab::param_value( a_node->get_sk_upper_threshold() ) );
+        a_config.add( "replacement", scarab::param_value( rfi_excision::replacement_to_string( a_node->get_replacement() ) ) );
+        return;
+    }
+
+} /* namespace fast_daq */
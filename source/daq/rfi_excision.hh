@@ -0,0 +1,155 @@
+/*
+ * rfi_excision.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_RFI_EXCISION_HH_
+#define FAST_DAQ_RFI_EXCISION_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "frequency_data.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class rfi_excision
+     @brief A transformer that flags and removes narrow-band interference from spectra before they are accumulated.
+
+     @details
+     Each bin's power is tracked over time with robust statistics:
+     - a running median, estimated with a streaming sign-step update whose step is proportional to a running median
+       absolute deviation (MAD) estimated the same way (a time constant of time-constant spectra);
+     - spectral kurtosis (SK), computed from the power sums S1 and S2 of each block of sk-length spectra:
+       SK = (M+1)/(M-1) * (M S2 / S1^2 - 1), which is 1 for Gaussian noise with a standard deviation of about 2/sqrt(M).
+
+     A bin is flagged in a spectrum when its power exceeds k times its mean noise power, or when the SK of the previous
+     block is below 1 by more than sk-threshold standard deviations or above 1 by more than sk-upper-threshold (persistent,
+     non-Gaussian interference: steady tones push SK towards 0, intermittent ones above 1).  Flagged bins are rescaled to
+     the bin's mean noise power (preserving phase) or zeroed, and marked in the output's flag array, so that a downstream
+     power-averager can report how often each bin was flagged.  No bins are flagged until the running statistics have
+     settled (warm-up spectra; the running median needs about ten time-constants from its one-spectrum seed).  All
+     statistics are reset at the start of each run.
+
+     The power of a bin of Gaussian noise in a single spectrum is exponentially distributed (chi-squared with 2 degrees of
+     freedom), not Gaussian: its median is ln 2 times its mean, and it exceeds k times its mean with probability exp(-k).
+     The mean noise power is therefore estimated as median / ln 2, and the cut is k = -ln(false-flag-rate), so that
+     false-flag-rate is the fraction of noise-only bins flagged in each spectrum.  The jitter of the running median raises
+     it slightly: simulated with pure noise and these update rules, the default 1e-6 flags 1.6e-6 of the bins after warm-up
+     at time-constant 100 and 1.1e-6 at 1000, and the replacements bias the averaged spectrum low by about 2e-5.
+     Replacing with the median itself would leave excised bins about 30% low in the averaged spectrum.  The replacement
+     never scales a bin up.
+
+     The noise distribution of SK is strongly skewed to high values, so the upper cut must be much wider than the lower.
+     Simulated with pure noise at sk-length 64, an upper cut of 13 standard deviations flags about 1e-6 of the blocks
+     (5 flags 1e-3), and no block fell below 1 by 3 standard deviations in 3e7; each flag excises the bin for a whole
+     block.  Longer blocks make SK closer to Gaussian (at sk-length 256, 9 standard deviations flag about 4e-7), so
+     retune sk-upper-threshold with sk-length.
+
+     The per-bin statistics are kept in separate arrays and updated in single branch-free passes over the bins.
+     Spectra are output in the layout in which they arrive (see frequency_data), and with a 16-bit copy in the input's format and
+     scale if the input has one (see compact_data).
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "rfi-excision"
+
+     Available configuration values:
+     - "freq-length": uint -- number of output buffers (default: 10)
+     - "spectrum-size": uint -- number of bins in each spectrum; must match the upstream node (default: 4096)
+     - "time-constant": double -- number of spectra over which the running median and MAD adapt (default: 100)
+     - "warm-up": uint -- number of spectra before any bins are flagged; should be at least ten time-constants (default: 1000)
+     - "false-flag-rate": double -- fraction of noise-only bins flagged by the power test in each spectrum; sets the cut at
+       -ln(false-flag-rate) times the mean noise power (default: 1e-6, i.e. 13.8 times)
+     - "sk-length": uint -- number of spectra in each spectral-kurtosis block; 0 disables the SK test (default: 64)
+     - "sk-threshold": double -- flag bins whose SK is this many standard deviations below 1 (default: 5)
+     - "sk-upper-threshold": double -- flag bins whose SK is this many standard deviations above 1 (default: 13)
+     - "replacement": string -- "median" (the mean noise power estimated from the running median) or "zero" (default: "median")
+
+     Input Stream:
+     - 0: frequency_data
+
+     Output Streams:
+     - 0: frequency_data
+    */
+    class rfi_excision : public midge::_transformer< midge::type_list< frequency_data >, midge::type_list< frequency_data > >, public thread_tuning
+    {
+        public:
+            enum class replacement_t
+            {
+                median,
+                zero
+            };
+            static std::string replacement_to_string( replacement_t a_replacement );
+            static replacement_t string_to_replacement( const std::string& a_replacement );
+
+        public:
+            rfi_excision();
+            virtual ~rfi_excision();
+
+        mv_accessible( uint64_t, freq_length );
+        mv_accessible( unsigned, spectrum_size );
+        mv_accessible( double, time_constant );
+        mv_accessible( unsigned, warm_up );
+        mv_accessible( double, false_flag_rate );
+        mv_accessible( unsigned, sk_length );
+        mv_accessible( double, sk_threshold );
+        mv_accessible( double, sk_upper_threshold );
+        mv_accessible( replacement_t, replacement );
+
+        mv_accessible_noset( uint64_t, n_flagged_total );
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            bool process_spectrum( const frequency_data* a_freq_data );
+            void reset_state();
+            void update_sk_mask();
+
+            // per-bin statistics
+            std::vector< float > f_power;
+            std::vector< float > f_median;
+            std::vector< float > f_mad;
+            std::vector< float > f_sum_power; // S1 of the current SK block
+            std::vector< float > f_sum_power_sq; // S2 of the current SK block
+            std::vector< uint8_t > f_sk_mask; // from the previous SK block
+            std::vector< float > f_scale; // applied to each bin of the current spectrum
+            unsigned f_n_spectra;
+            unsigned f_sk_fill;
+    };
+
+
+    class rfi_excision_binding : public _tuned_node_binding< rfi_excision, rfi_excision_binding >
+    {
+        public:
+            rfi_excision_binding();
+            virtual ~rfi_excision_binding();
+
+        private:
+            virtual void do_apply_node_config( rfi_excision* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const rfi_excision* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_RFI_EXCISION_HH_ */
@@ -0,0 +1,122 @@
+/*
+ * sample_ring.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_SAMPLE_RING_HH_
+#define FAST_DAQ_SAMPLE_RING_HH_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace fast_daq
+{
+    /*!
+     @class sample_ring
+     @brief FIFO of samples that is always readable as one contiguous block.
+
+     @details
+     Used to assemble fixed-size (and possibly overlapping) frames from input buffers of a different size:
+     append() each incoming buffer, then process data() and consume() the hop size while size() is at least a frame.
+
+     Consumed samples are only reclaimed when more space is needed, by moving the unconsumed samples to the front of
+     the storage, so each sample is copied at most once more than it is appended.  Storage grows to the largest
+     backlog that has been held and is not released until clear().
+
+     Not thread-safe; a ring belongs to the node that owns it.
+    */
+    template< typename T >
+    class sample_ring
+    {
+        public:
+            sample_ring();
+
+            /// Discard all samples and release the storage
+            void clear();
+            /// Append a_n_samples samples to the end of the ring
+            void append( const T* a_samples, uint64_t a_n_samples );
+            /// Add a_n_samples samples to the end of the ring and return a pointer to them, for the caller to fill in
+            T* extend( uint64_t a_n_samples );
+            /// Discard the oldest a_n_samples samples
+            void consume( uint64_t a_n_samples );
+
+            /// Number of samples held
+            uint64_t size() const;
+            /// Pointer to the oldest sample; the next size() samples are contiguous
+            const T* data() const;
+
+        private:
+            std::vector< T > f_storage;
+            uint64_t f_begin;
+            uint64_t f_end;
+    };
+
+    template< typename T >
+    sample_ring< T >::sample_ring() :
+            f_storage(),
+            f_begin( 0 ),
+            f_end( 0 )
+    {
+    }
+
+    template< typename T >
+    void sample_ring< T >::clear()
+    {
+        std::vector< T >().swap( f_storage );
+        f_begin = 0;
+        f_end = 0;
+        return;
+    }
+
+    template< typename T >
+    void sample_ring< T >::append( const T* a_samples, uint64_t a_n_samples )
+    {
+        std::copy( a_samples, a_samples + a_n_samples, extend( a_n_samples ) );
+        return;
+    }
+
+    template< typename T >
+    T* sample_ring< T >::extend( uint64_t a_n_samples )
+    {
+        if( f_end + a_n_samples > f_storage.size() )
+        {
+            // reclaim the consumed space first; only grow if that isn't enough
+            std::copy( f_storage.begin() + f_begin, f_storage.begin() + f_end, f_storage.begin() );
+            f_end -= f_begin;
+            f_begin = 0;
+            if( f_end + a_n_samples > f_storage.size() ) f_storage.resize( f_end + a_n_samples );
+        }
+        T* t_tail = f_storage.data() + f_end;
+        f_end += a_n_samples;
+        return t_tail;
+    }
+
+    template< typename T >
+    void sample_ring< T >::consume( uint64_t a_n_samples )
+    {
+        f_begin += std::min( a_n_samples, f_end - f_begin );
+        if( f_begin == f_end )
+        {
+            f_begin = 0;
+            f_end = 0;
+        }
+        return;
+    }
+
+    template< typename T >
+    inline uint64_t sample_ring< T >::size() const
+    {
+        return f_end - f_begin;
+    }
+
+    template< typename T >
+    inline const T* sample_ring< T >::data() const
+    {
+        return f_storage.data() + f_begin;
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_SAMPLE_RING_HH_ */
@@ -0,0 +1,258 @@
+/*
+ * spectral_trigger.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "spectral_trigger.hh"
+
+//scarab includes
+#include "logger.hh"
+#include "param.hh"
+
+//fast_daq includes
+#include "fast_daq_error.hh"
+#include "frequency_data.hh"
+#include "power_data.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( spectral_trigger, "spectral-trigger", spectral_trigger_binding );
+
+    LOGGER( flog, "spectral_trigger" );
+
+    // supporting enum helpers
+    std::string spectral_trigger::input_type_to_string( input_type_t an_input_type )
+    {
+        switch( an_input_type )
+        {
+            case input_type_t::frequency: return "frequency";
+            case input_type_t::power: return "power";
+            default: throw fast_daq::error() << "input_type value <" << static_cast< unsigned >( an_input_type ) << "> not recognized";
+        }
+    }
+    spectral_trigger::input_type_t spectral_trigger::string_to_input_type( const std::string& an_input_type )
+    {
+        if( an_input_type == input_type_to_string( input_type_t::frequency ) ) return input_type_t::frequency;
+        if( an_input_type == input_type_to_string( input_type_t::power ) ) return input_type_t::power;
+        throw fast_daq::error() << "string <" << an_input_type << "> not recognized as valid input_type";
+    }
+
+    /* spectral_trigger class */
+    /***************************/
+
+    spectral_trigger::spectral_trigger() :
+        f_input_type( input_type_t::frequency ),
+        f_trigger_channel( "spectral" ),
+        f_threshold( 10. ),
+        f_baseline_length( 100 ),
+        f_warm_up( -1 ),
+        f_holdoff( 0 ),
+        f_min_frequency( 0. ),
+        f_max_frequency( 0. ),
+        f_n_triggers( 0 ),
+        f_power(),
+        f_mean(),
+        f_n_spectra( 0 ),
+        f_holdoff_remaining( 0 ),
+        f_channel()
+    {
+    }
+
+    spectral_trigger::~spectral_trigger()
+    {
+    }
+
+    // node interface methods
+    void spectral_trigger::initialize()
+    {
+        if ( f_baseline_length == 0 ) throw fast_daq::error() << "baseline-length must be at least 1";
+        if ( f_threshold <= 1. ) throw fast_daq::error() << "threshold must be greater than 1";
+        f_channel = trigger_broker::get_instance()->get_channel( f_trigger_channel );
+        LINFO( flog, "firing trigger channel <" << f_trigger_channel << "> at " << f_threshold << " times the running mean" );
+    }
+
+    void spectral_trigger::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            while (! is_canceled() )
+            {
+                // check the slot status
+                midge::enum_t input_command = stream::s_none;
+                unsigned stream_index = 0;
+                if ( f_input_type == input_type_t::frequency )
+                {
+                    input_command = in_stream< 0 >().get();
+                    stream_index = in_stream< 0 >().get_current_index();
+                }
+                else
+                {
+                    input_command = in_stream< 1 >().get();
+                    stream_index = in_stream< 1 >().get_current_index();
+                }
+
+                if ( input_command == midge::stream::s_none )
+                {
+                    continue;
+                }
+                else if ( input_command == stream::s_error )
+                {
+                    LWARN( flog, " got an s_error on slot <" << stream_index << ">");
+                    break;
+                }
+                else if ( input_command == stream::s_exit )
+                {
+                    LDEBUG( flog, " got an s_exit on slot <" << stream_index << ">");
+                    break;
+                }
+                else if ( input_command == stream::s_stop )
+                {
+                    LINFO( flog, " got an s_stop on slot <" << stream_index << ">; fired " << f_n_triggers << " triggers");
+                    continue;
+                }
+                else if ( input_command == stream::s_start )
+                {
+                    LDEBUG( flog, " got an s_start on slot <" << stream_index << ">");
+                    f_mean.clear();
+                    f_n_spectra = 0;
+                    f_holdoff_remaining = 0;
+                    f_n_triggers = 0;
+                    continue;
+                }
+                else if ( input_command == stream::s_run )
+                {
+                    LTRACE( flog, " got an s_run on slot <" << stream_index << ">");
+                    if ( f_input_type == input_type_t::frequency )
+                    {
+                        const frequency_data* t_data = in_stream< 0 >().data();
+                        t_data->require_full_precision( get_name() );
+                        f_power.resize( t_data->get_array_size() );
+                        t_data->fill_power( f_power.data() );
+                        process_spectrum( t_data->get_minimum_frequency(), t_data->get_bin_width() );
+                    }
+                    else
+                    {
+                        const power_data* t_data = in_stream< 1 >().data();
+                        f_power.assign( t_data->get_data_array(), t_data->get_data_array() + t_data->get_array_size() );
+                        process_spectrum( t_data->get_minimum_frequency(), t_data->get_bin_width() );
+                    }
+                    continue;
+                }
+            }
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void spectral_trigger::finalize()
+    {
+        f_channel.reset();
+    }
+
+    void spectral_trigger::process_spectrum( float a_minimum_frequency, float a_bin_width )
+    {
+        const unsigned t_size = f_power.size();
+        if ( f_mean.size() != t_size )
+        {
+            f_mean.assign( f_power.begin(), f_power.end() );
+            f_n_spectra = 1;
+            return;
+        }
+
+        // search band
+        unsigned t_first_bin = 0;
+        unsigned t_last_bin = t_size;
+        if ( a_bin_width > 0. )
+        {
+            if ( f_min_frequency > 0. ) t_first_bin = std::min( t_size, (unsigned)std::max( 0., ceil( ( f_min_frequency - a_minimum_frequency ) / a_bin_width ) ) );
+            if ( f_max_frequency > 0. ) t_last_bin = std::min( t_size, (unsigned)std::max( 0., floor( ( f_max_frequency - a_minimum_frequency ) / a_bin_width ) + 1. ) );
+        }
+
+        // while warming up, the mean is a plain average; afterwards it is exponentially weighted
+        const unsigned t_warm_up = f_warm_up < 0 ? f_baseline_length : (unsigned)f_warm_up;
+        const bool t_armed = f_n_spectra >= t_warm_up;
+        const float t_weight = 1.f / (float)std::min( f_n_spectra + 1, f_baseline_length );
+        const float t_threshold = f_threshold;
+
+        unsigned t_loudest_bin = t_size;
+        float t_loudest_ratio = 0.;
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            const float t_limit = t_threshold * f_mean[i_bin];
+            if ( t_armed && f_power[i_bin] > t_limit )
+            {
+                if ( i_bin >= t_first_bin && i_bin < t_last_bin && f_power[i_bin] > t_loudest_ratio * f_mean[i_bin] )
+                {
+                    t_loudest_bin = i_bin;
+                    t_loudest_ratio = f_mean[i_bin] > 0. ? f_power[i_bin] / f_mean[i_bin] : t_threshold;
+                }
+                // absorb only up to the threshold, so that a short excess barely moves the baseline but a persistent one is absorbed gradually;
+                // a mean of zero (e.g. a bin that was empty during the warm-up) could never grow that way, so it takes the power itself
+                f_mean[i_bin] += t_weight * ( ( f_mean[i_bin] > 0.f ? t_limit : f_power[i_bin] ) - f_mean[i_bin] );
+                continue;
+            }
+            f_mean[i_bin] += t_weight * ( f_power[i_bin] - f_mean[i_bin] );
+        }
+        ++f_n_spectra;
+
+        if ( f_holdoff_remaining > 0 )
+        {
+            --f_holdoff_remaining;
+            return;
+        }
+        if ( t_loudest_bin < t_size )
+        {
+            trigger_broker::fire( *f_channel );
+            ++f_n_triggers;
+            f_holdoff_remaining = f_holdoff;
+            LDEBUG( flog, "trigger fired at " << a_minimum_frequency + t_loudest_bin * a_bin_width << " Hz; power is " << t_loudest_ratio << " times the running mean" );
+        }
+        return;
+    }
+
+
+    /* spectral_trigger_binding class */
+    /***********************************/
+    spectral_trigger_binding::spectral_trigger_binding()
+    {
+    }
+
+    spectral_trigger_binding::~spectral_trigger_binding()
+    {
+    }
+
+    void spectral_trigger_binding::do_apply_node_config( spectral_trigger* a_node, const scarab::param_node& a_config ) const
+    {
+        a_node->set_input_type( spectral_trigger::string_to_input_type( a_config.get_value( "input-type", spectral_trigger::input_type_to_string( a_node->get_input_type() ) ) ) );
+        a_node->set_trigger_channel( a_config.get_value( "trigger-channel", a_node->get_trigger_channel() ) );
+        a_node->set_threshold( a_config.get_value( "threshold", a_node->get_threshold() ) );
+        a_node->set_baseline_length( a_config.get_value( "baseline-length", a_node->get_baseline_length() ) );
+        a_node->set_warm_up( a_config.get_value( "warm-up", a_node->get_warm_up() ) );
+        a_node->set_holdoff( a_config.get_value( "holdoff", a_node->get_holdoff() ) );
+        a_node->set_min_frequency( a_config.get_value( "min-frequency", a_node->get_min_frequency() ) );
+        a_node->set_max_frequency( a_config.get_value( "max-frequency", a_node->get_max_frequency() ) );
+    }
+
+    void spectral_trigger_binding::do_dump_node_config( const spectral_trigger* a_node, scarab::param_node& a_config ) const
+    {
+        a_config.add( "input-type", scarab::param_value( spectral_trigger::input_type_to_string( a_node->get_input_type() ) ) );
+        a_config.add( "trigger-channel", scarab::param_value( a_node->get_trigger_channel() ) );
+        a_config.add( "threshold", scarab::param_value( a_node->get_threshold() ) );
+        a_config.add( "baseline-length", scarab::param_value( a_node->get_baseline_length() ) );
+        a_config.add( "warm-up", scarab::param_value( a_node->get_warm_up() ) );
+        a_config.add( "holdoff", scarab::param_value( a_node->get_holdoff() ) );
+        a_config.add( "min-frequency", scarab::param_value( a_node->get_min_frequency() ) );
+        a_config.add( "max-frequency", scarab::param_value( a_node->get_max_frequency() ) );
+    }
+
+} /* namespace fast_daq */
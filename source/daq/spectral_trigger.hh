@@ -0,0 +1,123 @@
+/*
+ * spectral_trigger.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_SPECTRAL_TRIGGER_HH_
+#define FAST_DAQ_SPECTRAL_TRIGGER_HH_
+
+// sandfly includes
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+#include "consumer.hh"
+#include "shared_cancel.hh"
+
+//fast_daq
+#include "trigger_broker.hh"
+
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    // forward declarations
+    class frequency_data;
+    class power_data;
+
+    /*!
+     @class spectral_trigger
+     @brief A node which watches spectra for threshold crossings and fires a trigger channel.
+
+     @details
+
+     Each bin's power is compared with a running (exponentially-weighted) mean of that bin over previous spectra.
+     When any bin inside the search band exceeds threshold times its mean, a trigger is fired on the configured
+     channel of the trigger_broker; a triggered-gate node listening to the same channel then passes a window of
+     IQ data to its writer.  No triggers are fired until the running means have settled (warm-up spectra),
+     and after a trigger none are fired for holdoff spectra.  The running means are reset at the start of each run.
+
+     A bin that exceeds the threshold is folded into its running mean clipped to the threshold, so a short signal
+     barely moves the baseline, while a persistent one (e.g. a carrier that appears during the run) is absorbed
+     gradually: the mean grows by a factor of 1 + (threshold - 1) / baseline-length per spectrum until the bin is
+     below threshold, i.e. after about baseline-length / (threshold - 1) * ln( ratio / threshold ) spectra for a
+     signal ratio times the old mean (about 50 spectra for a 30 dB carrier with the defaults).  Until then it
+     keeps triggering, once per holdoff.
+
+     Node type: "spectral-trigger"
+
+     Available configuration values:
+     - "input-type": string -- "frequency" (input stream 0) or "power" (input stream 1) (default: "frequency")
+     - "trigger-channel": string -- name of the trigger channel to fire (default: "spectral")
+     - "threshold": double -- trigger when a bin's power exceeds this multiple of its running mean (default: 10)
+     - "baseline-length": uint -- time constant, in spectra, of the running mean (default: 100)
+     - "warm-up": uint -- number of spectra used to form the running mean before triggering is enabled (default: baseline-length)
+     - "holdoff": uint -- number of spectra after a trigger during which no new trigger is fired (default: 0)
+     - "min-frequency": double -- lower edge of the search band in Hz (default: 0, meaning the start of the spectrum)
+     - "max-frequency": double -- upper edge of the search band in Hz (default: 0, meaning the end of the spectrum)
+
+     Input Streams
+     - 0: frequency_data
+     - 1: power_data
+
+    */
+    class spectral_trigger : public midge::_consumer< midge::type_list< frequency_data, power_data > >, public thread_tuning
+    {
+        public:
+            enum class input_type_t
+            {
+                frequency,
+                power
+            };
+            static std::string input_type_to_string( input_type_t an_input_type );
+            static input_type_t string_to_input_type( const std::string& an_input_type );
+
+        public:
+            spectral_trigger();
+            virtual ~spectral_trigger();
+
+        mv_accessible( input_type_t, input_type );
+        mv_accessible( std::string, trigger_channel );
+        mv_accessible( double, threshold );
+        mv_accessible( unsigned, baseline_length );
+        mv_accessible( int, warm_up ); // negative means baseline-length
+        mv_accessible( unsigned, holdoff );
+        mv_accessible( double, min_frequency );
+        mv_accessible( double, max_frequency );
+
+        mv_accessible_noset( uint64_t, n_triggers );
+
+        public: //node API
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            /// Update the running means with one spectrum of powers and decide whether to trigger
+            void process_spectrum( float a_minimum_frequency, float a_bin_width );
+
+            std::vector< float > f_power;
+            std::vector< float > f_mean;
+            unsigned f_n_spectra;
+            unsigned f_holdoff_remaining;
+            trigger_broker::trigger_channel_ptr f_channel;
+    };
+
+    class spectral_trigger_binding : public _tuned_node_binding< spectral_trigger, spectral_trigger_binding >
+    {
+        public:
+            spectral_trigger_binding();
+            virtual ~spectral_trigger_binding();
+
+        private:
+            virtual void do_apply_node_config( spectral_trigger* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const spectral_trigger* a_node, scarab::param_node& a_config ) const;
+    };
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_SPECTRAL_TRIGGER_HH_ */
@@ -20,6 +20,7 @@
 #include "spectrum_relay.hh"
 #include "power_data.hh"
 #include "butterfly_house.hh"
+#include "load_shedder.hh"
 
 using dripline::msg_alert;
 
@@ -36,7 +37,9 @@ namespace fast_daq
 
     // spectrum_relay methods
     spectrum_relay::spectrum_relay() :
-        f_spectrum_alert_rk( "spectrum-data" )
+        f_spectrum_alert_rk( "spectrum-data" ),
+        f_shed_under_load( true ),
+        f_spectra_shed( 0 )
     {
     }
 
@@ -53,6 +56,7 @@ namespace fast_daq
     {
         try
         {
+            tune_current_thread( get_name() );
             while (! is_canceled() )
             {
                 // Check for midge instructions
@@ -85,7 +89,13 @@ namespace fast_daq
                 else if ( input_command == stream::s_run )
                 {
                     LTRACE( flog, " got an s_run on slot <" << stream_index << ">");
-                    power_data* data_in = in_stream< 0 >().data();
+                    if ( f_shed_under_load && load_shedder::get_instance()->shedding() )
+                    {
+                        ++f_spectra_shed;
+                        LDEBUG( flog, "shedding load; skipping spectrum (" << f_spectra_shed << " skipped so far)" );
+                        continue;
+                    }
+                    const power_data* data_in = in_stream< 0 >().data();
                     broadcast_spectrum( data_in );
                     continue;
                 }
@@ -99,25 +109,74 @@ namespace fast_daq
 
     void spectrum_relay::finalize()
     {
+        if ( f_spectra_shed > 0 )
+        {
+            LINFO( flog, "skipped " << f_spectra_shed << " spectra while shedding load" );
+        }
     }
 
-    void spectrum_relay::broadcast_spectrum( power_data* a_spectrum )
+    void spectrum_relay::broadcast_spectrum( const power_data* a_spectrum )
     {
         // grab the run description and load it into the broadcast payload
         scarab::param_ptr_t t_payload_ptr( new scarab::param_node() );
         scarab::param_node& t_payload = t_payload_ptr->as_node();
         scarab::param_array t_spectrum_array;
-        for (unsigned i_bin=0; i_bin < a_spectrum->get_array_size(); ++i_bin)
+        std::string t_value_key( "value_raw" );
+        if ( a_spectrum->get_compact_format() != compact_data::compact_format_t::none )
+        {
+            // 16-bit codes are sent as integers, much shorter than the formatted values; the format and scale tell the receiver how to decode them
+            const uint16_t* t_codes = a_spectrum->get_compact_array();
+            const bool t_signed = a_spectrum->get_compact_format() == compact_data::compact_format_t::int16;
+            for (unsigned i_code=0; i_code < a_spectrum->get_compact_count(); ++i_code)
+            {
+                if ( t_signed ) t_spectrum_array.push_back( scarab::param_value( (int)(int16_t)t_codes[i_code] ) );
+                else t_spectrum_array.push_back( scarab::param_value( (unsigned)t_codes[i_code] ) );
+            }
+            t_value_key = "value_compact";
+            t_payload.add( "compact_format", compact_data::compact_format_to_string( a_spectrum->get_compact_format() ) );
+            t_payload.add( "compact_scale", a_spectrum->get_compact_scale() );
+        }
+        else
         {
-            //t_spectrum_array.push_back( a_spectrum->get_data_array()[i_bin] )
-	    std::stringstream ss;
-	    ss << std::scientific<< a_spectrum->get_data_array()[i_bin];
-	    t_spectrum_array.push_back(ss.str());
+            for (unsigned i_bin=0; i_bin < a_spectrum->get_array_size(); ++i_bin)
+            {
+                //t_spectrum_array.push_back( a_spectrum->get_data_array()[i_bin] )
+                std::stringstream ss;
+                ss << std::scientific<< a_spectrum->get_data_array()[i_bin];
+                t_spectrum_array.push_back(ss.str());
+            }
         }
-        t_payload.add( "value_raw", std::move( t_spectrum_array) );
+        t_payload.add( t_value_key, std::move( t_spectrum_array) );
         t_payload.add( "minimum_frequency", a_spectrum->get_minimum_frequency() );
         t_payload.add( "maximum_frequency", a_spectrum->get_minimum_frequency() + a_spectrum->get_array_size() * a_spectrum->get_bin_width() );
         t_payload.add( "frequency_resolution", a_spectrum->get_bin_width() );
+        t_payload.add( "acquisition_id", a_spectrum->get_acquisition_id() );
+        t_payload.add( "first_sample_index", a_spectrum->get_first_sample_index() );
+        t_payload.add( "sample_span", a_spectrum->get_sample_span() );
+        t_payload.add( "samples_lost", a_spectrum->get_samples_lost() );
+        t_payload.add( "n_spectra", a_spectrum->get_n_spectra() );
+        t_payload.add( "n_flagged", a_spectrum->get_n_flagged() );
+        if ( a_spectrum->get_n_flagged() > 0 )
+        {
+            // per-bin counts of RFI-excised spectra; only sent when something was flagged, since they are otherwise all zero
+            scarab::param_array t_flag_count_array;
+            const unsigned* t_flag_counts = a_spectrum->get_flag_count_array();
+            for (unsigned i_bin=0; i_bin < a_spectrum->get_array_size(); ++i_bin)
+            {
+                t_flag_count_array.push_back( scarab::param_value( t_flag_counts[i_bin] ) );
+            }
+            t_payload.add( "flag_count", std::move( t_flag_count_array ) );
+        }
+        if ( a_spectrum->get_kurtosis_array() != nullptr )
+        {
+            scarab::param_array t_kurtosis_array;
+            const float* t_kurtosis = a_spectrum->get_kurtosis_array();
+            for (unsigned i_bin=0; i_bin < a_spectrum->get_array_size(); ++i_bin)
+            {
+                t_kurtosis_array.push_back( scarab::param_value( t_kurtosis[i_bin] ) );
+            }
+            t_payload.add( "kurtosis", std::move( t_kurtosis_array ) );
+        }
 	
         auto notes = butterfly_house::get_instance()->get_description(0);
         t_payload.add( "notes", notes);
@@ -132,7 +191,7 @@ namespace fast_daq
 	}
 
 	std::string a_specifier = "";
-	LDEBUG( flog, "test spectrum 0: " << t_payload["value_raw"][1] << this->get_spectrum_alert_rk());
+	LDEBUG( flog, "test spectrum 0: " << t_payload[t_value_key][1] << this->get_spectrum_alert_rk());
     LDEBUG( flog, "notes: " << notes);
 	
 	// send it
@@ -156,14 +215,16 @@ namespace fast_daq
     {
     }
 
-    void spectrum_relay_binding::do_apply_config(spectrum_relay* a_node, const scarab::param_node& a_config ) const
+    void spectrum_relay_binding::do_apply_node_config(spectrum_relay* a_node, const scarab::param_node& a_config ) const
     {
         a_node->set_spectrum_alert_rk( a_config.get_value( "spectrum-alert-rk", a_node->get_spectrum_alert_rk() ) );
+        a_node->set_shed_under_load( a_config.get_value( "shed-under-load", a_node->get_shed_under_load() ) );
     }
 
-    void spectrum_relay_binding::do_dump_config( const spectrum_relay* a_node, scarab::param_node& a_config ) const
+    void spectrum_relay_binding::do_dump_node_config( const spectrum_relay* a_node, scarab::param_node& a_config ) const
     {
         a_config.add( "spectrum-alert-rk", scarab::param_value( a_node->get_spectrum_alert_rk() ) );
+        a_config.add( "shed-under-load", scarab::param_value( a_node->get_shed_under_load() ) );
     }
 
 } /* namespace fast_daq */
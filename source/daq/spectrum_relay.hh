@@ -10,6 +10,7 @@
 
 // sandfly includes
 #include "node_builder.hh"
+#include "thread_tuning.hh"
 
 #include "control_access.hh"
 #include "consumer.hh"
@@ -31,24 +32,34 @@ namespace fast_daq
 
      Medium resolution data are expected to be received (for example, from a power-averager node)
      to be sent out in a slack message, with proper associated metadata. This can be handled however
-     we like, but most probably it is to be logged in a (postgreSQL) database.
+     we like, but most probably it is to be logged in a (postgreSQL) database.  Each spectrum's place in the data
+     (acquisition_id, first_sample_index, sample_span and samples_lost; see sequenced_data) is sent with it.
+     Spectra are sent as formatted values ("value_raw"), or, if the producer attached a 16-bit copy (see compact_data),
+     as its integer codes ("value_compact", with "compact_format" and "compact_scale"): for int16, value = code * compact_scale;
+     for float16 and bfloat16 the codes are the bit patterns of the values.
+     The RFI-excision statistics are sent too: the number of spectra summed ("n_spectra"), the number of flagged bins
+     ("n_flagged") and, if any bins were flagged, the per-bin counts of spectra in which they were ("flag_count"); and the
+     spectral kurtosis of each bin ("kurtosis") if the power-averager computes it.
 
      Node type: "spectrum-relay"
 
      Available configuration values:
      - "spectrum-alert-rk": string -- A valid AMQP routing key to which each medium-res spectrum will be broadcast
+     - "shed-under-load": bool -- skip spectra while an upstream producer has asked for load shedding (see load_shedder) (default: true)
 
      Input Streams
      - 1: power_data
 
     */
-    class spectrum_relay : public midge::_consumer< midge::type_list< power_data > >, public sandfly::control_access
+    class spectrum_relay : public midge::_consumer< midge::type_list< power_data > >, public sandfly::control_access, public thread_tuning
     {
         public:
             spectrum_relay();
             virtual ~spectrum_relay();
 
         mv_accessible( std::string, spectrum_alert_rk );
+        mv_accessible( bool, shed_under_load );
+        mv_accessible_noset( unsigned, spectra_shed );
 
         public: //node API
             virtual void initialize();
@@ -56,18 +67,18 @@ namespace fast_daq
             virtual void finalize();
 
         private:
-            void broadcast_spectrum( power_data* a_spectrum );
+            void broadcast_spectrum( const power_data* a_spectrum );
     };
 
-    class spectrum_relay_binding : public sandfly::_node_binding< spectrum_relay, spectrum_relay_binding >
+    class spectrum_relay_binding : public _tuned_node_binding< spectrum_relay, spectrum_relay_binding >
     {
         public:
             spectrum_relay_binding();
             virtual ~spectrum_relay_binding();
 
         private:
-            virtual void do_apply_config(spectrum_relay* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const spectrum_relay* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config(spectrum_relay* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const spectrum_relay* a_node, scarab::param_node& a_config ) const;
     };
 } /* namespace fast_daq */
 #endif /* SPECTRUM_RELAY */
@@ -17,6 +17,7 @@
 #include "time.hh"
 
 #include <cmath>
+#include <sstream>
 
 using midge::stream;
 
@@ -41,7 +42,9 @@ namespace fast_daq
             f_v_range( 0.5 ),
             f_center_freq( 50.e6 ),
             f_freq_range( 100.e6 ),
-            f_last_pkt_in_batch( 0 ),
+            f_compressor(),
+            f_sequence(),
+            f_interleaved(),
             f_monarch_ptr(),
             f_stream_no( 0 )
     {
@@ -57,12 +60,36 @@ namespace fast_daq
 
         scarab::dig_calib_params t_dig_params;
         scarab::get_calib_params( f_bit_depth, f_data_type_size, f_v_offset, f_v_range, true, &t_dig_params );
+        set_compact_calib_params( t_dig_params );
+
+        // compact records hold the producer's 16-bit copy, described in the source
+        const unsigned t_data_type_size = record_data_type_size( f_data_type_size );
+        const unsigned t_bit_depth = writes_compact() ? 16 : f_bit_depth;
+        f_compressor.set_element_size( t_data_type_size );
+        std::string t_stream_name( "fast_daq - ATS9462" );
 
         vector< unsigned > t_chan_vec;
         //TODO this stream name should probably come from something more meaningful
-        f_stream_no = a_hw_ptr->header().AddStream( "fast_daq - ATS9462",
-                f_acq_rate, f_record_size, f_sample_size, f_data_type_size,
-                monarch3::sDigitizedS, f_bit_depth, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        if( f_compressor.is_enabled() )
+        {
+            // the records hold packed compressed frames, not samples: declare them as bytes, and give the codec and the original format in the source
+            uint64_t t_raw_record_n_bytes = f_record_size * f_sample_size * t_data_type_size;
+            std::stringstream t_source;
+            t_source << t_stream_name << " (" << f_compressor.describe() << "; frames of " << f_record_size << " x " << f_sample_size << " ";
+            if( writes_compact() ) t_source << compact_description() << ")";
+            else t_source << f_data_type_size << "-byte signed integer samples, " << f_bit_depth << " bits)";
+            f_stream_no = a_hw_ptr->header().AddStream( t_source.str(),
+                    f_acq_rate, record_compressor::packed_record_n_bytes( t_raw_record_n_bytes ), 1, 1,
+                    monarch3::sDigitizedUS, 8, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        }
+        else
+        {
+            std::string t_source( t_stream_name );
+            if( writes_compact() ) t_source += " (" + compact_description() + ")";
+            f_stream_no = a_hw_ptr->header().AddStream( t_source,
+                    f_acq_rate, f_record_size, f_sample_size, t_data_type_size,
+                    record_data_format( monarch3::sDigitizedS ), t_bit_depth, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        }
 
         //unsigned i_chan_psyllid = 0; // this is the channel number in psyllid, as opposed to the channel number in the monarch file
         for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
@@ -82,6 +109,7 @@ namespace fast_daq
     void streaming_frequency_writer::initialize()
     {
         butterfly_house::get_instance()->register_writer( this, f_file_num );
+        f_compressor.set_metrics_name( get_name() );
         return;
     }
 
@@ -90,13 +118,14 @@ namespace fast_daq
         LDEBUG( plog, "execute streaming writer" );
         try
         {
+            tune_current_thread( get_name() );
             midge::enum_t t_time_command = stream::s_none;
 
-            frequency_data* t_freq_data = nullptr;
+            const frequency_data* t_freq_data = nullptr;
 
             stream_wrap_ptr t_swrap_ptr;
 
-            uint64_t t_bytes_per_record = f_record_size * f_sample_size * f_data_type_size;
+            uint64_t t_bytes_per_record = f_record_size * f_sample_size * record_data_type_size( f_data_type_size );
             uint64_t t_record_length_nsec = llrint( (double)(f_record_size) / (double)f_acq_rate * 1.e3 );
 
             uint64_t t_record_counter = 0;
@@ -118,6 +147,10 @@ namespace fast_daq
 
                     if( t_swrap_ptr )
                     {
+                        if( f_compressor.is_enabled() && ! f_compressor.finish( t_swrap_ptr ) )
+                        {
+                            LERROR( plog, "Unable to write the final compressed records" );
+                        }
                         f_monarch_ptr->finish_stream( f_stream_no );
                         t_swrap_ptr.reset();
                     }
@@ -128,9 +161,18 @@ namespace fast_daq
                 if( t_time_command == stream::s_stop )
                 {
                     LDEBUG( plog, "Streaming writer is stopping" );
+                    if( f_sequence.get_breaks() > 0 )
+                    {
+                        LWARN( plog, "The run had " << f_sequence.get_breaks() << " break(s) in the data sequence over " << f_sequence.get_acquisitions()
+                                << " acquisition(s); " << f_sequence.get_samples_lost() << " digitizer samples were lost" );
+                    }
 
                     if( t_swrap_ptr )
                     {
+                        if( f_compressor.is_enabled() && ! f_compressor.finish( t_swrap_ptr ) )
+                        {
+                            LERROR( plog, "Unable to write the final compressed records" );
+                        }
                         f_monarch_ptr->finish_stream( f_stream_no );
                         t_swrap_ptr.reset();
                     }
@@ -146,6 +188,8 @@ namespace fast_daq
 
                     LDEBUG( plog, "Getting stream <" << f_stream_no << ">" );
                     t_swrap_ptr = f_monarch_ptr->get_stream( f_stream_no );
+                    f_sequence.reset();
+                    if( f_compressor.is_enabled() ) f_compressor.start( t_bytes_per_record );
 
                     t_start_file_with_next_data = true;
                     continue;
@@ -168,7 +212,37 @@ namespace fast_daq
 
                     LTRACE( plog, "Writing packet (in session) " << t_record_counter );
 
-                    if( ! t_swrap_ptr->write_record( t_record_counter, t_record_length_nsec * t_record_counter, t_freq_data->get_data_array(), t_bytes_per_record, t_is_new_acquisition ) )
+                    // a new acquisition or lost samples start a new egg acquisition
+                    if( f_sequence.add_input( *t_freq_data ) && ! t_is_new_acquisition )
+                    {
+                        LINFO( plog, "Break in the data sequence at sample " << t_freq_data->get_first_sample_index() << " of acquisition " << t_freq_data->get_acquisition_id()
+                                << " (" << t_freq_data->get_samples_lost() << " samples lost); starting a new egg acquisition with record " << t_record_counter );
+                        t_is_new_acquisition = true;
+                    }
+
+                    // the producer's 16-bit copy, if it fills the record, is already interleaved
+                    const void* t_record = compact_record( *t_freq_data, t_bytes_per_record );
+                    if( t_record == nullptr )
+                    {
+                        t_record = t_freq_data->get_data_array();
+                        if( t_freq_data->get_layout() == frequency_data::layout_t::split )
+                        {
+                            f_interleaved.resize( 2 * (size_t)t_freq_data->get_array_size() );
+                            t_freq_data->copy_bins( 0, t_freq_data->get_array_size(), reinterpret_cast< frequency_data::complex_t* >( f_interleaved.data() ) );
+                            t_record = f_interleaved.data();
+                        }
+                    }
+
+                    if( f_compressor.is_enabled() )
+                    {
+                        // compression runs on the worker pool; frames are written in order as they become ready
+                        f_compressor.submit( t_record_counter, t_record_length_nsec * t_record_counter, t_record, t_bytes_per_record, t_is_new_acquisition );
+                        if( ! f_compressor.write_ready( t_swrap_ptr ) )
+                        {
+                            throw midge::node_nonfatal_error() << "Unable to write compressed record to file; record ID: " << t_record_counter;
+                        }
+                    }
+                    else if( ! t_swrap_ptr->write_record( t_record_counter, t_record_length_nsec * t_record_counter, t_record, t_bytes_per_record, t_is_new_acquisition ) )
                     {
                         throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_record_counter;
                     }
@@ -186,6 +260,10 @@ namespace fast_daq
             // e.g. if cancelled first, before anything else happens
             if( t_swrap_ptr )
             {
+                if( f_compressor.is_enabled() && ! f_compressor.finish( t_swrap_ptr ) )
+                {
+                    LERROR( plog, "Unable to write the final compressed records" );
+                }
                 f_monarch_ptr->finish_stream( f_stream_no );
                 t_swrap_ptr.reset();
             }
@@ -209,7 +287,7 @@ namespace fast_daq
 
 
     streaming_frequency_writer_binding::streaming_frequency_writer_binding() :
-            _node_binding< streaming_frequency_writer, streaming_frequency_writer_binding >()
+            _tuned_node_binding< streaming_frequency_writer, streaming_frequency_writer_binding >()
     {
     }
 
@@ -217,7 +295,7 @@ namespace fast_daq
     {
     }
 
-    void streaming_frequency_writer_binding::do_apply_config( streaming_frequency_writer* a_node, const scarab::param_node& a_config ) const
+    void streaming_frequency_writer_binding::do_apply_node_config( streaming_frequency_writer* a_node, const scarab::param_node& a_config ) const
     {
         LDEBUG( plog, "Configuring streaming_frequency_writer with:\n" << a_config );
         a_node->set_file_num( a_config.get_value( "file-num", a_node->get_file_num() ) );
@@ -234,10 +312,15 @@ namespace fast_daq
         }
         a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
         a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        if( a_config.has( "compression" ) )
+        {
+            a_node->compressor().configure( a_config["compression"].as_node() );
+        }
+        a_node->apply_compact_config( a_config );
         return;
     }
 
-    void streaming_frequency_writer_binding::do_dump_config( const streaming_frequency_writer* a_node, scarab::param_node& a_config ) const
+    void streaming_frequency_writer_binding::do_dump_node_config( const streaming_frequency_writer* a_node, scarab::param_node& a_config ) const
     {
         LDEBUG( plog, "Dumping configuration for streaming_frequency_writer" );
         a_config.add( "file-num", scarab::param_value( a_node->get_file_num() ) );
@@ -252,6 +335,10 @@ namespace fast_daq
         a_config.add( "device", t_dev_node );
         a_config.add( "center-freq", a_node->get_center_freq() );
         a_config.add( "freq-range", a_node->get_freq_range() );
+        scarab::param_node t_compression_node = scarab::param_node();
+        a_node->compressor().dump_config( t_compression_node );
+        a_config.add( "compression", t_compression_node );
+        a_node->dump_compact_config( a_config );
         return;
     }
 
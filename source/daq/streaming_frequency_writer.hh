@@ -11,6 +11,8 @@
 
 #include "egg_writer.hh"
 #include "node_builder.hh"
+#include "thread_tuning.hh"
+#include "record_compressor.hh"
 #include "frequency_data.hh"
 
 #include "consumer.hh"
@@ -28,6 +30,12 @@ namespace fast_daq
 
      WARNING! the output of this node is not proper egg file, frequency data is not supported
 
+     A new egg acquisition is started at each break in the input sequence (a new digitizer acquisition, lost samples, or
+     skipped samples; see sequence_tracker), and the breaks and samples lost are logged when the run stops.
+     Records are always written as interleaved (re, im) pairs; spectra in the split layout are interleaved first.
+     With a "compact-format", the records hold the producer's 16-bit copy of each spectrum instead (see compact_data and
+     egg_writer), with 2-byte values.
+
      Parameter setting is not thread-safe.  Executing is thread-safe.
 
      Node type: "streaming-frequency-writer"
@@ -43,6 +51,10 @@ namespace fast_daq
        - "v-range": double -- voltage range for ADC calibration
      - "center-freq": double -- the center frequency of the data being digitized in Hz
      - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+     - "compression": node -- optional lossless compression of the records; see record_compressor for the available values
+       When compression is enabled, compressed frames are packed into byte records, and the stream source gives the codec and the original record format.
+       The compression ratio and throughput are published as the run metrics "<node name>.compression-ratio" and ".compress-mb-s".
+     - "compact-format", "compact-scale": write the producer's 16-bit copy; see egg_writer
 
      ADC calibration: analog (V) = digital * gain + v-offset
                       gain = v-range / # of digital levels
@@ -54,7 +66,8 @@ namespace fast_daq
     */
     class streaming_frequency_writer :
             public midge::_consumer< midge::type_list< fast_daq::frequency_data > >,
-            public egg_writer
+            public egg_writer,
+            public thread_tuning
     {
         public:
             streaming_frequency_writer();
@@ -73,6 +86,8 @@ namespace fast_daq
             mv_accessible( double, center_freq ); // Hz
             mv_accessible( double, freq_range ); // Hz
 
+            mv_referrable( record_compressor, compressor );
+
         public:
             virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
 
@@ -81,7 +96,8 @@ namespace fast_daq
             virtual void finalize();
 
         private:
-            unsigned f_last_pkt_in_batch;
+            sequence_tracker f_sequence;
+            std::vector< float > f_interleaved; // record of a split-layout spectrum
 
             monarch_wrap_ptr f_monarch_ptr;
             unsigned f_stream_no;
@@ -89,15 +105,15 @@ namespace fast_daq
     };
 
 
-    class streaming_frequency_writer_binding : public sandfly::_node_binding< streaming_frequency_writer, streaming_frequency_writer_binding >
+    class streaming_frequency_writer_binding : public _tuned_node_binding< streaming_frequency_writer, streaming_frequency_writer_binding >
     {
         public:
             streaming_frequency_writer_binding();
             virtual ~streaming_frequency_writer_binding();
 
         private:
-            virtual void do_apply_config( streaming_frequency_writer* a_node, const scarab::param_node& a_config ) const;
-            virtual void do_dump_config( const streaming_frequency_writer* a_node, scarab::param_node& a_config ) const;
+            virtual void do_apply_node_config( streaming_frequency_writer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const streaming_frequency_writer* a_node, scarab::param_node& a_config ) const;
     };
 
 } /* namespace fast_daq */
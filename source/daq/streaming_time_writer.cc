@@ -0,0 +1,318 @@
+/*
+ * streaming_time_writer.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "streaming_time_writer.hh"
+
+#include "butterfly_house.hh"
+#include "fast_daq_error.hh"
+#include "sample_kernels.hh"
+
+#include "midge_error.hh"
+
+#include "digital.hh"
+#include "logger.hh"
+
+#include <cmath>
+#include <sstream>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( streaming_time_writer, "streaming-time-writer", streaming_time_writer_binding );
+
+    LOGGER( plog, "streaming_time_writer" );
+
+    streaming_time_writer::streaming_time_writer() :
+            egg_writer(),
+            f_file_num( 0 ),
+            f_bit_depth( 16 ),
+            f_record_size( 4096 ),
+            f_acq_rate( 100 ),
+            f_v_offset( 0. ),
+            f_v_range( 0.5 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_sequence(),
+            f_monarch_ptr(),
+            f_stream_no( 0 ),
+            f_packed_record(),
+            f_unpacked_record()
+    {
+    }
+
+    streaming_time_writer::~streaming_time_writer()
+    {
+    }
+
+    bool streaming_time_writer::is_packing() const
+    {
+        return f_bit_depth != 16;
+    }
+
+    void streaming_time_writer::prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr )
+    {
+        f_monarch_ptr = a_mw_ptr;
+
+        scarab::dig_calib_params t_dig_params;
+        scarab::get_calib_params( f_bit_depth, sizeof(U16), f_v_offset, f_v_range, true, &t_dig_params );
+
+        std::string t_stream_name( "fast_daq - ATS9462" );
+
+        std::vector< unsigned > t_chan_vec;
+        if( is_packing() )
+        {
+            // the records hold a bit stream, not whole samples: declare them as bytes, and give the packing in the source
+            std::stringstream t_source;
+            t_source << t_stream_name << " (" << f_record_size << " " << f_bit_depth << "-bit digitized samples per record, packed as a little-endian bit stream)";
+            f_stream_no = a_hw_ptr->header().AddStream( t_source.str(),
+                    f_acq_rate, packed_sample_bytes( f_record_size, f_bit_depth ), 1, 1,
+                    monarch3::sDigitizedUS, 8, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        }
+        else
+        {
+            f_stream_no = a_hw_ptr->header().AddStream( t_stream_name,
+                    f_acq_rate, f_record_size, 1, sizeof(U16),
+                    monarch3::sDigitizedUS, f_bit_depth, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        }
+
+        for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
+        {
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageOffset( t_dig_params.v_offset );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageRange( t_dig_params.v_range );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetDACGain( t_dig_params.dac_gain );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyMin( f_center_freq - 0.5 * f_freq_range );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyRange( f_freq_range );
+        }
+
+        return;
+    }
+
+    void streaming_time_writer::initialize()
+    {
+        if( f_bit_depth != 12 && f_bit_depth != 14 && f_bit_depth != 16 )
+        {
+            throw fast_daq::error() << "streaming_time_writer: bit-depth must be 12, 14 or 16, not " << f_bit_depth;
+        }
+        if( is_packing() ) f_packed_record.resize( packed_sample_bytes( f_record_size, f_bit_depth ) );
+        f_unpacked_record.resize( f_record_size );
+        butterfly_house::get_instance()->register_writer( this, f_file_num );
+        return;
+    }
+
+    const void* streaming_time_writer::record_of( const real_time_data& a_time_data )
+    {
+        if( a_time_data.get_array_size() != f_record_size )
+        {
+            throw fast_daq::error() << "streaming_time_writer: chunks of " << a_time_data.get_array_size() << " samples do not match the record size of " << f_record_size;
+        }
+        if( a_time_data.get_bits_per_sample() > f_bit_depth )
+        {
+            throw fast_daq::error() << "streaming_time_writer: " << a_time_data.get_bits_per_sample() << "-bit samples would lose bits in " << f_bit_depth << "-bit records";
+        }
+
+        if( ! is_packing() )
+        {
+            if( ! a_time_data.get_packed() ) return a_time_data.get_time_series();
+            a_time_data.copy_samples( f_unpacked_record.data() );
+            return f_unpacked_record.data();
+        }
+
+        // already in the record format: write it as it is
+        if( a_time_data.get_packed() && a_time_data.get_bits_per_sample() == f_bit_depth ) return a_time_data.get_packed_series();
+
+        const U16* t_samples = a_time_data.get_time_series();
+        if( a_time_data.get_packed() )
+        {
+            a_time_data.copy_samples( f_unpacked_record.data() );
+            t_samples = f_unpacked_record.data();
+        }
+        pack_samples( t_samples, f_packed_record.data(), f_record_size, f_bit_depth );
+        return f_packed_record.data();
+    }
+
+    void streaming_time_writer::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute streaming time writer" );
+        try
+        {
+            tune_current_thread( get_name() );
+            midge::enum_t t_time_command = stream::s_none;
+
+            const real_time_data* t_time_data = nullptr;
+
+            stream_wrap_ptr t_swrap_ptr;
+
+            uint64_t t_bytes_per_record = is_packing() ? f_packed_record.size() : f_record_size * sizeof(U16);
+            uint64_t t_record_length_nsec = llrint( (double)(f_record_size) / (double)f_acq_rate * 1.e3 );
+
+            uint64_t t_first_pkt_in_run = 0;
+
+            bool t_is_new_acquisition = true;
+            bool t_start_file_with_next_data = false;
+
+            while( ! is_canceled() )
+            {
+                t_time_command = in_stream< 0 >().get();
+                if( t_time_command == stream::s_none ) continue;
+                if( t_time_command == stream::s_error ) break;
+
+                LTRACE( plog, "Time writer reading stream 0 at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_time_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Streaming time writer is exiting" );
+
+                    if( t_swrap_ptr )
+                    {
+                        f_monarch_ptr->finish_stream( f_stream_no );
+                        t_swrap_ptr.reset();
+                    }
+
+                    break;
+                }
+
+                if( t_time_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Streaming time writer is stopping" );
+                    if( f_sequence.get_breaks() > 0 )
+                    {
+                        LWARN( plog, "The run had " << f_sequence.get_breaks() << " break(s) in the data sequence over " << f_sequence.get_acquisitions()
+                                << " acquisition(s); " << f_sequence.get_samples_lost() << " digitizer samples were lost" );
+                    }
+
+                    if( t_swrap_ptr )
+                    {
+                        f_monarch_ptr->finish_stream( f_stream_no );
+                        t_swrap_ptr.reset();
+                    }
+
+                    continue;
+                }
+
+                if( t_time_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Will start file with next data" );
+
+                    if( t_swrap_ptr ) t_swrap_ptr.reset();
+
+                    LDEBUG( plog, "Getting stream <" << f_stream_no << ">" );
+                    t_swrap_ptr = f_monarch_ptr->get_stream( f_stream_no );
+                    f_sequence.reset();
+
+                    t_start_file_with_next_data = true;
+                    continue;
+                }
+
+                if( t_time_command == stream::s_run )
+                {
+                    t_time_data = in_stream< 0 >().data();
+
+                    if( t_start_file_with_next_data )
+                    {
+                        LDEBUG( plog, "Handling first packet in run" );
+
+                        t_first_pkt_in_run = t_time_data->get_chunk_counter();
+
+                        t_is_new_acquisition = true;
+
+                        t_start_file_with_next_data = false;
+                    }
+
+                    uint64_t t_time_id = t_time_data->get_chunk_counter();
+                    LTRACE( plog, "Writing packet (in session) " << t_time_id );
+
+                    // a new acquisition, lost samples, or a gap starts a new egg acquisition
+                    if( f_sequence.add_input( *t_time_data ) && ! t_is_new_acquisition )
+                    {
+                        LINFO( plog, "Break in the data sequence at sample " << t_time_data->get_first_sample_index() << " of acquisition " << t_time_data->get_acquisition_id()
+                                << " (" << t_time_data->get_samples_lost() << " samples lost); starting a new egg acquisition with record " << t_time_id );
+                        t_is_new_acquisition = true;
+                    }
+
+                    if( ! t_swrap_ptr->write_record( t_time_id, t_record_length_nsec * ( t_time_id - t_first_pkt_in_run ), record_of( *t_time_data ), t_bytes_per_record, t_is_new_acquisition ) )
+                    {
+                        throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_time_id;
+                    }
+
+                    LTRACE( plog, "Packet written (" << t_time_id << ")" );
+
+                    t_is_new_acquisition = false;
+
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            // final attempt to finish the stream if the outer while loop is broken without the stream having been stopped or exited
+            if( t_swrap_ptr )
+            {
+                f_monarch_ptr->finish_stream( f_stream_no );
+                t_swrap_ptr.reset();
+            }
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing streaming time writer" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void streaming_time_writer::finalize()
+    {
+        LDEBUG( plog, "finalize streaming time writer" );
+        butterfly_house::get_instance()->unregister_writer( this );
+        return;
+    }
+
+
+    streaming_time_writer_binding::streaming_time_writer_binding() :
+            _tuned_node_binding< streaming_time_writer, streaming_time_writer_binding >()
+    {
+    }
+
+    streaming_time_writer_binding::~streaming_time_writer_binding()
+    {
+    }
+
+    void streaming_time_writer_binding::do_apply_node_config( streaming_time_writer* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring streaming_time_writer with:\n" << a_config );
+        a_node->set_file_num( a_config.get_value( "file-num", a_node->get_file_num() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_bit_depth( t_dev_config.get_value( "bit-depth", a_node->get_bit_depth() ) );
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+            a_node->set_v_offset( t_dev_config.get_value( "v-offset", a_node->get_v_offset() ) );
+            a_node->set_v_range( t_dev_config.get_value( "v-range", a_node->get_v_range() ) );
+        }
+        a_node->set_record_size( a_config.get_value( "record-size", a_node->get_record_size() ) );
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        return;
+    }
+
+    void streaming_time_writer_binding::do_dump_node_config( const streaming_time_writer* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for streaming_time_writer" );
+        a_config.add( "file-num", a_node->get_file_num() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "bit-depth", a_node->get_bit_depth() );
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        t_dev_node.add( "v-offset", a_node->get_v_offset() );
+        t_dev_node.add( "v-range", a_node->get_v_range() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "record-size", a_node->get_record_size() );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        return;
+    }
+
+} /* namespace fast_daq */
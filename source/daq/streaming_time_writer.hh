@@ -0,0 +1,113 @@
+/*
+ * streaming_time_writer.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_STREAMING_TIME_WRITER_HH_
+#define FAST_DAQ_STREAMING_TIME_WRITER_HH_
+
+#include "egg_writer.hh"
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+#include "real_time_data.hh"
+
+#include "consumer.hh"
+
+#include <vector>
+
+namespace fast_daq
+{
+
+    /*!
+     @class streaming_time_writer
+     @brief A consumer that writes the digitized samples of every chunk to an egg file.
+
+     @details
+     Each chunk is written as one record, so the input array size must equal "record-size".
+
+     With a "bit-depth" of 16, records hold the 16-bit, left-justified samples.  With a "bit-depth" of 12 or 14, records
+     hold the samples packed to that many bits (see packed_sample_bytes()), which cuts the disk usage by 25% or 12.5%.
+     The stream is then declared as byte records, and its source gives the packing.  Chunks that arrive packed to the
+     same number of bits are written as they are; others are packed by the writer.  Input samples with more bits than
+     "bit-depth" are refused rather than truncated.
+
+     A new egg acquisition is started at each break in the input sequence (see sequence_tracker), and the breaks and
+     samples lost are logged when the run stops.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "streaming-time-writer"
+
+     Available configuration values:
+     - "file-num": uint -- file to write to (default: 0)
+     - "device": node -- digitizer parameters
+       - "bit-depth": uint -- bits per sample in the records: 16, or 12 or 14 for packed records (default: 16)
+       - "acq-rate": uint -- acquisition rate in MHz (default: 100)
+       - "v-offset": double -- voltage offset for ADC calibration (default: 0)
+       - "v-range": double -- voltage range for ADC calibration (default: 0.5)
+     - "record-size": uint -- number of samples in each record (default: 4096)
+     - "center-freq": double -- the center frequency of the data being digitized in Hz (default: 50e6)
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz (default: 100e6)
+
+     Input Stream:
+     - 0: real_time_data
+
+     Output Streams: (none)
+    */
+    class streaming_time_writer :
+            public midge::_consumer< midge::type_list< real_time_data > >,
+            public egg_writer,
+            public thread_tuning
+    {
+        public:
+            streaming_time_writer();
+            virtual ~streaming_time_writer();
+
+        public:
+            mv_accessible( unsigned, file_num );
+
+            mv_accessible( unsigned, bit_depth ); // # of bits
+            mv_accessible( unsigned, record_size ); // # of samples
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, v_offset ); // V
+            mv_accessible( double, v_range ); // V
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
+
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            bool is_packing() const;
+            /// Samples of a_time_data in the record format; may point into one of the scratch records
+            const void* record_of( const real_time_data& a_time_data );
+
+            sequence_tracker f_sequence;
+
+            monarch_wrap_ptr f_monarch_ptr;
+            unsigned f_stream_no;
+
+            std::vector< uint8_t > f_packed_record;
+            std::vector< U16 > f_unpacked_record;
+    };
+
+
+    class streaming_time_writer_binding : public _tuned_node_binding< streaming_time_writer, streaming_time_writer_binding >
+    {
+        public:
+            streaming_time_writer_binding();
+            virtual ~streaming_time_writer_binding();
+
+        private:
+            virtual void do_apply_node_config( streaming_time_writer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const streaming_time_writer* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_STREAMING_TIME_WRITER_HH_ */
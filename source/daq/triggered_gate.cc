@@ -0,0 +1,258 @@
+/*
+ * triggered_gate.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "triggered_gate.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+
+using midge::stream;
+
+namespace fast_daq
+{
+    REGISTER_NODE_AND_BUILDER( triggered_gate, "triggered-gate", triggered_gate_binding );
+
+    LOGGER( flog, "triggered_gate" );
+
+    triggered_gate::triggered_gate() :
+            f_time_length( 20 ),
+            f_chunk_size( 4096 ),
+            f_trigger_channel( "spectral" ),
+            f_pre_trigger( 10 ),
+            f_post_trigger( 10 ),
+            f_n_captures( 0 ),
+            f_n_chunks_passed( 0 ),
+            f_ring_samples(),
+            f_ring_counters(),
+            f_ring_sequences(),
+            f_ring_compact_scales(),
+            f_compact_format( compact_data::compact_format_t::none ),
+            f_pending_lost( 0 ),
+            f_ring_next( 0 ),
+            f_ring_fill( 0 ),
+            f_channel(),
+            f_last_trigger_count( 0 ),
+            f_post_remaining( 0 )
+    {
+    }
+
+    triggered_gate::~triggered_gate()
+    {
+    }
+
+    void triggered_gate::initialize()
+    {
+        if ( f_chunk_size == 0 ) throw fast_daq::error() << "triggered-gate requires a non-zero chunk-size";
+        if ( f_post_trigger == 0 ) throw fast_daq::error() << "triggered-gate requires at least 1 post-trigger chunk";
+
+        out_buffer< 0 >().initialize( f_time_length );
+        out_buffer< 0 >().call( &iq_time_data::allocate_container, f_chunk_size );
+
+        f_ring_samples.resize( 2 * (uint64_t)f_chunk_size * f_pre_trigger );
+        f_ring_counters.resize( f_pre_trigger );
+        f_ring_sequences.resize( f_pre_trigger );
+        f_ring_compact_scales.resize( f_pre_trigger );
+        f_channel = trigger_broker::get_instance()->get_channel( f_trigger_channel );
+
+        LINFO( flog, "listening to trigger channel <" << f_trigger_channel << ">; captures are " << f_pre_trigger << " + " << f_post_trigger << " chunks of " << f_chunk_size << " samples" );
+        return;
+    }
+
+    void triggered_gate::reset_state()
+    {
+        f_ring_next = 0;
+        f_ring_fill = 0;
+        f_post_remaining = 0;
+        f_n_captures = 0;
+        f_n_chunks_passed = 0;
+        f_pending_lost = 0;
+        f_last_trigger_count = trigger_broker::count( *f_channel );
+        return;
+    }
+
+    bool triggered_gate::send_chunk( const iq_time_data::complex_t* a_samples, uint64_t a_chunk_counter, const sequenced_data& a_sequence, float a_compact_scale )
+    {
+        iq_time_data* t_out = out_stream< 0 >().data();
+        std::copy( &a_samples[0][0], &a_samples[0][0] + 2 * f_chunk_size, &t_out->get_data_array()[0][0] );
+        t_out->set_chunk_counter( a_chunk_counter );
+        t_out->copy_sequence( a_sequence );
+        // losses reported by chunks the gate did not pass are carried by the next one it does
+        t_out->set_samples_lost( a_sequence.get_samples_lost() + f_pending_lost );
+        f_pending_lost = 0;
+        t_out->make_compact( f_compact_format, a_compact_scale );
+        ++f_n_chunks_passed;
+        if ( ! out_stream< 0 >().set( stream::s_run ) )
+        {
+            LERROR( flog, "triggered_gate error setting output stream to s_run" );
+            return false;
+        }
+        return true;
+    }
+
+    bool triggered_gate::process_chunk( const iq_time_data* a_time_data )
+    {
+        a_time_data->require_full_precision( get_name() );
+        if ( a_time_data->get_array_size() != f_chunk_size )
+        {
+            throw fast_daq::error() << "triggered-gate received a chunk of " << a_time_data->get_array_size() << " samples; chunk-size is " << f_chunk_size;
+        }
+        f_compact_format = a_time_data->get_compact_format();
+
+        uint64_t t_trigger_count = trigger_broker::count( *f_channel );
+        if ( t_trigger_count != f_last_trigger_count )
+        {
+            f_last_trigger_count = t_trigger_count;
+            if ( f_post_remaining == 0 )
+            {
+                // open the gate: release the pre-trigger chunks, oldest first
+                ++f_n_captures;
+                LDEBUG( flog, "trigger received at chunk " << a_time_data->get_chunk_counter() << "; sending " << f_ring_fill << " pre-trigger chunks" );
+                unsigned t_slot = ( f_ring_next + f_pre_trigger - f_ring_fill ) % std::max( f_pre_trigger, 1U );
+                for ( unsigned i_chunk = 0; i_chunk < f_ring_fill; ++i_chunk )
+                {
+                    const float* t_samples = &f_ring_samples[ 2 * (uint64_t)f_chunk_size * t_slot ];
+                    if ( ! send_chunk( reinterpret_cast< const iq_time_data::complex_t* >( t_samples ), f_ring_counters[ t_slot ], f_ring_sequences[ t_slot ], f_ring_compact_scales[ t_slot ] ) ) return false;
+                    t_slot = ( t_slot + 1 ) % f_pre_trigger;
+                }
+                f_ring_fill = 0;
+            }
+            f_post_remaining = f_post_trigger;
+        }
+
+        if ( f_post_remaining > 0 )
+        {
+            --f_post_remaining;
+            return send_chunk( a_time_data->get_data_array(), a_time_data->get_chunk_counter(), *a_time_data, a_time_data->get_compact_scale() );
+        }
+
+        // gate closed: keep the chunk in the pre-trigger ring
+        if ( f_pre_trigger == 0 )
+        {
+            f_pending_lost += a_time_data->get_samples_lost();
+            return true;
+        }
+        if ( f_ring_fill == f_pre_trigger ) f_pending_lost += f_ring_sequences[ f_ring_next ].get_samples_lost();
+        std::copy( &a_time_data->get_data_array()[0][0], &a_time_data->get_data_array()[0][0] + 2 * f_chunk_size, &f_ring_samples[ 2 * (uint64_t)f_chunk_size * f_ring_next ] );
+        f_ring_counters[ f_ring_next ] = a_time_data->get_chunk_counter();
+        f_ring_sequences[ f_ring_next ].copy_sequence( *a_time_data );
+        f_ring_compact_scales[ f_ring_next ] = a_time_data->get_compact_scale();
+        f_ring_next = ( f_ring_next + 1 ) % f_pre_trigger;
+        f_ring_fill = std::min( f_ring_fill + 1, f_pre_trigger );
+        return true;
+    }
+
+    void triggered_gate::execute( midge::diptera* a_midge )
+    {
+        try
+        {
+            tune_current_thread( get_name() );
+            LDEBUG( flog, "Executing the triggered gate" );
+
+            while (! is_canceled() )
+            {
+                midge::enum_t in_cmd = in_stream< 0 >().get();
+                unsigned in_stream_index = in_stream< 0 >().get_current_index();
+
+                if ( in_cmd == stream::s_none)
+                {
+                    LDEBUG( flog, "got an s_none on slot <" << in_stream_index << ">" );
+                    continue;
+                }
+                if ( in_cmd == stream::s_error )
+                {
+                    LDEBUG( flog, "got an s_error on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_exit )
+                {
+                    LDEBUG( flog, "got an s_exit on slot <" << in_stream_index << ">" );
+                    break;
+                }
+                if ( in_cmd == stream::s_stop )
+                {
+                    LDEBUG( flog, "got an s_stop on slot <" << in_stream_index << ">" );
+                    LINFO( flog, "recorded " << f_n_captures << " captures (" << f_n_chunks_passed << " chunks)" );
+                    if ( ! out_stream< 0 >().set( stream::s_stop ) ) throw midge::node_nonfatal_error() << "Stream 0 error while stopping";
+                    continue;
+                }
+                if ( in_cmd == stream::s_start )
+                {
+                    LDEBUG( flog, "got an s_start on slot <" << in_stream_index << ">" );
+                    reset_state();
+                    if ( ! out_stream< 0 >().set( stream::s_start ) ) throw midge::node_nonfatal_error() << "Stream 0 error while starting";
+                    continue;
+                }
+                if ( in_cmd == stream::s_run )
+                {
+                    LTRACE( flog, "got an s_run on slot <" << in_stream_index << ">" );
+                    if ( ! process_chunk( in_stream< 0 >().data() ) ) break;
+                }
+            }
+
+            LINFO( flog, "TRIGGERED GATE is exiting" );
+
+            // normal exit condition
+            LDEBUG( flog, "Stopping output stream" );
+            bool t_f_stop_ok = out_stream< 0 >().set( stream::s_stop );
+            if( ! t_f_stop_ok ) return;
+
+            LDEBUG( flog, "Exiting output streams" );
+            out_stream< 0 >().set( stream::s_exit );
+
+            return;
+        }
+        catch(...)
+        {
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+
+        return;
+    }
+
+    void triggered_gate::finalize()
+    {
+        out_buffer< 0 >().finalize();
+        f_channel.reset();
+        return;
+    }
+
+
+    // triggered_gate_binding methods
+    triggered_gate_binding::triggered_gate_binding() :
+            _tuned_node_binding< triggered_gate, triggered_gate_binding >()
+    {
+    }
+
+    triggered_gate_binding::~triggered_gate_binding()
+    {
+    }
+
+    void triggered_gate_binding::do_apply_node_config( triggered_gate* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Configuring triggered_gate with:\n" << a_config );
+        a_node->set_time_length( a_config.get_value( "time-length", a_node->get_time_length() ) );
+        a_node->set_chunk_size( a_config.get_value( "chunk-size", a_node->get_chunk_size() ) );
+        a_node->set_trigger_channel( a_config.get_value( "trigger-channel", a_node->get_trigger_channel() ) );
+        a_node->set_pre_trigger( a_config.get_value( "pre-trigger", a_node->get_pre_trigger() ) );
+        a_node->set_post_trigger( a_config.get_value( "post-trigger", a_node->get_post_trigger() ) );
+        return;
+    }
+
+    void triggered_gate_binding::do_dump_node_config( const triggered_gate* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( flog, "Dumping triggered_gate configuration" );
+        a_config.add( "time-length", scarab::param_value( a_node->get_time_length() ) );
+        a_config.add( "chunk-size", scarab::param_value( a_node->get_chunk_size() ) );
+        a_config.add( "trigger-channel", scarab::param_value( a_node->get_trigger_channel() ) );
+        a_config.add( "pre-trigger", scarab::param_value( a_node->get_pre_trigger() ) );
+        a_config.add( "post-trigger", scarab::param_value( a_node->get_post_trigger() ) );
+        return;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,121 @@
+/*
+ * triggered_gate.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_TRIGGERED_GATE_HH_
+#define FAST_DAQ_TRIGGERED_GATE_HH_
+
+//sandfly
+#include "node_builder.hh"
+#include "thread_tuning.hh"
+
+//fast_daq
+#include "iq_time_data.hh"
+#include "trigger_broker.hh"
+
+//midge
+#include "transformer.hh"
+#include "shared_cancel.hh"
+
+#include "fast_daq_error.hh"
+
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class triggered_gate
+     @brief A transformer that only passes IQ data around triggers, so that a downstream writer records targeted captures.
+
+     @details
+     While the gate is closed, incoming chunks are copied into a ring of the most recent pre-trigger chunks and nothing is sent.
+     When a trigger is fired on the configured trigger_broker channel (e.g. by a spectral-trigger node), the gate sends the
+     buffered pre-trigger chunks, oldest first, and then passes the next post-trigger chunks through.  A trigger that arrives
+     while the gate is open extends the capture by another post-trigger chunks.
+
+     Chunk counters and sequences (see sequenced_data) are passed through unchanged, so a writer sees the gap between two
+     captures and starts a new acquisition.  The skipped chunks are not counted as lost, but any losses they reported are
+     added to the next chunk passed.  Chunks that arrive with a 16-bit copy (see compact_data) are passed on with one in the same
+     format and scale.
+     Triggers are acted on when the next chunk arrives; pre-trigger must be long enough to cover the latency
+     between the trigger source and this node.  Triggers fired before the start of a run are ignored.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "triggered-gate"
+
+     Available configuration values:
+     - "time-length": uint -- number of output buffers (default: 20)
+     - "chunk-size": uint -- number of IQ samples in each input chunk; must match the upstream node (default: 4096)
+     - "trigger-channel": string -- name of the trigger channel to listen to (default: "spectral")
+     - "pre-trigger": uint -- number of chunks kept from before each trigger (default: 10)
+     - "post-trigger": uint -- number of chunks passed after each trigger (default: 10)
+
+     Input Stream:
+     - 0: iq_time_data
+
+     Output Streams:
+     - 0: iq_time_data
+    */
+    class triggered_gate : public midge::_transformer< midge::type_list< iq_time_data >, midge::type_list< iq_time_data > >, public thread_tuning
+    {
+        public:
+            triggered_gate();
+            virtual ~triggered_gate();
+
+        mv_accessible( uint64_t, time_length );
+        mv_accessible( unsigned, chunk_size );
+        mv_accessible( std::string, trigger_channel );
+        mv_accessible( unsigned, pre_trigger );
+        mv_accessible( unsigned, post_trigger );
+
+        mv_accessible_noset( uint64_t, n_captures );
+        mv_accessible_noset( uint64_t, n_chunks_passed );
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            bool process_chunk( const iq_time_data* a_time_data );
+            bool send_chunk( const iq_time_data::complex_t* a_samples, uint64_t a_chunk_counter, const sequenced_data& a_sequence, float a_compact_scale );
+            void reset_state();
+
+            // pre-trigger ring: f_pre_trigger slots of f_chunk_size samples
+            std::vector< float > f_ring_samples;
+            std::vector< uint64_t > f_ring_counters;
+            std::vector< sequenced_data > f_ring_sequences;
+            std::vector< float > f_ring_compact_scales;
+            compact_data::compact_format_t f_compact_format; // of the input; fixed by the upstream configuration
+            uint64_t f_pending_lost; // reported by chunks that were not passed
+            unsigned f_ring_next;
+            unsigned f_ring_fill;
+
+            trigger_broker::trigger_channel_ptr f_channel;
+            uint64_t f_last_trigger_count;
+            unsigned f_post_remaining;
+    };
+
+
+    class triggered_gate_binding : public _tuned_node_binding< triggered_gate, triggered_gate_binding >
+    {
+        public:
+            triggered_gate_binding();
+            virtual ~triggered_gate_binding();
+
+        private:
+            virtual void do_apply_node_config( triggered_gate* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_node_config( const triggered_gate* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_TRIGGERED_GATE_HH_ */
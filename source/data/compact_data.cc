@@ -0,0 +1,198 @@
+/*
+ * compact_data.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "compact_data.hh"
+
+#include "compact_kernels.hh"
+#include "data_arena.hh"
+#include "fast_daq_error.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace fast_daq
+{
+    std::string compact_data::compact_format_to_string( compact_format_t a_format )
+    {
+        switch( a_format )
+        {
+            case compact_format_t::none: return "none";
+            case compact_format_t::float16: return "float16";
+            case compact_format_t::bfloat16: return "bfloat16";
+            case compact_format_t::int16: return "int16";
+            default: throw fast_daq::error() << "compact_format value <" << static_cast< unsigned >( a_format ) << "> not recognized";
+        }
+    }
+
+    compact_data::compact_format_t compact_data::string_to_compact_format( const std::string& a_format )
+    {
+        if( a_format == compact_format_to_string( compact_format_t::none ) ) return compact_format_t::none;
+        if( a_format == compact_format_to_string( compact_format_t::float16 ) ) return compact_format_t::float16;
+        if( a_format == compact_format_to_string( compact_format_t::bfloat16 ) ) return compact_format_t::bfloat16;
+        if( a_format == compact_format_to_string( compact_format_t::int16 ) ) return compact_format_t::int16;
+        throw fast_daq::error() << "string <" << a_format << "> not recognized as valid compact_format type";
+    }
+
+    compact_data::compact_data() :
+        f_compact_format( compact_format_t::none ),
+        f_compact_count( 0 ),
+        f_compact_scale( 1.f ),
+        f_compact_only( false ),
+        f_compact_array( nullptr ),
+        f_compact_capacity( 0 )
+    {
+    }
+
+    compact_data::~compact_data()
+    {
+        data_arena::get_instance()->release_array( f_compact_array, f_compact_capacity );
+        f_compact_array = nullptr;
+    }
+
+    void compact_data::allocate_compact( unsigned a_n )
+    {
+        if( a_n > f_compact_capacity )
+        {
+            data_arena::get_instance()->release_array( f_compact_array, f_compact_capacity );
+            f_compact_array = data_arena::get_instance()->allocate_array< uint16_t >( a_n );
+            f_compact_capacity = a_n;
+        }
+        f_compact_count = a_n;
+        return;
+    }
+
+    float compact_data::scale_for_max( float a_max_abs )
+    {
+        // an all-zero record still needs a usable scale
+        return a_max_abs > 0.f ? a_max_abs / 32767.f : 1.f;
+    }
+
+    void compact_data::encode_compact( compact_format_t a_format, const float* a_values, unsigned a_n, float a_scale )
+    {
+        if( a_format == compact_format_t::none )
+        {
+            clear_compact();
+            return;
+        }
+        allocate_compact( a_n );
+        f_compact_scale = 1.f;
+        switch( a_format )
+        {
+            case compact_format_t::float16:
+                encode_float16( a_values, f_compact_array, a_n );
+                break;
+            case compact_format_t::bfloat16:
+                encode_bfloat16( a_values, f_compact_array, a_n );
+                break;
+            case compact_format_t::int16:
+                f_compact_scale = a_scale > 0.f ? a_scale : scale_for_max( max_abs_value( a_values, a_n ) );
+                encode_scaled_int16( a_values, reinterpret_cast< int16_t* >( f_compact_array ), a_n, f_compact_scale );
+                break;
+            default:
+                break;
+        }
+        f_compact_format = a_format;
+        f_compact_only = false;
+        return;
+    }
+
+    void compact_data::encode_compact_pairs( compact_format_t a_format, const float* a_real, const float* a_imag, unsigned a_n, float a_scale )
+    {
+        if( a_format == compact_format_t::none )
+        {
+            clear_compact();
+            return;
+        }
+        allocate_compact( 2 * a_n );
+        f_compact_scale = 1.f;
+        if( a_format == compact_format_t::int16 )
+        {
+            f_compact_scale = a_scale > 0.f ? a_scale : scale_for_max( std::max( max_abs_value( a_real, a_n ), max_abs_value( a_imag, a_n ) ) );
+        }
+
+        // interleave a block at a time on the stack, then encode it with the contiguous kernels
+        const unsigned t_block = 256;
+        float t_pairs[ 2 * t_block ];
+        for( unsigned i_start = 0; i_start < a_n; i_start += t_block )
+        {
+            const unsigned t_n = std::min( t_block, a_n - i_start );
+            for( unsigned i_pair = 0; i_pair < t_n; ++i_pair )
+            {
+                t_pairs[ 2 * i_pair ] = a_real[ i_start + i_pair ];
+                t_pairs[ 2 * i_pair + 1 ] = a_imag[ i_start + i_pair ];
+            }
+            uint16_t* t_codes = f_compact_array + 2 * (size_t)i_start;
+            switch( a_format )
+            {
+                case compact_format_t::float16:
+                    encode_float16( t_pairs, t_codes, 2 * t_n );
+                    break;
+                case compact_format_t::bfloat16:
+                    encode_bfloat16( t_pairs, t_codes, 2 * t_n );
+                    break;
+                case compact_format_t::int16:
+                    encode_scaled_int16( t_pairs, reinterpret_cast< int16_t* >( t_codes ), 2 * t_n, f_compact_scale );
+                    break;
+                default:
+                    break;
+            }
+        }
+        f_compact_format = a_format;
+        f_compact_only = false;
+        return;
+    }
+
+    void compact_data::decode_compact( float* a_values ) const
+    {
+        switch( f_compact_format )
+        {
+            case compact_format_t::float16:
+                decode_float16( f_compact_array, a_values, f_compact_count );
+                break;
+            case compact_format_t::bfloat16:
+                decode_bfloat16( f_compact_array, a_values, f_compact_count );
+                break;
+            case compact_format_t::int16:
+                decode_scaled_int16( reinterpret_cast< const int16_t* >( f_compact_array ), a_values, f_compact_count, f_compact_scale );
+                break;
+            default:
+                throw fast_daq::error() << "compact_data: nothing to decode";
+        }
+        return;
+    }
+
+    void compact_data::clear_compact()
+    {
+        f_compact_format = compact_format_t::none;
+        f_compact_count = 0;
+        f_compact_scale = 1.f;
+        f_compact_only = false;
+        return;
+    }
+
+    void compact_data::require_full_precision( const std::string& a_reader ) const
+    {
+        if( f_compact_only )
+        {
+            throw fast_daq::error() << a_reader << " needs full-precision input, but the producer filled only its " << compact_format_to_string( f_compact_format )
+                    << " copy; turn off the producer's compact-only";
+        }
+        return;
+    }
+
+    void compact_data::take_compact( compact_data& a_staging )
+    {
+        std::swap( f_compact_array, a_staging.f_compact_array );
+        std::swap( f_compact_capacity, a_staging.f_compact_capacity );
+        f_compact_format = a_staging.f_compact_format;
+        f_compact_count = a_staging.f_compact_count;
+        f_compact_scale = a_staging.f_compact_scale;
+        f_compact_only = true;
+        a_staging.clear_compact();
+        return;
+    }
+
+} /* namespace fast_daq */
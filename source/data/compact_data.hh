@@ -0,0 +1,100 @@
+/*
+ * compact_data.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_COMPACT_DATA_HH_
+#define FAST_DAQ_COMPACT_DATA_HH_
+
+#include "member_variables.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fast_daq
+{
+    /*!
+     @class compact_data
+     @brief Base of the floating-point data classes: an optional 16-bit copy of the values, for writers and relays.
+
+     @details
+     A producer that is configured for it encodes its output values into the compact array before sending the object,
+     which halves the bytes that writers and relays have to move.  The full-precision values are still there for
+     consumers that compute with them.  Formats:
+     - float16: IEEE half precision (11-bit significand, range about 6e-8 to 65504);
+     - bfloat16: the upper half of a float (8-bit significand, the full float range);
+     - int16: value = code * compact_scale; the scale is either fixed by the producer or set per object from its
+       largest magnitude (max / 32767).
+
+     Complex values are encoded as interleaved (re, im) pairs, whatever the layout of the full-precision data.
+     compact_format is none unless the producer encoded this object; objects are reused, so producers encode (or
+     clear_compact()) every time.
+
+     A producer whose output only goes to writers can skip the full-precision values: it fills a staging object of its
+     own, encodes that, and moves the compact copy into the output with take_compact().  The output is then marked
+     compact_only, and its full-precision values must not be read.
+    */
+    class compact_data
+    {
+        public:
+            enum class compact_format_t
+            {
+                none,
+                float16,
+                bfloat16,
+                int16
+            };
+            static std::string compact_format_to_string( compact_format_t a_format );
+            static compact_format_t string_to_compact_format( const std::string& a_format );
+
+        public:
+            compact_data();
+            virtual ~compact_data();
+
+        mv_accessible_noset( compact_format_t, compact_format );
+        mv_accessible_noset( unsigned, compact_count ); // number of 16-bit values
+        mv_accessible_noset( float, compact_scale ); // int16: value = code * compact_scale; 1 for the float formats
+        mv_accessible_noset( bool, compact_only ); // if true, only the compact array was filled
+
+        public:
+            /// The encoded values; int16 codes are stored as their bit patterns
+            const uint16_t* get_compact_array() const;
+
+        public:
+            /// Encode a_n values; for int16, a_scale > 0 fixes the scale, otherwise it is set from the largest magnitude
+            void encode_compact( compact_format_t a_format, const float* a_values, unsigned a_n, float a_scale = 0.f );
+            /// Encode a_n (re, im) pairs, given as separate arrays, into interleaved values
+            void encode_compact_pairs( compact_format_t a_format, const float* a_real, const float* a_imag, unsigned a_n, float a_scale = 0.f );
+            /// Decode the compact values into a_values, which must hold compact_count values
+            void decode_compact( float* a_values ) const;
+            /// Mark the object as not encoded
+            void clear_compact();
+            /// Throw fast_daq::error, naming a_reader, if only the compact copy was filled; for nodes that read the full-precision values
+            void require_full_precision( const std::string& a_reader ) const;
+            /// Take the compact copy encoded in a_staging (the arrays are exchanged, not copied), and mark this object compact_only
+            void take_compact( compact_data& a_staging );
+            /// Bytes of encoded data
+            size_t compact_bytes() const;
+
+        private:
+            void allocate_compact( unsigned a_n );
+            static float scale_for_max( float a_max_abs );
+            uint16_t* f_compact_array;
+            unsigned f_compact_capacity;
+    };
+
+    inline const uint16_t* compact_data::get_compact_array() const
+    {
+        return f_compact_array;
+    }
+
+    inline size_t compact_data::compact_bytes() const
+    {
+        return f_compact_count * sizeof(uint16_t);
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_COMPACT_DATA_HH_ */
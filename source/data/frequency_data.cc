@@ -7,32 +7,178 @@
 
 #include "frequency_data.hh"
 
+#include "fast_daq_error.hh"
+
+#include <algorithm>
+
 namespace fast_daq
 {
+    std::string frequency_data::layout_to_string( layout_t a_layout )
+    {
+        switch( a_layout )
+        {
+            case layout_t::interleaved: return "interleaved";
+            case layout_t::split: return "split";
+            default: throw fast_daq::error() << "layout value <" << static_cast< unsigned >( a_layout ) << "> not recognized";
+        }
+    }
+
+    frequency_data::layout_t frequency_data::string_to_layout( const std::string& a_layout )
+    {
+        if( a_layout == layout_to_string( layout_t::interleaved ) ) return layout_t::interleaved;
+        if( a_layout == layout_to_string( layout_t::split ) ) return layout_t::split;
+        throw fast_daq::error() << "string <" << a_layout << "> not recognized as valid layout type";
+    }
+
     frequency_data::frequency_data() :
-        f_data_array(),
+        f_layout( layout_t::interleaved ),
         f_array_size(),
         f_bin_width(),
         f_minimum_frequency(),
-        f_chunk_counter()
+        f_window( window_type_t::rectangular ),
+        f_chunk_counter(),
+        f_n_flagged( 0 ),
+        f_data_array( nullptr ),
+        f_real_array( nullptr ),
+        f_imag_array( nullptr ),
+        f_flag_array( nullptr ),
+        f_capacity( 0 ),
+        f_split_capacity( 0 ),
+        f_flag_capacity( 0 )
     {
     }
 
     frequency_data::~frequency_data()
     {
-        if (f_data_array != nullptr)
-        {
-            delete [] f_data_array;
-            f_data_array = nullptr;
-        }
+        data_arena::get_instance()->release_array( f_data_array, f_capacity );
+        data_arena::get_instance()->release_array( f_real_array, f_split_capacity );
+        data_arena::get_instance()->release_array( f_imag_array, f_split_capacity );
+        data_arena::get_instance()->release_array( f_flag_array, f_flag_capacity );
+        f_data_array = nullptr;
+        f_real_array = nullptr;
+        f_imag_array = nullptr;
+        f_flag_array = nullptr;
     }
 
     void frequency_data::allocate_array( unsigned n_samples )
     {
-        if (f_data_array == nullptr )
+        if ( n_samples > f_flag_capacity )
         {
-            f_data_array = new complex_t[n_samples];
+            data_arena::get_instance()->release_array( f_flag_array, f_flag_capacity );
+            f_flag_array = data_arena::get_instance()->allocate_array< uint8_t >( n_samples );
+            f_flag_capacity = n_samples;
         }
+        allocate_layout_arrays( f_layout, n_samples );
         f_array_size = n_samples;
     }
+
+    void frequency_data::allocate_layout_arrays( layout_t a_layout, unsigned n_samples )
+    {
+        if ( a_layout == layout_t::interleaved )
+        {
+            if ( n_samples <= f_capacity ) return;
+            data_arena::get_instance()->release_array( f_data_array, f_capacity );
+            f_data_array = data_arena::get_instance()->allocate_array< complex_t >( n_samples );
+            f_capacity = n_samples;
+            return;
+        }
+        if ( n_samples <= f_split_capacity ) return;
+        data_arena::get_instance()->release_array( f_real_array, f_split_capacity );
+        data_arena::get_instance()->release_array( f_imag_array, f_split_capacity );
+        f_real_array = data_arena::get_instance()->allocate_array< float >( n_samples );
+        f_imag_array = data_arena::get_instance()->allocate_array< float >( n_samples );
+        f_split_capacity = n_samples;
+    }
+
+    void frequency_data::set_layout( layout_t a_layout )
+    {
+        allocate_layout_arrays( a_layout, f_array_size );
+        f_layout = a_layout;
+    }
+
+    void frequency_data::convert_layout( layout_t a_layout )
+    {
+        if ( a_layout == f_layout ) return;
+        allocate_layout_arrays( a_layout, f_array_size );
+        const unsigned t_size = f_array_size;
+        if ( a_layout == layout_t::split )
+        {
+            for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+            {
+                f_real_array[i_bin] = f_data_array[i_bin][0];
+                f_imag_array[i_bin] = f_data_array[i_bin][1];
+            }
+        }
+        else
+        {
+            copy_bins( 0, t_size, f_data_array );
+        }
+        f_layout = a_layout;
+    }
+
+    void frequency_data::fill_power( float* a_power ) const
+    {
+        const unsigned t_size = f_array_size;
+        if ( f_layout == layout_t::split )
+        {
+            const float* t_re = f_real_array;
+            const float* t_im = f_imag_array;
+            for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+            {
+                a_power[i_bin] = t_re[i_bin] * t_re[i_bin] + t_im[i_bin] * t_im[i_bin];
+            }
+            return;
+        }
+        const complex_t* t_data = f_data_array;
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            a_power[i_bin] = t_data[i_bin][0] * t_data[i_bin][0] + t_data[i_bin][1] * t_data[i_bin][1];
+        }
+    }
+
+    void frequency_data::add_power( float* a_sum, float a_scale ) const
+    {
+        const unsigned t_size = f_array_size;
+        if ( f_layout == layout_t::split )
+        {
+            const float* t_re = f_real_array;
+            const float* t_im = f_imag_array;
+            for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+            {
+                a_sum[i_bin] += ( t_re[i_bin] * t_re[i_bin] + t_im[i_bin] * t_im[i_bin] ) * a_scale;
+            }
+            return;
+        }
+        const complex_t* t_data = f_data_array;
+        for ( unsigned i_bin = 0; i_bin < t_size; ++i_bin )
+        {
+            a_sum[i_bin] += ( t_data[i_bin][0] * t_data[i_bin][0] + t_data[i_bin][1] * t_data[i_bin][1] ) * a_scale;
+        }
+    }
+
+    void frequency_data::copy_bins( unsigned a_first_bin, unsigned a_count, complex_t* a_bins ) const
+    {
+        if ( f_layout == layout_t::interleaved )
+        {
+            std::copy( &f_data_array[a_first_bin][0], &f_data_array[a_first_bin][0] + 2 * (size_t)a_count, &a_bins[0][0] );
+            return;
+        }
+        const float* t_re = f_real_array + a_first_bin;
+        const float* t_im = f_imag_array + a_first_bin;
+        for ( unsigned i_bin = 0; i_bin < a_count; ++i_bin )
+        {
+            a_bins[i_bin][0] = t_re[i_bin];
+            a_bins[i_bin][1] = t_im[i_bin];
+        }
+    }
+
+    void frequency_data::make_compact( compact_format_t a_format, float a_scale )
+    {
+        if ( f_layout == layout_t::split )
+        {
+            encode_compact_pairs( a_format, f_real_array, f_imag_array, f_array_size, a_scale );
+            return;
+        }
+        encode_compact( a_format, &f_data_array[0][0], 2 * f_array_size, a_scale );
+    }
 } /* namespace fast_daq */
@@ -8,11 +8,41 @@
 #ifndef FREQUENCY_DATA_HH_
 #define FREQUENCY_DATA_HH_
 
+#include "compact_data.hh"
+#include "data_arena.hh"
 #include "member_variables.hh"
+#include "sequenced_data.hh"
+#include "window_functions.hh"
+
+#include <cstdint>
+#include <string>
 
 namespace fast_daq
 {
-    class frequency_data
+    /*!
+     @class frequency_data
+     @brief A complex spectrum, in one of two memory layouts.
+
+     @details
+     - interleaved (the default): data_array holds (re, im) pairs;
+     - split: real_array and imag_array hold the real and imaginary parts of all bins, so loops over the bins (power,
+       thresholding, masking) use full-width vector loads instead of shuffling pairs apart.
+     The producer chooses the layout with set_layout(), before or after allocate_array(); only the layout's arrays
+     are meaningful.  Consumers that need one layout use the helpers, which work from either: fill_power() and
+     add_power() for |X|^2, copy_bins() for interleaved pairs, or convert_layout() to rearrange the object in place.
+     The producer may also add a 16-bit copy of the bins (make_compact(); see compact_data).
+
+     The producer records the window its frames were multiplied by before the transform (rectangular by default), so
+     that consumers that undo the transform, like inverse-frequency-transform, can refuse tapered frames.
+
+     Arrays are taken from the data_arena and kept for reuse; they are reallocated only if they need to grow.
+
+     Sharing: an output stream connected to several inputs (e.g. one frequency-transform feeding a power-averager and an
+     inverse-frequency-transform) hands the same object to every reader, without copies; its buffer slot goes back to the
+     producer only once all of the readers have released it.  A reader must therefore never modify its input: consumers
+     hold their inputs as const pointers, through which the arrays are read-only, and the helpers above are const.
+    */
+    class frequency_data : public sequenced_data, public compact_data
     {
         public:
             frequency_data();
@@ -21,18 +51,104 @@ namespace fast_daq
         public:
             typedef float complex_t[2];
 
+            enum class layout_t
+            {
+                interleaved,
+                split
+            };
+            static std::string layout_to_string( layout_t a_layout );
+            static layout_t string_to_layout( const std::string& a_layout );
+
         // member varaible macros
-        mv_accessible( complex_t*, data_array );
-        mv_accessible( unsigned, array_size ); // the length of the f_data_array
+        mv_accessible_noset( layout_t, layout );
+        mv_accessible( unsigned, array_size ); // the number of bins
         mv_accessible( unsigned, fft_size ); // the length of the data array which went into the fft to produce this data (>= array_size)
         mv_accessible( float, bin_width ); // in [Hz]
         mv_accessible( float, minimum_frequency ); // in [Hz]
-        mv_accessible( unsigned, chunk_counter );
+        mv_accessible( window_type_t, window ); // applied to each frame before the transform
+        mv_accessible( uint64_t, chunk_counter );
+        mv_accessible( unsigned, n_flagged ); // number of flagged bins in this spectrum
+
+        public:
+            // arrays: writable only through a non-const object, i.e. by the producer
+            const complex_t* get_data_array() const; // interleaved layout
+            complex_t* get_data_array();
+            const float* get_real_array() const; // split layout
+            float* get_real_array();
+            const float* get_imag_array() const; // split layout
+            float* get_imag_array();
+            const uint8_t* get_flag_array() const; // non-zero for bins flagged by RFI excision; only meaningful if n_flagged > 0
+            uint8_t* get_flag_array();
 
         public:
+            /// Allocate n_samples bins for the current layout
             void allocate_array( unsigned n_samples );
+            /// Select the layout, allocating its arrays if needed; the data are not converted
+            void set_layout( layout_t a_layout );
+            /// Rearrange the data into a_layout
+            void convert_layout( layout_t a_layout );
+
+            /// |X|^2 of each bin into a_power, which must hold array_size values
+            void fill_power( float* a_power ) const;
+            /// Add a_scale * |X|^2 of each bin to a_sum, which must hold array_size values
+            void add_power( float* a_sum, float a_scale ) const;
+            /// Copy a_count bins, from a_first_bin, as interleaved pairs into a_bins
+            void copy_bins( unsigned a_first_bin, unsigned a_count, complex_t* a_bins ) const;
+            /// Encode the bins, from either layout, as compact (re, im) pairs; see compact_data
+            void make_compact( compact_format_t a_format, float a_scale = 0.f );
+
+        private:
+            void allocate_layout_arrays( layout_t a_layout, unsigned n_samples );
+            complex_t* f_data_array;
+            float* f_real_array;
+            float* f_imag_array;
+            uint8_t* f_flag_array;
+            unsigned f_capacity; // of data_array
+            unsigned f_split_capacity; // of real_array and imag_array
+            unsigned f_flag_capacity;
 
     };
+
+    inline const frequency_data::complex_t* frequency_data::get_data_array() const
+    {
+        return f_data_array;
+    }
+
+    inline frequency_data::complex_t* frequency_data::get_data_array()
+    {
+        return f_data_array;
+    }
+
+    inline const float* frequency_data::get_real_array() const
+    {
+        return f_real_array;
+    }
+
+    inline float* frequency_data::get_real_array()
+    {
+        return f_real_array;
+    }
+
+    inline const float* frequency_data::get_imag_array() const
+    {
+        return f_imag_array;
+    }
+
+    inline float* frequency_data::get_imag_array()
+    {
+        return f_imag_array;
+    }
+
+    inline const uint8_t* frequency_data::get_flag_array() const
+    {
+        return f_flag_array;
+    }
+
+    inline uint8_t* frequency_data::get_flag_array()
+    {
+        return f_flag_array;
+    }
+
 } /* namespace fast_daq */
 
 #endif /* FREQUENCY_DATA_HH_ */
@@ -11,22 +11,32 @@ namespace fast_daq
 {
     iq_time_data::iq_time_data() :
         f_array_size(),
-        f_data_array(),
-        f_chunk_counter()
+        f_chunk_counter(),
+        f_data_array( nullptr ),
+        f_capacity( 0 )
     {
     }
 
     iq_time_data::~iq_time_data()
     {
+        data_arena::get_instance()->release_array( f_data_array, f_capacity );
+        f_data_array = nullptr;
     }
 
     void iq_time_data::allocate_container( unsigned n_samples )
     {
-        if ( f_data_array == nullptr )
+        if ( n_samples > f_capacity )
         {
-            f_data_array = new complex_t[n_samples];
+            data_arena::get_instance()->release_array( f_data_array, f_capacity );
+            f_data_array = data_arena::get_instance()->allocate_array< complex_t >( n_samples );
+            f_capacity = n_samples;
         }
         f_array_size = n_samples;
     }
 
+    void iq_time_data::make_compact( compact_format_t a_format, float a_scale )
+    {
+        encode_compact( a_format, &f_data_array[0][0], 2 * f_array_size, a_scale );
+    }
+
 } /* namespace fast_daq */
@@ -9,7 +9,10 @@
 #define IQ_TIME_DATA_HH_
 
 //#include "AlazarApi.h"
+#include "compact_data.hh"
+#include "data_arena.hh"
 #include "member_variables.hh"
+#include "sequenced_data.hh"
 
 #include <vector>
 #include <complex>
@@ -17,7 +20,9 @@
 namespace fast_daq
 {
     /// This class contains "iq" time series which is naturally in units of Volts (not ADC units).
-    class iq_time_data
+    /// The array is taken from the data_arena and kept for reuse; it is reallocated only if it needs to grow.
+    /// It is read-only through a const object, as for frequency_data, so that readers sharing a chunk cannot modify it.
+    class iq_time_data : public sequenced_data, public compact_data
     {
         public:
             iq_time_data();
@@ -28,13 +33,33 @@ namespace fast_daq
 
         // member varaible macros
         mv_accessible( unsigned, array_size );
-        mv_accessible( complex_t*, data_array );
-        mv_accessible( unsigned, chunk_counter );
+        mv_accessible( uint64_t, chunk_counter );
+
+        public:
+            const complex_t* get_data_array() const;
+            complex_t* get_data_array();
 
         public:
             void allocate_container( unsigned n_samples );
+            /// Encode data_array, as (I, Q) pairs, into the compact array; see compact_data
+            void make_compact( compact_format_t a_format, float a_scale = 0.f );
+
+        private:
+            complex_t* f_data_array;
+            unsigned f_capacity;
 
     };
+
+    inline const iq_time_data::complex_t* iq_time_data::get_data_array() const
+    {
+        return f_data_array;
+    }
+
+    inline iq_time_data::complex_t* iq_time_data::get_data_array()
+    {
+        return f_data_array;
+    }
+
 } /* namespace fast_daq */
 
 #endif /* IQ_TIME_DATA_HH_ */
@@ -10,28 +10,54 @@
 namespace fast_daq
 {
     power_data::power_data() :
-        f_data_array(),
         f_array_size(),
         f_bin_width(),
-        f_minimum_frequency()
+        f_minimum_frequency(),
+        f_n_flagged( 0 ),
+        f_n_spectra( 0 ),
+        f_data_array( nullptr ),
+        f_flag_count_array( nullptr ),
+        f_kurtosis_array( nullptr ),
+        f_capacity( 0 ),
+        f_kurtosis_capacity( 0 )
     {
     }
 
     power_data::~power_data()
     {
-        if (f_data_array != nullptr)
-        {
-            delete f_data_array;
-            f_data_array = nullptr;
-        }
+        data_arena::get_instance()->release_array( f_data_array, f_capacity );
+        data_arena::get_instance()->release_array( f_flag_count_array, f_capacity );
+        data_arena::get_instance()->release_array( f_kurtosis_array, f_kurtosis_capacity );
+        f_data_array = nullptr;
+        f_flag_count_array = nullptr;
+        f_kurtosis_array = nullptr;
     }
 
     void power_data::allocate_array( unsigned n_samples )
     {
-        if (f_data_array == nullptr )
+        if ( n_samples > f_capacity )
         {
-            f_data_array = new float[n_samples];
+            data_arena::get_instance()->release_array( f_data_array, f_capacity );
+            data_arena::get_instance()->release_array( f_flag_count_array, f_capacity );
+            f_data_array = data_arena::get_instance()->allocate_array< float >( n_samples );
+            f_flag_count_array = data_arena::get_instance()->allocate_array< unsigned >( n_samples );
+            f_capacity = n_samples;
         }
         f_array_size = n_samples;
     }
+
+    void power_data::allocate_kurtosis_array( unsigned n_samples )
+    {
+        if ( n_samples > f_kurtosis_capacity )
+        {
+            data_arena::get_instance()->release_array( f_kurtosis_array, f_kurtosis_capacity );
+            f_kurtosis_array = data_arena::get_instance()->allocate_array< float >( n_samples );
+            f_kurtosis_capacity = n_samples;
+        }
+    }
+
+    void power_data::make_compact( compact_format_t a_format, float a_scale )
+    {
+        encode_compact( a_format, f_data_array, f_array_size, a_scale );
+    }
 } /* namespace fast_daq */
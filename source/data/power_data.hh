@@ -8,27 +8,82 @@
 #ifndef POWER_DATA_HH_
 #define POWER_DATA_HH_
 
+#include "compact_data.hh"
+#include "data_arena.hh"
 #include "member_variables.hh"
+#include "sequenced_data.hh"
 
 namespace fast_daq
 {
-    class power_data
+    /// Arrays are taken from the data_arena and kept for reuse; they are reallocated only if they need to grow.
+    /// They are read-only through a const object, as for frequency_data, so that readers sharing a spectrum cannot modify it.
+    class power_data : public sequenced_data, public compact_data
     {
         public:
             power_data();
             virtual ~power_data();
 
         // member varaible macros
-        //TODO this should probably be an std::vector, not an float*
-        mv_accessible( float*, data_array );
         mv_accessible( unsigned, array_size );
         mv_accessible( float, bin_width ); // in [Hz]
         mv_accessible( float, minimum_frequency ); // in [Hz]
+        mv_accessible( unsigned, n_flagged ); // total of flag_count_array
+        mv_accessible( unsigned, n_spectra ); // number of spectra summed into this one
+
+        public:
+            //TODO this should probably be an std::vector, not an float*
+            const float* get_data_array() const;
+            float* get_data_array();
+            const unsigned* get_flag_count_array() const; // per bin, the number of summed spectra in which the bin was flagged by RFI excision
+            unsigned* get_flag_count_array();
+            const float* get_kurtosis_array() const; // per-bin spectral kurtosis of the summed spectra; nullptr unless allocated
+            float* get_kurtosis_array();
 
         public:
             void allocate_array( unsigned n_samples );
+            void allocate_kurtosis_array( unsigned n_samples );
+            /// Encode data_array into the compact array; see compact_data
+            void make_compact( compact_format_t a_format, float a_scale = 0.f );
+
+        private:
+            float* f_data_array;
+            unsigned* f_flag_count_array;
+            float* f_kurtosis_array;
+            unsigned f_capacity;
+            unsigned f_kurtosis_capacity;
 
     };
+
+    inline const float* power_data::get_data_array() const
+    {
+        return f_data_array;
+    }
+
+    inline float* power_data::get_data_array()
+    {
+        return f_data_array;
+    }
+
+    inline const unsigned* power_data::get_flag_count_array() const
+    {
+        return f_flag_count_array;
+    }
+
+    inline unsigned* power_data::get_flag_count_array()
+    {
+        return f_flag_count_array;
+    }
+
+    inline const float* power_data::get_kurtosis_array() const
+    {
+        return f_kurtosis_array;
+    }
+
+    inline float* power_data::get_kurtosis_array()
+    {
+        return f_kurtosis_array;
+    }
+
 } /* namespace fast_daq */
 
 #endif /* POWER_DATA_HH_ */
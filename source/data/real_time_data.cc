@@ -7,40 +7,112 @@
 
 #include "real_time_data.hh"
 
+#include "fast_daq_error.hh"
+#include "sample_kernels.hh"
+
+#include <cstring>
+
 namespace fast_daq
 {
     real_time_data::real_time_data() :
-        f_time_series( nullptr ),
         f_array_size( 0 ),
         f_dynamic_range( 0. ),
         f_volts_data(),
-        f_chunk_counter( 0 )
+        f_chunk_counter( 0 ),
+        f_bits_per_sample( 16 ),
+        f_packed( false ),
+        f_time_series( nullptr ),
+        f_packed_series( nullptr ),
+        f_capacity( 0 ),
+        f_packed_capacity( 0 )
     {
     }
 
     real_time_data::~real_time_data()
     {
-        if (f_time_series != nullptr)
+        data_arena::get_instance()->release_array( f_time_series, f_capacity );
+        data_arena::get_instance()->release_array( f_packed_series, f_packed_capacity );
+    }
+
+    void real_time_data::allocate_array( unsigned n_samples )
+    {
+        if ( n_samples == 0 ) return;
+        if ( n_samples > f_capacity )
         {
-            delete [] f_time_series;
+            data_arena::get_instance()->release_array( f_time_series, f_capacity );
+            f_time_series = data_arena::get_instance()->allocate_array< U16 >( n_samples );
+            f_capacity = n_samples;
         }
+        f_array_size = n_samples;
+        f_packed = false;
     }
 
-    void real_time_data::allocate_array( unsigned n_samples )
+    void real_time_data::set_samples( const U16* a_samples )
     {
-        if ( n_samples != 0 && 
-             (f_time_series == nullptr || n_samples != f_array_size) 
-           )
+        if ( f_bits_per_sample == 12 || f_bits_per_sample == 14 )
         {
-            delete [] f_time_series;
-            f_time_series = new U16[n_samples];
-            f_array_size = n_samples;
-            f_volts_data.resize( n_samples );
+            pack_from( a_samples );
+            return;
         }
+        ::memcpy( f_time_series, a_samples, f_array_size * sizeof(U16) );
+        f_packed = false;
+    }
+
+    void real_time_data::allocate_packed_array()
+    {
+        if ( f_bits_per_sample != 12 && f_bits_per_sample != 14 )
+        {
+            throw fast_daq::error() << "real_time_data: packing is only supported for 12 or 14 bits per sample, not " << f_bits_per_sample;
+        }
+        size_t t_bytes = packed_sample_bytes( f_array_size, f_bits_per_sample );
+        if ( t_bytes > f_packed_capacity )
+        {
+            data_arena::get_instance()->release_array( f_packed_series, f_packed_capacity );
+            f_packed_series = data_arena::get_instance()->allocate_array< uint8_t >( t_bytes );
+            f_packed_capacity = t_bytes;
+        }
+    }
+
+    void real_time_data::pack()
+    {
+        pack_from( f_time_series );
+    }
+
+    void real_time_data::pack_from( const U16* a_samples )
+    {
+        allocate_packed_array();
+        pack_samples( a_samples, f_packed_series, f_array_size, f_bits_per_sample );
+        f_packed = true;
+    }
+
+    void real_time_data::unpack()
+    {
+        if ( ! f_packed ) return;
+        unpack_samples( f_packed_series, f_time_series, f_array_size, f_bits_per_sample );
+        f_packed = false;
+    }
+
+    void real_time_data::copy_samples( U16* a_samples ) const
+    {
+        if ( f_packed )
+        {
+            unpack_samples( f_packed_series, a_samples, f_array_size, f_bits_per_sample );
+        }
+        else
+        {
+            ::memcpy( a_samples, f_time_series, f_array_size * sizeof(U16) );
+        }
+    }
+
+    size_t real_time_data::sample_bytes() const
+    {
+        return f_packed ? packed_sample_bytes( f_array_size, f_bits_per_sample ) : f_array_size * sizeof(U16);
     }
 
     std::vector<float> real_time_data::as_volts()
     {
+         unpack();
+         if ( f_volts_data.size() != f_array_size ) f_volts_data.resize( f_array_size );
          float units_factor = f_dynamic_range / 65536.;
          float min_volts = f_dynamic_range / 2.0;
          for (unsigned i_bin=0; i_bin<f_array_size; ++i_bin)
@@ -50,6 +122,22 @@ namespace fast_daq
             // ... where min_voltage_in_range == -(dynamic_range/2.)
             f_volts_data[i_bin] = (static_cast<float>(f_time_series[i_bin]) * units_factor) - min_volts;
          }
-         return f_volts_data;
+         return std::vector<float>( f_volts_data.begin(), f_volts_data.end() );
+    }
+
+    void real_time_data::fill_volts( float* a_volts ) const
+    {
+         // same conversion as as_volts(), without the intermediate copy
+         float units_factor = f_dynamic_range / 65536.;
+         float min_volts = f_dynamic_range / 2.0;
+         if ( f_packed )
+         {
+            unpack_samples_to_volts( f_packed_series, a_volts, f_array_size, f_bits_per_sample, units_factor, min_volts );
+            return;
+         }
+         for (unsigned i_bin=0; i_bin<f_array_size; ++i_bin)
+         {
+            a_volts[i_bin] = (static_cast<float>(f_time_series[i_bin]) * units_factor) - min_volts;
+         }
     }
 } /* namespace fast_daq */
@@ -14,32 +14,83 @@
 typedef unsigned short U16;
 #endif
 
+#include "data_arena.hh"
 #include "member_variables.hh"
+#include "sequenced_data.hh"
 
+#include <cstdint>
 #include <vector>
 
 namespace fast_daq
 {
     /// This class contains "real" time data which is in some sense fundamenta
-    class real_time_data
+    /// Its arrays are taken from the data_arena and kept for reuse; they are reallocated only if they need to grow.
+    /// They are read-only through a const object, as for frequency_data, so that readers sharing a chunk cannot modify it.
+    class real_time_data : public sequenced_data
     {
         public:
             real_time_data();
             virtual ~real_time_data();
 
+        public:
+            typedef std::vector< float, arena_allocator< float > > volts_vector_t;
+
         // member varaible macros
-        mv_accessible( U16*, time_series );
         mv_accessible( unsigned, array_size );
         mv_accessible( float, dynamic_range ); //full scale range in V (not mV; not magnitude)
-        mv_accessible( std::vector<float>, volts_data );
-        mv_accessible( unsigned, chunk_counter );
+        mv_accessible( volts_vector_t, volts_data ); // sized on first use by as_volts()
+        mv_accessible( uint64_t, chunk_counter );
+        mv_accessible( unsigned, bits_per_sample ); // ADC resolution; samples are left-justified in 16 bits
+        mv_accessible_noset( bool, packed ); // if true, the samples are in packed_series and time_series is not up to date
+
+        public:
+            const U16* get_time_series() const;
+            U16* get_time_series();
+            const uint8_t* get_packed_series() const;
 
         public:
             void allocate_array( unsigned n_samples );
+            /// Fill the array_size samples from a_samples (left-justified), packing them if bits_per_sample is 12 or 14
+            void set_samples( const U16* a_samples );
+            /// Pack time_series, which must be up to date, to bits_per_sample bits per sample (12 or 14) in packed_series
+            void pack();
+            /// Pack a_samples (array_size left-justified samples) straight into packed_series, leaving time_series untouched
+            void pack_from( const U16* a_samples );
+            /// Restore time_series from packed_series
+            void unpack();
+            /// Copy the samples as 16-bit values into a_samples, which must hold at least array_size elements, whichever the storage
+            void copy_samples( U16* a_samples ) const;
+            /// Number of bytes of sample data currently held: packed if packed, otherwise 2 per sample
+            size_t sample_bytes() const;
             // is this the right signature?
             std::vector<float> as_volts();
+            /// Convert to volts directly into a_volts, which must hold at least array_size elements; unpacks on the fly if packed
+            void fill_volts( float* a_volts ) const;
+
+        private:
+            void allocate_packed_array();
+            U16* f_time_series;
+            uint8_t* f_packed_series;
+            unsigned f_capacity;
+            size_t f_packed_capacity;
 
     };
+
+    inline const U16* real_time_data::get_time_series() const
+    {
+        return f_time_series;
+    }
+
+    inline U16* real_time_data::get_time_series()
+    {
+        return f_time_series;
+    }
+
+    inline const uint8_t* real_time_data::get_packed_series() const
+    {
+        return f_packed_series;
+    }
+
 } /* namespace fast_daq */
 
 #endif /* REAL_TIME_DATA_HH_ */
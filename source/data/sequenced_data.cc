@@ -0,0 +1,114 @@
+/*
+ * sequenced_data.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "sequenced_data.hh"
+
+namespace fast_daq
+{
+    sequenced_data::sequenced_data() :
+        f_acquisition_id( 0 ),
+        f_first_sample_index( 0 ),
+        f_sample_span( 0 ),
+        f_samples_lost( 0 )
+    {
+    }
+
+    sequenced_data::~sequenced_data()
+    {
+    }
+
+    void sequenced_data::copy_sequence( const sequenced_data& a_other )
+    {
+        f_acquisition_id = a_other.f_acquisition_id;
+        f_first_sample_index = a_other.f_first_sample_index;
+        f_sample_span = a_other.f_sample_span;
+        f_samples_lost = a_other.f_samples_lost;
+        return;
+    }
+
+
+    sequence_tracker::sequence_tracker() :
+        f_acquisition_id( 0 ),
+        f_next_sample_index( 0 ),
+        f_samples_lost( 0 ),
+        f_breaks( 0 ),
+        f_acquisitions( 0 ),
+        f_started( false ),
+        f_covered_end( 0 ),
+        f_pending_lost( 0 )
+    {
+    }
+
+    sequence_tracker::~sequence_tracker()
+    {
+    }
+
+    void sequence_tracker::reset()
+    {
+        f_acquisition_id = 0;
+        f_next_sample_index = 0;
+        f_samples_lost = 0;
+        f_breaks = 0;
+        f_acquisitions = 0;
+        f_started = false;
+        f_covered_end = 0;
+        f_pending_lost = 0;
+        return;
+    }
+
+    bool sequence_tracker::breaks_sequence( const sequenced_data& a_input ) const
+    {
+        // overlapping inputs (e.g. spectra of overlapping frames) still follow on
+        return ! f_started
+                || a_input.get_acquisition_id() != f_acquisition_id
+                || a_input.get_first_sample_index() > f_next_sample_index
+                || a_input.get_samples_lost() > 0;
+    }
+
+    bool sequence_tracker::add_input( const sequenced_data& a_input )
+    {
+        bool t_break = breaks_sequence( a_input );
+        if( t_break )
+        {
+            if( f_started )
+            {
+                ++f_breaks;
+                // whatever the outputs have not covered by now can't be used any more
+                if( f_next_sample_index > f_covered_end )
+                {
+                    f_pending_lost += f_next_sample_index - f_covered_end;
+                    f_samples_lost += f_next_sample_index - f_covered_end;
+                }
+            }
+            if( ! f_started || a_input.get_acquisition_id() != f_acquisition_id ) ++f_acquisitions;
+            f_acquisition_id = a_input.get_acquisition_id();
+            f_covered_end = a_input.get_first_sample_index();
+            f_started = true;
+        }
+        f_pending_lost += a_input.get_samples_lost();
+        f_samples_lost += a_input.get_samples_lost();
+        f_next_sample_index = a_input.end_sample_index();
+        return t_break;
+    }
+
+    void sequence_tracker::stamp_output( sequenced_data& a_output, uint64_t a_first_sample_index, uint64_t a_span )
+    {
+        a_output.set_acquisition_id( f_acquisition_id );
+        a_output.set_first_sample_index( a_first_sample_index );
+        a_output.set_sample_span( a_span );
+        a_output.set_samples_lost( f_pending_lost );
+        f_pending_lost = 0;
+        if( a_first_sample_index + a_span > f_covered_end ) f_covered_end = a_first_sample_index + a_span;
+        return;
+    }
+
+    void sequence_tracker::stamp_output( sequenced_data& a_output, const sequenced_data& a_input )
+    {
+        stamp_output( a_output, a_input.get_first_sample_index(), a_input.get_sample_span() );
+        return;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,101 @@
+/*
+ * sequenced_data.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_SEQUENCED_DATA_HH_
+#define FAST_DAQ_SEQUENCED_DATA_HH_
+
+#include "member_variables.hh"
+
+#include <cstdint>
+
+namespace fast_daq
+{
+    /*!
+     @class sequenced_data
+     @brief Base of the data classes: places a data object in the digitized sample stream.
+
+     @details
+     An acquisition is an uninterrupted stretch of digitization; the digitizer starts a new one at the start of a run
+     and whenever it has to restart after an overrun.  Sample indices count digitizer samples from the start of the
+     acquisition, whatever the data type, so objects from different nodes can be lined up:
+     - acquisition_id: which acquisition of the run the object belongs to;
+     - first_sample_index: index of the first digitizer sample that contributed to the object;
+     - sample_span: number of digitizer samples, from first_sample_index, that the object covers (e.g. the FFT frame
+       of a spectrum, or the input samples that were decimated into an I/Q chunk);
+     - samples_lost: digitizer samples of the acquisition that were lost between the previous object on the same
+       stream and this one, either dropped by the digitizer or discarded by a node that could not use them.
+       Samples between two acquisitions are not counted, as the board was not digitizing.
+
+     Skipping samples on purpose (e.g. a triggered gate) leaves a gap in the indices without counting the samples as lost.
+    */
+    class sequenced_data
+    {
+        public:
+            sequenced_data();
+            virtual ~sequenced_data();
+
+        mv_accessible( uint64_t, acquisition_id );
+        mv_accessible( uint64_t, first_sample_index );
+        mv_accessible( uint64_t, sample_span );
+        mv_accessible( uint64_t, samples_lost );
+
+        public:
+            /// Copy the acquisition, first sample index, span and samples lost from a_other
+            void copy_sequence( const sequenced_data& a_other );
+            /// Index just past the last digitizer sample covered
+            uint64_t end_sample_index() const;
+    };
+
+    inline uint64_t sequenced_data::end_sample_index() const
+    {
+        return f_first_sample_index + f_sample_span;
+    }
+
+
+    /*!
+     @class sequence_tracker
+     @brief Follows the sequence of a node's input stream, detects gaps and carries the loss accounting to its outputs.
+
+     @details
+     A node calls add_input() for each input object, and stamp_output() for each output object.  add_input() reports
+     a break in the input (a new acquisition, lost samples, or skipped samples), at which point a node that assembles
+     outputs from several inputs has to start afresh.  Input samples that no output covered by the time of the break
+     are counted as lost, along with the losses reported by the inputs, and the total is attached to the next output.
+
+     The tracker also keeps the totals for the run, for nodes to report; reset() at the start of each run.
+    */
+    class sequence_tracker
+    {
+        public:
+            sequence_tracker();
+            virtual ~sequence_tracker();
+
+            void reset();
+
+            /// True if a_input would not follow on from the previous input (or would be the first); does not record it
+            bool breaks_sequence( const sequenced_data& a_input ) const;
+            /// Account for the next input; returns true if it does not follow on from the previous input (or is the first)
+            bool add_input( const sequenced_data& a_input );
+            /// Sequence an output that covers a_span samples from a_first_sample_index of the current acquisition
+            void stamp_output( sequenced_data& a_output, uint64_t a_first_sample_index, uint64_t a_span );
+            /// Sequence an output that covers the same samples as a_input
+            void stamp_output( sequenced_data& a_output, const sequenced_data& a_input );
+
+        mv_accessible_noset( uint64_t, acquisition_id ); // of the latest input
+        mv_accessible_noset( uint64_t, next_sample_index ); // just past the latest input
+        mv_accessible_noset( uint64_t, samples_lost ); // in this run, including samples discarded at breaks
+        mv_accessible_noset( uint64_t, breaks ); // in this run, not counting the first input
+        mv_accessible_noset( uint64_t, acquisitions ); // seen in this run
+
+        private:
+            bool f_started;
+            uint64_t f_covered_end; // just past the samples covered by the outputs so far
+            uint64_t f_pending_lost; // lost since the latest output
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_SEQUENCED_DATA_HH_ */
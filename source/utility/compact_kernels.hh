@@ -0,0 +1,202 @@
+/*
+ * compact_kernels.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_COMPACT_KERNELS_HH_
+#define FAST_DAQ_COMPACT_KERNELS_HH_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+namespace fast_daq
+{
+    /*!
+     @brief Round a float to the nearest IEEE 754 half-precision value (ties to even).
+
+     @details
+     Values beyond the half-precision range become infinities; NaNs stay NaNs.  Values below the smallest normal
+     half (2^-14) are rounded to subnormals by letting the FPU do the rounding: adding 0.5 leaves the subnormal code in
+     the low mantissa bits.
+    */
+    inline uint16_t float_to_float16( float a_value )
+    {
+        uint32_t t_bits;
+        ::memcpy( &t_bits, &a_value, sizeof(t_bits) );
+        const uint16_t t_sign = uint16_t( ( t_bits >> 16 ) & 0x8000 );
+        t_bits &= 0x7FFFFFFF;
+
+        if( t_bits >= 0x7F800000 ) return t_sign | ( t_bits > 0x7F800000 ? 0x7E00 : 0x7C00 ); // NaN, infinity
+        if( t_bits >= 0x477FF000 ) return t_sign | 0x7C00; // rounds to >= 65520: overflow
+        if( t_bits < 0x38800000 )
+        {
+            float t_abs;
+            ::memcpy( &t_abs, &t_bits, sizeof(t_abs) );
+            t_abs += 0.5f;
+            uint32_t t_sum;
+            ::memcpy( &t_sum, &t_abs, sizeof(t_sum) );
+            return t_sign | uint16_t( t_sum - 0x3F000000 );
+        }
+        const uint32_t t_mantissa_odd = ( t_bits >> 13 ) & 1;
+        t_bits += ( uint32_t( 15 - 127 ) << 23 ) + 0xFFF + t_mantissa_odd;
+        return t_sign | uint16_t( t_bits >> 13 );
+    }
+
+    /// Exact conversion of a half-precision value to float
+    inline float float16_to_float( uint16_t a_value )
+    {
+        const uint32_t t_sign = uint32_t( a_value & 0x8000 ) << 16;
+        const uint32_t t_exponent = ( a_value >> 10 ) & 0x1F;
+        const uint32_t t_mantissa = a_value & 0x3FF;
+        uint32_t t_bits;
+        if( t_exponent == 0 )
+        {
+            float t_subnormal = static_cast< float >( t_mantissa ) * 5.9604644775390625e-8f; // 2^-24
+            ::memcpy( &t_bits, &t_subnormal, sizeof(t_bits) );
+            t_bits |= t_sign;
+        }
+        else if( t_exponent == 0x1F )
+        {
+            t_bits = t_sign | 0x7F800000 | ( t_mantissa << 13 );
+        }
+        else
+        {
+            t_bits = t_sign | ( ( t_exponent + 112 ) << 23 ) | ( t_mantissa << 13 );
+        }
+        float t_value;
+        ::memcpy( &t_value, &t_bits, sizeof(t_value) );
+        return t_value;
+    }
+
+    /// Round a float to bfloat16 (the upper half of the float, ties to even); NaNs stay NaNs
+    inline uint16_t float_to_bfloat16( float a_value )
+    {
+        uint32_t t_bits;
+        ::memcpy( &t_bits, &a_value, sizeof(t_bits) );
+        if( ( t_bits & 0x7FFFFFFF ) > 0x7F800000 ) return uint16_t( ( t_bits >> 16 ) | 0x40 );
+        return uint16_t( ( t_bits + 0x7FFF + ( ( t_bits >> 16 ) & 1 ) ) >> 16 );
+    }
+
+    /// Exact conversion of a bfloat16 value to float
+    inline float bfloat16_to_float( uint16_t a_value )
+    {
+        uint32_t t_bits = uint32_t( a_value ) << 16;
+        float t_value;
+        ::memcpy( &t_value, &t_bits, sizeof(t_value) );
+        return t_value;
+    }
+
+    /*!
+     @brief Convert a_n floats to half precision.
+
+     @details
+     With F16C (e.g. FastDAQ_ENABLE_NATIVE_ARCH on any recent x86-64), eight values are converted per instruction;
+     otherwise, and for the remainder, the scalar conversion is used.  Both round to nearest, ties to even.
+    */
+    inline void encode_float16( const float* a_values, uint16_t* a_codes, size_t a_n )
+    {
+        size_t i_value = 0;
+#ifdef __F16C__
+        for( ; i_value + 8 <= a_n; i_value += 8 )
+        {
+            __m128i t_codes = _mm256_cvtps_ph( _mm256_loadu_ps( a_values + i_value ), _MM_FROUND_TO_NEAREST_INT );
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( a_codes + i_value ), t_codes );
+        }
+#endif
+        for( ; i_value < a_n; ++i_value ) a_codes[ i_value ] = float_to_float16( a_values[ i_value ] );
+    }
+
+    inline void decode_float16( const uint16_t* a_codes, float* a_values, size_t a_n )
+    {
+        size_t i_value = 0;
+#ifdef __F16C__
+        for( ; i_value + 8 <= a_n; i_value += 8 )
+        {
+            __m128i t_codes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_codes + i_value ) );
+            _mm256_storeu_ps( a_values + i_value, _mm256_cvtph_ps( t_codes ) );
+        }
+#endif
+        for( ; i_value < a_n; ++i_value ) a_values[ i_value ] = float16_to_float( a_codes[ i_value ] );
+    }
+
+    /// Convert a_n floats to bfloat16; the branch-free integer loop is left to the compiler to vectorize
+    inline void encode_bfloat16( const float* a_values, uint16_t* a_codes, size_t a_n )
+    {
+        for( size_t i_value = 0; i_value < a_n; ++i_value ) a_codes[ i_value ] = float_to_bfloat16( a_values[ i_value ] );
+    }
+
+    inline void decode_bfloat16( const uint16_t* a_codes, float* a_values, size_t a_n )
+    {
+        for( size_t i_value = 0; i_value < a_n; ++i_value ) a_values[ i_value ] = bfloat16_to_float( a_codes[ i_value ] );
+    }
+
+    /// Largest magnitude of a_n floats (0 for none)
+    inline float max_abs_value( const float* a_values, size_t a_n )
+    {
+        size_t i_value = 0;
+        float t_max = 0.f;
+#ifdef __SSE2__
+        const __m128 t_abs_mask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+        __m128 t_max_v = _mm_setzero_ps();
+        for( ; i_value + 4 <= a_n; i_value += 4 )
+        {
+            t_max_v = _mm_max_ps( t_max_v, _mm_and_ps( _mm_loadu_ps( a_values + i_value ), t_abs_mask ) );
+        }
+        float t_lanes[ 4 ];
+        _mm_storeu_ps( t_lanes, t_max_v );
+        for( unsigned i_lane = 0; i_lane < 4; ++i_lane ) t_max = t_lanes[ i_lane ] > t_max ? t_lanes[ i_lane ] : t_max;
+#endif
+        for( ; i_value < a_n; ++i_value )
+        {
+            float t_abs = std::fabs( a_values[ i_value ] );
+            t_max = t_abs > t_max ? t_abs : t_max;
+        }
+        return t_max;
+    }
+
+    /*!
+     @brief Quantize a_n floats to int16 codes: code = round( value / a_scale ), saturating at the int16 range.
+
+     @details
+     value ~= code * a_scale.  With SSE2 the rounding (to nearest, ties to even) and saturation are done four and
+     eight values at a time by the conversion and pack instructions.
+    */
+    inline void encode_scaled_int16( const float* a_values, int16_t* a_codes, size_t a_n, float a_scale )
+    {
+        const float t_inverse = 1.f / a_scale;
+        size_t i_value = 0;
+#ifdef __SSE2__
+        const __m128 t_inverse_v = _mm_set1_ps( t_inverse );
+        for( ; i_value + 8 <= a_n; i_value += 8 )
+        {
+            __m128i t_low = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( a_values + i_value ), t_inverse_v ) );
+            __m128i t_high = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( a_values + i_value + 4 ), t_inverse_v ) );
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( a_codes + i_value ), _mm_packs_epi32( t_low, t_high ) );
+        }
+#endif
+        for( ; i_value < a_n; ++i_value )
+        {
+            float t_code = std::nearbyint( a_values[ i_value ] * t_inverse );
+            t_code = t_code > 32767.f ? 32767.f : ( t_code < -32768.f ? -32768.f : t_code );
+            a_codes[ i_value ] = int16_t( t_code );
+        }
+    }
+
+    inline void decode_scaled_int16( const int16_t* a_codes, float* a_values, size_t a_n, float a_scale )
+    {
+        for( size_t i_value = 0; i_value < a_n; ++i_value ) a_values[ i_value ] = static_cast< float >( a_codes[ i_value ] ) * a_scale;
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_COMPACT_KERNELS_HH_ */
@@ -0,0 +1,189 @@
+/*
+ * data_arena.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "data_arena.hh"
+
+#include "fast_daq_error.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <cstdlib>
+
+namespace fast_daq
+{
+    LOGGER( flog, "data_arena" );
+
+    namespace
+    {
+        const size_t s_cache_line = 64;
+        const size_t s_page = 4096;
+        const double s_mb = 1024. * 1024.;
+
+        size_t round_up( size_t a_value, size_t a_multiple )
+        {
+            return ( ( a_value + a_multiple - 1 ) / a_multiple ) * a_multiple;
+        }
+    }
+
+    data_arena::data_arena() :
+            f_enabled( true ),
+            f_slab_bytes( 64 * 1024 * 1024 ),
+            f_huge_pages( dma_buffer_pool::huge_page_mode_t::automatic ),
+            f_numa_node( -1 ),
+            f_mutex(),
+            f_slabs(),
+            f_slab_offset( 0 ),
+            f_released(),
+            f_reserved_bytes( 0 ),
+            f_used_bytes( 0 ),
+            f_high_water_bytes( 0 ),
+            f_n_allocations( 0 ),
+            f_n_reused( 0 )
+    {
+    }
+
+    data_arena::~data_arena()
+    {
+        // blocks still held by the heap fallback are left to the OS; slabs are unmapped with their pools
+    }
+
+    void data_arena::configure( const scarab::param_node& a_config )
+    {
+        set_enabled( a_config.get_value( "enabled", get_enabled() ) );
+        double t_slab_mb = a_config.get_value( "slab-mb", (double)f_slab_bytes / s_mb );
+        if( t_slab_mb <= 0. ) throw fast_daq::error() << "data-arena slab-mb must be positive; got " << t_slab_mb;
+        set_slab_bytes( (size_t)( t_slab_mb * s_mb ) );
+        set_huge_pages( dma_buffer_pool::string_to_huge_page_mode( a_config.get_value( "huge-pages", dma_buffer_pool::huge_page_mode_to_string( get_huge_pages() ) ) ) );
+        set_numa_node( a_config.get_value( "numa-node", get_numa_node() ) );
+
+        double t_reserve_mb = a_config.get_value( "reserve-mb", 0. );
+        if( f_enabled && t_reserve_mb > 0. ) reserve( (size_t)( t_reserve_mb * s_mb ) );
+        return;
+    }
+
+    void data_arena::dump_config( scarab::param_node& a_config ) const
+    {
+        a_config.add( "enabled", scarab::param_value( get_enabled() ) );
+        a_config.add( "slab-mb", scarab::param_value( (double)get_slab_bytes() / s_mb ) );
+        a_config.add( "huge-pages", scarab::param_value( dma_buffer_pool::huge_page_mode_to_string( get_huge_pages() ) ) );
+        a_config.add( "numa-node", scarab::param_value( get_numa_node() ) );
+        return;
+    }
+
+    void data_arena::reserve( size_t a_bytes )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        size_t t_available = f_slabs.empty() ? 0 : f_slabs.back()->get_mapped_bytes() - f_slab_offset;
+        if( t_available >= a_bytes ) return;
+        add_slab( a_bytes );
+        return;
+    }
+
+    size_t data_arena::block_size( size_t a_bytes )
+    {
+        return round_up( a_bytes == 0 ? 1 : a_bytes, s_cache_line );
+    }
+
+    void* data_arena::allocate( size_t a_bytes )
+    {
+        size_t t_size = block_size( a_bytes );
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+
+        void* t_block = nullptr;
+        std::vector< void* >& t_released = f_released[ t_size ];
+        if( ! t_released.empty() )
+        {
+            t_block = t_released.back();
+            t_released.pop_back();
+            ++f_n_reused;
+        }
+        else if( f_enabled )
+        {
+            t_block = carve( t_size );
+        }
+        else
+        {
+            t_block = std::aligned_alloc( t_size >= s_page ? s_page : s_cache_line, t_size );
+            if( t_block == nullptr ) throw fast_daq::error() << "data_arena: unable to allocate " << t_size << " bytes";
+        }
+
+        ++f_n_allocations;
+        f_used_bytes += t_size;
+        if( f_used_bytes > f_high_water_bytes ) f_high_water_bytes = f_used_bytes;
+        return t_block;
+    }
+
+    void data_arena::release( void* a_block, size_t a_bytes )
+    {
+        if( a_block == nullptr ) return;
+        size_t t_size = block_size( a_bytes );
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_released[ t_size ].push_back( a_block );
+        f_used_bytes -= t_size;
+        return;
+    }
+
+    void* data_arena::carve( size_t a_size )
+    {
+        size_t t_alignment = a_size >= s_page ? s_page : s_cache_line;
+        size_t t_offset = round_up( f_slab_offset, t_alignment );
+        if( f_slabs.empty() || t_offset + a_size > f_slabs.back()->get_mapped_bytes() )
+        {
+            if( ! f_slabs.empty() )
+            {
+                LDEBUG( flog, "slab full; " << f_slabs.back()->get_mapped_bytes() - f_slab_offset << " bytes left unused" );
+            }
+            add_slab( std::max( a_size, f_slab_bytes ) );
+            t_offset = 0;
+        }
+        f_slab_offset = t_offset + a_size;
+        return static_cast< char* >( f_slabs.back()->buffer( 0 ) ) + t_offset;
+    }
+
+    void data_arena::add_slab( size_t a_bytes )
+    {
+        std::unique_ptr< dma_buffer_pool > t_slab( new dma_buffer_pool() );
+        t_slab->allocate( a_bytes, 1, f_huge_pages, f_numa_node );
+        f_reserved_bytes += t_slab->get_mapped_bytes();
+        f_slabs.push_back( std::move( t_slab ) );
+        f_slab_offset = 0;
+        LDEBUG( flog, "data arena now holds " << (double)f_reserved_bytes / s_mb << " MB in " << f_slabs.size() << " slab(s)" );
+        return;
+    }
+
+    void data_arena::log_statistics() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        LINFO( flog, "data arena: " << (double)f_used_bytes / s_mb << " MB in use, high-water " << (double)f_high_water_bytes / s_mb << " MB, "
+                << (double)f_reserved_bytes / s_mb << " MB mapped in " << f_slabs.size() << " slab(s); "
+                << f_n_allocations << " allocations, " << f_n_reused << " served by released blocks" );
+        if( f_enabled && f_high_water_bytes > f_reserved_bytes )
+        {
+            LWARN( flog, "more memory was used than mapped: is the heap fallback active?" );
+        }
+        return;
+    }
+
+    size_t data_arena::get_reserved_bytes() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_reserved_bytes;
+    }
+
+    size_t data_arena::get_used_bytes() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_used_bytes;
+    }
+
+    size_t data_arena::get_high_water_bytes() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        return f_high_water_bytes;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,169 @@
+/*
+ * data_arena.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_DATA_ARENA_HH_
+#define FAST_DAQ_DATA_ARENA_HH_
+
+#include "dma_buffer_pool.hh"
+
+#include "member_variables.hh"
+#include "singleton.hh"
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class data_arena
+     @brief Resident memory for the arrays of the data containers.
+
+     @details
+     The data containers (real_time_data, frequency_data, power_data, iq_time_data) take their arrays from this arena
+     instead of the heap.  The arena maps memory in large slabs, each a dma_buffer_pool (so optionally backed by huge
+     pages, placed on a NUMA node, and pre-faulted when it is mapped), and carves blocks out of them:
+     - blocks of at least a page are page-aligned; smaller blocks are aligned to 64 bytes (a cache line);
+     - a released block is kept for the next allocation of the same size, so containers rebuilt for each run reuse
+       the same memory, and slabs are only unmapped when the program exits;
+     - reserving the expected total at configuration time (reserve-mb) maps and faults everything before the first
+       run, so no page faults are left for the acquisition itself.
+
+     The containers' buffers are allocated when the nodes initialize, i.e. when the graph is built.  The bytes in use,
+     their high-water mark and the number of allocations served from released blocks are kept, and logged with
+     log_statistics() (by daq_control after each run).  With the arena disabled, blocks come from aligned heap
+     allocations, with the same statistics.
+
+     arena_allocator< T > lets standard containers use the arena.
+
+     Configuration values (the "data-arena" block of the daq configuration):
+     - "enabled": bool -- take container memory from the arena; if false, use aligned heap allocations (default: true)
+     - "reserve-mb": double -- memory to map and fault in when configured (default: 0)
+     - "slab-mb": double -- size of each further slab mapped when the arena runs out; larger blocks get a slab of their own (default: 64)
+     - "huge-pages": string -- page size of the slabs; see dma_buffer_pool (default: "auto")
+     - "numa-node": int -- NUMA node on which to place the slabs; -1 to leave it to the kernel (default: -1)
+
+     Thread safety: all functions are thread-safe; allocating and releasing take a lock, so they are for setting up and
+     tearing down containers, not for per-chunk use.
+    */
+    class data_arena : public scarab::singleton< data_arena >
+    {
+        public:
+            void configure( const scarab::param_node& a_config );
+            void dump_config( scarab::param_node& a_config ) const;
+
+            /// Make sure at least a_bytes are mapped and faulted in, ready for allocation
+            void reserve( size_t a_bytes );
+
+            /// Block of at least a_bytes; contents are undefined
+            void* allocate( size_t a_bytes );
+            /// Give back a block from allocate(), for reuse by a later allocation of the same size
+            void release( void* a_block, size_t a_bytes );
+
+            /// Zero-filled array of a_count elements
+            template< typename T >
+            T* allocate_array( size_t a_count );
+            /// Give back an array from allocate_array(); nullptr is ignored
+            template< typename T >
+            void release_array( T* a_array, size_t a_count );
+
+            void log_statistics() const;
+
+            size_t get_reserved_bytes() const;
+            size_t get_used_bytes() const;
+            size_t get_high_water_bytes() const;
+
+        mv_accessible( bool, enabled );
+        mv_accessible( size_t, slab_bytes );
+        mv_accessible( dma_buffer_pool::huge_page_mode_t, huge_pages );
+        mv_accessible( int, numa_node );
+
+        private:
+            static size_t block_size( size_t a_bytes );
+            void* carve( size_t a_size );
+            void add_slab( size_t a_bytes );
+
+            mutable std::mutex f_mutex;
+            std::vector< std::unique_ptr< dma_buffer_pool > > f_slabs;
+            size_t f_slab_offset; // in the last slab
+            std::map< size_t, std::vector< void* > > f_released; // by block size
+
+            size_t f_reserved_bytes;
+            size_t f_used_bytes;
+            size_t f_high_water_bytes;
+            uint64_t f_n_allocations;
+            uint64_t f_n_reused;
+
+        private:
+            friend class scarab::singleton< data_arena >;
+            friend class scarab::destroyer< data_arena >;
+
+            data_arena();
+            virtual ~data_arena();
+    };
+
+    template< typename T >
+    T* data_arena::allocate_array( size_t a_count )
+    {
+        static_assert( std::is_trivially_copyable< T >::value, "data_arena arrays must be of trivially-copyable types" );
+        T* t_array = static_cast< T* >( allocate( a_count * sizeof(T) ) );
+        ::memset( static_cast< void* >( t_array ), 0, a_count * sizeof(T) );
+        return t_array;
+    }
+
+    template< typename T >
+    void data_arena::release_array( T* a_array, size_t a_count )
+    {
+        if( a_array == nullptr ) return;
+        release( a_array, a_count * sizeof(T) );
+        return;
+    }
+
+
+    /// Standard allocator that takes its memory from the data_arena
+    template< typename T >
+    class arena_allocator
+    {
+        public:
+            typedef T value_type;
+
+            arena_allocator() noexcept {}
+            template< typename U >
+            arena_allocator( const arena_allocator< U >& ) noexcept {}
+
+            T* allocate( size_t a_count )
+            {
+                return static_cast< T* >( data_arena::get_instance()->allocate( a_count * sizeof(T) ) );
+            }
+            void deallocate( T* a_array, size_t a_count )
+            {
+                data_arena::get_instance()->release( a_array, a_count * sizeof(T) );
+            }
+    };
+
+    template< typename T, typename U >
+    inline bool operator==( const arena_allocator< T >&, const arena_allocator< U >& )
+    {
+        return true;
+    }
+
+    template< typename T, typename U >
+    inline bool operator!=( const arena_allocator< T >&, const arena_allocator< U >& )
+    {
+        return false;
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_DATA_ARENA_HH_ */
@@ -0,0 +1,286 @@
+/*
+ * dma_buffer_pool.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "dma_buffer_pool.hh"
+
+#include "fast_daq_error.hh"
+
+#include "logger.hh"
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB ( 21 << MAP_HUGE_SHIFT )
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB ( 30 << MAP_HUGE_SHIFT )
+#endif
+
+// from linux/mempolicy.h; mbind is called directly so there is no dependency on libnuma
+#define FAST_DAQ_MPOL_PREFERRED 1
+
+namespace fast_daq
+{
+    LOGGER( flog, "dma_buffer_pool" );
+
+    namespace
+    {
+        const size_t s_small_page = 4096;
+        const size_t s_page_2MB = size_t(1) << 21;
+        const size_t s_page_1GB = size_t(1) << 30;
+        const unsigned s_max_numa_nodes = 1024;
+
+        size_t round_up( size_t a_value, size_t a_multiple )
+        {
+            return ( ( a_value + a_multiple - 1 ) / a_multiple ) * a_multiple;
+        }
+    }
+
+    std::string dma_buffer_pool::huge_page_mode_to_string( huge_page_mode_t a_mode )
+    {
+        switch( a_mode )
+        {
+            case huge_page_mode_t::none: return "none";
+            case huge_page_mode_t::transparent: return "transparent";
+            case huge_page_mode_t::huge_2MB: return "2MB";
+            case huge_page_mode_t::huge_1GB: return "1GB";
+            case huge_page_mode_t::automatic: return "auto";
+            default: throw fast_daq::error() << "huge_page_mode value <" << static_cast< unsigned >( a_mode ) << "> not recognized";
+        }
+    }
+
+    dma_buffer_pool::huge_page_mode_t dma_buffer_pool::string_to_huge_page_mode( const std::string& a_mode )
+    {
+        if( a_mode == huge_page_mode_to_string( huge_page_mode_t::none ) ) return huge_page_mode_t::none;
+        if( a_mode == huge_page_mode_to_string( huge_page_mode_t::transparent ) ) return huge_page_mode_t::transparent;
+        if( a_mode == huge_page_mode_to_string( huge_page_mode_t::huge_2MB ) ) return huge_page_mode_t::huge_2MB;
+        if( a_mode == huge_page_mode_to_string( huge_page_mode_t::huge_1GB ) ) return huge_page_mode_t::huge_1GB;
+        if( a_mode == huge_page_mode_to_string( huge_page_mode_t::automatic ) ) return huge_page_mode_t::automatic;
+        throw fast_daq::error() << "string <" << a_mode << "> not recognized as valid huge_page_mode type";
+    }
+
+    dma_buffer_pool::dma_buffer_pool() :
+            f_buffer_stride( 0 ),
+            f_buffer_count( 0 ),
+            f_mapped_bytes( 0 ),
+            f_huge_page_mode( huge_page_mode_t::none ),
+            f_numa_node( -1 ),
+            f_base( nullptr )
+    {
+    }
+
+    dma_buffer_pool::~dma_buffer_pool()
+    {
+        release();
+    }
+
+    void dma_buffer_pool::allocate( size_t a_buffer_bytes, size_t a_count, huge_page_mode_t a_mode, int a_numa_node )
+    {
+        release();
+        if( a_buffer_bytes == 0 || a_count == 0 )
+        {
+            throw fast_daq::error() << "dma_buffer_pool: buffer size and count must be nonzero";
+        }
+
+        // buffers stay page-aligned, as they were when allocated individually
+        f_buffer_stride = round_up( a_buffer_bytes, s_small_page );
+        size_t t_pool_bytes = f_buffer_stride * a_count;
+
+        bool t_mapped = false;
+        if( a_mode == huge_page_mode_t::automatic )
+        {
+            // only use 1 GB pages if the pool fills at least one of them
+            if( t_pool_bytes >= s_page_1GB ) t_mapped = map_pool( t_pool_bytes, huge_page_mode_t::huge_1GB );
+            if( ! t_mapped ) t_mapped = map_pool( t_pool_bytes, huge_page_mode_t::huge_2MB );
+            if( ! t_mapped ) t_mapped = map_pool( t_pool_bytes, huge_page_mode_t::transparent );
+        }
+        else
+        {
+            t_mapped = map_pool( t_pool_bytes, a_mode );
+            if( ! t_mapped && a_mode != huge_page_mode_t::none )
+            {
+                LWARN( flog, "unable to map " << t_pool_bytes << " bytes with " << huge_page_mode_to_string( a_mode ) << " pages (" << strerror( errno ) << "); falling back to normal pages" );
+            }
+        }
+        if( ! t_mapped ) t_mapped = map_pool( t_pool_bytes, huge_page_mode_t::none );
+        if( ! t_mapped )
+        {
+            throw fast_daq::error() << "dma_buffer_pool: unable to map " << t_pool_bytes << " bytes: " << strerror( errno );
+        }
+
+        bind_to_node( a_numa_node );
+        prefault();
+        f_buffer_count = a_count;
+
+        LINFO( flog, "mapped " << f_buffer_count << " buffers of " << f_buffer_stride << " bytes (" << f_mapped_bytes << " bytes total) with "
+                << huge_page_mode_to_string( f_huge_page_mode ) << " pages" << ( f_numa_node >= 0 ? " on NUMA node " + std::to_string( f_numa_node ) : std::string() ) );
+    }
+
+    bool dma_buffer_pool::map_pool( size_t a_bytes, huge_page_mode_t a_mode )
+    {
+        int t_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        size_t t_page = s_small_page;
+        size_t t_alignment = s_small_page;
+        switch( a_mode )
+        {
+            case huge_page_mode_t::huge_1GB:
+                t_flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+                t_page = s_page_1GB;
+                t_alignment = s_page_1GB;
+                break;
+            case huge_page_mode_t::huge_2MB:
+                t_flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+                t_page = s_page_2MB;
+                t_alignment = s_page_2MB;
+                break;
+            case huge_page_mode_t::transparent:
+                // the kernel can only back 2 MB-aligned ranges with transparent huge pages
+                t_page = s_page_2MB;
+                t_alignment = s_page_2MB;
+                break;
+            default:
+                break;
+        }
+        size_t t_bytes = round_up( a_bytes, t_page );
+
+        // hugetlb mappings are aligned by the kernel; otherwise over-map and trim to the alignment
+        bool t_trim = ( t_flags & MAP_HUGETLB ) == 0 && t_alignment > s_small_page;
+        size_t t_map_bytes = t_trim ? t_bytes + t_alignment : t_bytes;
+        void* t_map = mmap( nullptr, t_map_bytes, PROT_READ | PROT_WRITE, t_flags, -1, 0 );
+        if( t_map == MAP_FAILED ) return false;
+
+        char* t_base = static_cast< char* >( t_map );
+        if( t_trim )
+        {
+            char* t_aligned = reinterpret_cast< char* >( round_up( reinterpret_cast< size_t >( t_base ), t_alignment ) );
+            size_t t_head = t_aligned - t_base;
+            size_t t_tail = t_map_bytes - t_head - t_bytes;
+            if( t_head > 0 ) munmap( t_base, t_head );
+            if( t_tail > 0 ) munmap( t_aligned + t_bytes, t_tail );
+            t_base = t_aligned;
+        }
+
+        if( a_mode == huge_page_mode_t::transparent && madvise( t_base, t_bytes, MADV_HUGEPAGE ) != 0 )
+        {
+            LDEBUG( flog, "transparent huge pages not available (" << strerror( errno ) << ")" );
+            a_mode = huge_page_mode_t::none;
+        }
+
+        f_base = t_base;
+        f_mapped_bytes = t_bytes;
+        f_huge_page_mode = a_mode;
+        return true;
+    }
+
+    void dma_buffer_pool::bind_to_node( int a_numa_node )
+    {
+        f_numa_node = -1;
+        if( a_numa_node < 0 ) return;
+        if( a_numa_node >= (int)s_max_numa_nodes )
+        {
+            LWARN( flog, "NUMA node " << a_numa_node << " is out of range; memory placement is left to the kernel" );
+            return;
+        }
+
+        // must be set before the pages are first touched
+        const unsigned t_bits_per_word = 8 * sizeof( unsigned long );
+        unsigned long t_node_mask[ s_max_numa_nodes / t_bits_per_word ] = {};
+        t_node_mask[ a_numa_node / t_bits_per_word ] = 1UL << ( a_numa_node % t_bits_per_word );
+        if( syscall( SYS_mbind, f_base, f_mapped_bytes, FAST_DAQ_MPOL_PREFERRED, t_node_mask, (unsigned long)s_max_numa_nodes, 0 ) != 0 )
+        {
+            LWARN( flog, "unable to set NUMA policy to node " << a_numa_node << " (" << strerror( errno ) << "); memory placement is left to the kernel" );
+            return;
+        }
+        f_numa_node = a_numa_node;
+    }
+
+    void dma_buffer_pool::prefault()
+    {
+        size_t t_step = f_huge_page_mode == huge_page_mode_t::huge_1GB ? s_page_1GB
+                      : ( f_huge_page_mode == huge_page_mode_t::huge_2MB ? s_page_2MB : s_small_page );
+        volatile char* t_base = f_base;
+        for( size_t t_offset = 0; t_offset < f_mapped_bytes; t_offset += t_step )
+        {
+            t_base[ t_offset ] = 0;
+        }
+    }
+
+    bool dma_buffer_pool::lock()
+    {
+        if( f_base == nullptr ) return false;
+        if( mlock( f_base, f_mapped_bytes ) != 0 )
+        {
+            LWARN( flog, "unable to lock " << f_mapped_bytes << " bytes in memory (" << strerror( errno ) << "); check RLIMIT_MEMLOCK" );
+            return false;
+        }
+        LDEBUG( flog, "locked " << f_mapped_bytes << " bytes in memory" );
+        return true;
+    }
+
+    void dma_buffer_pool::release()
+    {
+        if( f_base != nullptr )
+        {
+            munmap( f_base, f_mapped_bytes );
+        }
+        f_base = nullptr;
+        f_mapped_bytes = 0;
+        f_buffer_count = 0;
+        f_buffer_stride = 0;
+        f_huge_page_mode = huge_page_mode_t::none;
+        f_numa_node = -1;
+    }
+
+    void* dma_buffer_pool::buffer( size_t a_index ) const
+    {
+        if( a_index >= f_buffer_count )
+        {
+            throw fast_daq::error() << "dma_buffer_pool: buffer index " << a_index << " out of range (" << f_buffer_count << " buffers)";
+        }
+        return f_base + a_index * f_buffer_stride;
+    }
+
+    int dma_buffer_pool::numa_node_of_pci_device( const std::string& a_address )
+    {
+        std::ifstream t_file( "/sys/bus/pci/devices/" + a_address + "/numa_node" );
+        int t_node = -1;
+        if( ! ( t_file >> t_node ) ) return -1;
+        return t_node;
+    }
+
+    int dma_buffer_pool::numa_node_of_pci_vendor( unsigned a_vendor_id )
+    {
+        DIR* t_dir = opendir( "/sys/bus/pci/devices" );
+        if( t_dir == nullptr ) return -1;
+
+        int t_node = -1;
+        while( dirent* t_entry = readdir( t_dir ) )
+        {
+            if( t_entry->d_name[0] == '.' ) continue;
+            std::string t_address( t_entry->d_name );
+            std::ifstream t_vendor_file( "/sys/bus/pci/devices/" + t_address + "/vendor" );
+            unsigned t_vendor = 0;
+            if( ! ( t_vendor_file >> std::hex >> t_vendor ) || t_vendor != a_vendor_id ) continue;
+
+            t_node = numa_node_of_pci_device( t_address );
+            LDEBUG( flog, "found PCI device " << t_address << " with vendor 0x" << std::hex << a_vendor_id << std::dec << " on NUMA node " << t_node );
+            break;
+        }
+        closedir( t_dir );
+        return t_node;
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,87 @@
+/*
+ * dma_buffer_pool.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_DMA_BUFFER_POOL_HH_
+#define FAST_DAQ_DMA_BUFFER_POOL_HH_
+
+#include "member_variables.hh"
+
+#include <cstddef>
+#include <string>
+
+namespace fast_daq
+{
+    /*!
+     @class dma_buffer_pool
+     @brief One contiguous, pre-faulted allocation carved into equally-sized, page-aligned buffers.
+
+     @details
+     Replaces one page-aligned heap allocation per buffer, which for thousands of buffers scatters the memory
+     across 4 kB pages and leaves its NUMA placement to chance.  The pool is a single anonymous mapping:
+     - huge pages are requested according to the huge-page mode: explicit 1 GB or 2 MB pages (MAP_HUGETLB, which
+       need to be reserved by the system, e.g. through /proc/sys/vm/nr_hugepages), or transparent huge pages
+       (madvise); "auto" tries each in turn, largest first, and falls back to normal pages;
+     - if a NUMA node is given, the mapping's memory policy prefers that node (preferred rather than strict, so
+       that a node short of huge pages falls back instead of faulting);
+     - every page is touched at allocation, so no page faults happen once acquisition starts.
+
+     numa_node_of_pci_device() and numa_node_of_pci_vendor() look up the node of a PCI device in sysfs, so the
+     pool can be placed on the node closest to the device doing the DMA.
+
+     Not thread-safe; buffers are owned by the pool and released with it.
+    */
+    class dma_buffer_pool
+    {
+        public:
+            enum class huge_page_mode_t
+            {
+                none,
+                transparent,
+                huge_2MB,
+                huge_1GB,
+                automatic
+            };
+            static std::string huge_page_mode_to_string( huge_page_mode_t a_mode );
+            static huge_page_mode_t string_to_huge_page_mode( const std::string& a_mode );
+
+        public:
+            dma_buffer_pool();
+            virtual ~dma_buffer_pool();
+
+            dma_buffer_pool( const dma_buffer_pool& ) = delete;
+            dma_buffer_pool& operator=( const dma_buffer_pool& ) = delete;
+
+            /// Map, place and pre-fault a_count buffers of at least a_buffer_bytes each; a negative a_numa_node leaves placement to the kernel
+            void allocate( size_t a_buffer_bytes, size_t a_count, huge_page_mode_t a_mode, int a_numa_node );
+            /// Lock the pool in RAM (mlock); returns false, with a warning, if the memory-lock limit does not allow it
+            bool lock();
+            /// Unmap the pool; safe to call when nothing is allocated
+            void release();
+
+            void* buffer( size_t a_index ) const;
+
+            /// NUMA node of the PCI device at a_address (e.g. "0000:3b:00.0"); -1 if unknown
+            static int numa_node_of_pci_device( const std::string& a_address );
+            /// NUMA node of the first PCI device with the given vendor ID; -1 if none is found or the node is unknown
+            static int numa_node_of_pci_vendor( unsigned a_vendor_id );
+
+        mv_accessible_noset( size_t, buffer_stride );
+        mv_accessible_noset( size_t, buffer_count );
+        mv_accessible_noset( size_t, mapped_bytes );
+        mv_accessible_noset( huge_page_mode_t, huge_page_mode ); // mode actually obtained
+        mv_accessible_noset( int, numa_node ); // node actually requested; -1 for none
+
+        private:
+            bool map_pool( size_t a_bytes, huge_page_mode_t a_mode );
+            void bind_to_node( int a_numa_node );
+            void prefault();
+
+            char* f_base;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_DMA_BUFFER_POOL_HH_ */
@@ -0,0 +1,74 @@
+/*
+ * run_metrics.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "run_metrics.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+namespace fast_daq
+{
+    LOGGER( flog, "run_metrics" );
+
+    run_metrics::run_metrics() :
+            f_mutex(),
+            f_metrics()
+    {
+    }
+
+    run_metrics::~run_metrics()
+    {
+    }
+
+    void run_metrics::set( const std::string& a_name, double a_value )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_metrics[ a_name ] = a_value;
+        return;
+    }
+
+    void run_metrics::add( const std::string& a_name, double a_delta )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_metrics[ a_name ] += a_delta;
+        return;
+    }
+
+    double run_metrics::get( const std::string& a_name ) const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        auto t_it = f_metrics.find( a_name );
+        return t_it == f_metrics.end() ? 0. : t_it->second;
+    }
+
+    void run_metrics::clear()
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_metrics.clear();
+        return;
+    }
+
+    void run_metrics::fill_node( scarab::param_node& a_node ) const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        for( auto t_it = f_metrics.begin(); t_it != f_metrics.end(); ++t_it )
+        {
+            a_node.add( t_it->first, scarab::param_value( t_it->second ) );
+        }
+        return;
+    }
+
+    void run_metrics::log_metrics() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        for( auto t_it = f_metrics.begin(); t_it != f_metrics.end(); ++t_it )
+        {
+            LINFO( flog, "run metric <" << t_it->first << ">: " << t_it->second );
+        }
+        return;
+    }
+
+} /* namespace fast_daq */
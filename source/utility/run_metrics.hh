@@ -0,0 +1,68 @@
+/*
+ * run_metrics.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_RUN_METRICS_HH_
+#define FAST_DAQ_RUN_METRICS_HH_
+
+#include "singleton.hh"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class run_metrics
+     @brief Named counters and gauges published by the nodes and the file handling during a run.
+
+     @details
+     Any part of the DAQ can set a metric (a gauge, e.g. the duration of the last egg file) or add to one (a counter,
+     e.g. the number of buffer overruns).  daq_control clears the metrics when a run starts, logs them when it ends,
+     and returns them in reply to a "metrics" get request, so they can be monitored while a run is in progress.
+
+     Names are dotted by source, e.g. "file-0.rotations" or "digitizer.overruns".
+
+     Thread safety: all functions are thread-safe; each takes a lock, so metrics are meant to be updated per buffer or
+     per file, not per sample.
+    */
+    class run_metrics : public scarab::singleton< run_metrics >
+    {
+        public:
+            /// Set a gauge
+            void set( const std::string& a_name, double a_value );
+            /// Add to a counter; the counter starts from 0
+            void add( const std::string& a_name, double a_delta = 1. );
+            /// Value of a metric; 0 if it has not been published
+            double get( const std::string& a_name ) const;
+
+            /// Remove all metrics
+            void clear();
+
+            /// Add each metric to a_node as a name/value pair
+            void fill_node( scarab::param_node& a_node ) const;
+            void log_metrics() const;
+
+        private:
+            mutable std::mutex f_mutex;
+            std::map< std::string, double > f_metrics;
+
+        private:
+            friend class scarab::singleton< run_metrics >;
+            friend class scarab::destroyer< run_metrics >;
+
+            run_metrics();
+            virtual ~run_metrics();
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_RUN_METRICS_HH_ */
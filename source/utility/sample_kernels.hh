@@ -0,0 +1,169 @@
+/*
+ * sample_kernels.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_SAMPLE_KERNELS_HH_
+#define FAST_DAQ_SAMPLE_KERNELS_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+namespace fast_daq
+{
+    /*!
+     @brief Split two-channel interleaved samples (A0 B0 A1 B1 ...) into one array per channel.
+
+     @details
+     a_n_per_channel is the number of samples in each output array; a_interleaved must hold twice that.
+     Where SSE2 is available (always, on x86-64), eight sample pairs are split per iteration: each 32-bit lane holds one
+     A/B pair, the two halves are sign-extended into separate lanes and packed back to 16 bits, which is exact for any
+     16-bit pattern.  The remainder, and other architectures, use the scalar loop.
+    */
+    inline void deinterleave_two_channels( const uint16_t* a_interleaved, uint16_t* a_channel_a, uint16_t* a_channel_b, size_t a_n_per_channel )
+    {
+        size_t i_sample = 0;
+#ifdef __SSE2__
+        for( ; i_sample + 8 <= a_n_per_channel; i_sample += 8 )
+        {
+            __m128i t_low = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_interleaved + 2 * i_sample ) );
+            __m128i t_high = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_interleaved + 2 * i_sample + 8 ) );
+            __m128i t_a = _mm_packs_epi32( _mm_srai_epi32( _mm_slli_epi32( t_low, 16 ), 16 ), _mm_srai_epi32( _mm_slli_epi32( t_high, 16 ), 16 ) );
+            __m128i t_b = _mm_packs_epi32( _mm_srai_epi32( t_low, 16 ), _mm_srai_epi32( t_high, 16 ) );
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( a_channel_a + i_sample ), t_a );
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( a_channel_b + i_sample ), t_b );
+        }
+#endif
+        for( ; i_sample < a_n_per_channel; ++i_sample )
+        {
+            a_channel_a[ i_sample ] = a_interleaved[ 2 * i_sample ];
+            a_channel_b[ i_sample ] = a_interleaved[ 2 * i_sample + 1 ];
+        }
+    }
+
+    /*!
+     @brief Number of bytes needed to hold a_n_samples samples of a_bits bits each, packed.
+
+     @details
+     Packed samples form a little-endian bit stream: sample i occupies bits [i * a_bits, (i + 1) * a_bits).  For 12-bit
+     samples that is three bytes per pair, for 14-bit samples seven bytes per four.
+    */
+    inline size_t packed_sample_bytes( size_t a_n_samples, unsigned a_bits )
+    {
+        return ( a_n_samples * a_bits + 7 ) / 8;
+    }
+
+    /*!
+     @brief Pack left-justified 16-bit samples (as delivered by the digitizer) into a_bits-bit samples.
+
+     @details
+     The low 16 - a_bits bits of each input sample are dropped; for an ADC with a_bits of resolution they are zero.
+     a_packed must hold packed_sample_bytes( a_n_samples, a_bits ) bytes.
+    */
+    inline void pack_samples( const uint16_t* a_samples, uint8_t* a_packed, size_t a_n_samples, unsigned a_bits )
+    {
+        const unsigned t_shift = 16 - a_bits;
+        uint64_t t_accumulator = 0;
+        unsigned t_n_bits = 0;
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            t_accumulator |= uint64_t( a_samples[ i_sample ] >> t_shift ) << t_n_bits;
+            t_n_bits += a_bits;
+            while( t_n_bits >= 8 )
+            {
+                *a_packed++ = uint8_t( t_accumulator );
+                t_accumulator >>= 8;
+                t_n_bits -= 8;
+            }
+        }
+        if( t_n_bits > 0 ) *a_packed = uint8_t( t_accumulator );
+    }
+
+    /*!
+     @brief Unpack a_bits-bit samples back to left-justified 16-bit samples.
+
+     @details
+     12-bit samples are expanded eight at a time with SSSE3 when the build enables it (e.g. FastDAQ_ENABLE_NATIVE_ARCH):
+     one byte shuffle puts each sample's two source bytes in its 16-bit lane, and a shift or mask per lane aligns it.
+    */
+    inline void unpack_samples( const uint8_t* a_packed, uint16_t* a_samples, size_t a_n_samples, unsigned a_bits )
+    {
+        size_t i_sample = 0;
+#ifdef __SSSE3__
+        if( a_bits == 12 )
+        {
+            const __m128i t_gather = _mm_setr_epi8( 0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11 );
+            const __m128i t_odd_mask = _mm_set1_epi32( int( 0xFFF00000 ) );
+            const __m128i t_even_mask = _mm_set1_epi32( 0x0000FFFF );
+            const size_t t_n_bytes = packed_sample_bytes( a_n_samples, a_bits );
+            // each step reads 16 bytes but consumes 12
+            for( ; ( i_sample / 2 ) * 3 + 16 <= t_n_bytes && i_sample + 8 <= a_n_samples; i_sample += 8 )
+            {
+                __m128i t_bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_packed + ( i_sample / 2 ) * 3 ) );
+                __m128i t_lanes = _mm_shuffle_epi8( t_bytes, t_gather );
+                __m128i t_even = _mm_and_si128( _mm_slli_epi16( t_lanes, 4 ), t_even_mask );
+                __m128i t_odd = _mm_and_si128( t_lanes, t_odd_mask );
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( a_samples + i_sample ), _mm_or_si128( t_even, t_odd ) );
+            }
+        }
+#endif
+        const unsigned t_shift = 16 - a_bits;
+        const uint64_t t_mask = ( uint64_t(1) << a_bits ) - 1;
+        for( ; i_sample < a_n_samples; ++i_sample )
+        {
+            size_t t_bit = i_sample * a_bits;
+            const uint8_t* t_first = a_packed + t_bit / 8;
+            unsigned t_n_bytes = ( t_bit % 8 + a_bits + 7 ) / 8;
+            uint64_t t_word = 0;
+            for( unsigned i_byte = 0; i_byte < t_n_bytes; ++i_byte ) t_word |= uint64_t( t_first[ i_byte ] ) << ( 8 * i_byte );
+            a_samples[ i_sample ] = uint16_t( ( ( t_word >> ( t_bit % 8 ) ) & t_mask ) << t_shift );
+        }
+    }
+
+    /*!
+     @brief Unpack a_bits-bit samples straight to volts: code * a_units_factor - a_min_volts, with code left-justified to 16 bits.
+
+     @details
+     Same conversion as real_time_data::fill_volts(), without the intermediate 16-bit array; samples are unpacked in
+     blocks on the stack and converted with SSE2 where available.
+    */
+    inline void unpack_samples_to_volts( const uint8_t* a_packed, float* a_volts, size_t a_n_samples, unsigned a_bits, float a_units_factor, float a_min_volts )
+    {
+        const size_t t_block = 256; // a multiple of 8, so every block but the last starts on a byte boundary
+        uint16_t t_codes[ t_block ];
+        for( size_t i_start = 0; i_start < a_n_samples; i_start += t_block )
+        {
+            size_t t_n = a_n_samples - i_start < t_block ? a_n_samples - i_start : t_block;
+            unpack_samples( a_packed + ( i_start * a_bits ) / 8, t_codes, t_n, a_bits );
+            size_t i_sample = 0;
+#ifdef __SSE2__
+            const __m128 t_units = _mm_set1_ps( a_units_factor );
+            const __m128 t_min = _mm_set1_ps( a_min_volts );
+            const __m128i t_zero = _mm_setzero_si128();
+            for( ; i_sample + 8 <= t_n; i_sample += 8 )
+            {
+                __m128i t_codes_v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( t_codes + i_sample ) );
+                __m128 t_low = _mm_cvtepi32_ps( _mm_unpacklo_epi16( t_codes_v, t_zero ) );
+                __m128 t_high = _mm_cvtepi32_ps( _mm_unpackhi_epi16( t_codes_v, t_zero ) );
+                _mm_storeu_ps( a_volts + i_start + i_sample, _mm_sub_ps( _mm_mul_ps( t_low, t_units ), t_min ) );
+                _mm_storeu_ps( a_volts + i_start + i_sample + 4, _mm_sub_ps( _mm_mul_ps( t_high, t_units ), t_min ) );
+            }
+#endif
+            for( ; i_sample < t_n; ++i_sample )
+            {
+                a_volts[ i_start + i_sample ] = static_cast< float >( t_codes[ i_sample ] ) * a_units_factor - a_min_volts;
+            }
+        }
+    }
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_SAMPLE_KERNELS_HH_ */
@@ -0,0 +1,189 @@
+/*
+ * thread_tuning.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "thread_tuning.hh"
+
+#include "fast_daq_error.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+namespace fast_daq
+{
+    LOGGER( flog, "thread_tuning" );
+
+    thread_tuning::thread_tuning() :
+            f_cpu_set(),
+            f_realtime_priority( 0 )
+    {
+    }
+
+    thread_tuning::~thread_tuning()
+    {
+    }
+
+    void thread_tuning::apply_thread_config( const scarab::param_node& a_config )
+    {
+        set_cpu_set( a_config.get_value( "cpu-set", get_cpu_set() ) );
+        set_realtime_priority( a_config.get_value( "realtime-priority", get_realtime_priority() ) );
+        // check now, rather than when the thread starts
+        parse_cpu_set( f_cpu_set );
+        if( f_realtime_priority < 0 || f_realtime_priority > 99 )
+        {
+            throw fast_daq::error() << "realtime-priority must be between 0 and 99; got " << f_realtime_priority;
+        }
+    }
+
+    void thread_tuning::dump_thread_config( scarab::param_node& a_config ) const
+    {
+        a_config.add( "cpu-set", scarab::param_value( get_cpu_set() ) );
+        a_config.add( "realtime-priority", scarab::param_value( get_realtime_priority() ) );
+    }
+
+    void thread_tuning::tune_current_thread( const std::string& a_thread_name ) const
+    {
+        std::vector< unsigned > t_cpus = parse_cpu_set( f_cpu_set );
+        if( ! t_cpus.empty() )
+        {
+            cpu_set_t t_mask;
+            CPU_ZERO( &t_mask );
+            for( unsigned t_cpu : t_cpus )
+            {
+                if( t_cpu >= CPU_SETSIZE ) throw fast_daq::error() << "CPU " << t_cpu << " is out of range";
+                CPU_SET( t_cpu, &t_mask );
+            }
+            int t_result = pthread_setaffinity_np( pthread_self(), sizeof( t_mask ), &t_mask );
+            if( t_result != 0 )
+            {
+                LWARN( flog, a_thread_name << ": unable to pin thread to CPUs " << f_cpu_set << " (" << strerror( t_result ) << ")" );
+            }
+        }
+
+        if( f_realtime_priority > 0 )
+        {
+            sched_param t_param;
+            t_param.sched_priority = f_realtime_priority;
+            int t_result = pthread_setschedparam( pthread_self(), SCHED_FIFO, &t_param );
+            if( t_result != 0 )
+            {
+                LWARN( flog, a_thread_name << ": unable to set SCHED_FIFO priority " << f_realtime_priority << " (" << strerror( t_result ) << "); keeping normal scheduling" );
+            }
+        }
+
+        LINFO( flog, a_thread_name << ": " << describe_current_thread() );
+        return;
+    }
+
+    std::vector< unsigned > thread_tuning::parse_cpu_set( const std::string& a_cpu_set )
+    {
+        std::set< unsigned > t_cpus;
+        std::stringstream t_stream( a_cpu_set );
+        std::string t_item;
+        while( std::getline( t_stream, t_item, ',' ) )
+        {
+            if( t_item.empty() ) continue;
+            char* t_end = nullptr;
+            unsigned long t_first = std::strtoul( t_item.c_str(), &t_end, 10 );
+            unsigned long t_last = t_first;
+            if( t_end == t_item.c_str() ) throw fast_daq::error() << "invalid CPU set <" << a_cpu_set << ">";
+            if( *t_end == '-' )
+            {
+                const char* t_start = t_end + 1;
+                t_last = std::strtoul( t_start, &t_end, 10 );
+                if( t_end == t_start ) throw fast_daq::error() << "invalid CPU set <" << a_cpu_set << ">";
+            }
+            if( *t_end != '\0' || t_last < t_first || t_last >= CPU_SETSIZE )
+            {
+                throw fast_daq::error() << "invalid CPU set <" << a_cpu_set << ">";
+            }
+            for( unsigned long t_cpu = t_first; t_cpu <= t_last; ++t_cpu ) t_cpus.insert( t_cpu );
+        }
+        return std::vector< unsigned >( t_cpus.begin(), t_cpus.end() );
+    }
+
+    int thread_tuning::numa_node_of_cpu( unsigned a_cpu )
+    {
+        // the CPU's sysfs directory has a "node<N>" link to its node
+        std::string t_path = "/sys/devices/system/cpu/cpu" + std::to_string( a_cpu );
+        DIR* t_dir = opendir( t_path.c_str() );
+        if( t_dir == nullptr ) return -1;
+        int t_node = -1;
+        while( dirent* t_entry = readdir( t_dir ) )
+        {
+            if( std::strncmp( t_entry->d_name, "node", 4 ) == 0 && t_entry->d_name[4] >= '0' && t_entry->d_name[4] <= '9' )
+            {
+                t_node = std::atoi( t_entry->d_name + 4 );
+                break;
+            }
+        }
+        closedir( t_dir );
+        return t_node;
+    }
+
+    std::string thread_tuning::describe_current_thread()
+    {
+        std::stringstream t_description;
+        t_description << "thread " << syscall( SYS_gettid );
+
+        cpu_set_t t_mask;
+        CPU_ZERO( &t_mask );
+        if( pthread_getaffinity_np( pthread_self(), sizeof( t_mask ), &t_mask ) == 0 )
+        {
+            std::set< int > t_nodes;
+            t_description << " on CPUs ";
+            int t_run_start = -1;
+            bool t_first = true;
+            for( int t_cpu = 0; t_cpu <= CPU_SETSIZE; ++t_cpu )
+            {
+                bool t_in_set = t_cpu < CPU_SETSIZE && CPU_ISSET( t_cpu, &t_mask );
+                if( t_in_set )
+                {
+                    if( t_run_start < 0 ) t_run_start = t_cpu;
+                    int t_node = numa_node_of_cpu( t_cpu );
+                    if( t_node >= 0 ) t_nodes.insert( t_node );
+                }
+                else if( t_run_start >= 0 )
+                {
+                    t_description << ( t_first ? "" : "," ) << t_run_start;
+                    if( t_cpu - 1 > t_run_start ) t_description << "-" << t_cpu - 1;
+                    t_first = false;
+                    t_run_start = -1;
+                }
+            }
+            if( ! t_nodes.empty() )
+            {
+                t_description << " (NUMA node" << ( t_nodes.size() > 1 ? "s " : " " );
+                for( auto t_it = t_nodes.begin(); t_it != t_nodes.end(); ++t_it )
+                {
+                    t_description << ( t_it == t_nodes.begin() ? "" : "," ) << *t_it;
+                }
+                t_description << ")";
+            }
+        }
+
+        int t_policy = 0;
+        sched_param t_param;
+        if( pthread_getschedparam( pthread_self(), &t_policy, &t_param ) == 0 )
+        {
+            t_description << ", scheduling " << ( t_policy == SCHED_FIFO ? "SCHED_FIFO" : ( t_policy == SCHED_RR ? "SCHED_RR" : "normal" ) );
+            if( t_policy == SCHED_FIFO || t_policy == SCHED_RR ) t_description << " priority " << t_param.sched_priority;
+        }
+        return t_description.str();
+    }
+
+} /* namespace fast_daq */
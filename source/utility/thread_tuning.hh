@@ -0,0 +1,103 @@
+/*
+ * thread_tuning.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_THREAD_TUNING_HH_
+#define FAST_DAQ_THREAD_TUNING_HH_
+
+#include "member_variables.hh"
+#include "node_builder.hh"
+
+#include <string>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace fast_daq
+{
+    /*!
+     @class thread_tuning
+     @brief Mix-in that lets a node pin the thread it executes in to a set of CPUs and give it real-time scheduling.
+
+     @details
+     Nodes run in threads created by midge, so they can only change their own thread's placement: a node inherits from
+     this class, its binding derives from _tuned_node_binding, which applies and dumps the "cpu-set" and
+     "realtime-priority" configuration values along with the node's own, and it calls tune_current_thread() at the start
+     of execute().  Each call logs the resulting placement
+     (thread ID, allowed CPUs and their NUMA nodes, scheduling policy), so the topology of a run is recorded at startup.
+
+     Keeping the acquisition thread alone on its cores, away from FFT and writer threads, and running it with SCHED_FIFO
+     removes most of the scheduling jitter that lets DMA buffers back up.  Real-time scheduling needs CAP_SYS_NICE (or a
+     suitable RLIMIT_RTPRIO); if it is refused, a warning is logged and the thread keeps its normal scheduling.
+
+     Configuration values:
+     - "cpu-set": string -- CPUs on which the node's thread may run, as a list of numbers and ranges, e.g. "2" or "4-7,12"; empty for no pinning (default: "")
+     - "realtime-priority": int -- if nonzero, run the node's thread with SCHED_FIFO at this priority, 1 to 99 (default: 0)
+    */
+    class thread_tuning
+    {
+        public:
+            thread_tuning();
+            virtual ~thread_tuning();
+
+        mv_accessible( std::string, cpu_set );
+        mv_accessible( int, realtime_priority );
+
+        public:
+            void apply_thread_config( const scarab::param_node& a_config );
+            void dump_thread_config( scarab::param_node& a_config ) const;
+
+            /// Apply the CPU set and scheduling to the calling thread and log the result
+            void tune_current_thread( const std::string& a_thread_name ) const;
+
+            /// Parse a CPU list such as "0-3,8"; throws fast_daq::error if it is malformed
+            static std::vector< unsigned > parse_cpu_set( const std::string& a_cpu_set );
+            /// NUMA node of a CPU; -1 if unknown
+            static int numa_node_of_cpu( unsigned a_cpu );
+            /// One-line description of the calling thread's CPUs, NUMA nodes and scheduling
+            static std::string describe_current_thread();
+    };
+
+    /*!
+     @class _tuned_node_binding
+     @brief Node binding for nodes that inherit from thread_tuning.
+
+     @details
+     Handles the thread_tuning configuration values ("cpu-set" and "realtime-priority"), so that every tuned node accepts
+     them without its binding repeating them.  Derived bindings implement do_apply_node_config() and
+     do_dump_node_config() for the node's own values; these are called before the thread values are applied or dumped.
+    */
+    template< class x_node_type, class x_binding_type >
+    class _tuned_node_binding : public sandfly::_node_binding< x_node_type, x_binding_type >
+    {
+        public:
+            _tuned_node_binding() {}
+            virtual ~_tuned_node_binding() {}
+
+        private:
+            virtual void do_apply_config( x_node_type* a_node, const scarab::param_node& a_config ) const
+            {
+                do_apply_node_config( a_node, a_config );
+                a_node->apply_thread_config( a_config );
+                return;
+            }
+
+            virtual void do_dump_config( const x_node_type* a_node, scarab::param_node& a_config ) const
+            {
+                do_dump_node_config( a_node, a_config );
+                a_node->dump_thread_config( a_config );
+                return;
+            }
+
+            virtual void do_apply_node_config( x_node_type* a_node, const scarab::param_node& a_config ) const = 0;
+            virtual void do_dump_node_config( const x_node_type* a_node, scarab::param_node& a_config ) const = 0;
+    };
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_THREAD_TUNING_HH_ */
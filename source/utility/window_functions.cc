@@ -0,0 +1,102 @@
+/*
+ * window_functions.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "window_functions.hh"
+
+#include "fast_daq_error.hh"
+
+#include <cmath>
+
+namespace fast_daq
+{
+    std::string window_type_to_string( window_type_t a_window_type )
+    {
+        switch( a_window_type )
+        {
+            case window_type_t::rectangular: return "rectangular";
+            case window_type_t::hann: return "hann";
+            case window_type_t::hamming: return "hamming";
+            case window_type_t::blackman_harris: return "blackman-harris";
+            case window_type_t::flat_top: return "flat-top";
+            case window_type_t::kaiser: return "kaiser";
+            default: throw fast_daq::error() << "window_type value <" << static_cast< unsigned >( a_window_type ) << "> not recognized";
+        }
+    }
+
+    window_type_t string_to_window_type( const std::string& a_window_type )
+    {
+        if( a_window_type == window_type_to_string( window_type_t::rectangular ) ) return window_type_t::rectangular;
+        if( a_window_type == window_type_to_string( window_type_t::hann ) ) return window_type_t::hann;
+        if( a_window_type == window_type_to_string( window_type_t::hamming ) ) return window_type_t::hamming;
+        if( a_window_type == window_type_to_string( window_type_t::blackman_harris ) ) return window_type_t::blackman_harris;
+        if( a_window_type == window_type_to_string( window_type_t::flat_top ) ) return window_type_t::flat_top;
+        if( a_window_type == window_type_to_string( window_type_t::kaiser ) ) return window_type_t::kaiser;
+        throw fast_daq::error() << "string <" << a_window_type << "> not recognized as valid window type";
+    }
+
+    void make_window( window_type_t a_window_type, unsigned a_size, std::vector< float >& a_window, double a_kaiser_beta )
+    {
+        a_window.resize( a_size );
+        const double t_step = 2. * M_PI / (double)a_size;
+        const double t_kaiser_norm = 1. / std::cyl_bessel_i( 0., a_kaiser_beta );
+        for( unsigned i_point = 0; i_point < a_size; ++i_point )
+        {
+            double t_phase = t_step * (double)i_point;
+            switch( a_window_type )
+            {
+                case window_type_t::rectangular:
+                    a_window[ i_point ] = 1.;
+                    break;
+                case window_type_t::hann:
+                    a_window[ i_point ] = 0.5 - 0.5 * cos( t_phase );
+                    break;
+                case window_type_t::hamming:
+                    a_window[ i_point ] = 0.54 - 0.46 * cos( t_phase );
+                    break;
+                case window_type_t::blackman_harris:
+                    a_window[ i_point ] = 0.35875 - 0.48829 * cos( t_phase ) + 0.14128 * cos( 2. * t_phase ) - 0.01168 * cos( 3. * t_phase );
+                    break;
+                case window_type_t::flat_top:
+                    a_window[ i_point ] = 0.21557895 - 0.41663158 * cos( t_phase ) + 0.277263158 * cos( 2. * t_phase ) - 0.083578947 * cos( 3. * t_phase ) + 0.006947368 * cos( 4. * t_phase );
+                    break;
+                case window_type_t::kaiser:
+                {
+                    double t_x = 2. * (double)i_point / (double)a_size - 1.;
+                    a_window[ i_point ] = std::cyl_bessel_i( 0., a_kaiser_beta * sqrt( 1. - t_x * t_x ) ) * t_kaiser_norm;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    double window_sum( const std::vector< float >& a_window )
+    {
+        double t_sum = 0.;
+        for( float t_value : a_window )
+        {
+            t_sum += (double)t_value;
+        }
+        return t_sum;
+    }
+
+    double window_sum_of_squares( const std::vector< float >& a_window )
+    {
+        double t_sum = 0.;
+        for( float t_value : a_window )
+        {
+            t_sum += (double)t_value * (double)t_value;
+        }
+        return t_sum;
+    }
+
+    double window_enbw_bins( const std::vector< float >& a_window )
+    {
+        double t_sum = window_sum( a_window );
+        return (double)a_window.size() * window_sum_of_squares( a_window ) / ( t_sum * t_sum );
+    }
+
+} /* namespace fast_daq */
@@ -0,0 +1,44 @@
+/*
+ * window_functions.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FAST_DAQ_WINDOW_FUNCTIONS_HH_
+#define FAST_DAQ_WINDOW_FUNCTIONS_HH_
+
+#include <string>
+#include <vector>
+
+namespace fast_daq
+{
+    /// Window (taper) functions shared by the spectral nodes
+    enum class window_type_t
+    {
+        rectangular,
+        hann,
+        hamming,
+        blackman_harris,
+        flat_top,
+        kaiser
+    };
+
+    std::string window_type_to_string( window_type_t a_window_type );
+    window_type_t string_to_window_type( const std::string& a_window_type );
+
+    /// Fill a_window with a_size points of the requested window (periodic form, suited to spectral analysis)
+    /// a_kaiser_beta is only used by the Kaiser window
+    void make_window( window_type_t a_window_type, unsigned a_size, std::vector< float >& a_window, double a_kaiser_beta = 8.6 );
+
+    /// Sum of the window coefficients; sets the amplitude (power-spectrum) normalization of a windowed transform
+    double window_sum( const std::vector< float >& a_window );
+
+    /// Sum of the squared window coefficients; sets the PSD normalization of a windowed transform
+    double window_sum_of_squares( const std::vector< float >& a_window );
+
+    /// Equivalent noise bandwidth of the window, in bins: N * sum(w^2) / sum(w)^2
+    double window_enbw_bins( const std::vector< float >& a_window );
+
+} /* namespace fast_daq */
+
+#endif /* FAST_DAQ_WINDOW_FUNCTIONS_HH_ */